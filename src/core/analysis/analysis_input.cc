@@ -18,8 +18,17 @@ Status AnalysisInput::reset(StringPiece data) {
 
   raw_input_.clear();
   codepoints_.clear();
+  arrays_.clear();
   raw_input_.append(data.begin(), data.end());
-  JPP_RETURN_IF_ERROR(chars::preprocessRawData(raw_input_, &codepoints_));
+  JPP_RETURN_IF_ERROR(
+      chars::preprocessRawData(raw_input_, &codepoints_, &arrays_));
+
+  classRuns_.clear();
+  chars::computeClassRuns(arrays_.classes, &classRuns_);
+  presentClasses_ = chars::CharacterClass::FAMILY_OTHERS;
+  for (auto &run : classRuns_) {
+    presentClasses_ = presentClasses_ | run.charClass;
+  }
 
   constexpr auto max_codepoints = std::numeric_limits<LatticePosition>::max();
   if (codepoints().size() > max_codepoints) {
@@ -20,6 +20,9 @@ class AnalysisInput {
   std::string raw_input_;
   using CodepointStorage = std::vector<jumanpp::chars::InputCodepoint>;
   CodepointStorage codepoints_;
+  chars::CodepointArrays arrays_;
+  std::vector<chars::CharClassRun> classRuns_;
+  chars::CharacterClass presentClasses_ = chars::CharacterClass::FAMILY_OTHERS;
 
  public:
   AnalysisInput(size_t maxSize = 8 * 1024) : max_size_{maxSize} {
@@ -31,6 +34,24 @@ class AnalysisInput {
 
   const CodepointStorage &codepoints() const { return codepoints_; }
 
+  /**
+   * Same data as codepoints() in the structure-of-arrays form
+   */
+  const chars::CodepointArrays &codepointArrays() const { return arrays_; }
+
+  util::ArraySlice<i32> charClasses() const { return arrays_.classes; }
+
+  /**
+   * Runs of the same character class, computed once for the input
+   * and shared by all unk makers
+   */
+  util::ArraySlice<chars::CharClassRun> classRuns() const {
+    return classRuns_;
+  }
+
+  // Union of all character classes of the input
+  chars::CharacterClass presentClasses() const { return presentClasses_; }
+
   u16 numCodepoints();
 
   StringPiece surface(i32 start, i32 end) const {
@@ -46,6 +46,10 @@ Status AnalysisPath::fillIn(const Lattice *l) {
 
   const ConnectionPtr *topPtr = &lastStart->beamData().at(0).ptr;
   i32 myBeam = 0;
+  u32 end = l->pathEnd();
+  if (end == 0) {
+    end = bnds - 1;
+  }
 
   // 0 and 1 are BOS
   offsets_.push_back(0);
@@ -54,7 +58,9 @@ Status AnalysisPath::fillIn(const Lattice *l) {
     auto starts = bnd->starts();
     auto beamAtBnd = starts->beamData().row(topPtr->right);
     auto topItem = beamAtBnd.at(myBeam);
-    elems_.push_back(topItem.ptr.previous);
+    if (topItem.ptr.previous->boundary < end) {
+      elems_.push_back(topItem.ptr.previous);
+    }
 #if 0
     for (i32 id = myBeam + 1; id < beamAtBnd.size(); ++id) {
       auto nextItem = beamAtBnd.at(id);
@@ -65,7 +71,9 @@ Status AnalysisPath::fillIn(const Lattice *l) {
       elems_.push_back(*nextItem.ptr.previous);
     }
 #endif
-    offsets_.push_back((u32)elems_.size());
+    if (offsets_.back() != elems_.size()) {
+      offsets_.push_back((u32)elems_.size());
+    }
     myBeam = topPtr->beam;
     topPtr = topPtr->previous;
   }
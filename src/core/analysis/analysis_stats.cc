@@ -0,0 +1,188 @@
+#include "analysis_stats.h"
+#include <algorithm>
+#include <ostream>
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+namespace {
+
+// number of significant bits, 0 for 0
+u32 bucketOf(u64 value) {
+  u32 bits = 0;
+  while (value != 0) {
+    value >>= 1;
+    ++bits;
+  }
+  return bits;
+}
+
+u64 bucketUpperBound(u32 bucket) {
+  if (bucket == 0) {
+    return 0;
+  }
+  if (bucket >= 64) {
+    return ~u64{0};
+  }
+  return (u64{1} << bucket) - 1;
+}
+
+struct NamedHistogram {
+  StringPiece name;
+  const StatsHistogram* histogram;
+};
+
+std::vector<NamedHistogram> counters(const AnalysisStats& stats) {
+  return {{"lattice_nodes", &stats.latticeNodes},
+          {"boundaries", &stats.boundaries},
+          {"gbeam_fill_percent", &stats.gbeamFill},
+          {"other_scorer_evaluations", &stats.otherEvaluations},
+          {"dic_cache_hits", &stats.dicCacheHits},
+          {"dic_cache_misses", &stats.dicCacheMisses},
+          {"unk_duplicates", &stats.unkDuplicates}};
+}
+
+void printTextLine(std::ostream& os, StringPiece name,
+                   const StatsHistogram& h) {
+  os << "  " << name << ": count=" << h.count() << " sum=" << h.sum()
+     << " mean=" << static_cast<u64>(h.mean()) << " min=" << h.min()
+     << " p50=" << h.percentile(0.5) << " p90=" << h.percentile(0.9)
+     << " p99=" << h.percentile(0.99) << " max=" << h.max() << "\n";
+}
+
+void printJsonObject(std::ostream& os, const StatsHistogram& h) {
+  os << "{\"count\":" << h.count() << ",\"sum\":" << h.sum()
+     << ",\"mean\":" << h.mean() << ",\"min\":" << h.min()
+     << ",\"p50\":" << h.percentile(0.5) << ",\"p90\":" << h.percentile(0.9)
+     << ",\"p99\":" << h.percentile(0.99) << ",\"max\":" << h.max() << "}";
+}
+
+}  // namespace
+
+void StatsHistogram::add(u64 value) {
+  count_ += 1;
+  sum_ += value;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  buckets_[bucketOf(value)] += 1;
+}
+
+void StatsHistogram::merge(const StatsHistogram& o) {
+  count_ += o.count_;
+  sum_ += o.sum_;
+  min_ = std::min(min_, o.min_);
+  max_ = std::max(max_, o.max_);
+  for (u32 i = 0; i < NumBuckets; ++i) {
+    buckets_[i] += o.buckets_[i];
+  }
+}
+
+double StatsHistogram::mean() const {
+  if (count_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(sum_) / count_;
+}
+
+u64 StatsHistogram::percentile(double p) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<u64>(p * count_);
+  rank = std::min(std::max<u64>(rank, 1), count_);
+  u64 seen = 0;
+  for (u32 i = 0; i < NumBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(std::max(bucketUpperBound(i), min()), max_);
+    }
+  }
+  return max_;
+}
+
+StringPiece stageName(AnalysisStage stage) {
+  switch (stage) {
+    case AnalysisStage::NodeSeeds:
+      return "node_seeds";
+    case AnalysisStage::Lattice:
+      return "lattice";
+    case AnalysisStage::PatternFeatures:
+      return "pattern_features";
+    case AnalysisStage::Scores:
+      return "scores";
+    case AnalysisStage::OtherScorers:
+      return "other_scorers";
+    case AnalysisStage::Output:
+      return "output";
+    default:
+      return "unknown";
+  }
+}
+
+void AnalysisStats::merge(const AnalysisStats& o) {
+  for (u32 i = 0; i < NumStages; ++i) {
+    stageNanos[i].merge(o.stageNanos[i]);
+  }
+  latticeNodes.merge(o.latticeNodes);
+  boundaries.merge(o.boundaries);
+  gbeamFill.merge(o.gbeamFill);
+  otherEvaluations.merge(o.otherEvaluations);
+  dicCacheHits.merge(o.dicCacheHits);
+  dicCacheMisses.merge(o.dicCacheMisses);
+  unkDuplicates.merge(o.unkDuplicates);
+}
+
+void AnalysisStats::printText(std::ostream& os) const {
+  os << "analysis stats: " << boundaries.count() << " sentences\n";
+  os << "stage times (ns per sentence):\n";
+  for (u32 i = 0; i < NumStages; ++i) {
+    auto stage = static_cast<AnalysisStage>(i);
+    printTextLine(os, stageName(stage), stageNanos[i]);
+  }
+  os << "counters (per sentence):\n";
+  for (auto& c : counters(*this)) {
+    printTextLine(os, c.name, *c.histogram);
+  }
+}
+
+void AnalysisStats::printJson(std::ostream& os) const {
+  os << "{\"sentences\":" << boundaries.count() << ",\"stage_nanos\":{";
+  for (u32 i = 0; i < NumStages; ++i) {
+    if (i != 0) {
+      os << ",";
+    }
+    os << "\"" << stageName(static_cast<AnalysisStage>(i)) << "\":";
+    printJsonObject(os, stageNanos[i]);
+  }
+  os << "},\"counters\":{";
+  bool first = true;
+  for (auto& c : counters(*this)) {
+    if (!first) {
+      os << ",";
+    }
+    first = false;
+    os << "\"" << c.name << "\":";
+    printJsonObject(os, *c.histogram);
+  }
+  os << "}}\n";
+}
+
+AnalysisStats* AnalysisStatsCollector::makePart() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  parts_.emplace_back(new AnalysisStats);
+  return parts_.back().get();
+}
+
+AnalysisStats AnalysisStatsCollector::aggregate() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  AnalysisStats result;
+  for (auto& p : parts_) {
+    result.merge(*p);
+  }
+  return result;
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,147 @@
+#ifndef JUMANPP_ANALYSIS_STATS_H
+#define JUMANPP_ANALYSIS_STATS_H
+
+#include <array>
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+/**
+ * Histogram with power-of-two buckets.
+ * Percentiles are approximate: they are upper bounds of buckets.
+ */
+class StatsHistogram {
+  static constexpr u32 NumBuckets = 65;
+  u64 count_ = 0;
+  u64 sum_ = 0;
+  u64 min_ = ~u64{0};
+  u64 max_ = 0;
+  std::array<u64, NumBuckets> buckets_{};
+
+ public:
+  void add(u64 value);
+  void merge(const StatsHistogram& o);
+
+  u64 count() const { return count_; }
+  u64 sum() const { return sum_; }
+  u64 min() const { return count_ == 0 ? 0 : min_; }
+  u64 max() const { return max_; }
+  double mean() const;
+  // p is in [0, 1]
+  u64 percentile(double p) const;
+};
+
+enum class AnalysisStage {
+  NodeSeeds,
+  Lattice,
+  // Only static pattern features, dynamic ones are computed with the lattice
+  PatternFeatures,
+  Scores,
+  // Scorers other than the perceptron (RNN)
+  OtherScorers,
+  Output,
+  NumStages
+};
+
+StringPiece stageName(AnalysisStage stage);
+
+/**
+ * Per-sentence timings (in nanoseconds) and counters of analysis.
+ * Each analyzer fills its own object, so they are not synchronized.
+ */
+struct AnalysisStats {
+  static constexpr u32 NumStages = static_cast<u32>(AnalysisStage::NumStages);
+
+  StatsHistogram stageNanos[NumStages];
+  StatsHistogram latticeNodes;
+  StatsHistogram boundaries;
+  // used part of the global beam (in percent), averaged over boundaries
+  StatsHistogram gbeamFill;
+  StatsHistogram otherEvaluations;
+  // only when the dictionary lookup cache is enabled
+  StatsHistogram dicCacheHits;
+  StatsHistogram dicCacheMisses;
+  // unk seeds which were removed as duplicates
+  StatsHistogram unkDuplicates;
+
+  StatsHistogram& stage(AnalysisStage s) {
+    return stageNanos[static_cast<u32>(s)];
+  }
+  const StatsHistogram& stage(AnalysisStage s) const {
+    return stageNanos[static_cast<u32>(s)];
+  }
+
+  void merge(const AnalysisStats& o);
+  void printText(std::ostream& os) const;
+  void printJson(std::ostream& os) const;
+};
+
+using StatsClock = std::chrono::steady_clock;
+
+inline u64 nanosSince(StatsClock::time_point start) {
+  auto passed = StatsClock::now() - start;
+  return static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(passed).count());
+}
+
+/**
+ * Adds the time of its lifetime to the stage.
+ * Does nothing if stats are nullptr.
+ */
+class StageTimer {
+  AnalysisStats* stats_;
+  AnalysisStage stage_;
+  StatsClock::time_point start_;
+
+ public:
+  StageTimer(AnalysisStats* stats, AnalysisStage stage)
+      : stats_{stats}, stage_{stage} {
+    if (stats_ != nullptr) {
+      start_ = StatsClock::now();
+    }
+  }
+
+  StageTimer(const StageTimer&) = delete;
+
+  ~StageTimer() {
+    if (stats_ != nullptr) {
+      stats_->stage(stage_).add(nanosSince(start_));
+    }
+  }
+};
+
+/**
+ * Owns statistics of all analyzers which were created with it
+ * (see AnalyzerConfig::statsCollector).
+ */
+class AnalysisStatsCollector {
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<AnalysisStats>> parts_;
+
+ public:
+  /**
+   * Statistics object for a single analyzer, owned by the collector.
+   * Thread-safe.
+   */
+  AnalysisStats* makePart();
+
+  /**
+   * Merges statistics of all analyzers.
+   * Analyzers must not be used while this function is called.
+   */
+  AnalysisStats aggregate() const;
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_ANALYSIS_STATS_H
@@ -0,0 +1,71 @@
+#include "analysis_stats.h"
+#include <sstream>
+#include "core/test/test_analyzer_env.h"
+
+using namespace tests;
+
+TEST_CASE("stats histogram computes summary") {
+  StatsHistogram h;
+  CHECK(h.percentile(0.5) == 0);
+  CHECK(h.min() == 0);
+  for (u64 i = 1; i <= 100; ++i) {
+    h.add(i);
+  }
+  CHECK(h.count() == 100);
+  CHECK(h.sum() == 5050);
+  CHECK(h.min() == 1);
+  CHECK(h.max() == 100);
+  CHECK(h.mean() == Approx(50.5));
+  // buckets are powers of two
+  CHECK(h.percentile(0.5) == 63);
+  CHECK(h.percentile(0.99) == 100);
+  CHECK(h.percentile(0.0) == 1);
+}
+
+TEST_CASE("stats histograms are merged") {
+  StatsHistogram h1;
+  StatsHistogram h2;
+  h1.add(5);
+  h2.add(1000);
+  h2.add(0);
+  h1.merge(h2);
+  CHECK(h1.count() == 3);
+  CHECK(h1.sum() == 1005);
+  CHECK(h1.min() == 0);
+  CHECK(h1.max() == 1000);
+}
+
+TEST_CASE("stats collector aggregates all parts") {
+  AnalysisStatsCollector collector;
+  auto p1 = collector.makePart();
+  auto p2 = collector.makePart();
+  p1->stage(AnalysisStage::Lattice).add(10);
+  p2->stage(AnalysisStage::Lattice).add(20);
+  p2->boundaries.add(5);
+  auto all = collector.aggregate();
+  CHECK(all.stage(AnalysisStage::Lattice).count() == 2);
+  CHECK(all.stage(AnalysisStage::Lattice).sum() == 30);
+  CHECK(all.boundaries.count() == 1);
+  std::stringstream json;
+  all.printJson(json);
+  CHECK(json.str().find("\"lattice\":{\"count\":2") != std::string::npos);
+}
+
+TEST_CASE("analyzer collects stats when it is configured to") {
+  StringPiece dic = "XXX,z,KANA\na,b,\nb,c,\naf,b,\nfb,c,\nf,a,\n";
+  AnalysisStatsCollector collector;
+  PrimFeatureTestEnv env{
+      dic, [](dsl::ModelSpecBuilder& specBldr, FeatureSet& fs) {}, 3, 4, 0,
+      &collector};
+  env.analyze2("afb");
+  env.analyze2("afbafb");
+  auto stats = collector.aggregate();
+  CHECK(stats.boundaries.count() == 2);
+  CHECK(stats.boundaries.sum() == 3 + 3 + 3 + 6);
+  CHECK(stats.stage(AnalysisStage::NodeSeeds).count() == 2);
+  CHECK(stats.stage(AnalysisStage::Lattice).count() == 2);
+  CHECK(stats.stage(AnalysisStage::Scores).count() == 2);
+  CHECK(stats.latticeNodes.min() > 0);
+  CHECK(stats.gbeamFill.count() == 2);
+  CHECK(stats.gbeamFill.max() <= 100);
+}
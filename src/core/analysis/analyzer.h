@@ -12,6 +12,9 @@ namespace jumanpp {
 namespace core {
 namespace analysis {
 
+class AnalysisStatsCollector;
+class UserDictionary;
+
 struct AnalyzerConfig {
   size_t pageSize = 4 * 1024 * 1024;
   size_t maxInputBytes = 4 * 1024;
@@ -23,6 +26,18 @@ struct AnalyzerConfig {
   i32 autoBeamStep = 0;
   i32 autoBeamBase = 0;
   i32 autoBeamMax = 0;
+  // Time budget for analysis of a single input in microseconds, 0 disables.
+  // Analyses which are at risk to exceed it are degraded
+  // (only with global beam), see AnalyzerImpl::computeScoresGbeam
+  i64 deadlineMicros = 0;
+  // Analyzers collect timings and counters into it if it is not null
+  AnalysisStatsCollector* statsCollector = nullptr;
+  // Number of dictionary lookups for short substrings which are cached
+  // by each analyzer, 0 disables the cache (see DicLookupCache)
+  i32 dicCacheSize = 0;
+  // Entries which are added to the dictionary at runtime, must outlive
+  // analyzers (see UserDictionary)
+  const UserDictionary* userDictionary = nullptr;
 };
 
 /**
@@ -19,6 +19,10 @@ Status AnalyzerImpl::resetForInput(StringPiece input) {
   JPP_RETURN_IF_ERROR(input_.reset(input));
   latticeBldr_.reset(input_.numCodepoints());
   autoBeamSizes();
+  if (cfg_.deadlineMicros > 0) {
+    deadline_ = std::chrono::steady_clock::now() +
+                std::chrono::microseconds{cfg_.deadlineMicros};
+  }
   return Status::Ok();
 }
 
@@ -31,11 +35,19 @@ AnalyzerImpl::AnalyzerImpl(const CoreHolder* core, const ScoringConfig& sconf,
       input_{cfg.maxInputBytes},
       latticeConfig_{core->latticeConfig(sconf)},
       lattice_{alloc_.get(), latticeConfig_},
+      dicNodes_{core->dic().entries()},
       xtra_{alloc_.get(), core->dic().entries().numFeatures(),
             core->spec().features.numPlaceholders},
       outputManager_{&xtra_, &core->dic(), &lattice_},
       compactor_{core->dic().entries()} {
   ngramStats_.initialze(&core->spec().features);
+  if (cfg.statsCollector != nullptr) {
+    stats_ = cfg.statsCollector->makePart();
+  }
+  if (cfg.dicCacheSize > 0) {
+    dicNodes_.initCache(static_cast<u32>(cfg.dicCacheSize));
+  }
+  dicNodes_.setUserDictionary(cfg.userDictionary);
 }
 
 Status AnalyzerImpl::initScorers(const ScorerDef& cfg) {
@@ -57,6 +69,7 @@ Status AnalyzerImpl::initScorers(const ScorerDef& cfg) {
     return JPPS_INVALID_PARAMETER
            << "right global beam size should not be zero if you enable it";
   }
+
   scorers_.clear();
   scorers_.reserve(cfg.others.size());
   for (auto& sf : cfg.others) {
@@ -87,21 +100,30 @@ Status AnalyzerImpl::initScorers(const ScorerDef& cfg) {
 }
 
 Status AnalyzerImpl::makeNodeSeedsFromDic() {
-  DictionaryNodeCreator dnc{core_->dic().entries()};
-  if (!dnc.spawnNodes(input_, &latticeBldr_)) {
+  auto& cache = dicNodes_.cache();
+  auto hits = cache.hits();
+  auto misses = cache.misses();
+  if (!dicNodes_.spawnNodes(input_, &latticeBldr_)) {
     return Status::InvalidState()
            << "error when creating nodes from dictionary";
   }
+  if (dicNodes_.hasUserDictionary() &&
+      !dicNodes_.spawnUserNodes(input_, &xtra_, &latticeBldr_)) {
+    return Status::InvalidState()
+           << "error when creating nodes from user dictionary";
+  }
+  if (stats_ != nullptr && cache.enabled()) {
+    stats_->dicCacheHits.add(cache.hits() - hits);
+    stats_->dicCacheMisses.add(cache.misses() - misses);
+  }
   return Status::Ok();
 }
 
 Status AnalyzerImpl::makeUnkNodes1() {
   auto& unk = core_->unkMakers();
   analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries()};
-  for (auto& m : unk.stage1) {
-    if (!m->spawnNodes(input_, &unc, &latticeBldr_)) {
-      return Status::InvalidState() << "failed to create unk nodes";
-    }
+  if (!unkSpawner_.spawnNodes(unk.stage1, input_, &unc, &latticeBldr_)) {
+    return Status::InvalidState() << "failed to create unk nodes";
   }
 
   return Status::Ok();
@@ -114,17 +136,17 @@ bool AnalyzerImpl::checkLatticeConnectivity() {
 Status AnalyzerImpl::makeUnkNodes2() {
   auto& unk = core_->unkMakers();
   analysis::UnkNodesContext unc{&xtra_, alloc(), dic().entries()};
-  for (auto& m : unk.stage2) {
-    if (!m->spawnNodes(input_, &unc, &latticeBldr_)) {
-      return Status::InvalidState() << "failed to create unk nodes (2)";
-    }
+  if (!unkSpawner_.spawnNodes(unk.stage2, input_, &unc, &latticeBldr_)) {
+    return Status::InvalidState() << "failed to create unk nodes (2)";
   }
 
   return Status::Ok();
 }
 
 Status AnalyzerImpl::prepareNodeSeeds() {
+  StageTimer timer{stats_, AnalysisStage::NodeSeeds};
   JPP_RETURN_IF_ERROR(makeNodeSeedsFromDic());
+  auto duplicates = unkSpawner_.numDuplicates();
   JPP_RETURN_IF_ERROR(makeUnkNodes1());
   if (!checkLatticeConnectivity()) {
     JPP_RETURN_IF_ERROR(makeUnkNodes2());
@@ -132,11 +154,15 @@ Status AnalyzerImpl::prepareNodeSeeds() {
       return Status::InvalidState() << "could not build lattice";
     }
   }
+  if (stats_ != nullptr) {
+    stats_->unkDuplicates.add(unkSpawner_.numDuplicates() - duplicates);
+  }
   JPP_RETURN_IF_ERROR(latticeBldr_.prepare());
   return Status::Ok();
 }
 
 Status AnalyzerImpl::buildLattice() {
+  StageTimer timer{stats_, AnalysisStage::Lattice};
   lattice_.hintSize(input_.numCodepoints() + 3);
 
   LatticeConstructionContext lcc;
@@ -192,6 +218,45 @@ Status AnalyzerImpl::bootstrapAnalysis() {
   return Status::Ok();
 }
 
+namespace {
+
+// Separates the time of static pattern features from the rest of scoring
+class ScoringTimer {
+  AnalysisStats* stats_;
+  StatsClock::time_point start_;
+  StatsClock::time_point patternStart_;
+  u64 patternNanos_ = 0;
+
+ public:
+  explicit ScoringTimer(AnalysisStats* stats) : stats_{stats} {
+    if (stats_ != nullptr) {
+      start_ = StatsClock::now();
+    }
+  }
+
+  void startPatterns() {
+    if (stats_ != nullptr) {
+      patternStart_ = StatsClock::now();
+    }
+  }
+
+  void endPatterns() {
+    if (stats_ != nullptr) {
+      patternNanos_ += nanosSince(patternStart_);
+    }
+  }
+
+  void finish() {
+    if (stats_ != nullptr) {
+      stats_->stage(AnalysisStage::PatternFeatures).add(patternNanos_);
+      stats_->stage(AnalysisStage::Scores)
+          .add(nanosSince(start_) - patternNanos_);
+    }
+  }
+};
+
+}  // namespace
+
 Status AnalyzerImpl::computeScoresFull(const ScorerDef* sconf) {
   JPP_DCHECK_NE(sconf, nullptr);
   JPP_DCHECK_NE(sconf->feature, nullptr);
@@ -202,6 +267,8 @@ Status AnalyzerImpl::computeScoresFull(const ScorerDef* sconf) {
     return Status::Ok();
   }
 
+  ScoringTimer timer{stats_};
+
   for (i32 boundary = 2; boundary < bndCount; ++boundary) {
     JPP_CAPTURE(boundary);
     auto bnd = lattice_.boundary(boundary);
@@ -213,12 +280,14 @@ Status AnalyzerImpl::computeScoresFull(const ScorerDef* sconf) {
 
     proc.startBoundary(bnd->localNodeCount());
     if (proc.patternIsStatic()) {
+      timer.startPatterns();
       features::impl::PrimitiveFeatureContext pfc{
           &xtra_, dic().fields(), dic().entries(), input_.codepoints()};
       proc.computeT0All(boundary, sconf->feature, &pfc);
       if (JPP_UNLIKELY(cfg_.storeAllPatterns)) {
         proc.computeUniOnlyPatterns(boundary, &pfc);
       }
+      timer.endPatterns();
     } else {
       proc.applyT0(boundary, sconf->feature);
     }
@@ -242,9 +311,22 @@ Status AnalyzerImpl::computeScoresFull(const ScorerDef* sconf) {
     proc.makeBeams(boundary, bnd, sconf);
   }
 
+  timer.finish();
   return Status::Ok();
 }
 
+// Number of boundaries between deadline checks
+constexpr i32 DeadlineCheckInterval = 8;
+
+/**
+ * If the deadline is enabled, the time is checked every few boundaries.
+ * When analysis is projected to miss the deadline (assuming that
+ * remaining boundaries take as long as the last ones),
+ * left and right global beams are halved.
+ * Additional scorers (RNN) are skipped if the remaining time is less than
+ * the time spent in the perceptron scoring: the result is the perceptron-only
+ * analysis then, and scores of skipped scorers are zero.
+ */
 Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
   JPP_DCHECK_NE(sconf, nullptr);
   JPP_DCHECK_NE(sconf->feature, nullptr);
@@ -257,6 +339,16 @@ Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
 
   auto& proc = *this->sproc_;
 
+  using Clock = std::chrono::steady_clock;
+  bool hasDeadline = cfg_.deadlineMicros > 0;
+  auto scoringStart = hasDeadline ? Clock::now() : Clock::time_point{};
+  auto lastCheck = scoringStart;
+  i32 lastCheckBoundary = 2;
+  i32 gbeamSize = static_cast<i32>(latticeConfig_.globalBeamSize);
+  ScoringTimer timer{stats_};
+  u64 gbeamUsed = 0;
+  u64 gbeamBoundaries = 0;
+
   for (i32 boundary = 2; boundary < bndCount; ++boundary) {
     JPP_CAPTURE(boundary);
     auto bnd = lattice_.boundary(boundary);
@@ -264,8 +356,22 @@ Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
       continue;
     }
     JPP_DCHECK(bnd->endingsFilled());
+
+    if (hasDeadline && boundary - lastCheckBoundary >= DeadlineCheckInterval) {
+      auto now = Clock::now();
+      auto perBoundary = (now - lastCheck) / (boundary - lastCheckBoundary);
+      if (now + perBoundary * (bndCount - boundary) > deadline_) {
+        gbeamSize = std::max(gbeamSize / 2, 1);
+        proc.narrowRightBeam();
+        degraded_ = true;
+      }
+      lastCheck = now;
+      lastCheckBoundary = boundary;
+    }
+
     proc.startBoundary(bnd->localNodeCount());
     if (proc.patternIsStatic()) {
+      timer.startPatterns();
       auto entries = dic().entries();
       features::impl::PrimitiveFeatureContext pfc{&xtra_, dic().fields(),
                                                   entries, input_.codepoints()};
@@ -273,22 +379,53 @@ Status AnalyzerImpl::computeScoresGbeam(const ScorerDef* sconf) {
       if (JPP_UNLIKELY(cfg_.storeAllPatterns)) {
         proc.computeUniOnlyPatterns(boundary, &pfc);
       }
+      timer.endPatterns();
     } else {
       proc.applyT0(boundary, sconf->feature);
     }
 
-    auto gbeam = proc.makeGlobalBeam(boundary, latticeConfig_.globalBeamSize);
+    auto gbeam = proc.makeGlobalBeam(boundary, gbeamSize);
     proc.computeGbeamScores(boundary, gbeam, sconf->feature);
+    gbeamUsed += gbeam.size();
+    gbeamBoundaries += 1;
   }
 
-  if (!scorers_.empty()) {
+  timer.finish();
+  if (stats_ != nullptr && gbeamBoundaries > 0) {
+    auto capacity = gbeamBoundaries * latticeConfig_.globalBeamSize;
+    stats_->gbeamFill.add(gbeamUsed * 100 / capacity);
+  }
+
+  bool skipScorers = false;
+  if (!scorers_.empty() && hasDeadline) {
+    auto now = Clock::now();
+    if (now + (now - scoringStart) > deadline_) {
+      degraded_ = true;
+      skipScorers = true;
+    }
+  }
+
+  if (skipScorers) {
+    // output formats read scores of all scorers
+    for (u32 i = 0; i < lattice_.createdBoundaryCount(); ++i) {
+      lattice_.boundary(i)->scores()->clearScorers(1);
+    }
+  }
+
+  if (!scorers_.empty() && !skipScorers) {
+    StageTimer scorersTimer{stats_, AnalysisStage::OtherScorers};
     u32 idx = 1;
+    u64 evaluations = 0;
     for (auto& s : scorers_) {
       JPP_RETURN_IF_ERROR(s->scoreLattice(&lattice_, &xtra_, idx));
+      evaluations += s->lastEvaluations();
       ++idx;
     }
     proc.adjustBeamScores(sconf->scoreWeights);
     proc.remakeEosBeam(sconf->scoreWeights);
+    if (stats_ != nullptr) {
+      stats_->otherEvaluations.add(evaluations);
+    }
   }
 
   return Status::Ok();
@@ -299,10 +436,15 @@ Status AnalyzerImpl::computeScores(const ScorerDef* sconf) {
     return JPPS_INVALID_STATE << "Analyzer was not initialized";
   }
   if (cfg().globalBeamSize <= 0) {
-    return computeScoresFull(sconf);
+    JPP_RETURN_IF_ERROR(computeScoresFull(sconf));
   } else {
-    return computeScoresGbeam(sconf);
+    JPP_RETURN_IF_ERROR(computeScoresGbeam(sconf));
   }
+  if (stats_ != nullptr) {
+    stats_->latticeNodes.add(latticeBldr_.seeds().size());
+    stats_->boundaries.add(lattice_.createdBoundaryCount());
+  }
+  return Status::Ok();
 }
 
 bool AnalyzerImpl::setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam) {
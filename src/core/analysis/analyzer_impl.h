@@ -5,13 +5,17 @@
 #ifndef JUMANPP_ANALYZER_IMPL_H
 #define JUMANPP_ANALYZER_IMPL_H
 
+#include <chrono>
 #include "core/analysis/analysis_input.h"
+#include "core/analysis/analysis_stats.h"
 #include "core/analysis/analyzer.h"
+#include "core/analysis/dictionary_node_creator.h"
 #include "core/analysis/extra_nodes.h"
 #include "core/analysis/lattice_builder.h"
 #include "core/analysis/lattice_types.h"
 #include "core/analysis/score_plugin.h"
 #include "core/analysis/score_processor.h"
+#include "core/analysis/unk_nodes_creator.h"
 
 namespace jumanpp {
 namespace core {
@@ -27,6 +31,8 @@ class AnalyzerImpl {
   LatticeConfig latticeConfig_;
   Lattice lattice_;
   LatticeBuilder latticeBldr_;
+  DictionaryNodeCreator dicNodes_;
+  UnkNodeSpawner unkSpawner_;
   ExtraNodesContext xtra_;
   OutputManager outputManager_;
   ScoreProcessor* sproc_;
@@ -34,6 +40,9 @@ class AnalyzerImpl {
   LatticeCompactor compactor_;
   NgramStats ngramStats_;
   ScorePlugin* plugin_ = nullptr;
+  std::chrono::steady_clock::time_point deadline_;
+  bool degraded_ = false;
+  AnalysisStats* stats_ = nullptr;
 
  public:
   AnalyzerImpl(const AnalyzerImpl&) = delete;
@@ -52,6 +61,7 @@ class AnalyzerImpl {
     alloc_->reset();
     sproc_ = nullptr;
     plugin_ = nullptr;
+    degraded_ = false;
   }
 
   // This set of functions is internal
@@ -96,9 +106,17 @@ class AnalyzerImpl {
   const AnalyzerConfig& cfg() const { return cfg_; }
   bool setGlobalBeam(i32 leftBeam, i32 rightCheck, i32 rightBeam);
   bool setStoreAllPatterns(bool value);
+  void setDeadline(i64 micros) { cfg_.deadlineMicros = micros; }
   const AnalysisInput& input() const { return input_; }
   i32 autoBeamSizes();
   ScorePlugin* plugin() const { return plugin_; }
+  /**
+   * True if the last analysis has narrowed its beams or skipped
+   * additional scorers to fit into AnalyzerConfig::deadlineMicros.
+   */
+  bool degraded() const { return degraded_; }
+  // nullptr if statistics are not collected
+  AnalysisStats* stats() const { return stats_; }
   void setPlugin(ScorePlugin* plugin) { plugin_ = plugin; }
 };
 
@@ -84,4 +84,28 @@ TEST_CASE("global beam does not crash") {
   CHECK_FALSE(top.nextNode(&el));
   CHECK_FALSE(top.nextBoundary());
   // env.dumpTrainers("/tmp/jpp", 5);
-}
\ No newline at end of file
+}
+
+TEST_CASE("global beam analysis is degraded when it misses the deadline") {
+  StringPiece dic = "XXX,z,KANA\na,b,\nb,c,\naf,b,\nfb,c,\nf,a,\n";
+  PrimFeatureTestEnv env{
+      dic, [](dsl::ModelSpecBuilder& specBldr, FeatureSet& fs) {}, 3, 4, 1};
+  env.analyze2("afbafbafbafbafbafb");
+  CHECK(env.degraded());
+  auto& top = env.top();
+  ConnectionPtr el;
+  u32 length = 0;
+  while (top.nextBoundary()) {
+    REQUIRE(top.nextNode(&el));
+    length += env.target(el).f1.size();
+  }
+  CHECK(length == 18);
+}
+
+TEST_CASE("global beam analysis is not degraded without the deadline") {
+  StringPiece dic = "XXX,z,KANA\na,b,\nb,c,\naf,b,\nfb,c,\nf,a,\n";
+  PrimFeatureTestEnv env{
+      dic, [](dsl::ModelSpecBuilder& specBldr, FeatureSet& fs) {}, 3, 4};
+  env.analyze2("afbafbafbafbafbafb");
+  CHECK_FALSE(env.degraded());
+}
@@ -190,6 +190,32 @@ inline bool CheckSubstituteLower(const std::vector<Codepoint>& codepoints,
   return (itr != CMaps().lower2upper.end());
 }
 
+bool CharLattice::mayBeApplicable(util::ArraySlice<Codepoint> codepoints) {
+  // Parse creates candidates only for prolong marks and for characters
+  // which are keys of lower2upper or are checked by the hatsuon and youon
+  // deletion rules.
+  for (auto& cp : codepoints) {
+    if (cp.hasClass(CharacterClass::CHOON)) {
+      return true;
+    }
+    switch (cp.codepoint) {
+      case U'ぁ':
+      case U'ぃ':
+      case U'ぅ':
+      case U'ぇ':
+      case U'ぉ':
+      case U'ゎ':
+      case U'ヶ':
+      case U'ケ':
+      case DEF_PROLONG_SYMBOL3:
+      case DEF_PROLONG_SYMBOL4:
+        return true;
+      default:;  // noop
+    }
+  }
+  return false;
+}
+
 CharLattceTraversal CharLattice::traversal(util::ArraySlice<Codepoint> input) {
   return CharLattceTraversal{*this, input};
 }
@@ -200,17 +226,20 @@ int CharLattice::Parse(const std::vector<Codepoint>& codepoints) {
   bool nextPreIsDeleted = false;
 
   Codepoint skipped("");
-  nodeList.clear();  // Lattice
-  nodeList.reserve(length);
-  for (int i = 0; i < length; ++i) {
-    nodeList.emplace_back(alloc_);
-  }
+  offsets_.clear();  // Lattice
+  offsets_.reserve(length + 1);
+  nodes_.clear();
+  posModifiers_.clear();
+  posModifiers_.resize(length, Modifiers::EMPTY);
+  notNormal = 0;
+  lastModified_ = -1;
 
   const auto& db = CMaps();
 
   for (size_t pos = 0; pos < length; ++pos) {
     const Codepoint& currentCp = codepoints[pos];
     nextPreIsDeleted = false;
+    offsets_.push_back(static_cast<u32>(nodes_.size()));
 
     /* Double Width Characters */
     if (currentCp.hasClass(CharacterClass::FAMILY_DOUBLE)) {
@@ -259,6 +288,7 @@ int CharLattice::Parse(const std::vector<Codepoint>& codepoints) {
     }
     preIsDeleted = nextPreIsDeleted;
   }
+  offsets_.push_back(static_cast<u32>(nodes_.size()));
   constructed = true;
   return 0;
 }
@@ -302,6 +332,11 @@ bool CharLattceTraversal::lookupCandidatesFrom(i32 start) {
     return false;
   }
   result_.clear();
+  // results must contain at least one normalized character
+  // after the first one
+  if (start >= lattice_.lastModified_) {
+    return false;
+  }
   auto trav = lattice_.entries.doubleArrayTraversal();
   auto stat = trav.step(input_.at(start).bytes);
   if (stat == TraverseStatus::NoNode) {
@@ -357,7 +392,12 @@ bool CharLattceTraversal::lookupCandidatesFrom(i32 start) {
 
 void CharLattceTraversal::doTraverseStep(i32 pos) {
   auto& ch = input_.at(pos);
-  auto& extraNodes = lattice_.nodeList[pos];
+  // most positions do not have normalized candidates
+  bool hasExtra = lattice_.modifiersAt(pos) != Modifiers::EMPTY;
+  util::ArraySlice<CharNode> extraNodes;
+  if (hasExtra) {
+    extraNodes = lattice_.nodesAt(pos);
+  }
   for (auto state : states1_) {
     if (state->end != pos) {
       // need to place a copy, because the memory will be recycled
@@ -367,8 +407,10 @@ void CharLattceTraversal::doTraverseStep(i32 pos) {
       states2_.push_back(copy);
     }
     tryWalk(state, ch, Modifiers::ORIGINAL, true);
-    for (auto& n : extraNodes) {
-      tryWalk(state, n.cp, n.type, !n.hasType(Modifiers::DELETE));
+    if (hasExtra) {
+      for (auto& n : extraNodes) {
+        tryWalk(state, n.cp, n.type, !n.hasType(Modifiers::DELETE));
+      }
     }
   }
 }
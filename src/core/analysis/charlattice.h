@@ -94,14 +94,23 @@ class CharLattice {
   //    static bool initialized;
   const dic::DictionaryEntries& entries;
   util::memory::PoolAlloc* alloc_;
-  Vec<Vec<CharNode>> nodeList;
+  // Candidate characters are stored in CSR format:
+  // candidates for position i are nodes_[offsets_[i]..offsets_[i + 1]).
+  // Parse adds them in the order of positions.
+  Vec<u32> offsets_;
+  Vec<CharNode> nodes_;
+  // union of candidate modifiers for each position
+  Vec<Modifiers> posModifiers_;
   u32 notNormal = 0;
+  i32 lastModified_ = -1;
 
   void add(size_t pos, const Codepoint& cp, Modifiers flags) {
     if (flags != Modifiers::ORIGINAL) {
       notNormal += 1;
+      lastModified_ = static_cast<i32>(pos);
     }
-    nodeList[pos].emplace_back(cp, flags);
+    nodes_.emplace_back(cp, flags);
+    posModifiers_[pos] = posModifiers_[pos] | flags;
   }
 
  public:
@@ -111,10 +120,28 @@ class CharLattice {
 
   CharLattice(const dic::DictionaryEntries& entries_,
               util::memory::PoolAlloc* alloc)
-      : entries{entries_}, alloc_{alloc}, nodeList{alloc} {}
+      : entries{entries_},
+        alloc_{alloc},
+        offsets_{alloc},
+        nodes_{alloc},
+        posModifiers_{alloc} {}
+
+  /**
+   * Checks if any codepoint of the input can have a normalized candidate.
+   * Parse does not need to be called if it returns false.
+   */
+  static bool mayBeApplicable(util::ArraySlice<Codepoint> codepoints);
 
   bool isApplicable() const { return notNormal != 0; }
 
+  util::ArraySlice<CharNode> nodesAt(i32 pos) const {
+    auto begin = offsets_[pos];
+    return util::ArraySlice<CharNode>{nodes_.data() + begin,
+                                      offsets_[pos + 1] - begin};
+  }
+
+  Modifiers modifiersAt(i32 pos) const { return posModifiers_[pos]; }
+
   friend class CharLattceTraversal;
 
   CharLattceTraversal traversal(util::ArraySlice<Codepoint> input);
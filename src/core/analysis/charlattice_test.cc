@@ -300,3 +300,17 @@ TEST_CASE("don't crash on very long prolong") {
       "ーーーーーーーーーーーーーーーーーーーーーーーーーーーーーーーーー");
   CHECK(env.numNodeSeeds() == 199);
 }
+
+TEST_CASE("charlattice pre-scan finds inputs with normalizable characters") {
+  auto applicable = [](StringPiece str) {
+    std::vector<chars::InputCodepoint> cp;
+    REQUIRE_OK(chars::preprocessRawData(str, &cp));
+    return charlattice::CharLattice::mayBeApplicable(cp);
+  };
+  CHECK_FALSE(applicable("今日は良い天気です"));
+  CHECK_FALSE(applicable("abcd"));
+  CHECK(applicable("すげー"));
+  CHECK(applicable("ねぇさん"));
+  CHECK(applicable("あっ"));
+  CHECK(applicable("ケーキ"));
+}
@@ -0,0 +1,95 @@
+#include "dic_lookup_cache.h"
+#include <algorithm>
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+void DicLookupCache::initialize(u32 capacity) {
+  entries_.clear();
+  setMask_ = 0;
+  clock_ = 0;
+  if (capacity == 0) {
+    return;
+  }
+  u32 numSets = 1;
+  while (numSets * Ways < capacity) {
+    numSets *= 2;
+  }
+  entries_.resize(numSets * Ways);
+  setMask_ = numSets - 1;
+}
+
+DicLookupCache::Entry* DicLookupCache::setOf(
+    util::ArraySlice<chars::InputCodepoint> input) {
+  u32 h = static_cast<u32>(input[0].codepoint) * 0x9e3779b1u;
+  h ^= static_cast<u32>(input[1].codepoint) * 0x85ebca77u;
+  h ^= h >> 15;
+  return &entries_[(h & setMask_) * Ways];
+}
+
+void DicLookupCache::tick() {
+  clock_ += 1;
+  if (JPP_UNLIKELY(clock_ == 0)) {
+    // wrapped around, forget the usage history
+    for (auto& e : entries_) {
+      if (e.lastUse != 0) {
+        e.lastUse = 1;
+      }
+    }
+    clock_ = 2;
+  }
+}
+
+bool DicLookupCache::find(util::ArraySlice<chars::InputCodepoint> input,
+                          util::ArraySlice<DicLookupCacheSeed>* seeds) {
+  auto set = setOf(input);
+  for (u32 way = 0; way < Ways; ++way) {
+    auto& e = set[way];
+    if (e.lastUse == 0 || e.keyLength > input.size()) {
+      continue;
+    }
+    bool equal = true;
+    for (u32 i = 0; i < e.keyLength; ++i) {
+      if (e.key[i] != input[i].codepoint) {
+        equal = false;
+        break;
+      }
+    }
+    if (equal) {
+      tick();
+      e.lastUse = clock_;
+      hits_ += 1;
+      *seeds = util::ArraySlice<DicLookupCacheSeed>{
+          e.seeds, static_cast<size_t>(e.numSeeds)};
+      return true;
+    }
+  }
+  misses_ += 1;
+  *seeds = util::ArraySlice<DicLookupCacheSeed>{};
+  return false;
+}
+
+void DicLookupCache::insert(util::ArraySlice<chars::InputCodepoint> input,
+                            u32 keyLength,
+                            util::ArraySlice<DicLookupCacheSeed> seeds) {
+  if (keyLength > MaxKeyLength || seeds.size() > MaxSeeds) {
+    return;
+  }
+  auto set = setOf(input);
+  auto victim = std::min_element(
+      set, set + Ways,
+      [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+  tick();
+  victim->lastUse = clock_;
+  victim->keyLength = static_cast<u16>(keyLength);
+  for (u32 i = 0; i < keyLength; ++i) {
+    victim->key[i] = input[i].codepoint;
+  }
+  victim->numSeeds = static_cast<u16>(seeds.size());
+  std::copy(seeds.begin(), seeds.end(), victim->seeds);
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
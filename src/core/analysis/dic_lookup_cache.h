@@ -0,0 +1,92 @@
+#ifndef JUMANPP_DIC_LOOKUP_CACHE_H
+#define JUMANPP_DIC_LOOKUP_CACHE_H
+
+#include <vector>
+#include "util/array_slice.h"
+#include "util/characters.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+struct DicLookupCacheSeed {
+  i32 entryPtr;
+  // in codepoints, from the start of the lookup
+  i32 length;
+};
+
+/**
+ * Size-bounded cache of dictionary lookups for short substrings
+ * of the input, see DictionaryNodeCreator.
+ *
+ * A trie walk from an input position depends only on the codepoints
+ * it has consumed. Walks which were stopped by the trie (not by the end
+ * of the input) after at most MaxKeyLength codepoints can be cached:
+ * the key is the consumed codepoints, the value is the list of
+ * found entries with their lengths.
+ *
+ * The cache is set-associative, a set is selected by the first
+ * two codepoints of the input, the least recently used entry of a set
+ * is evicted. It belongs to a single analyzer and is not synchronized.
+ */
+class DicLookupCache {
+ public:
+  static constexpr u32 MaxKeyLength = 8;
+  static constexpr u32 MaxSeeds = 24;
+  static constexpr u32 Ways = 4;
+
+ private:
+  struct Entry {
+    // 0 for empty entries
+    u32 lastUse = 0;
+    u16 keyLength = 0;
+    u16 numSeeds = 0;
+    char32_t key[MaxKeyLength];
+    DicLookupCacheSeed seeds[MaxSeeds];
+  };
+
+  std::vector<Entry> entries_;
+  u32 setMask_ = 0;
+  u32 clock_ = 0;
+  u64 hits_ = 0;
+  u64 misses_ = 0;
+
+  Entry* setOf(util::ArraySlice<chars::InputCodepoint> input);
+  void tick();
+
+ public:
+  /**
+   * Capacity is the number of cached lookups, 0 disables the cache.
+   * It is rounded up to a power of two.
+   */
+  void initialize(u32 capacity);
+
+  bool enabled() const { return !entries_.empty(); }
+
+  /**
+   * Finds a cached lookup for the beginning of the input,
+   * which must have at least two codepoints.
+   * Returns false and clears seeds if there is none.
+   */
+  bool find(util::ArraySlice<chars::InputCodepoint> input,
+            util::ArraySlice<DicLookupCacheSeed>* seeds);
+
+  /**
+   * Stores a lookup whose trie walk consumed keyLength codepoints
+   * from the beginning of the input.
+   * Lookups which are too long or have too many seeds are not stored.
+   */
+  void insert(util::ArraySlice<chars::InputCodepoint> input, u32 keyLength,
+              util::ArraySlice<DicLookupCacheSeed> seeds);
+
+  u32 capacity() const { return static_cast<u32>(entries_.size()); }
+  u64 hits() const { return hits_; }
+  u64 misses() const { return misses_; }
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_DIC_LOOKUP_CACHE_H
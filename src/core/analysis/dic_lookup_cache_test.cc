@@ -0,0 +1,80 @@
+#include "dic_lookup_cache.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core::analysis;
+
+namespace {
+std::vector<chars::InputCodepoint> codepoints(StringPiece data) {
+  std::vector<chars::InputCodepoint> cps;
+  REQUIRE_OK(chars::preprocessRawData(data, &cps));
+  return cps;
+}
+}  // namespace
+
+TEST_CASE("dic lookup cache finds inserted lookups") {
+  DicLookupCache cache;
+  CHECK_FALSE(cache.enabled());
+  cache.initialize(10);
+  REQUIRE(cache.enabled());
+  CHECK(cache.capacity() == 16);
+
+  auto input = codepoints("すもももも");
+  std::vector<DicLookupCacheSeed> seeds = {{2, 1}, {4, 1}, {6, 3}};
+  util::ArraySlice<DicLookupCacheSeed> result;
+  CHECK_FALSE(cache.find(input, &result));
+  cache.insert(input, 4, seeds);
+
+  REQUIRE(cache.find(input, &result));
+  REQUIRE(result.size() == 3);
+  CHECK(result[2].entryPtr == 6);
+  CHECK(result[2].length == 3);
+
+  // only the consumed part of the input is a key
+  REQUIRE(cache.find(codepoints("すもももはも"), &result));
+  CHECK(result.size() == 3);
+  CHECK_FALSE(cache.find(codepoints("すもも"), &result));
+  CHECK_FALSE(cache.find(codepoints("すもかも"), &result));
+  CHECK(result.size() == 0);
+
+  CHECK(cache.hits() == 2);
+  CHECK(cache.misses() == 3);
+}
+
+TEST_CASE("dic lookup cache does not store large lookups") {
+  DicLookupCache cache;
+  cache.initialize(16);
+  auto input = codepoints("あいうえおかきくけこ");
+  std::vector<DicLookupCacheSeed> seeds = {{2, 1}};
+  util::ArraySlice<DicLookupCacheSeed> result;
+  cache.insert(input, DicLookupCache::MaxKeyLength + 1, seeds);
+  CHECK_FALSE(cache.find(input, &result));
+
+  std::vector<DicLookupCacheSeed> many(DicLookupCache::MaxSeeds + 1, {2, 1});
+  cache.insert(input, 2, many);
+  CHECK_FALSE(cache.find(input, &result));
+}
+
+TEST_CASE("dic lookup cache evicts least recently used lookups") {
+  DicLookupCache cache;
+  // a single set
+  cache.initialize(DicLookupCache::Ways);
+  std::vector<StringPiece> keys = {"あい", "かき", "さし", "たち"};
+  std::vector<DicLookupCacheSeed> seeds = {{2, 1}};
+  util::ArraySlice<DicLookupCacheSeed> result;
+  for (i32 i = 0; i < keys.size(); ++i) {
+    seeds[0].entryPtr = i;
+    cache.insert(codepoints(keys[i]), 2, seeds);
+  }
+  REQUIRE(cache.find(codepoints("あい"), &result));
+  CHECK(result[0].entryPtr == 0);
+
+  seeds[0].entryPtr = 100;
+  cache.insert(codepoints("なに"), 2, seeds);
+  REQUIRE(cache.find(codepoints("なに"), &result));
+  CHECK(result[0].entryPtr == 100);
+  CHECK(cache.find(codepoints("あい"), &result));
+  CHECK_FALSE(cache.find(codepoints("かき"), &result));
+  CHECK(cache.find(codepoints("さし"), &result));
+  CHECK(cache.find(codepoints("たち"), &result));
+}
@@ -3,37 +3,120 @@
 //
 
 #include "dictionary_node_creator.h"
+#include "core/analysis/user_dictionary.h"
 
 namespace jumanpp {
 namespace core {
 namespace analysis {
 
-bool DictionaryNodeCreator::spawnNodes(const AnalysisInput& input,
-                                       LatticeBuilder* lattice) {
-  auto& points = input.codepoints();
+namespace {
+struct SeedAppender {
+  const dic::DictionaryEntries& entries;
+  LatticeBuilder* lattice;
 
-  LatticePosition totalPoints = (LatticePosition)points.size();
-
-  for (LatticePosition begin = 0; begin < totalPoints; ++begin) {
-    auto trav = entries_.traversal();
+  void match(i32 begin, i32 end, i32 value) {
+    auto dicEntries = entries.entryTraversal(value);
+    while (dicEntries.readOnePtr()) {
+      lattice->appendSeed(dicEntries.currentPtr(), LatticePosition(begin),
+                          LatticePosition(end));
+    }
+  }
+};
+}  // namespace
 
-    using dic::TraverseStatus;
+template <typename Trie>
+void DictionaryNodeCreator::spawnCached(
+    const Trie& trie, util::ArraySlice<chars::InputCodepoint> points,
+    LatticeBuilder* lattice) {
+  i32 total = static_cast<i32>(points.size());
+  util::ArraySlice<DicLookupCacheSeed> cached;
+  for (i32 begin = 0; begin < total; ++begin) {
+    util::ArraySlice<chars::InputCodepoint> rest{
+        points, static_cast<size_t>(begin), static_cast<size_t>(total - begin)};
+    bool cacheable = rest.size() >= 2;
+    if (cacheable && cache_.find(rest, &cached)) {
+      for (auto& seed : cached) {
+        lattice->appendSeed(EntryPtr{seed.entryPtr}, LatticePosition(begin),
+                            LatticePosition(begin + seed.length));
+      }
+      continue;
+    }
 
-    for (LatticePosition position = begin; position < totalPoints; ++position) {
-      auto& cp = points[position];
-      TraverseStatus status = trav.step(cp.bytes);
-      if (status == TraverseStatus::Ok) {
-        LatticePosition end = position + LatticePosition(1);
-        auto dicEntries = trav.entries();
+    seedBuffer_.clear();
+    i32 consumed = 0;
+    auto trav = trie.traversal();
+    for (i32 position = begin; position < total; ++position) {
+      auto status = trav.step(points[position]);
+      if (status == dic::TraverseStatus::Ok) {
+        auto dicEntries = entries_.entryTraversal(trav.value());
         while (dicEntries.readOnePtr()) {
-          lattice->appendSeed(dicEntries.currentPtr(), begin, end);
+          seedBuffer_.push_back(
+              {dicEntries.currentPtr().rawValue(), position + 1 - begin});
         }
-      } else if (status == TraverseStatus::NoNode) {
+      } else if (status == dic::TraverseStatus::NoNode) {
+        consumed = position + 1 - begin;
         break;
       }
     }
+
+    for (auto& seed : seedBuffer_) {
+      lattice->appendSeed(EntryPtr{seed.entryPtr}, LatticePosition(begin),
+                          LatticePosition(begin + seed.length));
+    }
+    // walks which were stopped by the end of input depend on it
+    if (cacheable && consumed != 0) {
+      cache_.insert(rest, static_cast<u32>(consumed), seedBuffer_);
+    }
+  }
+}
+
+bool DictionaryNodeCreator::spawnNodes(const AnalysisInput& input,
+                                       LatticeBuilder* lattice) {
+  auto cpTrie = entries_.codepointTrie();
+  if (cache_.enabled()) {
+    if (cpTrie != nullptr) {
+      spawnCached(*cpTrie, input.codepoints(), lattice);
+    } else {
+      spawnCached(entries_.trie(), input.codepoints(), lattice);
+    }
+    return true;
   }
 
+  SeedAppender appender{entries_, lattice};
+  if (cpTrie != nullptr) {
+    cpTraversal_.traverse(*cpTrie, input.codepoints(), appender);
+  } else {
+    byteTraversal_.traverse(entries_.trie(), input.codepoints(), appender);
+  }
+  return true;
+}
+
+bool DictionaryNodeCreator::spawnUserNodes(const AnalysisInput& input,
+                                           ExtraNodesContext* xtra,
+                                           LatticeBuilder* lattice) {
+  if (userDic_ == nullptr || userDic_->empty()) {
+    return true;
+  }
+  auto& trie = userDic_->trie();
+  auto points = input.codepoints();
+  i32 total = static_cast<i32>(points.size());
+  for (i32 begin = 0; begin < total; ++begin) {
+    auto trav = trie.traversal();
+    for (i32 position = begin; position < total; ++position) {
+      auto status = trav.step(points[position]);
+      if (status == dic::TraverseStatus::Ok) {
+        auto group = trav.value();
+        auto last = userDic_->groupStart(group + 1);
+        for (i32 entry = userDic_->groupStart(group); entry < last; ++entry) {
+          auto node = xtra->makeUser(userDic_, entry);
+          lattice->appendSeed(node->ptr(), LatticePosition(begin),
+                              LatticePosition(position + 1));
+        }
+      } else if (status == dic::TraverseStatus::NoNode) {
+        break;
+      }
+    }
+  }
   return true;
 }
 
@@ -6,6 +6,8 @@
 #define JUMANPP_DICTIONARY_NODE_CREATOR_H
 
 #include "core/analysis/analysis_input.h"
+#include "core/analysis/dic_lookup_cache.h"
+#include "core/analysis/extra_nodes.h"
 #include "core/analysis/lattice_builder.h"
 #include "core/dic/dic_entries.h"
 
@@ -13,12 +15,43 @@ namespace jumanpp {
 namespace core {
 namespace analysis {
 
+/**
+ * Creates node seeds for all dictionary entries which occur in the input.
+ * Seeds are appended in the order of start, then end positions.
+ *
+ * Lookups use the codepoint trie if the dictionary has one
+ * and fall back to the byte trie for older models.
+ *
+ * If the lookup cache is enabled, lookups are done for each start
+ * separately and are taken from the cache when possible.
+ *
+ * Entries of a user dictionary become extra nodes, see spawnUserNodes.
+ */
 class DictionaryNodeCreator {
   dic::DictionaryEntries entries_;
+  dic::AllStartsTraversal<> byteTraversal_;
+  dic::AllStartsTraversal<dic::CodepointTrie> cpTraversal_;
+  DicLookupCache cache_;
+  std::vector<DicLookupCacheSeed> seedBuffer_;
+  const UserDictionary* userDic_ = nullptr;
+
+  template <typename Trie>
+  void spawnCached(const Trie& trie,
+                   util::ArraySlice<chars::InputCodepoint> points,
+                   LatticeBuilder* lattice);
 
  public:
   DictionaryNodeCreator(const dic::DictionaryEntries& entries_);
+  // see AnalyzerConfig::dicCacheSize
+  void initCache(u32 capacity) { cache_.initialize(capacity); }
   bool spawnNodes(const AnalysisInput& input, LatticeBuilder* lattice);
+  // see AnalyzerConfig::userDictionary
+  void setUserDictionary(const UserDictionary* dic) { userDic_ = dic; }
+  bool hasUserDictionary() const { return userDic_ != nullptr; }
+  // Seeds are appended after the ones of the main dictionary.
+  bool spawnUserNodes(const AnalysisInput& input, ExtraNodesContext* xtra,
+                      LatticeBuilder* lattice);
+  const DicLookupCache& cache() const { return cache_; }
 };
 
 }  // namespace analysis
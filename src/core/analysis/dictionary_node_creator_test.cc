@@ -3,6 +3,7 @@
 //
 
 #include "dictionary_node_creator.h"
+#include <tuple>
 #include "core/dic/dic_builder.h"
 #include "core/dic/dictionary.h"
 #include "core/spec/spec_dsl.h"
@@ -23,11 +24,12 @@ class NodeCreatorTestEnv {
   StringField fld;
 
  public:
-  NodeCreatorTestEnv(StringPiece csvData) {
+  NodeCreatorTestEnv(StringPiece csvData, i32 dicCacheSize = 0) {
     tenv.spec([](dsl::ModelSpecBuilder& specBldr) {
       auto& a = specBldr.field(1, "a").strings().trieIndex();
       specBldr.unigram({a});
     });
+    tenv.aconf.dicCacheSize = dicCacheSize;
     tenv.importDic(csvData);
     REQUIRE_OK(tenv.analyzer->output().stringField("a", &fld));
   }
@@ -38,6 +40,18 @@ class NodeCreatorTestEnv {
     CHECK_OK(tenv.analyzer->makeNodeSeedsFromDic());
   }
 
+  // (start, end, entry) triples in the order of creation
+  std::vector<std::tuple<i32, i32, i32>> seeds() {
+    std::vector<std::tuple<i32, i32, i32>> result;
+    for (auto& seed : tenv.analyzer->latticeBuilder().seeds()) {
+      result.emplace_back(seed.codepointStart, seed.codepointEnd,
+                          seed.entryPtr.rawValue());
+    }
+    return result;
+  }
+
+  const DicLookupCache& cache() { return tenv.analyzer->dicNodes().cache(); }
+
   bool exists(StringPiece str, i32 start) {
     CAPTURE(str);
     CAPTURE(start);
@@ -72,6 +86,25 @@ TEST_CASE("it is possible to extract some nodes from input string") {
   CHECK(env.exists("gum", 2));
 }
 
+TEST_CASE("cached lookups produce the same nodes") {
+  StringPiece dic =
+      "of\na\nan\napple\nabout\nargument\narg\ngum\nmug\nrgu\nfme";
+  NodeCreatorTestEnv plain{dic};
+  NodeCreatorTestEnv cached{dic, 16};
+  REQUIRE(cached.cache().enabled());
+  std::vector<StringPiece> inputs = {"argumentofme",  "argumentofme", "mugapple",
+                                     "argumentofmug", "a",            "ab",
+                                     "gumgumgum"};
+  for (auto input : inputs) {
+    CAPTURE(input);
+    plain.analyze(input);
+    cached.analyze(input);
+    CHECK(cached.seeds() == plain.seeds());
+  }
+  CHECK(cached.cache().hits() > 0);
+  CHECK(cached.cache().misses() > 0);
+}
+
 namespace {
 class NodeCreatorTestEnv2 {
   TestEnv tenv;
@@ -4,6 +4,7 @@
 
 #include "extra_nodes.h"
 #include "core/analysis/dic_reader.h"
+#include "core/analysis/user_dictionary.h"
 #include "util/stl_util.h"
 
 namespace jumanpp {
@@ -38,6 +39,21 @@ ExtraNode *ExtraNodesContext::makeAlias() {
   return node;
 }
 
+ExtraNode *ExtraNodesContext::makeUser(const UserDictionary *dic, i32 entry) {
+  auto node = allocateExtra();
+  node->header.type = ExtraNodeType::User;
+  node->header.user.dictionary = dic;
+  node->header.user.entry = entry;
+  auto content = nodeContent(node);
+  util::copy_buffer(dic->features(entry), content);
+  return node;
+}
+
+StringPiece ExtraNodesContext::userString(const ExtraNode *node,
+                                          i32 value) const {
+  return node->header.user.dictionary->stringOf(value);
+}
+
 ExtraNode *ExtraNodesContext::allocateExtra() {
   size_t memory =
       sizeof(ExtraNodeHeader) + sizeof(i32) * (numFields_ + numPlaceholders_);
@@ -16,7 +16,9 @@ namespace jumanpp {
 namespace core {
 namespace analysis {
 
-enum class ExtraNodeType { Invalid, Unknown, Alias, Special };
+enum class ExtraNodeType { Invalid, Unknown, Alias, Special, User };
+
+class UserDictionary;
 
 struct AliasNodeHeader {
   util::ArraySlice<i32> dictionaryNodes;
@@ -28,12 +30,18 @@ struct UnkNodeHeader {
   EntryPtr templatePtr;
 };
 
+struct UserNodeHeader {
+  const UserDictionary* dictionary;
+  i32 entry;
+};
+
 struct ExtraNodeHeader {
   i32 index = std::numeric_limits<i32>::min();
   ExtraNodeType type = ExtraNodeType::Invalid;
   union {
     AliasNodeHeader alias;
     UnkNodeHeader unk;
+    UserNodeHeader user;
   };
 };
 
@@ -54,6 +62,7 @@ class ExtraNodesContext {
   util::FlatMap<StringPiece, i32> stringPtrs_;
 
   ExtraNode* allocateExtra();
+  StringPiece userString(const ExtraNode* node, i32 value) const;
 
  public:
   ExtraNodesContext(util::memory::PoolAlloc* alloc, i32 numFields,
@@ -65,6 +74,7 @@ class ExtraNodesContext {
   ExtraNode* makeZeroedUnk();
   ExtraNode* makeUnk(const DictNode& pat);
   ExtraNode* makeAlias();
+  ExtraNode* makeUser(const UserDictionary* dic, i32 entry);
 
   util::MutableArraySlice<i32> nodeContent(ExtraNode* ptr) const {
     return util::MutableArraySlice<i32>{ptr->content, numFields_};
@@ -74,6 +84,11 @@ class ExtraNodesContext {
     return util::ArraySlice<i32>{ptr->content, numFields_};
   }
 
+  // node content followed by placeholder values
+  util::ArraySlice<i32> nodeData(ExtraNode const* ptr) const {
+    return util::ArraySlice<i32>{ptr->content, numFields_ + numPlaceholders_};
+  }
+
   util::MutableArraySlice<i32> aliasBuffer(ExtraNode* node, size_t numNodes);
 
   const ExtraNode* node(EntryPtr ptr) const {
@@ -86,10 +101,19 @@ class ExtraNodesContext {
     return extraNodes_[idx];
   }
 
-  i32 lengthOf(EntryPtr eptr) const {
+  // string of a negative field value of a node
+  StringPiece stringOf(EntryPtr eptr, i32 value) const {
     JPP_DCHECK(eptr.isSpecial());
+    JPP_DCHECK_LT(value, 0);
     auto n = node(eptr);
-    return static_cast<i32>(n->header.unk.surface.size());
+    if (JPP_UNLIKELY(n->header.type == ExtraNodeType::User)) {
+      return userString(n, value);
+    }
+    return n->header.unk.surface;
+  }
+
+  i32 lengthOf(EntryPtr eptr, i32 value) const {
+    return static_cast<i32>(stringOf(eptr, value).size());
   }
 
   void putPlaceholderData(EntryPtr ptr, i32 idx, i32 value) {
@@ -3,9 +3,15 @@
 //
 
 #include "lattice_builder.h"
+#include <algorithm>
+#include <numeric>
 #include "util/array_slice_util.h"
 #include "util/hashing.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "util/debug_output.h"
 #include "util/logging.hpp"
 
@@ -185,45 +191,56 @@ void LatticeConstructionContext::addEos(LatticeBoundary *lb,
 }
 
 void LatticeCompactor::computeHashes(util::ArraySlice<LatticeNodeSeed> seeds) {
-  entries.clear();
-  entries.resize(seeds.size() * dicEntries.numFeatures());
+  auto numKeys = static_cast<u32>(features.size()) + 1;
+  keyStride = (numKeys + 3) & ~3u;
+  keys.clear();
+  keys.resize(seeds.size() * keyStride, 0);
   hashes.clear();
   hashes.resize(seeds.size());
 
-  util::Sliceable<i32> entryData{&entries, (u32)dicEntries.numFeatures(),
-                                 seeds.size()};
+  util::MutableArraySlice<i32> prefix{&entryPrefix};
   for (int i = 0; i < seeds.size(); ++i) {
     auto &s = seeds[i];
-    auto result = entryData.row(i);
+    auto key = &keys[i * keyStride];
     auto ptr = s.entryPtr;
     if (ptr.isSpecial()) {
-      util::copy_buffer(xtra->nodeContent(xtra->node(ptr)), result);
+      auto content = xtra->nodeContent(xtra->node(ptr));
+      for (int k = 0; k < features.size(); ++k) {
+        key[k] = content[features[k]];
+      }
     } else {
-      dicEntries.entryAtPtr(ptr).fill(result, result.size());
+      // entry data is decoded only up to the last compared feature
+      dicEntries.fillFeatures(ptr, prefix);
+      for (int k = 0; k < features.size(); ++k) {
+        key[k] = prefix[features[k]];
+      }
     }
+    key[numKeys - 1] = s.codepointEnd;
 
-    hashes[i] = util::hashing::hashIndexedSeq(0x23fa23a12, result, features);
+    util::hashing::Hasher hasher{0x23fa23a12};
+    for (u32 k = 0; k < numKeys; ++k) {
+      hasher = hasher.merge(static_cast<u32>(key[k]));
+    }
+    hashes[i] = hasher.result();
   }
 }
 
-class ValueChecker {
-  util::ArraySlice<i32> indices;
-
- public:
-  ValueChecker(const util::ArraySlice<i32> &indices) : indices(indices) {}
-
-  bool valuesEqual(const util::Sliceable<i32> &data, i32 e1, i32 e2) const {
-    auto row1 = data.row(e1);
-    auto row2 = data.row(e2);
-
-    for (auto &idx : indices) {
-      if (row1.at(idx) != row2.at(idx)) {
-        return false;
-      }
+bool LatticeCompactor::keysEqual(i32 e1, i32 e2) const noexcept {
+  auto row1 = keys.data() + e1 * keyStride;
+  auto row2 = keys.data() + e2 * keyStride;
+#ifdef __SSE2__
+  for (u32 i = 0; i < keyStride; i += 4) {
+    auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + i));
+    auto v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row2 + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(v1, v2)) != 0xffff) {
+      return false;
     }
-    return true;
   }
-};
+  return true;
+#else
+  return std::equal(row1, row1 + keyStride, row2);
+#endif
+}
 
 std::ostream &operator<<(std::ostream &os,
                          const core::analysis::LatticeNodeSeed &seed) {
@@ -239,60 +256,84 @@ std::ostream &operator<<(std::ostream &os, const core::EntryPtr &eptr) {
 
 bool LatticeCompactor::compact(
     util::MutableArraySlice<LatticeNodeSeed> *seeds) {
-  processed.clear_no_resize();
-  auto numElems = hashes.size();
+  auto numElems = static_cast<i32>(hashes.size());
   JPP_DCHECK_EQ(seeds->size(), numElems);
-  util::Sliceable<i32> entryData{&entries, (u32)dicEntries.numFeatures(),
-                                 numElems};
-  ValueChecker valueChecker{features};
-  for (int i = 0; i < numElems; ++i) {
-    if (processed.count(i) != 0) {
-      continue;
+  group.clear();
+
+  order.resize(numElems);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](u32 a, u32 b) {
+    return hashes[a] < hashes[b] || (hashes[a] == hashes[b] && a < b);
+  });
+
+  // Groups are linked lists of seeds in the order of their indices,
+  // the first seed of a group (which has the smallest index) stays
+  // in the lattice as an alias of all of them.
+  nextInGroup.assign(numElems, -1);
+  deleted.assign(numElems, 0);
+  bool hasGroups = false;
+  for (i32 begin = 0; begin < numElems;) {
+    auto hash = hashes[order[begin]];
+    auto end = begin + 1;
+    while (end < numElems && hashes[order[end]] == hash) {
+      ++end;
     }
-    group.clear();
-    for (int j = i + 1; j < numElems; ++j) {
-      if (processed.count(j) != 0) {
+    for (i32 i = begin; i < end - 1; ++i) {
+      auto first = order[i];
+      if (deleted[first] != 0) {
         continue;
       }
-      if (hashes[i] == hashes[j] && valueChecker.valuesEqual(entryData, i, j)) {
-        //        LOG_TRACE() << "COMPACT SAME=" << VOut(entryData.row(j))
-        //                    << " SEED=" << seeds->at(j) << " IDX=" << j;
-        group.push_back(j);
-        processed.insert(j);
+      auto last = first;
+      for (i32 j = i + 1; j < end; ++j) {
+        auto other = order[j];
+        if (deleted[other] == 0 && keysEqual(first, other)) {
+          nextInGroup[last] = other;
+          last = other;
+          deleted[other] = 1;
+          hasGroups = true;
+        }
       }
     }
-
-    //    LOG_TRACE() << "COMPACT BASE=" << VOut(entryData.row(i))
-    //                << " SEED=" << seeds->at(i) << " COMPACT=" <<
-    //                !group.empty()
-    //                << " IDX=" << i;
-
-    if (!group.empty()) {
-      auto node = xtra->makeAlias();
-      auto data = xtra->nodeContent(node);
-      util::copy_buffer(entryData.row(i), data);
-      auto buffer = xtra->aliasBuffer(node, group.size() + 1);
-      buffer[0] = seeds->at(i).entryPtr.rawValue();
-      for (int j = 0; j < group.size(); ++j) {
-        buffer[j + 1] = seeds->at(group[j]).entryPtr.rawValue();
-      }
-      seeds->at(i).entryPtr = node->ptr();
-    }
+    begin = end;
   }
 
   // there weren't any combinable nodes
-  if (processed.empty()) {
+  if (!hasGroups) {
     return false;
   }
 
-  group.clear();
-  util::copy_insert(processed, group);
-  util::sort(group);
-  //  LOG_TRACE() << "PRECOMPACT" << VOut(*seeds) << " REMOVE=" << VOut(group)
-  //              << " SIZE=" << seeds->size();
-  util::compact(*seeds, group);
-  //  LOG_TRACE() << "POSTCOMPACT" << VOut(*seeds);
+  for (i32 i = 0; i < numElems; ++i) {
+    if (deleted[i] != 0) {
+      group.push_back(i);
+      continue;
+    }
+    if (nextInGroup[i] == -1) {
+      continue;
+    }
+    size_t groupSize = 1;
+    for (auto j = nextInGroup[i]; j != -1; j = nextInGroup[j]) {
+      ++groupSize;
+    }
+    auto ptr = seeds->at(i).entryPtr;
+    auto node = xtra->makeAlias();
+    auto data = xtra->nodeContent(node);
+    if (ptr.isSpecial()) {
+      util::copy_buffer(xtra->nodeContent(xtra->node(ptr)), data);
+    } else {
+      dicEntries.fillFeatures(ptr, data);
+    }
+    auto buffer = xtra->aliasBuffer(node, groupSize);
+    buffer[0] = ptr.rawValue();
+    size_t idx = 1;
+    for (auto j = nextInGroup[i]; j != -1; j = nextInGroup[j]) {
+      buffer[idx] = seeds->at(j).entryPtr.rawValue();
+      ++idx;
+    }
+    seeds->at(i).entryPtr = node->ptr();
+  }
 
+  totalDeleted_ += group.size();
+  util::compact(*seeds, group);
   return true;
 }
 
@@ -311,6 +352,8 @@ Status LatticeCompactor::initialize(ExtraNodesContext *ctx,
   }
 
   util::sort(features);
+  i32 prefixSize = features.empty() ? 0 : features.back() + 1;
+  entryPrefix.resize(prefixSize);
 
   return Status::Ok();
 }
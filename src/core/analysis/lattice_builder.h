@@ -69,20 +69,32 @@ class LatticeConstructionContext {
  * This class compacts nodes which will have the same
  * feature representation to a single node.
  *
- * Instead of group of original nodes, lattice will have
- * only one Alias extra node.
- *
+ * Nodes starting at a boundary which have the same span and
+ * the same values of features which are used by the scoring model
+ * are replaced by only one Alias extra node.
  * The extra node has the same feature representation,
  * however output needs to unroll it to all nodes.
+ *
+ * Seeds are bucketed by the hash of compared values,
+ * the values are compared only inside a bucket.
  */
 class LatticeCompactor {
   std::vector<i32> features;
   dic::DictionaryEntries dicEntries;
   ExtraNodesContext* xtra;
-  std::vector<i32> entries;
+  // values of compared features and the end of a seed,
+  // rows are padded with zeros to a multiple of 4
+  std::vector<i32> keys;
+  u32 keyStride = 0;
+  std::vector<i32> entryPrefix;
   std::vector<u64> hashes;
+  std::vector<u32> order;
+  std::vector<i32> nextInGroup;
+  std::vector<u8> deleted;
   std::vector<i32> group;
-  util::FlatSet<i32> processed;
+  u64 totalDeleted_ = 0;
+
+  bool keysEqual(i32 e1, i32 e2) const noexcept;
 
  public:
   LatticeCompactor(const dic::DictionaryEntries& dicEntries);
@@ -90,7 +102,10 @@ class LatticeCompactor {
   Status initialize(ExtraNodesContext* ctx, const spec::AnalysisSpec& spec);
   void computeHashes(util::ArraySlice<LatticeNodeSeed> seeds);
   bool compact(util::MutableArraySlice<LatticeNodeSeed>* seeds);
-  i32 numDeleted() const { return processed.size(); }
+  // by the last compaction
+  i32 numDeleted() const { return static_cast<i32>(group.size()); }
+  // by all compactions of this compactor
+  u64 totalDeleted() const { return totalDeleted_; }
 
   util::ArraySlice<i32> usedFeatures() const { return features; }
 };
@@ -107,6 +122,26 @@ class LatticeBuilder {
     seeds_.emplace_back(entryPtr, start, end);
   }
 
+  /**
+   * Removes seeds with indices starting from the passed one
+   * for which the predicate returns true, keeping the order of others.
+   * The predicate is called once for each seed, in order.
+   * Returns the number of removed seeds.
+   */
+  template <typename Pred>
+  size_t removeSeedsIf(size_t from, Pred pred) {
+    auto out = seeds_.begin() + from;
+    for (auto it = out; it != seeds_.end(); ++it) {
+      if (!pred(*it)) {
+        *out = *it;
+        ++out;
+      }
+    }
+    auto removed = static_cast<size_t>(seeds_.end() - out);
+    seeds_.erase(out, seeds_.end());
+    return removed;
+  }
+
   void sortSeeds();
   bool checkConnectability();
   void reset(LatticePosition maxCodepoints);
@@ -40,11 +40,13 @@ class LatticeCompactorTestEnv {
     REQUIRE_OK(tenv.analyzer->initScorers(scfg));
   }
 
-  void analyze(StringPiece str) {
+  u64 analyze(StringPiece str) {
     CAPTURE(str);
     CHECK_OK(tenv.analyzer->resetForInput(str));
     CHECK_OK(tenv.analyzer->prepareNodeSeeds());
+    auto merged = tenv.analyzer->compactNodeSeeds();
     CHECK_OK(tenv.analyzer->buildLattice());
+    return merged;
   }
 
   Lattice* lattice() { return tenv.analyzer->lattice(); }
@@ -73,12 +75,12 @@ class LatticeCompactorTestEnv {
 };
 }  // namespace
 
-// TODO: fixme later, compactor is not used right now
-TEST_CASE("compactor works", "[.]") {
+TEST_CASE("compactor works") {
   LatticeCompactorTestEnv env{
       "KANA,0,x\nすもも,1,x\nすもも,1,y\nもも,2,x\nもも,2,z\nも,3,x\nうち,4,"
       "x\nの,5,x"};
-  env.analyze("すもももももももものうち");
+  // nodes with the same features are already aliases in the dictionary
+  CHECK(env.analyze("すもももももももものうち") == 0);
   CHECK(1 == env.lattice()->boundary(2)->localNodeCount());
   CHECK(2 == env.lattice()->boundary(3)->localNodeCount());
   auto& output = env.output();
@@ -92,4 +94,39 @@ TEST_CASE("compactor works", "[.]") {
   CHECK(walker.next());
   CHECK(env.fldc[walker] == "z");
   CHECK_FALSE(walker.next());
-}
\ No newline at end of file
+}
+
+TEST_CASE("compactor merges nodes with the same span and used features") {
+  TestEnv tenv;
+  tenv.spec([](dsl::ModelSpecBuilder& specBldr) {
+    auto& a = specBldr.field(1, "a").strings().trieIndex();
+    auto& b = specBldr.field(2, "b").strings();
+    specBldr.field(3, "c").strings();
+    specBldr.unk("chunks", 1)
+        .chunking(chars::CharacterClass::KATAKANA)
+        .outputTo({a});
+    specBldr.unk("singles", 2)
+        .single(chars::CharacterClass::KATAKANA)
+        .outputTo({a});
+    specBldr.unigram({b});
+  });
+  tenv.importDic("X,,x\nY,,y\nの,z,x\n");
+  ScorerDef scfg{};
+  scfg.scoreWeights.push_back(1.0f);
+  REQUIRE_OK(tenv.analyzer->initScorers(scfg));
+  CHECK_OK(tenv.analyzer->resetForInput("カナの"));
+  CHECK_OK(tenv.analyzer->prepareNodeSeeds());
+  CHECK(tenv.analyzer->compactNodeSeeds() == 2);
+  CHECK_OK(tenv.analyzer->buildLattice());
+  // カ from chunks and singles differ only in c and are merged, カナ
+  CHECK(tenv.analyzer->lattice()->boundary(2)->localNodeCount() == 2);
+  auto seeds = tenv.analyzer->latticeBuilder().seeds();
+  i32 numErased = 0;
+  for (auto& seed : seeds) {
+    if (seed.codepointStart == seed.codepointEnd) {
+      numErased += 1;
+    }
+  }
+  // カ and ナ
+  CHECK(numErased == 2);
+}
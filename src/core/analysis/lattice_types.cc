@@ -3,6 +3,7 @@
 //
 
 #include "lattice_types.h"
+#include <algorithm>
 #include "util/stl_util.h"
 
 #ifdef __SSE2__
@@ -25,7 +26,10 @@ Status Lattice::makeBoundary(const LatticeBoundaryConfig &lbc,
   return Status::Ok();
 }
 
-void Lattice::reset() { boundaries.clear(); }
+void Lattice::reset() {
+  boundaries.clear();
+  pathEnd_ = 0;
+}
 
 void Lattice::hintSize(u32 size) { boundaries.reserve(size); }
 
@@ -84,6 +88,14 @@ void LatticeBoundaryScores::importBeamScore(i32 left, i32 scorer, i32 beam,
   }
 }
 
+void LatticeBoundaryScores::clearScorers(u32 first) {
+  for (auto data : scores_) {
+    for (u32 i = 0; i < scoresPerItem_; i += numScorers_) {
+      std::fill(data + i + first, data + i + numScorers_, Score{0});
+    }
+  }
+}
+
 LatticeRightBoundary::LatticeRightBoundary(util::memory::PoolAlloc *alloc,
                                            const LatticeConfig &lc,
                                            const LatticeBoundaryConfig &lbc) {
@@ -117,6 +117,9 @@ class LatticeBoundaryScores final {
 
   void importBeamScore(i32 left, i32 scorer, i32 beam,
                        util::ArraySlice<Score> scores);
+
+  // Sets scores of the scorer first and all following ones to zero
+  void clearScorers(u32 first);
 };
 
 class LatticeBoundary {
@@ -162,6 +165,8 @@ class Lattice {
   LatticeConfig lconf;
   util::memory::PoolAlloc* alloc;
   const u64* lastGbeam_;
+  // 0 means that top paths end at EOS
+  u32 pathEnd_ = 0;
 
  public:
   Lattice(const Lattice&) = delete;
@@ -186,6 +191,14 @@ class Lattice {
   void updateConfig(const LatticeConfig& cfg) { lconf = cfg; }
   const u64* lastGbeamRaw() const { return lastGbeam_; }
   void setLastGbeam(const u64* ptr) { lastGbeam_ = ptr; }
+  /**
+   * Top paths (see AnalysisPath) will contain only nodes
+   * which start before the boundary.
+   * This is used to output a prefix of the analyzed input.
+   * Lattice::reset() removes the limit.
+   */
+  void cutPathsAt(u32 boundary) { pathEnd_ = boundary; }
+  u32 pathEnd() const { return pathEnd_; }
 };
 
 }  // namespace analysis
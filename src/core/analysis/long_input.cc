@@ -0,0 +1,189 @@
+#include "long_input.h"
+#include "core/analysis/analyzer_impl.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+namespace {
+
+bool isSentenceEnd(char32_t cp) {
+  switch (cp) {
+    case U'。':
+    case U'．':
+    case U'！':
+    case U'？':
+    case U'!':
+    case U'?':
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+Status LongInputAnalyzer::initialize(Analyzer* analyzer,
+                                     const LongInputConfig& config) {
+  analyzer_ = analyzer;
+  auto maxBytes = analyzer->impl()->cfg().maxInputBytes;
+  maxInputBytes_ = static_cast<u32>(maxBytes);
+  overlap_ = config.overlap;
+  stitchPaths_ = config.stitchPaths;
+  chunkSize_ = config.chunkSize;
+  if (chunkSize_ == 0 && maxBytes > overlap_) {
+    chunkSize_ = static_cast<u32>(maxBytes - overlap_);
+  }
+  if (chunkSize_ < 16) {
+    return JPPS_INVALID_PARAMETER << "chunk size (" << chunkSize_
+                                  << ") must be at least 16 bytes";
+  }
+  if (chunkSize_ + overlap_ > maxBytes) {
+    return JPPS_INVALID_PARAMETER
+           << "chunk size (" << chunkSize_ << ") with overlap (" << overlap_
+           << ") is larger than maximum analyzer input (" << maxBytes << ")";
+  }
+  return Status::Ok();
+}
+
+void LongInputAnalyzer::reset(StringPiece input) {
+  input_ = input;
+  position_ = 0;
+  current_ = EMPTY_SP;
+  started_ = false;
+  numChunks_ = 0;
+}
+
+Status LongInputAnalyzer::analyzeNext() {
+  started_ = true;
+  numChunks_ += 1;
+  auto remaining = input_.size() - position_;
+  if (remaining <= maxInputBytes_) {
+    current_ = input_.from(position_);
+    position_ = input_.size();
+    return analyzer_->analyze(current_);
+  }
+
+  auto windowEnd = std::min(input_.size(), position_ + chunkSize_ + overlap_);
+  // do not cut utf8 sequences
+  while (windowEnd < input_.size() && windowEnd > position_ &&
+         (input_.ubegin()[windowEnd] & 0xc0) == 0x80) {
+    windowEnd -= 1;
+  }
+
+  size_t split = 0;
+  Status s = findSplit(windowEnd, &split);
+  if (!s) {
+    position_ = input_.size();
+    return s;
+  }
+
+  current_ = input_.slice(position_, split);
+  position_ = split;
+  if (pathEnd_ != 0) {
+    // the analyzer already contains the chunk with the overlap
+    analyzer_->impl()->lattice()->cutPathsAt(pathEnd_);
+    return Status::Ok();
+  }
+  return analyzer_->analyze(current_);
+}
+
+Status LongInputAnalyzer::findSplit(size_t windowEnd, size_t* split) {
+  pathEnd_ = 0;
+  codepoints_.clear();
+  JPP_RETURN_IF_ERROR(chars::preprocessRawData(
+      input_.slice(position_, windowEnd), &codepoints_));
+
+  auto limit = position_ + chunkSize_;
+  auto sentence = sentenceEnd(limit);
+  if (sentence > position_ + chunkSize_ / 2) {
+    *split = sentence;
+    return Status::Ok();
+  }
+
+  JPP_RETURN_IF_ERROR(analyzer_->analyze(input_.slice(position_, windowEnd)));
+  u32 pathEnd = 0;
+  auto morpheme = lastMorphemeEnd(limit, &pathEnd);
+  if (morpheme > position_) {
+    *split = morpheme;
+    if (stitchPaths_) {
+      pathEnd_ = pathEnd;
+    }
+    return Status::Ok();
+  }
+
+  return characterClassEnd(limit, split);
+}
+
+size_t LongInputAnalyzer::sentenceEnd(size_t limit) const {
+  size_t result = 0;
+  for (auto& cp : codepoints_) {
+    auto end = static_cast<size_t>(cp.bytes.end() - input_.begin());
+    if (end > limit) {
+      break;
+    }
+    if (isSentenceEnd(cp.codepoint)) {
+      result = end;
+    }
+  }
+  return result;
+}
+
+size_t LongInputAnalyzer::lastMorphemeEnd(size_t limit, u32* pathEnd) {
+  auto impl = analyzer_->impl();
+  auto lattice = impl->lattice();
+  auto& input = impl->input();
+  if (!path_.fillIn(lattice)) {
+    return 0;
+  }
+
+  size_t result = 0;
+  ConnectionPtr ptr;
+  while (path_.nextBoundary()) {
+    if (!path_.nextNode(&ptr)) {
+      break;
+    }
+    auto bnd = lattice->boundary(ptr.boundary);
+    auto& ninfo = bnd->starts()->nodeInfo().at(ptr.right);
+    auto endCp = ptr.boundary - 2 + ninfo.numCodepoints();  // we have 2 BOS
+    auto& last = input.codepoints()[endCp - 1];
+    auto end = static_cast<size_t>(last.bytes.end() - input.surface().begin());
+    end += position_;
+    if (end > limit) {
+      break;
+    }
+    result = end;
+    *pathEnd = static_cast<u32>(endCp + 2);
+  }
+  return result;
+}
+
+Status LongInputAnalyzer::characterClassEnd(size_t limit, size_t* result) {
+  size_t classBoundary = 0;
+  size_t lastBoundary = 0;
+  for (size_t i = 1; i < codepoints_.size(); ++i) {
+    auto& cp = codepoints_[i];
+    auto begin = static_cast<size_t>(cp.bytes.begin() - input_.begin());
+    if (begin > limit) {
+      break;
+    }
+    lastBoundary = begin;
+    if (cp.charClass != codepoints_[i - 1].charClass) {
+      classBoundary = begin;
+    }
+  }
+
+  if (classBoundary > position_) {
+    *result = classBoundary;
+  } else if (lastBoundary > position_) {
+    *result = lastBoundary;
+  } else {
+    return JPPS_INVALID_STATE << "failed to find a split point at "
+                              << position_;
+  }
+  return Status::Ok();
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,103 @@
+#ifndef JUMANPP_LONG_INPUT_H
+#define JUMANPP_LONG_INPUT_H
+
+#include "core/analysis/analysis_result.h"
+#include "core/analysis/analyzer.h"
+#include "util/characters.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+struct LongInputConfig {
+  /**
+   * Inputs longer than this (in bytes) are split into chunks.
+   * 0 means the maximum input size of the analyzer minus the overlap.
+   */
+  u32 chunkSize = 0;
+  /**
+   * When a chunk can not be ended at sentence punctuation,
+   * this number of bytes after the chunk are analyzed as well,
+   * and the chunk is ended at a morpheme boundary of that analysis.
+   */
+  u32 overlap = 256;
+  /**
+   * When a chunk is ended at a morpheme boundary, the analysis
+   * with the overlap is kept and its best path is cut at the boundary
+   * (see Lattice::cutPathsAt) instead of analyzing the chunk again.
+   * Only outputs which use the best path (AnalysisPath) can be
+   * used then.
+   */
+  bool stitchPaths = false;
+};
+
+/**
+ * Raw input which is accepted by the long input mode.
+ * Memory for the analysis is bounded by the analyzer configuration,
+ * not by this value.
+ */
+constexpr size_t MaxLongInputBytes = 64 * 1024 * 1024;
+
+/**
+ * Analyzes inputs which are longer than the analyzer can handle
+ * by splitting them into chunks.
+ *
+ * Chunks end after sentence punctuation if there is some
+ * in the second half of a chunk.
+ * Otherwise a chunk is analyzed with some right context (overlap)
+ * and is ended at the last morpheme boundary of the best path
+ * which is inside the chunk, or at a character class boundary
+ * if the path has no such boundary.
+ * The chunk itself is then analyzed again without the overlap,
+ * or, with LongInputConfig::stitchPaths, the best path of the analysis
+ * with the overlap is cut at the end of the chunk.
+ *
+ * Usage:
+ *   reset(input);
+ *   while (hasNext()) {
+ *     analyzeNext(); // the best path of analyzer now covers current()
+ *   }
+ *
+ * Inputs (and their remaining parts) which are not longer than
+ * the maximum input of the analyzer are analyzed with a single analysis
+ * as usual.
+ */
+class LongInputAnalyzer {
+  Analyzer* analyzer_ = nullptr;
+  u32 maxInputBytes_ = 0;
+  u32 chunkSize_ = 0;
+  u32 overlap_ = 0;
+  bool stitchPaths_ = false;
+  // boundary after the last morpheme of the best path inside the chunk
+  u32 pathEnd_ = 0;
+  StringPiece input_;
+  size_t position_ = 0;
+  StringPiece current_;
+  bool started_ = false;
+  u32 numChunks_ = 0;
+  AnalysisPath path_;
+  std::vector<chars::InputCodepoint> codepoints_;
+
+  Status findSplit(size_t windowEnd, size_t* split);
+  size_t lastMorphemeEnd(size_t limit, u32* pathEnd);
+  size_t sentenceEnd(size_t limit) const;
+  Status characterClassEnd(size_t limit, size_t* result);
+
+ public:
+  Status initialize(Analyzer* analyzer, const LongInputConfig& config);
+  void reset(StringPiece input);
+  bool hasNext() const { return !started_ || position_ < input_.size(); }
+  Status analyzeNext();
+  StringPiece current() const { return current_; }
+  // true if the current chunk is the first one of the input
+  bool isFirst() const { return numChunks_ == 1; }
+  u32 chunkSize() const { return chunkSize_; }
+  // inputs which are not longer than this are not split
+  u32 maxInputBytes() const { return maxInputBytes_; }
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_LONG_INPUT_H
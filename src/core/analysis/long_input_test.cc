@@ -0,0 +1,170 @@
+#include "long_input.h"
+#include "core/analysis/perceptron.h"
+#include "testing/test_analyzer.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core;
+using namespace jumanpp::core::analysis;
+
+namespace {
+
+class LongInputTestEnv {
+  testing::TestEnv tenv;
+  std::unique_ptr<HashedFeaturePerceptron> hfp;
+  ScorerDef sconf;
+
+ public:
+  Analyzer analyzer;
+
+  LongInputTestEnv() {
+    tenv.aconf.maxInputBytes = 64;
+    tenv.spec([](spec::dsl::ModelSpecBuilder& sb) {
+      auto& a = sb.field(1, "a").strings().trieIndex();
+      auto& b = sb.field(2, "b").strings();
+      sb.unigram({a, b});
+    });
+    tenv.importDic("a,x\nb,y\nab,z\nbab,w\n。,p\n");
+    sconf.scoreWeights.push_back(1.0f);
+    static float defaultWeights[] = {0.101f, 0.102f, 0.103f, 0.104f};
+    hfp.reset(new HashedFeaturePerceptron{defaultWeights});
+    sconf.feature = hfp.get();
+    REQUIRE_OK(analyzer.initialize(tenv.analyzer.get(), &sconf));
+  }
+
+  std::vector<std::string> chunks(LongInputAnalyzer* lia, StringPiece input) {
+    std::vector<std::string> result;
+    lia->reset(input);
+    while (lia->hasNext()) {
+      REQUIRE_OK(lia->analyzeNext());
+      CHECK(lia->isFirst() == result.empty());
+      result.push_back(lia->current().str());
+    }
+    return result;
+  }
+};
+
+std::string join(const std::vector<std::string>& parts) {
+  std::string result;
+  for (auto& p : parts) {
+    result += p;
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("long input analyzer does not split short inputs") {
+  LongInputTestEnv env;
+  LongInputAnalyzer lia;
+  REQUIRE_OK(lia.initialize(&env.analyzer, LongInputConfig{0, 16}));
+  auto result = env.chunks(&lia, "abab");
+  REQUIRE(result.size() == 1);
+  CHECK(result[0] == "abab");
+}
+
+TEST_CASE("long input analyzer analyzes empty input once") {
+  LongInputTestEnv env;
+  LongInputAnalyzer lia;
+  REQUIRE_OK(lia.initialize(&env.analyzer, LongInputConfig{32, 16}));
+  auto result = env.chunks(&lia, "");
+  REQUIRE(result.size() == 1);
+  CHECK(result[0].empty());
+}
+
+TEST_CASE("long input analyzer splits after sentence punctuation") {
+  LongInputTestEnv env;
+  LongInputAnalyzer lia;
+  REQUIRE_OK(lia.initialize(&env.analyzer, LongInputConfig{32, 16}));
+  std::string input;
+  for (int i = 0; i < 20; ++i) {
+    input += "ababab。";
+  }
+  auto result = env.chunks(&lia, input);
+  CHECK(result.size() > 1);
+  CHECK(join(result) == input);
+  for (int i = 0; i < result.size() - 1; ++i) {
+    CAPTURE(i);
+    CHECK(result[i].size() <= 32);
+    CHECK(StringPiece{result[i]}.from(result[i].size() - 3) == "。");
+  }
+}
+
+TEST_CASE("long input analyzer splits at morpheme boundaries") {
+  LongInputTestEnv env;
+  LongInputAnalyzer lia;
+  REQUIRE_OK(lia.initialize(&env.analyzer, LongInputConfig{32, 16}));
+  std::string input;
+  for (int i = 0; i < 100; ++i) {
+    input += "bab";
+  }
+  auto result = env.chunks(&lia, input);
+  CHECK(result.size() > 1);
+  CHECK(join(result) == input);
+  for (int i = 0; i < result.size(); ++i) {
+    CAPTURE(i);
+    // the remaining input is analyzed whole when the analyzer accepts it
+    CHECK(result[i].size() <= (i + 1 == result.size() ? 64 : 32));
+    CHECK(result[i].size() > 0);
+  }
+}
+
+TEST_CASE("long input analyzer does not split inputs the analyzer accepts") {
+  LongInputTestEnv env;
+  LongInputAnalyzer lia;
+  REQUIRE_OK(lia.initialize(&env.analyzer, LongInputConfig{0, 16}));
+  REQUIRE(lia.chunkSize() == 48);
+  std::string input;
+  for (int i = 0; i < 20; ++i) {
+    input += "bab";
+  }
+  auto result = env.chunks(&lia, input);
+  REQUIRE(result.size() == 1);
+  CHECK(result[0] == input);
+}
+
+TEST_CASE("long input analyzer stitches paths of the analysis with overlap") {
+  LongInputTestEnv env;
+  LongInputAnalyzer lia;
+  LongInputConfig config{32, 16};
+  config.stitchPaths = true;
+  REQUIRE_OK(lia.initialize(&env.analyzer, config));
+  std::string input;
+  for (int i = 0; i < 100; ++i) {
+    input += "bab";
+  }
+  lia.reset(input);
+  std::string joined;
+  int stitched = 0;
+  AnalysisPath path;
+  while (lia.hasNext()) {
+    REQUIRE_OK(lia.analyzeNext());
+    REQUIRE_OK(path.fillIn(env.analyzer.impl()->lattice()));
+    auto lattice = env.analyzer.impl()->lattice();
+    auto& analyzed = env.analyzer.impl()->input();
+    ConnectionPtr ptr;
+    std::string surface;
+    while (path.nextBoundary()) {
+      REQUIRE(path.nextNode(&ptr));
+      auto bnd = lattice->boundary(ptr.boundary);
+      auto& ninfo = bnd->starts()->nodeInfo().at(ptr.right);
+      for (int i = 0; i < ninfo.numCodepoints(); ++i) {
+        surface += analyzed.codepoints()[ptr.boundary - 2 + i].bytes.str();
+      }
+    }
+    CHECK(surface == lia.current().str());
+    joined += surface;
+    stitched += analyzed.surface().size() > lia.current().size();
+  }
+  CHECK(joined == input);
+  CHECK(stitched > 0);
+}
+
+TEST_CASE("long input analyzer validates the config") {
+  LongInputTestEnv env;
+  LongInputAnalyzer lia;
+  CHECK_FALSE(lia.initialize(&env.analyzer, LongInputConfig{60, 16}));
+  CHECK_FALSE(lia.initialize(&env.analyzer, LongInputConfig{8, 16}));
+  CHECK_FALSE(lia.initialize(&env.analyzer, LongInputConfig{}));
+  CHECK_OK(lia.initialize(&env.analyzer, LongInputConfig{0, 16}));
+  CHECK(lia.chunkSize() == 48);
+}
@@ -16,6 +16,10 @@ bool NormalizedNodeMaker::spawnNodes(const AnalysisInput& input,
                                      UnkNodesContext* ctx,
                                      LatticeBuilder* lattice) const {
   auto& points = input.codepoints();
+  if (!charlattice::CharLattice::mayBeApplicable(points)) {
+    return true;
+  }
+
   charlattice::CharLattice cl{entries_, ctx->alloc()};
   cl.Parse(points);
 
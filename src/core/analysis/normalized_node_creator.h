@@ -32,6 +32,11 @@ class NormalizedNodeMaker : public UnkMaker {
                       UnkNodeConfig&& info_);
   bool spawnNodes(const AnalysisInput& input, UnkNodesContext* ctx,
                   LatticeBuilder* lattice) const override;
+
+  // normalization rules are applied only to these characters
+  chars::CharacterClass triggerClass() const override {
+    return chars::CharacterClass::FAMILY_DOUBLE;
+  }
 };
 
 }  // namespace analysis
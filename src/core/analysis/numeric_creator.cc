@@ -60,45 +60,51 @@ bool NumericUnkMaker::spawnNodes(const AnalysisInput &input,
   using dic::TraverseStatus;
   // Spawn the longest matting node
   auto &codepoints = input.codepoints();
-  for (LatticePosition i = 0; i < codepoints.size(); ++i) {
-    auto trav = entries_.traversal();
-    LatticePosition nextstep = i;
-    TraverseStatus status = TraverseStatus::NoNode;
-
-    auto length = FindLongestNumber(codepoints, i);  // returns character length
-    bool nonode = false;
-    if (length > 0) {
-      for (; nextstep < i + length; ++nextstep) {
-        status = trav.step(codepoints[nextstep].bytes);
-        if (status == TraverseStatus::NoNode) {
-          nonode = true;
+  auto trigger = triggerClass();
+  for (auto &run : input.classRuns()) {
+    if (!chars::IsCompatibleCharClass(run.charClass, trigger)) {
+      continue;
+    }
+    for (auto i = static_cast<LatticePosition>(run.start); i < run.end; ++i) {
+      auto trav = entries_.traversal();
+      LatticePosition nextstep = i;
+      TraverseStatus status = TraverseStatus::NoNode;
+
+      auto length = FindLongestNumber(codepoints, i);  // returns character length
+      bool nonode = false;
+      if (length > 0) {
+        for (; nextstep < i + length; ++nextstep) {
+          status = trav.step(codepoints[nextstep]);
+          if (status == TraverseStatus::NoNode) {
+            nonode = true;
+          }
         }
-      }
 
-      if (nonode) status = TraverseStatus::NoNode;
+        if (nonode) status = TraverseStatus::NoNode;
 
-      switch (status) {
-        case TraverseStatus::NoNode: {  // 同一表層のノード無し prefix でもない
-          LatticePosition start = i;
-          LatticePosition end = i + length;
-          auto ptr = ctx->makePtr(input.surface(start, end), info_, true);
-          lattice->appendSeed(ptr, start, end);
-          break;
-        }
-        case TraverseStatus::NoLeaf: {  // 先端
-          LatticePosition start = i;
-          LatticePosition end = i + length;
-          auto ptr = ctx->makePtr(input.surface(start, end), info_, false);
-          lattice->appendSeed(ptr, start, end);
-          break;
-        }
-        case TraverseStatus::Ok:
-          LatticePosition start = i;
-          LatticePosition end = i + length;
-          if (!ctx->dicPatternMatches(info_, trav.entries())) {
+        switch (status) {
+          case TraverseStatus::NoNode: {  // 同一表層のノード無し prefix でもない
+            LatticePosition start = i;
+            LatticePosition end = i + length;
+            auto ptr = ctx->makePtr(input.surface(start, end), info_, true);
+            lattice->appendSeed(ptr, start, end);
+            break;
+          }
+          case TraverseStatus::NoLeaf: {  // 先端
+            LatticePosition start = i;
+            LatticePosition end = i + length;
             auto ptr = ctx->makePtr(input.surface(start, end), info_, false);
             lattice->appendSeed(ptr, start, end);
+            break;
           }
+          case TraverseStatus::Ok:
+            LatticePosition start = i;
+            LatticePosition end = i + length;
+            if (!ctx->dicPatternMatches(info_, trav.entries())) {
+              auto ptr = ctx->makePtr(input.surface(start, end), info_, false);
+              lattice->appendSeed(ptr, start, end);
+            }
+        }
       }
     }
   }
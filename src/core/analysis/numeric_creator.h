@@ -69,6 +69,11 @@ class NumericUnkMaker : public UnkMaker {
   bool spawnNodes(const AnalysisInput &input, UnkNodesContext *ctx,
                   LatticeBuilder *lattice) const override;
 
+  // numbers can also start with a prefix like 数
+  chars::CharacterClass triggerClass() const override {
+    return charClass_ | chars::CharacterClass::FIGURE_EXCEPTION;
+  }
+
   LatticePosition FindLongestNumber(const CodepointStorage &codepoints,
                                     LatticePosition start) const;
 };
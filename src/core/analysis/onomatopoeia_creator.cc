@@ -18,37 +18,42 @@ bool OnomatopoeiaUnkMaker::spawnNodes(const AnalysisInput& input,
                                       LatticeBuilder* lattice) const {
   using dic::TraverseStatus;
   auto& codepoints = input.codepoints();
-  for (LatticePosition i = 0; i < codepoints.size(); ++i) {
-    auto trav = entries_.traversal();
-    LatticePosition nextstep = i;
-    TraverseStatus status;
-    auto pattern = FindOnomatopoeia(codepoints, i);
-    if (pattern == Pattern::None) {
+  for (auto& run : input.classRuns()) {
+    if (!chars::IsCompatibleCharClass(run.charClass, charClass_)) {
       continue;
     }
-    for (LatticePosition halfLen = 2; halfLen * 2 <= MaxOnomatopoeiaLength;
-         ++halfLen) {
-      if ((pattern & HalfLenToPattern(halfLen)) != Pattern::None) {
-        for (; nextstep < i + halfLen * 2; ++nextstep) {
-          status = trav.step(codepoints[nextstep].bytes);
-        }
-        switch (status) {
-          case TraverseStatus::NoNode: {
-            LatticePosition start = i;
-            LatticePosition end = i + halfLen * LatticePosition(2);
-            auto ptr = ctx->makePtr(input.surface(start, end), info_, true);
-            lattice->appendSeed(ptr, start, end);
-            break;
+    for (auto i = static_cast<LatticePosition>(run.start); i < run.end; ++i) {
+      auto trav = entries_.traversal();
+      LatticePosition nextstep = i;
+      TraverseStatus status;
+      auto pattern = FindOnomatopoeia(codepoints, i);
+      if (pattern == Pattern::None) {
+        continue;
+      }
+      for (LatticePosition halfLen = 2; halfLen * 2 <= MaxOnomatopoeiaLength;
+           ++halfLen) {
+        if ((pattern & HalfLenToPattern(halfLen)) != Pattern::None) {
+          for (; nextstep < i + halfLen * 2; ++nextstep) {
+            status = trav.step(codepoints[nextstep]);
           }
-          case TraverseStatus::NoLeaf: {
-            LatticePosition start = i;
-            LatticePosition end = i + halfLen * LatticePosition(2);
-            auto ptr = ctx->makePtr(input.surface(start, end), info_, false);
-            lattice->appendSeed(ptr, start, end);
-            break;
+          switch (status) {
+            case TraverseStatus::NoNode: {
+              LatticePosition start = i;
+              LatticePosition end = i + halfLen * LatticePosition(2);
+              auto ptr = ctx->makePtr(input.surface(start, end), info_, true);
+              lattice->appendSeed(ptr, start, end);
+              break;
+            }
+            case TraverseStatus::NoLeaf: {
+              LatticePosition start = i;
+              LatticePosition end = i + halfLen * LatticePosition(2);
+              auto ptr = ctx->makePtr(input.surface(start, end), info_, false);
+              lattice->appendSeed(ptr, start, end);
+              break;
+            }
+            case TraverseStatus::Ok:
+              continue;
           }
-          case TraverseStatus::Ok:
-            continue;
         }
       }
     }
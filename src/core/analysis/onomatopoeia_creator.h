@@ -55,6 +55,8 @@ class OnomatopoeiaUnkMaker : public UnkMaker {
   bool spawnNodes(const AnalysisInput& input, UnkNodesContext* ctx,
                   LatticeBuilder* lattice) const override;
 
+  chars::CharacterClass triggerClass() const override { return charClass_; }
+
   Pattern FindOnomatopoeia(const CodepointStorage& codepoints,
                            LatticePosition start) const;
 };
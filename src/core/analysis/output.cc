@@ -5,6 +5,7 @@
 #include "output.h"
 #include "core/analysis/extra_nodes.h"
 #include "core/analysis/lattice_types.h"
+#include "core/analysis/user_dictionary.h"
 
 namespace jumanpp {
 namespace core {
@@ -102,6 +103,13 @@ bool OutputManager::locate(EntryPtr ptr, NodeWalker *result) const {
       return true;
     }
 
+    if (node->header.type == ExtraNodeType::User) {
+      auto& user = node->header.user;
+      result->buffer_.fillFromValues(xtra_->nodeContent(node),
+                                     user.dictionary->data(user.entry));
+      return true;
+    }
+
   } else {
     result->buffer_.fillFromStorage(result->current_,
                                     this->entries_.entryData());
@@ -129,7 +137,7 @@ StringPiece StringField::operator[](const NodeWalker &node) const {
   if (node.valueOf(index_, &value)) {
     if (value < 0) {
       auto xtra = node.mgr_->xtra_;
-      return xtra->node(node.eptr())->header.unk.surface;
+      return xtra->stringOf(node.eptr(), value);
     }
     StringPiece result;
     if (reader_.value().readAt(value, &result)) {
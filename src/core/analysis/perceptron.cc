@@ -3,6 +3,8 @@
 //
 
 #include "core/analysis/perceptron.h"
+#include <algorithm>
+#include <cmath>
 #include "core/analysis/lattice_types.h"
 #include "core/impl/perceptron_io.h"
 #include "util/logging.hpp"
@@ -17,7 +19,13 @@ void HashedFeaturePerceptron::compute(util::MutableArraySlice<float> result,
                                       util::ConstSliceable<u32> ngrams) const {
   auto weightobj = weights();
   JPP_DCHECK(util::memory::IsPowerOf2(weightobj.size()));
+  JPP_DCHECK_LE(ngrams.numRows(), result.size());
   u32 mask = static_cast<u32>(weightobj.size() - 1);
+  auto floats = weightobj.floats();
+  if (floats != nullptr) {
+    rows_(floats, mask, ngrams, nullptr, result.data());
+    return;
+  }
   for (int i = 0; i < ngrams.numRows(); ++i) {
     result.at(i) =
         impl::computeUnrolled4Perceptron(weightobj, ngrams.row(i), mask);
@@ -30,7 +38,13 @@ void HashedFeaturePerceptron::add(util::ArraySlice<float> source,
   JPP_DCHECK_EQ(source.size(), result.size());
   auto weightobj = weights();
   JPP_DCHECK(util::memory::IsPowerOf2(weightobj.size()));
+  JPP_DCHECK_LE(ngrams.numRows(), result.size());
   u32 mask = static_cast<u32>(weightobj.size() - 1);
+  auto floats = weightobj.floats();
+  if (floats != nullptr) {
+    rows_(floats, mask, ngrams, source.data(), result.data());
+    return;
+  }
   auto total = ngrams.numRows();
   for (int i = 0; i < total; ++i) {
     auto src = source.at(i);
@@ -39,28 +53,125 @@ void HashedFeaturePerceptron::add(util::ArraySlice<float> source,
   }
 }
 
-const size_t TWO_MEGS_FOR_FLOATS = 2 * 1024 * 1024 / sizeof(float);
+const size_t TWO_MEGS = 2 * 1024 * 1024;
 struct PerceptronState {
   util::memory::Manager manager_;
   std::unique_ptr<util::memory::PoolAlloc> alloc_;
-  size_t numElems_;
-  FloatBufferWeights weights_;
-
-  PerceptronState(size_t numElems)
-      : manager_{std::max(numElems * sizeof(float), TWO_MEGS_FOR_FLOATS)},
-        alloc_{manager_.core()},
-        numElems_{numElems},
-        weights_{{}} {}
-
-  const float* importDoubles(const float* data) {
-    auto objs = numElems_;
-    auto arr = alloc_->allocateArray<float>(objs);
-    memcpy(arr, data, objs * sizeof(float));
-    weights_ = {{arr, objs}};
+  WeightBuffer weights_;
+
+  PerceptronState(size_t numBytes)
+      : manager_{std::max(numBytes, TWO_MEGS)}, alloc_{manager_.core()} {}
+
+  template <typename T>
+  const T* import(StringPiece data) {
+    auto objs = data.size() / sizeof(T);
+    auto arr = alloc_->allocateArray<T>(objs);
+    memcpy(arr, data.begin(), objs * sizeof(T));
     return arr;
   }
 };
 
+namespace {
+
+Status loadQuantization(const model::ModelPart& part, size_t dataSize,
+                        const PerceptronQuantization* pq,
+                        util::ArraySlice<util::LinearQuantParams>* blocks) {
+  auto encoding = static_cast<util::WeightEncoding>(pq->encoding);
+  if (encoding != util::WeightEncoding::Linear8 &&
+      encoding != util::WeightEncoding::Linear16) {
+    return Status::InvalidState()
+           << "perceptron: unsupported weight encoding " << pq->encoding;
+  }
+
+  if (pq->blockExponent >= 64) {
+    return Status::InvalidState()
+           << "perceptron: block exponent must be lesser than 64";
+  }
+
+  if (part.data[1].size() != dataSize << util::weightCodeShift(encoding)) {
+    return Status::InvalidState()
+           << "perceptron: slice size was not equal to model size in header";
+  }
+
+  auto numBlocks = ((dataSize - 1) >> pq->blockExponent) + 1;
+  auto blockData = part.data[3];
+  if (blockData.size() != numBlocks * sizeof(util::LinearQuantParams)) {
+    return Status::InvalidState()
+           << "perceptron: quantization block parameters had size "
+           << blockData.size() << ", expected " << numBlocks << " blocks";
+  }
+  *blocks = util::ArraySlice<util::LinearQuantParams>{
+      reinterpret_cast<const util::LinearQuantParams*>(blockData.begin()),
+      numBlocks};
+  return Status::Ok();
+}
+
+Status checkSparseWords(const model::ModelPart& part, size_t dataSize,
+                        util::ArraySlice<SparseWeightWord>* words) {
+  auto numWords = (dataSize + 63) / 64;
+  auto wordData = part.data[3];
+  if (wordData.size() != numWords * sizeof(SparseWeightWord)) {
+    return Status::InvalidState()
+           << "perceptron: sparse weight bitmap had size " << wordData.size()
+           << ", expected " << numWords << " words";
+  }
+  *words = util::ArraySlice<SparseWeightWord>{
+      reinterpret_cast<const SparseWeightWord*>(wordData.begin()), numWords};
+
+  // values start with a zero for weights which are not stored
+  u64 rank = 1;
+  for (size_t i = 0; i < numWords; ++i) {
+    auto& word = (*words)[i];
+    if (word.rank != rank) {
+      return Status::InvalidState()
+             << "perceptron: sparse weight bitmap had invalid rank in word #"
+             << i;
+    }
+    rank += util::popCount(word.bits);
+  }
+  if (dataSize < 64 && ((*words)[0].bits >> dataSize) != 0) {
+    return Status::InvalidState()
+           << "perceptron: sparse weight bitmap had bits outside of the table";
+  }
+
+  if (part.data[1].size() != rank * sizeof(float)) {
+    return Status::InvalidState()
+           << "perceptron: sparse weights had " << part.data[1].size()
+           << " bytes of values for " << rank - 1 << " stored weights";
+  }
+  float first;
+  memcpy(&first, part.data[1].begin(), sizeof(float));
+  if (first != 0) {
+    return Status::InvalidState()
+           << "perceptron: sparse weight values must start with a zero";
+  }
+  return Status::Ok();
+}
+
+Status checkHotSlots(StringPiece slotData, size_t dataSize,
+                     util::ArraySlice<u32>* slots) {
+  auto numHot = slotData.size() / sizeof(u32);
+  if (numHot * sizeof(u32) != slotData.size() ||
+      !util::memory::IsPowerOf2(numHot) || numHot > dataSize / 2) {
+    return Status::InvalidState()
+           << "perceptron: hot slot table had invalid size "
+           << slotData.size();
+  }
+  *slots = util::ArraySlice<u32>{
+      reinterpret_cast<const u32*>(slotData.begin()), numHot};
+  auto mask = numHot - 1;
+  for (size_t i = 0; i < numHot; ++i) {
+    auto slot = (*slots)[i];
+    if (slot >= dataSize || (slot & mask) != i) {
+      return Status::InvalidState() << "perceptron: hot slot #" << i
+                                    << " had invalid value " << slot;
+    }
+  }
+  return Status::Ok();
+}
+
+}  // namespace
+
 Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
   const model::ModelPart* savedPerc = nullptr;
   for (auto& part : model.parts) {
@@ -75,9 +186,9 @@ Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
            << "perceptron: saved model did not have perceptron attached";
   }
 
-  if (savedPerc->data.size() != 2) {
+  if (savedPerc->data.size() < 2 || savedPerc->data.size() > 4) {
     return Status::InvalidState()
-           << "perceptron: saved model did not have exactly two parts";
+           << "perceptron: saved model did not have two to four parts";
   }
 
   auto& data = savedPerc->data;
@@ -103,6 +214,41 @@ Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
 
   StringPiece modelData = data[1];
 
+  if (data.size() == 4) {
+    util::serialization::Loader encodingLdr{data[2]};
+    PerceptronQuantization pq{};
+    if (!encodingLdr.load(&pq)) {
+      return Status::InvalidState()
+             << "perceptron: failed to load quantization information";
+    }
+    auto encoding = static_cast<util::WeightEncoding>(pq.encoding);
+
+    if (encoding == util::WeightEncoding::SparseFloat32) {
+      util::ArraySlice<SparseWeightWord> words;
+      JPP_RETURN_IF_ERROR(checkSparseWords(*savedPerc, dataSize, &words));
+      auto values = reinterpret_cast<const float*>(modelData.begin());
+      auto wordData = words.data();
+      state_.reset(new PerceptronState{modelData.size() + data[3].size()});
+      if (util::memory::Manager::supportHugePages()) {
+        values = state_->import<float>(modelData);
+        wordData = state_->import<SparseWeightWord>(data[3]);
+      }
+      state_->weights_ = WeightBuffer{values, wordData, dataSize};
+      return Status::Ok();
+    }
+
+    util::ArraySlice<util::LinearQuantParams> blocks;
+    JPP_RETURN_IF_ERROR(loadQuantization(*savedPerc, dataSize, &pq, &blocks));
+    auto codes = modelData.begin();
+    state_.reset(new PerceptronState{modelData.size()});
+    if (util::memory::Manager::supportHugePages()) {
+      codes = state_->import<char>(modelData);
+    }
+    state_->weights_ =
+        WeightBuffer{encoding, codes, dataSize, pq.blockExponent, blocks.data()};
+    return Status::Ok();
+  }
+
   auto weightCount = modelData.size() / sizeof(float);
 
   if (weightCount != dataSize) {
@@ -112,42 +258,278 @@ Status HashedFeaturePerceptron::load(const model::ModelInfo& model) {
 
   auto weightData = reinterpret_cast<const float*>(modelData.begin());
 
-  state_.reset(new PerceptronState{weightCount});
+  util::ArraySlice<u32> hotSlots;
+  if (data.size() == 3) {
+    JPP_RETURN_IF_ERROR(checkHotSlots(data[2], dataSize, &hotSlots));
+  }
+
+  state_.reset(new PerceptronState{modelData.size()});
   if (util::memory::Manager::supportHugePages()) {
-    state_->importDoubles(weightData);
-  } else {
-    util::ArraySlice<float> weightSlice{weightData, dataSize};
-    state_->weights_ = weightSlice;
+    weightData = state_->import<float>(modelData);
+  }
+  util::ArraySlice<float> weights{weightData, dataSize};
+
+  if (hotSlots.size() == 0) {
+    state_->weights_ = weights;
+    return Status::Ok();
   }
 
+  // the cold table is the full one, it gets huge pages with the import
+  auto hot = state_->alloc_->allocateArray<HotWeight>(hotSlots.size(), 64);
+  for (size_t i = 0; i < hotSlots.size(); ++i) {
+    auto slot = hotSlots[i];
+    hot[i] = HotWeight{slot, weights[slot]};
+  }
+  state_->weights_ =
+      WeightBuffer{weights, hot, static_cast<u32>(hotSlots.size())};
   return Status::Ok();
 }
 
 HashedFeaturePerceptron::HashedFeaturePerceptron(
     const util::ArraySlice<float>& weights)
-    : state_{new PerceptronState{weights.size()}} {
+    : state_{new PerceptronState{weights.size() * sizeof(float)}},
+      rows_{impl::perceptronRowsKernel(impl::bestPerceptronKernel())} {
   state_->weights_ = {weights};
 }
 
-HashedFeaturePerceptron::HashedFeaturePerceptron() = default;
+HashedFeaturePerceptron::HashedFeaturePerceptron()
+    : rows_{impl::perceptronRowsKernel(impl::bestPerceptronKernel())} {}
 HashedFeaturePerceptron::~HashedFeaturePerceptron() = default;
 
 const WeightBuffer& HashedFeaturePerceptron::weights() const {
-#if 0
-  const char* data = reinterpret_cast<const char*>(weights_.data());
-  size_t sz = weights_.size();
-  float min = -1;
-  float step = 0.1;
-  return WeightBuffer{data, sz, min, step};
-#endif
   return state_->weights_;
 }
 
 void HashedFeaturePerceptron::setWeightsTo(util::ArraySlice<float> weights) {
-  state_.reset(new PerceptronState{weights.size()});
+  state_.reset(new PerceptronState{weights.size() * sizeof(float)});
   state_->weights_ = {weights};
 }
 
+Status HashedFeaturePerceptron::setKernel(PerceptronKernel kernel) {
+  auto rows = impl::perceptronRowsKernel(kernel);
+  if (rows == nullptr) {
+    return JPPS_INVALID_PARAMETER
+           << "perceptron kernel " << impl::perceptronKernelName(kernel)
+           << " is not supported by this CPU";
+  }
+  rows_ = rows;
+  return Status::Ok();
+}
+
+Status PerceptronQuantizer::quantize(util::ArraySlice<float> weights,
+                                     util::WeightEncoding encoding,
+                                     u32 blockExponent) {
+  if (!util::memory::IsPowerOf2(weights.size())) {
+    return JPPS_INVALID_PARAMETER << "number of weights must be a power of 2";
+  }
+  u32 sizeExponent = 0;
+  while ((size_t{1} << sizeExponent) < weights.size()) {
+    ++sizeExponent;
+  }
+  if (blockExponent == 0 || blockExponent > sizeExponent) {
+    blockExponent = sizeExponent;
+  }
+
+  u32 levels;
+  switch (encoding) {
+    case util::WeightEncoding::Linear8:
+      levels = 1u << 8;
+      break;
+    case util::WeightEncoding::Linear16:
+      levels = 1u << 16;
+      break;
+    default:
+      return JPPS_INVALID_PARAMETER << "weights can be quantized only to 8 or "
+                                       "16 bits";
+  }
+
+  auto codeShift = util::weightCodeShift(encoding);
+  codes_.assign(weights.size() << codeShift, 0);
+  blocks_.clear();
+  auto blockSize = size_t{1} << blockExponent;
+  for (size_t start = 0; start < weights.size(); start += blockSize) {
+    util::ArraySlice<float> block{weights, start, blockSize};
+    auto params = util::computeLinearQuantization(block, levels);
+    blocks_.push_back(params);
+    for (size_t i = start; i < start + blockSize; ++i) {
+      auto code = util::quantizeLinear(weights[i], params, levels);
+      if (encoding == util::WeightEncoding::Linear8) {
+        codes_[i] = static_cast<char>(code);
+      } else {
+        // u16 is signed
+        auto value = static_cast<std::uint16_t>(code);
+        memcpy(&codes_[i * sizeof(value)], &value, sizeof(value));
+      }
+    }
+  }
+
+  info_.reset();
+  util::serialization::Saver infoSaver{&info_};
+  PerceptronInfo pi{static_cast<i32>(sizeExponent)};
+  infoSaver.save(pi);
+
+  quantInfo_.reset();
+  util::serialization::Saver quantSaver{&quantInfo_};
+  PerceptronQuantization pq{static_cast<u32>(encoding), blockExponent};
+  quantSaver.save(pq);
+
+  weights_ = WeightBuffer{encoding, codes_.data(), weights.size(),
+                          blockExponent, blocks_.data()};
+  return Status::Ok();
+}
+
+void PerceptronQuantizer::fillModelPart(model::ModelPart* part) const {
+  part->kind = model::ModelPartKind::Perceprton;
+  part->data.clear();
+  part->data.push_back(info_.contents());
+  part->data.push_back(StringPiece{codes_.data(), codes_.size()});
+  part->data.push_back(quantInfo_.contents());
+  auto blockMem = reinterpret_cast<const char*>(blocks_.data());
+  part->data.push_back(StringPiece{
+      blockMem, blockMem + blocks_.size() * sizeof(util::LinearQuantParams)});
+}
+
+Status HotWeightSelector::select(util::ArraySlice<float> weights,
+                                 util::ArraySlice<u32> accessCounts,
+                                 u32 hotExponent) {
+  if (!util::memory::IsPowerOf2(weights.size())) {
+    return JPPS_INVALID_PARAMETER << "number of weights must be a power of 2";
+  }
+  if (accessCounts.size() != weights.size()) {
+    return JPPS_INVALID_PARAMETER << "there were " << accessCounts.size()
+                                  << " access counts for " << weights.size()
+                                  << " weights";
+  }
+  u32 sizeExponent = 0;
+  while ((size_t{1} << sizeExponent) < weights.size()) {
+    ++sizeExponent;
+  }
+  if (hotExponent == 0 || hotExponent >= sizeExponent) {
+    return JPPS_INVALID_PARAMETER << "hot table size exponent must be in [1, "
+                                  << sizeExponent << "), was " << hotExponent;
+  }
+
+  std::vector<u32> used;
+  totalAccesses_ = 0;
+  for (u32 slot = 0; slot < accessCounts.size(); ++slot) {
+    if (accessCounts[slot] != 0) {
+      used.push_back(slot);
+      totalAccesses_ += accessCounts[slot];
+    }
+  }
+  usedSlots_ = used.size();
+  std::stable_sort(used.begin(), used.end(), [&](u32 a, u32 b) {
+    return accessCounts[a] > accessCounts[b];
+  });
+
+  auto numHot = u32{1} << hotExponent;
+  auto mask = numHot - 1;
+  slots_.resize(numHot);
+  for (u32 i = 0; i < numHot; ++i) {
+    slots_[i] = i;
+  }
+  std::vector<bool> taken(numHot, false);
+  for (auto slot : used) {
+    auto pos = slot & mask;
+    if (!taken[pos]) {
+      taken[pos] = true;
+      slots_[pos] = slot;
+    }
+  }
+
+  hot_.resize(numHot);
+  hotAccesses_ = 0;
+  for (u32 i = 0; i < numHot; ++i) {
+    auto slot = slots_[i];
+    hot_[i] = HotWeight{slot, weights[slot]};
+    hotAccesses_ += accessCounts[slot];
+  }
+  weights_ = weights;
+
+  info_.reset();
+  util::serialization::Saver infoSaver{&info_};
+  PerceptronInfo pi{static_cast<i32>(sizeExponent)};
+  infoSaver.save(pi);
+  return Status::Ok();
+}
+
+void HotWeightSelector::fillModelPart(model::ModelPart* part) const {
+  part->kind = model::ModelPartKind::Perceprton;
+  part->data.clear();
+  part->data.push_back(info_.contents());
+  auto weightMem = reinterpret_cast<const char*>(weights_.data());
+  part->data.push_back(
+      StringPiece{weightMem, weightMem + weights_.size() * sizeof(float)});
+  auto slotMem = reinterpret_cast<const char*>(slots_.data());
+  part->data.push_back(
+      StringPiece{slotMem, slotMem + slots_.size() * sizeof(u32)});
+}
+
+WeightBuffer HotWeightSelector::weights() const {
+  return WeightBuffer{weights_, hot_.data(), static_cast<u32>(hot_.size())};
+}
+
+Status PerceptronPruner::prune(util::ArraySlice<float> weights,
+                               float threshold) {
+  if (!util::memory::IsPowerOf2(weights.size())) {
+    return JPPS_INVALID_PARAMETER << "number of weights must be a power of 2";
+  }
+  if (!(threshold >= 0)) {
+    return JPPS_INVALID_PARAMETER << "pruning threshold must not be negative";
+  }
+  u32 sizeExponent = 0;
+  while ((size_t{1} << sizeExponent) < weights.size()) {
+    ++sizeExponent;
+  }
+
+  values_.assign(1, 0.0f);
+  words_.assign((weights.size() + 63) / 64, SparseWeightWord{0, 0});
+  for (size_t i = 0; i < words_.size(); ++i) {
+    auto& word = words_[i];
+    word.rank = values_.size();
+    auto end = std::min(weights.size(), i * 64 + 64);
+    for (size_t idx = i * 64; idx < end; ++idx) {
+      auto value = weights[idx];
+      if (std::abs(value) <= threshold) {
+        continue;
+      }
+      word.bits |= u64{1} << (idx & 63);
+      values_.push_back(value);
+    }
+  }
+  if (values_.size() == 1) {
+    return JPPS_INVALID_PARAMETER << "pruning threshold " << threshold
+                                  << " drops all weights";
+  }
+
+  info_.reset();
+  util::serialization::Saver infoSaver{&info_};
+  PerceptronInfo pi{static_cast<i32>(sizeExponent)};
+  infoSaver.save(pi);
+
+  encodingInfo_.reset();
+  util::serialization::Saver encodingSaver{&encodingInfo_};
+  PerceptronQuantization pq{
+      static_cast<u32>(util::WeightEncoding::SparseFloat32), 0};
+  encodingSaver.save(pq);
+
+  weights_ = WeightBuffer{values_.data(), words_.data(), weights.size()};
+  return Status::Ok();
+}
+
+void PerceptronPruner::fillModelPart(model::ModelPart* part) const {
+  part->kind = model::ModelPartKind::Perceprton;
+  part->data.clear();
+  part->data.push_back(info_.contents());
+  auto valueMem = reinterpret_cast<const char*>(values_.data());
+  part->data.push_back(
+      StringPiece{valueMem, valueMem + values_.size() * sizeof(float)});
+  part->data.push_back(encodingInfo_.contents());
+  auto wordMem = reinterpret_cast<const char*>(words_.data());
+  part->data.push_back(StringPiece{
+      wordMem, wordMem + words_.size() * sizeof(SparseWeightWord)});
+}
+
 }  // namespace analysis
 }  // namespace core
-}  // namespace jumanpp
\ No newline at end of file
+}  // namespace jumanpp
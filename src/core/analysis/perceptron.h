@@ -5,7 +5,10 @@
 #ifndef JUMANPP_PERCEPTRON_H
 #define JUMANPP_PERCEPTRON_H
 
+#include <vector>
+#include "perceptron_kernels.h"
 #include "score_api.h"
+#include "util/coded_io.h"
 
 namespace jumanpp {
 namespace core {
@@ -75,6 +78,7 @@ struct PerceptronState;
 
 class HashedFeaturePerceptron : public FeatureScorer {
   std::unique_ptr<PerceptronState> state_;
+  impl::PerceptronRowsFn rows_;
 
  public:
   HashedFeaturePerceptron();
@@ -90,9 +94,89 @@ class HashedFeaturePerceptron : public FeatureScorer {
 
   void setWeightsTo(util::ArraySlice<float> weights);
 
+  // The fastest kernel supported by the CPU is used by default.
+  // Vector kernels can differ from the scalar one in the last bits,
+  // force the scalar kernel for scores which do not depend on the machine.
+  Status setKernel(PerceptronKernel kernel);
+
   const WeightBuffer& weights() const override;
 };
 
+/**
+ * Quantizes linear model weights into a perceptron model part,
+ * which HashedFeaturePerceptron::load reads.
+ * Chunks of the part point to the memory of the quantizer.
+ */
+class PerceptronQuantizer {
+  util::CodedBuffer info_;
+  util::CodedBuffer quantInfo_;
+  std::vector<char> codes_;
+  std::vector<util::LinearQuantParams> blocks_;
+  WeightBuffer weights_;
+
+ public:
+  // Blocks have 2^blockExponent weights, 0 means a single block
+  Status quantize(util::ArraySlice<float> weights,
+                  util::WeightEncoding encoding, u32 blockExponent);
+  void fillModelPart(model::ModelPart* part) const;
+  const WeightBuffer& weights() const { return weights_; }
+};
+
+/**
+ * Drops small linear model weights and stores the rest sparsely
+ * in a perceptron model part, which HashedFeaturePerceptron::load reads.
+ * Dropped weights become zero.
+ * Chunks of the part point to the memory of the pruner.
+ */
+class PerceptronPruner {
+  util::CodedBuffer info_;
+  util::CodedBuffer encodingInfo_;
+  std::vector<float> values_;
+  std::vector<SparseWeightWord> words_;
+  WeightBuffer weights_;
+
+ public:
+  // Weights with absolute values not greater than the threshold are dropped,
+  // so zero weights are always dropped
+  Status prune(util::ArraySlice<float> weights, float threshold);
+  void fillModelPart(model::ModelPart* part) const;
+  const WeightBuffer& weights() const { return weights_; }
+  size_t numStored() const {
+    return values_.empty() ? 0 : values_.size() - 1;
+  }
+};
+
+/**
+ * Selects slots for the hot table of float weights.
+ * Slots are placed greedily by the number of accesses:
+ * a slot which conflicts with a more frequent one stays cold.
+ * Positions which do not get a frequent slot hold their own slot,
+ * so the table is always full.
+ * Chunks of the part point to the memory of the selector and
+ * to the selected weights.
+ */
+class HotWeightSelector {
+  util::CodedBuffer info_;
+  std::vector<u32> slots_;
+  std::vector<HotWeight> hot_;
+  util::ArraySlice<float> weights_;
+  u64 hotAccesses_ = 0;
+  u64 totalAccesses_ = 0;
+  size_t usedSlots_ = 0;
+
+ public:
+  // The hot table has 2^hotExponent weights
+  Status select(util::ArraySlice<float> weights,
+                util::ArraySlice<u32> accessCounts, u32 hotExponent);
+  void fillModelPart(model::ModelPart* part) const;
+  WeightBuffer weights() const;
+  // accesses which were served by the hot table
+  u64 hotAccesses() const { return hotAccesses_; }
+  u64 totalAccesses() const { return totalAccesses_; }
+  // slots which were accessed at least once
+  size_t usedSlots() const { return usedSlots_; }
+};
+
 }  // namespace analysis
 }  // namespace core
 }  // namespace jumanpp
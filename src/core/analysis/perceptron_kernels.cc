@@ -0,0 +1,217 @@
+#include "perceptron_kernels.h"
+#include "core/analysis/perceptron.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define JPP_PERCEPTRON_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+namespace impl {
+
+namespace {
+
+void scalarRows(const float* weights, u32 mask,
+                util::ConstSliceable<u32> ngrams, const float* source,
+                float* result) {
+  WeightBuffer buffer{util::ArraySlice<float>{weights, size_t{mask} + 1}};
+  for (int i = 0; i < ngrams.numRows(); ++i) {
+    float score = computeUnrolled4Perceptron(buffer, ngrams.row(i), mask);
+    result[i] = source == nullptr ? score : source[i] + score;
+  }
+}
+
+#ifdef JPP_PERCEPTRON_X86_KERNELS
+
+// gathers use signed 32-bit indices
+constexpr u32 MaxGatherMask = 0x7fffffffu;
+
+__attribute__((target("avx2"))) float rowAvx2(const float* weights,
+                                              __m256i mask, const u32* indices,
+                                              u32 size) {
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  u32 i = 0;
+  for (; i + 16 <= size; i += 16) {
+    auto p = reinterpret_cast<const __m256i*>(indices + i);
+    __m256i ids1 = _mm256_and_si256(_mm256_loadu_si256(p), mask);
+    __m256i ids2 = _mm256_and_si256(_mm256_loadu_si256(p + 1), mask);
+    acc1 = _mm256_add_ps(acc1, _mm256_i32gather_ps(weights, ids1, 4));
+    acc2 = _mm256_add_ps(acc2, _mm256_i32gather_ps(weights, ids2, 4));
+  }
+  if (i + 8 <= size) {
+    auto p = reinterpret_cast<const __m256i*>(indices + i);
+    __m256i ids = _mm256_and_si256(_mm256_loadu_si256(p), mask);
+    acc1 = _mm256_add_ps(acc1, _mm256_i32gather_ps(weights, ids, 4));
+    i += 8;
+  }
+  if (i < size) {
+    // masked lanes are neither loaded nor gathered
+    __m256i lanes =
+        _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(size - i)),
+                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    auto p = reinterpret_cast<const int*>(indices + i);
+    __m256i ids = _mm256_and_si256(_mm256_maskload_epi32(p, lanes), mask);
+    acc2 = _mm256_add_ps(
+        acc2, _mm256_mask_i32gather_ps(_mm256_setzero_ps(), weights, ids,
+                                       _mm256_castsi256_ps(lanes), 4));
+  }
+  __m256 acc = _mm256_add_ps(acc1, acc2);
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc),
+                          _mm256_extractf128_ps(acc, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2"))) void avx2Rows(const float* weights, u32 mask,
+                                              util::ConstSliceable<u32> ngrams,
+                                              const float* source,
+                                              float* result) {
+  if (mask > MaxGatherMask) {
+    scalarRows(weights, mask, ngrams, source, result);
+    return;
+  }
+  __m256i vmask = _mm256_set1_epi32(static_cast<int>(mask));
+  auto rowSize = static_cast<u32>(ngrams.rowSize());
+  auto indices = ngrams.data().data();
+  for (int i = 0; i < ngrams.numRows(); ++i) {
+    float score = rowAvx2(weights, vmask, indices, rowSize);
+    result[i] = source == nullptr ? score : source[i] + score;
+    indices += rowSize;
+  }
+}
+
+__attribute__((target("avx512f"))) float rowAvx512(const float* weights,
+                                                   __m512i mask,
+                                                   const u32* indices,
+                                                   u32 size) {
+  __m512 acc1 = _mm512_setzero_ps();
+  __m512 acc2 = _mm512_setzero_ps();
+  u32 i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m512i ids1 = _mm512_and_si512(_mm512_loadu_si512(indices + i), mask);
+    __m512i ids2 =
+        _mm512_and_si512(_mm512_loadu_si512(indices + i + 16), mask);
+    acc1 = _mm512_add_ps(acc1, _mm512_i32gather_ps(ids1, weights, 4));
+    acc2 = _mm512_add_ps(acc2, _mm512_i32gather_ps(ids2, weights, 4));
+  }
+  if (i + 16 <= size) {
+    __m512i ids = _mm512_and_si512(_mm512_loadu_si512(indices + i), mask);
+    acc1 = _mm512_add_ps(acc1, _mm512_i32gather_ps(ids, weights, 4));
+    i += 16;
+  }
+  if (i < size) {
+    auto lanes = static_cast<__mmask16>((1u << (size - i)) - 1);
+    __m512i ids =
+        _mm512_and_si512(_mm512_maskz_loadu_epi32(lanes, indices + i), mask);
+    acc2 = _mm512_add_ps(acc2, _mm512_mask_i32gather_ps(_mm512_setzero_ps(),
+                                                        lanes, ids, weights,
+                                                        4));
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc1, acc2));
+}
+
+__attribute__((target("avx512f"))) void avx512Rows(
+    const float* weights, u32 mask, util::ConstSliceable<u32> ngrams,
+    const float* source, float* result) {
+  if (mask > MaxGatherMask) {
+    scalarRows(weights, mask, ngrams, source, result);
+    return;
+  }
+  __m512i vmask = _mm512_set1_epi32(static_cast<int>(mask));
+  auto rowSize = static_cast<u32>(ngrams.rowSize());
+  auto indices = ngrams.data().data();
+  for (int i = 0; i < ngrams.numRows(); ++i) {
+    float score = rowAvx512(weights, vmask, indices, rowSize);
+    result[i] = source == nullptr ? score : source[i] + score;
+    indices += rowSize;
+  }
+}
+
+#endif  // JPP_PERCEPTRON_X86_KERNELS
+
+}  // namespace
+
+bool perceptronKernelSupported(PerceptronKernel kernel) {
+  switch (kernel) {
+    case PerceptronKernel::Scalar:
+      return true;
+#ifdef JPP_PERCEPTRON_X86_KERNELS
+    case PerceptronKernel::Avx2: {
+      static const bool supported = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+      }();
+      return supported;
+    }
+    case PerceptronKernel::Avx512: {
+      static const bool supported = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") != 0;
+      }();
+      return supported;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+PerceptronKernel bestPerceptronKernel() {
+  if (perceptronKernelSupported(PerceptronKernel::Avx512)) {
+    return PerceptronKernel::Avx512;
+  }
+  if (perceptronKernelSupported(PerceptronKernel::Avx2)) {
+    return PerceptronKernel::Avx2;
+  }
+  return PerceptronKernel::Scalar;
+}
+
+PerceptronRowsFn perceptronRowsKernel(PerceptronKernel kernel) {
+  if (!perceptronKernelSupported(kernel)) {
+    return nullptr;
+  }
+  switch (kernel) {
+#ifdef JPP_PERCEPTRON_X86_KERNELS
+    case PerceptronKernel::Avx2:
+      return &avx2Rows;
+    case PerceptronKernel::Avx512:
+      return &avx512Rows;
+#endif
+    default:
+      return &scalarRows;
+  }
+}
+
+StringPiece perceptronKernelName(PerceptronKernel kernel) {
+  switch (kernel) {
+    case PerceptronKernel::Scalar:
+      return "scalar";
+    case PerceptronKernel::Avx2:
+      return "avx2";
+    case PerceptronKernel::Avx512:
+      return "avx512";
+    default:
+      return "unknown";
+  }
+}
+
+bool perceptronKernelByName(StringPiece name, PerceptronKernel* result) {
+  for (auto kernel : {PerceptronKernel::Scalar, PerceptronKernel::Avx2,
+                      PerceptronKernel::Avx512}) {
+    if (perceptronKernelName(kernel) == name) {
+      *result = kernel;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace impl
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,49 @@
+#ifndef JUMANPP_PERCEPTRON_KERNELS_H
+#define JUMANPP_PERCEPTRON_KERNELS_H
+
+#include "util/array_slice.h"
+#include "util/sliceable_array.h"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+enum class PerceptronKernel { Scalar, Avx2, Avx512 };
+
+namespace impl {
+
+/**
+ * Computes linear model scores for rows of hashed feature indices:
+ * result[i] = source[i] + sum(weights[ngrams[i][j] & mask]).
+ * Source can be nullptr, then it is treated as zeros.
+ *
+ * Vector kernels sum weights in a different order than the scalar one,
+ * so scores can differ from the scalar ones in the last bits.
+ */
+using PerceptronRowsFn = void (*)(const float* weights, u32 mask,
+                                  util::ConstSliceable<u32> ngrams,
+                                  const float* source, float* result);
+
+// AVX2 and AVX-512 kernels are compiled only for x86 with GCC or Clang
+// and are selected at runtime, so the binaries stay portable.
+bool perceptronKernelSupported(PerceptronKernel kernel);
+
+// The fastest kernel which is supported by the current CPU
+PerceptronKernel bestPerceptronKernel();
+
+// nullptr if the kernel is not supported
+PerceptronRowsFn perceptronRowsKernel(PerceptronKernel kernel);
+
+StringPiece perceptronKernelName(PerceptronKernel kernel);
+
+// Inverse of perceptronKernelName, false for unknown names
+bool perceptronKernelByName(StringPiece name, PerceptronKernel* result);
+
+}  // namespace impl
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_PERCEPTRON_KERNELS_H
@@ -3,6 +3,7 @@
 //
 
 #include "perceptron.h"
+#include <random>
 #include "testing/standalone_test.h"
 
 using namespace jumanpp;
@@ -42,4 +43,206 @@ TEST_CASE("perceptron impl computes positioned sums") {
   CHECK(compute({1, 2, 3}) == Approx(1110.f));
   CHECK(compute({6, 7, 5, 9}) == Approx(10111'00000.f));
   CHECK(compute({8, 7, 5, 9, 3}) == Approx(11101'01000.f));
-}
\ No newline at end of file
+}
+TEST_CASE("perceptron kernels compute the same scores") {
+  std::minstd_rand rng{5};
+  std::uniform_real_distribution<float> floats{-1.0f, 1.0f};
+  std::vector<float> weights(1024);
+  for (auto& w : weights) {
+    w = floats(rng);
+  }
+  u32 mask = static_cast<u32>(weights.size() - 1);
+
+  // row sizes cover full vectors and all tail lengths
+  for (u32 rowSize = 1; rowSize < 70; ++rowSize) {
+    CAPTURE(rowSize);
+    u32 numRows = 5;
+    std::vector<u32> ngrams(rowSize * numRows);
+    for (auto& v : ngrams) {
+      v = static_cast<u32>(rng());
+    }
+    std::vector<float> source(numRows, 0.5f);
+    std::vector<float> expected(numRows);
+    util::ConstSliceable<u32> rows{ngrams, rowSize, numRows};
+    auto scalar = impl::perceptronRowsKernel(PerceptronKernel::Scalar);
+    REQUIRE(scalar != nullptr);
+    scalar(weights.data(), mask, rows, source.data(), expected.data());
+
+    for (auto kernel : {PerceptronKernel::Avx2, PerceptronKernel::Avx512}) {
+      auto rowsFn = impl::perceptronRowsKernel(kernel);
+      if (rowsFn == nullptr) {
+        continue;
+      }
+      CAPTURE(impl::perceptronKernelName(kernel));
+      std::vector<float> result(numRows);
+      rowsFn(weights.data(), mask, rows, source.data(), result.data());
+      for (u32 i = 0; i < numRows; ++i) {
+        CHECK(result[i] == Approx(expected[i]).epsilon(1e-4));
+      }
+      rowsFn(weights.data(), mask, rows, nullptr, result.data());
+      for (u32 i = 0; i < numRows; ++i) {
+        CHECK(result[i] == Approx(expected[i] - 0.5f).epsilon(1e-4));
+      }
+    }
+  }
+}
+
+TEST_CASE("perceptron rejects unsupported kernels") {
+  std::vector<float> weights(16, 0.1f);
+  HashedFeaturePerceptron perc{weights};
+  CHECK_OK(perc.setKernel(PerceptronKernel::Scalar));
+  CHECK_OK(perc.setKernel(impl::bestPerceptronKernel()));
+  for (auto kernel : {PerceptronKernel::Avx2, PerceptronKernel::Avx512}) {
+    if (!impl::perceptronKernelSupported(kernel)) {
+      CHECK_FALSE(perc.setKernel(kernel));
+    }
+  }
+}
+
+TEST_CASE("quantized perceptron weights are loaded from a model part") {
+  std::minstd_rand rng{7};
+  std::uniform_real_distribution<float> floats{-2.0f, 1.0f};
+  std::vector<float> weights(1024);
+  for (auto& w : weights) {
+    w = floats(rng);
+  }
+  weights[5] = 0;
+  weights[700] = 0;
+
+  for (auto encoding :
+       {util::WeightEncoding::Linear8, util::WeightEncoding::Linear16}) {
+    for (u32 blockExponent : {0, 6}) {
+      CAPTURE(static_cast<u32>(encoding));
+      CAPTURE(blockExponent);
+      PerceptronQuantizer quantizer;
+      REQUIRE_OK(quantizer.quantize(weights, encoding, blockExponent));
+      core::model::ModelInfo info;
+      info.parts.emplace_back();
+      quantizer.fillModelPart(&info.parts.back());
+      HashedFeaturePerceptron perc;
+      REQUIRE_OK(perc.load(info));
+      auto& loaded = perc.weights();
+      REQUIRE(loaded.size() == weights.size());
+      CHECK(loaded.encoding() == encoding);
+      CHECK(loaded.floats() == nullptr);
+
+      float maxStep = encoding == util::WeightEncoding::Linear8 ? 3.0f / 254
+                                                                : 3.0f / 65534;
+      for (size_t i = 0; i < weights.size(); ++i) {
+        CHECK(std::abs(loaded.at(i) - weights[i]) <= maxStep / 2 + 1e-6f);
+      }
+      CHECK(loaded.at(5) == 0);
+      CHECK(loaded.at(700) == 0);
+
+      std::vector<u32> ngrams = {1, 5, 9, 700, 1023, 2048 + 3, 17};
+      util::ConstSliceable<u32> rows{ngrams, 7, 1};
+      float result = 0;
+      perc.compute({&result, 1}, rows);
+      float expected = 0;
+      for (auto idx : ngrams) {
+        expected += loaded.at(idx & 1023);
+      }
+      CHECK(result == Approx(expected));
+    }
+  }
+}
+
+TEST_CASE("perceptron quantizer rejects float encoding") {
+  std::vector<float> weights(16, 0.1f);
+  PerceptronQuantizer quantizer;
+  CHECK_FALSE(quantizer.quantize(weights, util::WeightEncoding::Float32, 0));
+}
+
+TEST_CASE("hot perceptron weights give the same scores") {
+  std::minstd_rand rng{11};
+  std::uniform_real_distribution<float> floats{-1.0f, 1.0f};
+  std::vector<float> weights(1024);
+  for (auto& w : weights) {
+    w = floats(rng);
+  }
+  std::vector<u32> counts(weights.size(), 0);
+  // 3 and 67 have the same position in a table of 64,
+  // the more frequent one gets it
+  counts[3] = 10;
+  counts[67] = 20;
+  counts[100] = 5;
+  counts[900] = 1;
+
+  HotWeightSelector selector;
+  CHECK_FALSE(selector.select(weights, counts, 10));
+  REQUIRE_OK(selector.select(weights, counts, 6));
+  CHECK(selector.usedSlots() == 4);
+  CHECK(selector.totalAccesses() == 36);
+  CHECK(selector.hotAccesses() == 26);
+
+  core::model::ModelInfo info;
+  info.parts.emplace_back();
+  selector.fillModelPart(&info.parts.back());
+  HashedFeaturePerceptron perc;
+  REQUIRE_OK(perc.load(info));
+  auto& loaded = perc.weights();
+  REQUIRE(loaded.size() == weights.size());
+  CHECK(loaded.hasHotWeights());
+  CHECK(loaded.floats() == nullptr);
+  for (size_t i = 0; i < weights.size(); ++i) {
+    CHECK(loaded.at(i) == weights[i]);
+  }
+
+  std::vector<u32> ngrams = {3, 67, 100, 900, 5, 1023, 2048 + 67, 17};
+  util::ConstSliceable<u32> rows{ngrams, 4, 2};
+  float hot[2];
+  float flat[2];
+  perc.compute(hot, rows);
+  HashedFeaturePerceptron flatPerc{weights};
+  flatPerc.compute(flat, rows);
+  CHECK(hot[0] == flat[0]);
+  CHECK(hot[1] == flat[1]);
+}
+
+TEST_CASE("pruned perceptron weights are loaded from a model part") {
+  std::minstd_rand rng{13};
+  std::uniform_real_distribution<float> floats{-1.0f, 1.0f};
+  for (size_t size : {16, 1024}) {
+    CAPTURE(size);
+    std::vector<float> weights(size);
+    for (auto& w : weights) {
+      w = floats(rng);
+    }
+    weights[0] = 0;
+    weights[1] = -0.1f;
+    weights[size - 1] = 0.05f;
+
+    PerceptronPruner pruner;
+    REQUIRE_OK(pruner.prune(weights, 0.1f));
+    core::model::ModelInfo info;
+    info.parts.emplace_back();
+    pruner.fillModelPart(&info.parts.back());
+    HashedFeaturePerceptron perc;
+    REQUIRE_OK(perc.load(info));
+    auto& loaded = perc.weights();
+    REQUIRE(loaded.size() == weights.size());
+    CHECK(loaded.encoding() == util::WeightEncoding::SparseFloat32);
+    CHECK(loaded.floats() == nullptr);
+
+    size_t stored = 0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+      auto expected = std::abs(weights[i]) <= 0.1f ? 0 : weights[i];
+      CHECK(loaded.at(i) == expected);
+      stored += expected != 0;
+    }
+    CHECK(pruner.numStored() == stored);
+    CHECK(loaded.byteSize() ==
+          (stored + 1) * sizeof(float) +
+              (size + 63) / 64 * sizeof(SparseWeightWord));
+
+    std::vector<u32> ngrams = {1, 5, 9, 700, 1023, 2048 + 3, 17};
+    util::ConstSliceable<u32> rows{ngrams, 7, 1};
+    float result = 0;
+    perc.compute({&result, 1}, rows);
+    float expected = 0;
+    for (auto idx : ngrams) {
+      expected += loaded.at(idx & (size - 1));
+    }
+    CHECK(result == Approx(expected));
+  }
+}
@@ -163,8 +163,7 @@ StringPiece RnnIdResolver::reprOf(RnnReprBuilder* bldr, EntryPtr eptr,
     if (feature >= 0) {
       bldr->addInt(feature);
     } else {
-      auto node = xtra->node(eptr);
-      bldr->addString(node->header.unk.surface);
+      bldr->addString(xtra->stringOf(eptr, feature));
     }
   }
   return bldr->repr();
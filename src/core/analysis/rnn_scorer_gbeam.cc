@@ -72,6 +72,7 @@ struct GbeamRnnState {
   Lattice* lat;
   const ExtraNodesContext* xtra;
   u32 scorerIdx;
+  u64 evaluations = 0;
 
   util::Sliceable<i32> ctxIdBuf;
   util::MutableArraySlice<i32> rightIdBuf;
@@ -259,6 +260,7 @@ struct GbeamRnnState {
         gatherNceEmbeds(rnnIds), scores};
 
     shared->rnn.applyParallel(&psd);
+    evaluations += rbnd.scoreCnt;
 
     copyScoresToLattice(scores, rbnd, bndIdx);
 
@@ -270,6 +272,7 @@ struct GbeamRnnState {
     this->xtra = xtra;
     manager.reset();
     alloc->reset();
+    evaluations = 0;
     auto numBnd = l->createdBoundaryCount() - 1;
     allocateState();
     JPP_RETURN_IF_ERROR(
@@ -292,6 +295,8 @@ Status RnnScorerGbeam::scoreLattice(Lattice* l, const ExtraNodesContext* xtra,
   return state_->scoreLattice(l, xtra);
 }
 
+u64 RnnScorerGbeam::lastEvaluations() const { return state_->evaluations; }
+
 RnnScorerGbeam::~RnnScorerGbeam() = default;
 
 RnnScorerGbeamFactory::RnnScorerGbeamFactory() = default;
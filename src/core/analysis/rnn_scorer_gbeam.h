@@ -41,7 +41,9 @@ class RnnScorerGbeam : public ScoreComputer {
   std::unique_ptr<GbeamRnnState> state_;
 
  public:
-  Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra, u32 scorerIdx);
+  Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra,
+                      u32 scorerIdx) override;
+  u64 lastEvaluations() const override;
   RnnScorerGbeam();
   ~RnnScorerGbeam();
 
@@ -26,20 +26,155 @@ class ScorerBase {
   virtual Status load(const model::ModelInfo& model) = 0;
 };
 
-struct FloatBufferWeights {
-  util::ArraySlice<float> weights;
-  FloatBufferWeights(const util::ArraySlice<float>& weights)
-      : weights(weights) {}
-  float at(size_t idx) const { return weights.at(idx); }
-  size_t size() const { return weights.size(); }
+/**
+ * A copy of a weight of a frequently used slot.
+ * Hot weights form a direct-mapped table indexed by lower bits of slots.
+ */
+struct HotWeight {
+  u32 slot;
+  float weight;
+};
+
+/**
+ * 64 weights of a sparse table: bits of the stored (nonzero) ones and
+ * the position of the first of them in the value array.
+ * Both are in a single word, so a lookup reads a single cache line
+ * in addition to the value.
+ */
+struct SparseWeightWord {
+  u64 bits;
+  u64 rank;
+};
+
+/**
+ * Weights of a linear model: floats or linearly quantized 8/16-bit codes.
+ * Quantized weights are split into blocks of 2^blockExponent codes which
+ * have their own min and step; per-table quantization has a single block.
+ * The encoding is chosen at runtime when a model is loaded.
+ *
+ * Float weights can additionally have a hot table: weights of slots
+ * which are used the most are copied into a table which is small enough
+ * to stay in cache, and the rest are read from the full (cold) table.
+ * Both tables contain the same values, so scores do not change.
+ *
+ * Sparse weights store only floats of nonzero weights, a bitmap with
+ * ranks (SparseWeightWord) maps slots to them. Values start with a zero
+ * which is read for weights which are not stored, so lookups do not
+ * branch on whether a weight is stored: it is unpredictable.
+ */
+class WeightBuffer {
+  enum class Layout : u32 { Flat, Quantized, HotCold, Sparse };
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  util::WeightEncoding encoding_ = util::WeightEncoding::Float32;
+  Layout layout_ = Layout::Flat;
+  u32 codeShift_ = 2;
+  u32 blockExponent_ = 0;
+  const util::LinearQuantParams* blocks_ = nullptr;
+  const HotWeight* hot_ = nullptr;
+  u32 hotMask_ = 0;
+  const SparseWeightWord* sparse_ = nullptr;
+
+ public:
+  WeightBuffer() = default;
+  WeightBuffer(const util::ArraySlice<float>& weights)
+      : data_{reinterpret_cast<const char*>(weights.data())},
+        size_{weights.size()} {}
+  WeightBuffer(util::WeightEncoding encoding, const char* codes, size_t size,
+               u32 blockExponent, const util::LinearQuantParams* blocks)
+      : data_{codes},
+        size_{size},
+        encoding_{encoding},
+        layout_{Layout::Quantized},
+        codeShift_{util::weightCodeShift(encoding)},
+        blockExponent_{blockExponent},
+        blocks_{blocks} {}
+  // hotSize must be a power of 2,
+  // the weight of slot s can be only at hot[s & (hotSize - 1)]
+  WeightBuffer(const util::ArraySlice<float>& weights, const HotWeight* hot,
+               u32 hotSize)
+      : data_{reinterpret_cast<const char*>(weights.data())},
+        size_{weights.size()},
+        layout_{Layout::HotCold},
+        hot_{hot},
+        hotMask_{hotSize - 1} {}
+  // there are (size + 63) / 64 words
+  WeightBuffer(const float* values, const SparseWeightWord* words, size_t size)
+      : data_{reinterpret_cast<const char*>(values)},
+        size_{size},
+        encoding_{util::WeightEncoding::SparseFloat32},
+        layout_{Layout::Sparse},
+        sparse_{words} {}
+
+  JPP_ALWAYS_INLINE float at(size_t idx) const {
+    JPP_DCHECK_IN(idx, 0, size_);
+    auto floats = reinterpret_cast<const float*>(data_);
+    if (JPP_LIKELY(layout_ == Layout::Flat)) {
+      return floats[idx];
+    }
+    if (layout_ == Layout::HotCold) {
+      auto& hot = hot_[idx & hotMask_];
+      // selects the address instead of branching
+      auto ptr = hot.slot == idx ? &hot.weight : floats + idx;
+      return *ptr;
+    }
+    if (layout_ == Layout::Sparse) {
+      return floats[sparsePosition(idx)];
+    }
+    auto& block = blocks_[idx >> blockExponent_];
+    u32 code = encoding_ == util::WeightEncoding::Linear8
+                   ? reinterpret_cast<const u8*>(data_)[idx]
+                   : reinterpret_cast<const std::uint16_t*>(data_)[idx];
+    return block.min + block.step * code;
+  }
+  size_t size() const { return size_; }
+  util::WeightEncoding encoding() const { return encoding_; }
+  // nullptr if weights are quantized, sparse or have a hot table
+  const float* floats() const {
+    if (layout_ != Layout::Flat) {
+      return nullptr;
+    }
+    return reinterpret_cast<const float*>(data_);
+  }
+  bool hasHotWeights() const { return layout_ == Layout::HotCold; }
+  size_t byteSize() const {
+    if (layout_ == Layout::Sparse) {
+      auto numWords = (size_ + 63) / 64;
+      auto& last = sparse_[numWords - 1];
+      // includes the leading zero
+      auto numValues = last.rank + util::popCount(last.bits);
+      return numValues * sizeof(float) + numWords * sizeof(SparseWeightWord);
+    }
+    auto hotSize = hot_ == nullptr ? 0 : size_t{hotMask_} + 1;
+    return (size_ << codeShift_) + hotSize * sizeof(HotWeight);
+  }
+  // always inlined: otherwise GCC can treat it as a pure function
+  // and drop the calls
   template <util::PrefetchHint Hint>
-  void prefetch(size_t idx) const {
-    util::prefetch<Hint>(weights.data() + idx);
+  JPP_ALWAYS_INLINE void prefetch(size_t idx) const {
+    // hot weights are expected to be in cache already
+    if (layout_ == Layout::HotCold && hot_[idx & hotMask_].slot == idx) {
+      return;
+    }
+    if (layout_ == Layout::Sparse) {
+      util::prefetch<Hint>(sparse_ + (idx >> 6));
+      return;
+    }
+    util::prefetch<Hint>(data_ + (idx << codeShift_));
   }
-};
 
-// using WeightBuffer = util::Float8BitLinearQ;
-using WeightBuffer = FloatBufferWeights;
+ private:
+  // position of the value, 0 (the leading zero) if it is not stored
+  JPP_ALWAYS_INLINE size_t sparsePosition(size_t idx) const {
+    auto& word = sparse_[idx >> 6];
+    auto shift = idx & 63;
+    u64 below = word.bits & ((u64{1} << shift) - 1);
+    // all ones if the weight is stored, zero otherwise
+    u64 stored = u64{0} - ((word.bits >> shift) & 1);
+    return (word.rank + util::popCount(below)) & stored;
+  }
+};
 
 class FeatureScorer : public ScorerBase {
  public:
@@ -56,6 +191,8 @@ class ScoreComputer {
   virtual ~ScoreComputer() = default;
   virtual Status scoreLattice(Lattice* l, const ExtraNodesContext* xtra,
                               u32 scorerIdx) = 0;
+  // Number of scores computed by the last scoreLattice call (for statistics)
+  virtual u64 lastEvaluations() const { return 0; }
 };
 
 class ScorerFactory : public ScorerBase {
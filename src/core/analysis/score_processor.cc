@@ -25,6 +25,8 @@ ScoreProcessor::ScoreProcessor(AnalyzerImpl *analyzer)
     : ngramApply_{analyzer->core().features().ngramPartial},
       lattice_{analyzer->lattice()},
       cfg_{&analyzer->cfg()},
+      rightGbeamCheck_{cfg_->rightGbeamCheck},
+      rightGbeamSize_{cfg_->rightGbeamSize},
       t1PtrData_{analyzer->alloc()} {
   u32 maxNodes = 0;
   u32 maxEnds = 0;
@@ -293,13 +295,13 @@ void ScoreProcessor::computeGbeamScores(i32 bndIdx,
   auto t0data = right->patternFeatureData();
   util::MutableArraySlice<Score> result{gbeamScoreBuf_, 0, gbeam.size()};
 
-  if (cfg_->rightGbeamCheck > 0) {
+  if (rightGbeamCheck_ > 0) {
     // we cut off right elements as well
 
-    auto size = static_cast<size_t>(cfg_->rightGbeamCheck);
+    auto size = static_cast<size_t>(rightGbeamCheck_);
     auto fullBeamApplySize =
         std::min<size_t>({size, bnd->localNodeCount(), gbeam.size()});
-    auto toKeep = std::min<size_t>(static_cast<u32>(cfg_->rightGbeamSize),
+    auto toKeep = std::min<size_t>(static_cast<u32>(rightGbeamSize_),
                                    bnd->localNodeCount());
     size_t remainingItems =
         std::max<size_t>(gbeam.size() - fullBeamApplySize, 0);
@@ -494,9 +496,17 @@ void ScoreProcessor::makeT0cutoffBeam(u32 fullAnalysis, u32 rightBeam) {
                    comp);
 }
 
+void ScoreProcessor::narrowRightBeam() {
+  if (rightGbeamCheck_ <= 0) {
+    return;
+  }
+  rightGbeamCheck_ = std::max(rightGbeamCheck_ / 2, 1);
+  rightGbeamSize_ = std::max(rightGbeamSize_ / 2, 1);
+}
+
 void ScoreProcessor::computeT0Prescores(util::ArraySlice<BeamCandidate> gbeam,
                                         FeatureScorer *scorer) {
-  auto max = cfg_->rightGbeamCheck;
+  auto max = rightGbeamCheck_;
   auto theMax = std::min<i32>(max, gbeam.size());
   for (int i = 0; i < theMax; ++i) {
     auto t1idx = t1positions_.at(i);
@@ -130,6 +130,8 @@ struct ScoreProcessor {
   ScorePlugin* plugin_;
 
   const AnalyzerConfig* cfg_;
+  i32 rightGbeamCheck_;
+  i32 rightGbeamSize_;
   i32 globalBeamSize_;
   util::MutableArraySlice<BeamCandidate> globalBeam_;
   util::FlatMap<LatticeNodePtr, u32> t1PtrData_;
@@ -164,6 +166,8 @@ struct ScoreProcessor {
   util::ArraySlice<BeamCandidate> makeGlobalBeam(i32 bndIdx, i32 maxElems);
   void computeGbeamScores(i32 bndIdx, util::ArraySlice<BeamCandidate> gbeam,
                           FeatureScorer* features);
+  // Halves right beam sizes for the rest of the analysis
+  void narrowRightBeam();
 
   util::ArraySlice<u32> dedupT1(i32 bndIdx,
                                 util::ArraySlice<BeamCandidate> gbeam);
@@ -22,6 +22,16 @@ class UnkMaker {
  public:
   virtual bool spawnNodes(const AnalysisInput& input, UnkNodesContext* ctx,
                           LatticeBuilder* lattice) const = 0;
+
+  /**
+   * The maker can create nodes only for sentences which contain
+   * characters of these classes, it is not run for other sentences.
+   * See UnkNodeSpawner.
+   */
+  virtual chars::CharacterClass triggerClass() const {
+    return chars::CharacterClass::FAMILY_ANYTHING;
+  }
+
   virtual ~UnkMaker() = default;
 };
 
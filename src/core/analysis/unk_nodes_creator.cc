@@ -5,12 +5,79 @@
 #include "unk_nodes_creator.h"
 #include <util/logging.hpp>
 #include "core_config.h"
+#include "util/hashing.h"
 #include "util/murmur_hash.h"
 
 namespace jumanpp {
 namespace core {
 namespace analysis {
 
+bool UnkNodeSpawner::spawnNodes(
+    util::ArraySlice<std::unique_ptr<UnkMaker>> makers,
+    const AnalysisInput& input, UnkNodesContext* ctx,
+    LatticeBuilder* lattice) {
+  auto present = input.presentClasses();
+  auto firstSeed = lattice->seeds().size();
+  for (auto& m : makers) {
+    auto trigger = m->triggerClass();
+    if (trigger != chars::CharacterClass::FAMILY_ANYTHING &&
+        !chars::IsCompatibleCharClass(present, trigger)) {
+      continue;
+    }
+    if (!m->spawnNodes(input, ctx, lattice)) {
+      return false;
+    }
+  }
+
+  seen_.clear_no_resize();
+  unique_.clear();
+  auto& xtra = ctx->xtra();
+  auto removed = lattice->removeSeedsIf(
+      firstSeed,
+      [&](const LatticeNodeSeed& seed) { return isDuplicate(seed, xtra); });
+  numDuplicates_ += removed;
+  return true;
+}
+
+bool UnkNodeSpawner::isDuplicate(const LatticeNodeSeed& seed,
+                                 const ExtraNodesContext& xtra) {
+  if (!seed.entryPtr.isSpecial()) {
+    return false;
+  }
+  auto node = xtra.node(seed.entryPtr);
+  if (node == nullptr || node->header.type != ExtraNodeType::Unknown) {
+    return false;
+  }
+  auto data = xtra.nodeData(node);
+  auto templatePtr = static_cast<u32>(node->header.unk.templatePtr.rawValue());
+  util::hashing::Hasher hasher{0x2f1e4d3c5b6aULL};
+  hasher = hasher.merge(seed.codepointStart, seed.codepointEnd);
+  hasher = hasher.merge(templatePtr, data.size());
+  for (auto v : data) {
+    hasher = hasher.merge(static_cast<u32>(v));
+  }
+  auto hash = hasher.result();
+
+  auto it = seen_.find(hash);
+  if (it == seen_.end()) {
+    seen_[hash] = static_cast<u32>(unique_.size());
+    unique_.push_back(seed);
+    return false;
+  }
+
+  auto& other = unique_[it->second];
+  if (other.codepointStart != seed.codepointStart ||
+      other.codepointEnd != seed.codepointEnd) {
+    return false;
+  }
+  auto otherNode = xtra.node(other.entryPtr);
+  if (otherNode->header.unk.templatePtr != node->header.unk.templatePtr) {
+    return false;
+  }
+  auto otherData = xtra.nodeData(otherNode);
+  return std::equal(data.begin(), data.end(), otherData.begin());
+}
+
 ChunkingUnkMaker::ChunkingUnkMaker(const dic::DictionaryEntries& entries_,
                                    chars::CharacterClass charClass_,
                                    UnkNodeConfig&& info_)
@@ -20,44 +87,44 @@ bool ChunkingUnkMaker::spawnNodes(const AnalysisInput& input,
                                   UnkNodesContext* ctx,
                                   LatticeBuilder* lattice) const {
   auto& codepoints = input.codepoints();
-  for (LatticePosition i = 0; i < codepoints.size(); ++i) {
-    auto& codept = codepoints[i];
-    if (!codept.hasClass(charClass_)) {
+  for (auto& run : input.classRuns()) {
+    if (!chars::IsCompatibleCharClass(run.charClass, charClass_)) {
       continue;
     }
+    for (auto i = static_cast<LatticePosition>(run.start); i < run.end; ++i) {
+      auto trav = entries_.traversal();
+      for (LatticePosition j = i; j < codepoints.size(); ++j) {
+        auto& cp = codepoints[j];
+        if (!cp.hasClass(charClass_)) {
+          break;
+        }
+        auto status = trav.step(cp);
+        using dic::TraverseStatus;
 
-    auto trav = entries_.traversal();
-    for (LatticePosition j = i; j < codepoints.size(); ++j) {
-      auto& cp = codepoints[j];
-      if (!cp.hasClass(charClass_)) {
-        break;
-      }
-      auto status = trav.step(cp.bytes);
-      using dic::TraverseStatus;
-
-      switch (status) {
-        case TraverseStatus::NoNode: {
-          for (; j < codepoints.size(); ++j) {
-            if (!codepoints[j].hasClass(charClass_)) {
-              j = codepoints.size();
-              break;
+        switch (status) {
+          case TraverseStatus::NoNode: {
+            for (; j < codepoints.size(); ++j) {
+              if (!codepoints[j].hasClass(charClass_)) {
+                j = codepoints.size();
+                break;
+              }
+              LatticePosition start = i;
+              LatticePosition end = (LatticePosition)(j + 1);
+              auto ptr = ctx->makePtr(input.surface(start, end), info_, true);
+              lattice->appendSeed(ptr, start, end);
             }
+            break;
+          }
+          case TraverseStatus::NoLeaf: {
             LatticePosition start = i;
             LatticePosition end = (LatticePosition)(j + 1);
-            auto ptr = ctx->makePtr(input.surface(start, end), info_, true);
+            auto ptr = ctx->makePtr(input.surface(start, end), info_, false);
             lattice->appendSeed(ptr, start, end);
+            break;
           }
-          break;
-        }
-        case TraverseStatus::NoLeaf: {
-          LatticePosition start = i;
-          LatticePosition end = (LatticePosition)(j + 1);
-          auto ptr = ctx->makePtr(input.surface(start, end), info_, false);
-          lattice->appendSeed(ptr, start, end);
-          break;
+          case TraverseStatus::Ok:
+            continue;
         }
-        case TraverseStatus::Ok:
-          continue;
       }
     }
   }
@@ -74,13 +141,14 @@ bool SingleUnkMaker::spawnNodes(const AnalysisInput& input,
                                 LatticeBuilder* lattice) const {
   using dic::TraverseStatus;
   auto& codepoints = input.codepoints();
-  for (LatticePosition i = 0; i < codepoints.size(); ++i) {
-    auto& codept = codepoints[i];
-    if (!codept.hasClass(charClass_)) {
+  for (auto& run : input.classRuns()) {
+    if (!chars::IsCompatibleCharClass(run.charClass, charClass_)) {
       continue;
-    } else {
+    }
+    for (auto i = static_cast<LatticePosition>(run.start); i < run.end; ++i) {
+      auto& codept = codepoints[i];
       auto trav = entries_.traversal();
-      auto result = trav.step(codept.bytes);
+      auto result = trav.step(codept);
       bool notPrefix;
       switch (result) {
         case TraverseStatus::Ok:
@@ -49,6 +49,7 @@ class UnkNodesContext {
       : xtra_{xtra}, alloc_{alloc}, entries_{entries} {}
 
   util::memory::PoolAlloc* alloc() const { return alloc_; }
+  const ExtraNodesContext& xtra() const { return *xtra_; }
 
   EntryPtr makePtr(StringPiece surface, const UnkNodeConfig& conf,
                    bool notPrefix);
@@ -67,6 +68,29 @@ class UnkNodesContext {
                          dic::IndexedEntries entries) const;
 };
 
+/**
+ * Runs unk makers of an analysis stage for a sentence.
+ *
+ * Character class runs of the sentence are computed once by AnalysisInput,
+ * makers whose trigger classes are not present in it are skipped.
+ * Seeds which repeat an earlier seed of the same run (the same span,
+ * template and node content) are removed before they reach the lattice.
+ */
+class UnkNodeSpawner {
+  util::FlatMap<u64, u32> seen_;
+  std::vector<LatticeNodeSeed> unique_;
+  u64 numDuplicates_ = 0;
+
+  bool isDuplicate(const LatticeNodeSeed& seed, const ExtraNodesContext& xtra);
+
+ public:
+  bool spawnNodes(util::ArraySlice<std::unique_ptr<UnkMaker>> makers,
+                  const AnalysisInput& input, UnkNodesContext* ctx,
+                  LatticeBuilder* lattice);
+
+  u64 numDuplicates() const { return numDuplicates_; }
+};
+
 class ChunkingUnkMaker : public UnkMaker {
   dic::DictionaryEntries entries_;
   chars::CharacterClass charClass_;
@@ -78,6 +102,8 @@ class ChunkingUnkMaker : public UnkMaker {
 
   bool spawnNodes(const AnalysisInput& input, UnkNodesContext* ctx,
                   LatticeBuilder* lattice) const override;
+
+  chars::CharacterClass triggerClass() const override { return charClass_; }
 };
 
 class SingleUnkMaker : public UnkMaker {
@@ -91,6 +117,8 @@ class SingleUnkMaker : public UnkMaker {
 
   bool spawnNodes(const AnalysisInput& input, UnkNodesContext* ctx,
                   LatticeBuilder* lattice) const override;
+
+  chars::CharacterClass triggerClass() const override { return charClass_; }
 };
 
 }  // namespace analysis
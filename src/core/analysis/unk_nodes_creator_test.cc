@@ -108,4 +108,35 @@ TEST_CASE("chunked unks do not go over different classes") {
   CHECK(env.contains("dx", 0, "b"));
   CHECK(env.contains("1", 2, "c"));
   CHECK(env.numNodeSeeds() == 5);
-}
\ No newline at end of file
+}
+
+TEST_CASE("duplicate unk nodes from different makers are removed") {
+  TestEnv tenv;
+  tenv.spec([](dsl::ModelSpecBuilder& specBldr) {
+    auto& a = specBldr.field(1, "a").strings().trieIndex();
+    specBldr.field(2, "b").strings();
+    specBldr.unk("chunks", 1)
+        .chunking(chars::CharacterClass::ALPH)
+        .outputTo({a});
+    specBldr.unk("singles", 1)
+        .single(chars::CharacterClass::ALPH)
+        .outputTo({a});
+    specBldr.unk("hiragana", 1)
+        .single(chars::CharacterClass::HIRAGANA)
+        .outputTo({a});
+  });
+  tenv.importDic("x,a\nxa,b\n");
+  CHECK_OK(tenv.analyzer->resetForInput("dx"));
+  CHECK_OK(tenv.analyzer->makeNodeSeedsFromDic());
+  CHECK_OK(tenv.analyzer->makeUnkNodes1());
+  // x from the dictionary, d and dx from chunks, d from singles is removed
+  auto seeds = tenv.analyzer->latticeBuilder().seeds();
+  CHECK(seeds.size() == 3);
+  i32 numShort = 0;
+  for (auto& s : seeds) {
+    if (s.codepointStart == 0 && s.codepointEnd == 1) {
+      numShort += 1;
+    }
+  }
+  CHECK(numShort == 1);
+}
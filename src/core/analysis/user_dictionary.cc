@@ -0,0 +1,367 @@
+#include "user_dictionary.h"
+#include <algorithm>
+#include <cstdlib>
+#include "core/analysis/unk_nodes_creator.h"
+#include "util/coded_io.h"
+#include "util/csv_reader.h"
+#include "util/flatset.h"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+namespace {
+
+using StringValues = util::FlatMap<StringPiece, i32>;
+
+// A feature or data value of dictionary entries which is a string pointer
+struct StringImport {
+  bool isData;
+  i32 target;
+  i32 storage;
+};
+
+// Fills pointers of the strings which are values of main dictionary
+// entries with the given surfaces, other strings keep the value of -1.
+// Only the trie paths of the surfaces and their entries are read,
+// not whole string storages.
+void resolveStrings(const dic::DictionaryHolder& dic,
+                    const std::vector<StringImport>& imports,
+                    const std::vector<const dic::impl::StringStorageReader*>&
+                        readers,
+                    const util::FlatSet<StringPiece>& surfaces,
+                    std::vector<StringValues>* storages) {
+  auto entries = dic.entries();
+  dic::DicEntryBuffer buffer;
+  auto resolve = [&](i32 storage, i32 ptr) {
+    // 0 is the empty string
+    if (ptr <= 0) {
+      return;
+    }
+    StringPiece str;
+    if (!readers[storage]->readAt(ptr, &str)) {
+      return;
+    }
+    auto& values = (*storages)[storage];
+    auto it = values.find(str);
+    if (it != values.end()) {
+      it->second = ptr;
+    }
+  };
+
+  for (auto& surface : surfaces) {
+    auto trav = entries.doubleArrayTraversal();
+    if (trav.step(surface) != dic::TraverseStatus::Ok) {
+      continue;
+    }
+    auto matched = entries.entryTraversal(trav);
+    while (matched.readOnePtr()) {
+      if (!matched.fillEntryData(&buffer)) {
+        break;
+      }
+      for (auto& imp : imports) {
+        if (!imp.isData) {
+          resolve(imp.storage, buffer.features()[imp.target]);
+        }
+      }
+      while (buffer.nextData()) {
+        for (auto& imp : imports) {
+          if (imp.isData) {
+            resolve(imp.storage, buffer.data()[imp.target]);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Fills pointers of the strings which are present in the storage
+// by decoding all of it, absent strings keep their values.
+void scanStorage(const dic::impl::StringStorageReader& reader,
+                 StringValues* values) {
+  auto data = reader.data();
+  auto alignPower = reader.alignPower();
+  size_t position = 0;
+  while (position < data.size()) {
+    // padding and the empty string at 0
+    if (data[position] == 0) {
+      position += 1;
+      continue;
+    }
+    util::CodedBufferParser parser{data.from(position)};
+    StringPiece str;
+    if (!parser.readStringPiece(&str)) {
+      return;
+    }
+    auto it = values->find(str);
+    if (it != values->end()) {
+      it->second = static_cast<i32>(position >> alignPower);
+    }
+    position = static_cast<size_t>(str.end() - data.begin());
+  }
+}
+
+bool isEmptyValue(const spec::FieldDescriptor& fld, StringPiece value) {
+  return value.size() == 0 || value == fld.emptyString;
+}
+
+}  // namespace
+
+constexpr size_t UserDictionary::MaxScannedStorageBytes;
+
+Status UserDictionary::importCsv(const spec::AnalysisSpec& spec,
+                                 const dic::DictionaryHolder& dic,
+                                 StringPiece data) {
+  auto& fields = spec.dictionary.fields;
+  auto& fspec = spec.features;
+  auto surfaceIdx = spec.dictionary.indexColumn;
+  if (surfaceIdx < 0) {
+    return JPPS_INVALID_PARAMETER << "spec does not have an index column";
+  }
+  numFeatures_ = static_cast<u32>(fspec.numDicFeatures);
+  numData_ = static_cast<u32>(fspec.numDicData);
+
+  // first pass: values of all fields and strings which need pointers
+  std::vector<StringPiece> rows;
+  std::vector<i64> lines;
+  std::vector<StringValues> storages(
+      static_cast<size_t>(spec.dictionary.numStringStorage));
+  util::CsvReader csv;
+  JPP_RETURN_IF_ERROR(csv.initFromMemory(data));
+  while (csv.nextLine()) {
+    for (auto& fld : fields) {
+      StringPiece value;
+      if (fld.position > 0) {
+        if (fld.position > csv.numFields()) {
+          return JPPS_INVALID_PARAMETER
+                 << "line #" << csv.lineNumber() << " has " << csv.numFields()
+                 << " fields, field " << fld.name << " is at position "
+                 << fld.position;
+        }
+        value = csv.field(fld.position - 1);
+      }
+      if (!chars_.import(&value)) {
+        return JPPS_INVALID_PARAMETER << "line #" << csv.lineNumber()
+                                      << ": value of field " << fld.name
+                                      << " is too long";
+      }
+      switch (fld.fieldType) {
+        case spec::FieldType::String:
+          if (!isEmptyValue(fld, value)) {
+            storages[fld.stringStorage].insert(std::make_pair(value, -1));
+          }
+          break;
+        case spec::FieldType::StringList:
+        case spec::FieldType::StringKVList:
+          if (!isEmptyValue(fld, value)) {
+            return JPPS_NOT_IMPLEMENTED
+                   << "line #" << csv.lineNumber() << ": list field "
+                   << fld.name << " must be empty in user dictionaries";
+          }
+          break;
+        default:
+          break;
+      }
+      rows.push_back(value);
+    }
+    if (rows[rows.size() - fields.size() + surfaceIdx].size() == 0) {
+      return JPPS_INVALID_PARAMETER << "line #" << csv.lineNumber()
+                                    << ": surface can not be empty";
+    }
+    lines.push_back(csv.lineNumber());
+  }
+
+  std::vector<const dic::impl::StringStorageReader*> readers(
+      storages.size());
+  for (i32 idx = 0; idx < storages.size(); ++idx) {
+    if (storages[idx].size() == 0) {
+      continue;
+    }
+    for (u32 i = 0; i < dic.fields().totalFields(); ++i) {
+      if (dic.fields().at(i).stringStorageIdx == idx) {
+        readers[idx] = &dic.fields().at(i).strings;
+        break;
+      }
+    }
+    if (readers[idx] == nullptr) {
+      return JPPS_INVALID_STATE << "dictionary does not have string storage #"
+                                << idx;
+    }
+  }
+
+  std::vector<StringImport> imports;
+  for (auto& desc : fspec.dictionary) {
+    bool isData = desc.kind == spec::DicImportKind::ImportAsData;
+    if (!isData && desc.kind != spec::DicImportKind::ImportAsFeature) {
+      continue;
+    }
+    auto& fld = fields[desc.references[0]];
+    if (fld.fieldType == spec::FieldType::String &&
+        readers[fld.stringStorage] != nullptr) {
+      imports.push_back({isData, desc.target, fld.stringStorage});
+    }
+  }
+
+  // All string values (surfaces too) are looked up as surfaces
+  // of main entries: the same word or e.g. a POS tag which is a word too.
+  util::FlatSet<StringPiece> keys;
+  for (auto& values : storages) {
+    for (auto& v : values) {
+      keys.insert(v.first);
+    }
+  }
+  resolveStrings(dic, imports, readers, keys, &storages);
+
+  for (i32 idx = 0; idx < storages.size(); ++idx) {
+    auto& values = storages[idx];
+    bool resolved = true;
+    for (auto& v : values) {
+      resolved &= v.second >= 0;
+    }
+    if (!resolved && readers[idx]->data().size() <= MaxScannedStorageBytes) {
+      scanStorage(*readers[idx], &values);
+    }
+  }
+
+  // second pass: feature and data values of entries
+  for (size_t line = 0; line < lines.size(); ++line) {
+    util::ArraySlice<StringPiece> row{rows, line * fields.size(),
+                                      fields.size()};
+    auto valueOf = [&](i32 fieldIdx, i32* result) -> Status {
+      auto& fld = fields[fieldIdx];
+      auto value = row[fieldIdx];
+      *result = 0;
+      if (fld.position == 0) {
+        return Status::Ok();
+      }
+      switch (fld.fieldType) {
+        case spec::FieldType::Int:
+          if (value.size() != 0) {
+            *result = static_cast<i32>(
+                std::strtol(value.str().c_str(), nullptr, 10));
+          }
+          break;
+        case spec::FieldType::String: {
+          if (isEmptyValue(fld, value)) {
+            break;
+          }
+          auto ptr = storages[fld.stringStorage].find(value)->second;
+          if (ptr >= 0) {
+            *result = ptr;
+            break;
+          }
+          auto hash = hashUnkString(value);
+          auto it = strings_.find(hash);
+          if (it == strings_.end()) {
+            strings_[hash] = value;
+          } else if (it->second != value) {
+            return JPPS_INVALID_PARAMETER
+                   << "values " << value << " and " << it->second
+                   << " have the same hash, rename one of them";
+          }
+          *result = hash;
+          break;
+        }
+        default:
+          // lists are empty
+          break;
+      }
+      return Status::Ok();
+    };
+
+    auto matchesTuple = [&](const spec::DicImportDescriptor& desc,
+                            bool* result) -> Status {
+      *result = false;
+      util::CsvReader tuple;
+      for (auto& s : desc.data) {
+        JPP_RETURN_IF_ERROR(tuple.initFromMemory(s));
+        if (!tuple.nextLine() || tuple.numFields() != desc.references.size()) {
+          return JPPS_INVALID_PARAMETER << "could not parse line: " << s;
+        }
+        bool equal = true;
+        for (i32 i = 0; i < desc.references.size() && equal; ++i) {
+          auto ref = desc.references[i];
+          i32 ptr = 0;
+          JPP_RETURN_IF_ERROR(valueOf(ref, &ptr));
+          // the dictionary builder does not match absent values
+          equal = ptr >= 0 && tuple.field(i) == row[ref];
+        }
+        if (equal) {
+          *result = true;
+          return Status::Ok();
+        }
+      }
+      return Status::Ok();
+    };
+
+    Entry entry;
+    entry.surface = row[surfaceIdx];
+    entry.values.resize(numFeatures_ + numData_, 0);
+    for (auto& desc : fspec.dictionary) {
+      switch (desc.kind) {
+        case spec::DicImportKind::ImportAsFeature:
+          JPP_RIE_MSG(valueOf(desc.references[0], &entry.values[desc.target]),
+                      "line #" << lines[line]);
+          break;
+        case spec::DicImportKind::ImportAsData:
+          JPP_RIE_MSG(valueOf(desc.references[0],
+                              &entry.values[numFeatures_ + desc.target]),
+                      "line #" << lines[line]);
+          break;
+        case spec::DicImportKind::MatchListKey:
+          // lists are empty and never match
+          break;
+        case spec::DicImportKind::MatchFields: {
+          bool matches = false;
+          JPP_RIE_MSG(matchesTuple(desc, &matches), "line #" << lines[line]);
+          if (matches) {
+            entry.values[desc.target] |= (1 << desc.shift);
+          }
+          break;
+        }
+        default:
+          return JPPS_INVALID_PARAMETER << "feature " << desc.name
+                                        << " was not initialized";
+      }
+    }
+    entries_.push_back(std::move(entry));
+  }
+
+  return buildTrie();
+}
+
+Status UserDictionary::buildTrie() {
+  std::stable_sort(entries_.begin(), entries_.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return std::lexicographical_compare(
+                         a.surface.begin(), a.surface.end(), b.surface.begin(),
+                         b.surface.end());
+                   });
+  groupStarts_.clear();
+  trieBldr_.reset(new dic::CodepointTrieBuilder);
+  for (u32 i = 0; i < entries_.size(); ++i) {
+    if (i == 0 || entries_[i].surface != entries_[i - 1].surface) {
+      auto group = static_cast<i32>(groupStarts_.size());
+      JPP_RETURN_IF_ERROR(trieBldr_->add(entries_[i].surface, group));
+      groupStarts_.push_back(i);
+    }
+  }
+  groupStarts_.push_back(static_cast<u32>(entries_.size()));
+  if (entries_.empty()) {
+    return Status::Ok();
+  }
+  JPP_RETURN_IF_ERROR(trieBldr_->build());
+  return trie_.loadFromMemory(trieBldr_->result());
+}
+
+StringPiece UserDictionary::stringOf(i32 value) const {
+  auto it = strings_.find(value);
+  if (it == strings_.end()) {
+    return StringPiece{};
+  }
+  return it->second;
+}
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
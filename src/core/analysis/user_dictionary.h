@@ -0,0 +1,89 @@
+#ifndef JUMANPP_USER_DICTIONARY_H
+#define JUMANPP_USER_DICTIONARY_H
+
+#include <memory>
+#include <vector>
+#include "core/dic/codepoint_trie.h"
+#include "core/dic/dictionary.h"
+#include "core/spec/spec_types.h"
+#include "util/array_slice.h"
+#include "util/char_buffer.h"
+#include "util/flatmap.h"
+#include "util/status.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace analysis {
+
+/**
+ * Dictionary entries which are imported at runtime from CSV files
+ * in the format of the main dictionary, without rebuilding the model.
+ * The main dictionary is only read.
+ *
+ * String values get the same pointers as in the main dictionary,
+ * so user entries are scored like main ones, if they are values of
+ * main entries with the surface of the user entry or with one of its values
+ * as the surface (e.g. a POS tag which is a word as well).
+ * Only these entries are read, and string storages which are not larger
+ * than MaxScannedStorageBytes (e.g. of POS tags) are scanned for the rest.
+ * Other strings are represented by their hashes,
+ * like surfaces of unknown words (see hashUnkString).
+ * List fields of user entries must be empty.
+ *
+ * Entries are looked up with their own codepoint trie and become
+ * ExtraNodeType::User nodes (see DictionaryNodeCreator::spawnUserNodes).
+ */
+class UserDictionary {
+  struct Entry {
+    StringPiece surface;
+    std::vector<i32> values;
+  };
+
+  u32 numFeatures_ = 0;
+  u32 numData_ = 0;
+  std::vector<Entry> entries_;
+  // entries with the same surface form a group, trie values are group ids
+  std::vector<u32> groupStarts_;
+  util::CharBuffer<> chars_;
+  util::FlatMap<i32, StringPiece> strings_;
+  std::unique_ptr<dic::CodepointTrieBuilder> trieBldr_;
+  dic::CodepointTrie trie_;
+
+  Status buildTrie();
+
+ public:
+  static constexpr size_t MaxScannedStorageBytes = 64 * 1024;
+
+  /**
+   * Imports entries from CSV data, can be called several times.
+   * The spec and the dictionary must be the ones of the analyzers
+   * which will use the entries.
+   */
+  Status importCsv(const spec::AnalysisSpec& spec,
+                   const dic::DictionaryHolder& dic, StringPiece data);
+
+  bool empty() const { return entries_.empty(); }
+  size_t size() const { return entries_.size(); }
+  const dic::CodepointTrie& trie() const { return trie_; }
+
+  // entries of a group are [groupStart(g), groupStart(g + 1))
+  i32 groupStart(i32 group) const { return groupStarts_[group]; }
+
+  util::ArraySlice<i32> features(i32 entry) const {
+    return util::ArraySlice<i32>{entries_[entry].values, 0, numFeatures_};
+  }
+
+  util::ArraySlice<i32> data(i32 entry) const {
+    return util::ArraySlice<i32>{entries_[entry].values, numFeatures_,
+                                 numData_};
+  }
+
+  // string of a value which was not found in the main dictionary
+  StringPiece stringOf(i32 value) const;
+};
+
+}  // namespace analysis
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_USER_DICTIONARY_H
@@ -0,0 +1,139 @@
+#include "user_dictionary.h"
+#include "testing/test_analyzer.h"
+
+using namespace jumanpp::core::analysis;
+using namespace jumanpp::testing;
+using namespace jumanpp;
+
+namespace {
+class UserDicTestEnv {
+ public:
+  TestEnv tenv;
+  UserDictionary userDic;
+  StringField flda;
+  StringField fldb;
+  StringField fldc;
+
+  explicit UserDicTestEnv(StringPiece csvData) {
+    tenv.spec([](core::spec::dsl::ModelSpecBuilder& specBldr) {
+      auto& a = specBldr.field(1, "a").strings().trieIndex();
+      auto& b = specBldr.field(2, "b").strings();
+      specBldr.field(3, "c").strings();
+      specBldr.unigram({a, b});
+    });
+    tenv.importDic(csvData);
+  }
+
+  void importUser(StringPiece csvData) {
+    REQUIRE_OK(userDic.importCsv(tenv.core->spec(), tenv.dic, csvData));
+    tenv.aconf.userDictionary = &userDic;
+    ScoringConfig scoreConf{tenv.beamSize, 1};
+    tenv.analyzer.reset(
+        new TestAnalyzer(tenv.core.get(), scoreConf, tenv.aconf));
+    auto& output = tenv.analyzer->output();
+    REQUIRE_OK(output.stringField("a", &flda));
+    REQUIRE_OK(output.stringField("b", &fldb));
+    REQUIRE_OK(output.stringField("c", &fldc));
+  }
+
+  void analyze(StringPiece str) {
+    CAPTURE(str);
+    REQUIRE_OK(tenv.analyzer->resetForInput(str));
+    REQUIRE_OK(tenv.analyzer->prepareNodeSeeds());
+  }
+};
+}  // namespace
+
+TEST_CASE("user dictionary entries become lattice nodes") {
+  UserDicTestEnv env{"すもも,1,x\nうち,2,y\n"};
+  env.importUser("うち,1,new\nうち,3,x\nもも,2,z\n");
+  CHECK(env.userDic.size() == 3);
+  env.analyze("すももももうち");
+
+  auto& output = env.tenv.analyzer->output();
+  auto walker = output.nodeWalker();
+  std::vector<std::string> user;
+  for (auto& seed : env.tenv.analyzer->latticeBuilder().seeds()) {
+    if (!seed.entryPtr.isSpecial()) {
+      continue;
+    }
+    REQUIRE(output.locate(seed.entryPtr, &walker));
+    REQUIRE(walker.next());
+    std::string value = env.flda[walker].str();
+    value += ",";
+    value += env.fldb[walker].str();
+    value += ",";
+    value += env.fldc[walker].str();
+    user.push_back(value);
+    CHECK_FALSE(walker.next());
+  }
+  CHECK(user == std::vector<std::string>{"もも,2,z", "もも,2,z", "もも,2,z",
+                                         "うち,1,new", "うち,3,x"});
+}
+
+TEST_CASE("user dictionary uses pointers of the main dictionary strings") {
+  UserDicTestEnv env{"すもも,1,x\nうち,2,y\n"};
+  env.importUser("うち,1,new\n");
+  env.analyze("うち");
+
+  auto& output = env.tenv.analyzer->output();
+  auto walker = output.nodeWalker();
+  auto seeds = env.tenv.analyzer->latticeBuilder().seeds();
+  REQUIRE(seeds.size() == 2);
+  REQUIRE(output.locate(seeds[0].entryPtr, &walker));
+  REQUIRE(walker.next());
+  auto a = env.flda.pointer(walker);
+  auto b = env.fldb.pointer(walker);
+  REQUIRE(output.locate(seeds[1].entryPtr, &walker));
+  REQUIRE(walker.next());
+  CHECK(env.flda.pointer(walker) == a);
+  CHECK(env.fldb.pointer(walker) != b);
+  CHECK(env.fldb.pointer(walker) > 0);
+  CHECK(env.fldc.pointer(walker) < 0);
+  CHECK(env.fldc[walker] == "new");
+}
+
+TEST_CASE("user dictionary does not scan large string storages") {
+  std::string dic = "すもも,1,x\n";
+  for (int i = 0; i < 3000; ++i) {
+    auto num = std::to_string(i);
+    dic += "w" + num + ",1,value-of-an-entry-number-" + num + "\n";
+  }
+  UserDicTestEnv env{dic};
+  REQUIRE(env.tenv.dic.fieldByName("c")->strings.data().size() >
+          UserDictionary::MaxScannedStorageBytes);
+  env.importUser(
+      "w7,2,value-of-an-entry-number-7\n"
+      "もも,1,value-of-an-entry-number-8\n");
+  auto& output = env.tenv.analyzer->output();
+  auto walker = output.nodeWalker();
+
+  env.analyze("w7");
+  auto seeds = env.tenv.analyzer->latticeBuilder().seeds();
+  REQUIRE(seeds.size() == 2);
+  REQUIRE(output.locate(seeds[0].entryPtr, &walker));
+  REQUIRE(walker.next());
+  auto c = env.fldc.pointer(walker);
+  REQUIRE(output.locate(seeds[1].entryPtr, &walker));
+  REQUIRE(walker.next());
+  // found through the main entry with the same surface
+  CHECK(env.fldc.pointer(walker) == c);
+
+  env.analyze("もも");
+  seeds = env.tenv.analyzer->latticeBuilder().seeds();
+  REQUIRE(seeds.size() == 1);
+  REQUIRE(output.locate(seeds[0].entryPtr, &walker));
+  REQUIRE(walker.next());
+  // the storage of b is small and was scanned
+  CHECK(env.fldb.pointer(walker) > 0);
+  CHECK(env.fldb[walker] == "1");
+  CHECK(env.fldc.pointer(walker) < 0);
+  CHECK(env.fldc[walker] == "value-of-an-entry-number-8");
+}
+
+TEST_CASE("user dictionary rejects lines without some fields") {
+  UserDicTestEnv env{"すもも,1,x\nうち,2,y\n"};
+  UserDictionary dic;
+  CHECK_FALSE(dic.importCsv(env.tenv.core->spec(), env.tenv.dic, "うち,1\n"));
+  CHECK(dic.empty());
+}
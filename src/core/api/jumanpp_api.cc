@@ -0,0 +1,387 @@
+#include "jumanpp_api.h"
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/analysis/analysis_result.h"
+#include "core/analysis/analyzer_impl.h"
+#include "core/analysis/lattice_types.h"
+#include "core/analysis/output.h"
+#include "core/env.h"
+
+using namespace jumanpp;
+
+struct jpp_model {
+  core::JumanppEnv env;
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+jpp_status reportError(const Status& status) {
+  lastError = status.message().str();
+  switch (status.code()) {
+    case StatusCode::Ok:
+      return JPP_STATUS_OK;
+    case StatusCode::InvalidParameter:
+      return JPP_STATUS_INVALID_PARAMETER;
+    case StatusCode::NotImplemented:
+      return JPP_STATUS_NOT_IMPLEMENTED;
+    default:
+      return JPP_STATUS_INVALID_STATE;
+  }
+}
+
+jpp_status reportError(const std::exception& e) {
+  lastError = e.what();
+  return JPP_STATUS_INVALID_STATE;
+}
+
+jpp_string toApi(StringPiece sp) {
+  return jpp_string{sp.char_begin(), sp.size()};
+}
+
+struct ApiField {
+  core::spec::FieldType type;
+  i32 index;
+  core::analysis::StringField strings;
+  core::analysis::StringListField stringLists;
+  core::analysis::KVListField kvLists;
+};
+
+}  // namespace
+
+struct jpp_analyzer {
+  const jpp_model* model;
+  core::analysis::Analyzer analyzer;
+  core::analysis::AnalysisPath top1;
+  core::analysis::NodeWalker walker;
+  std::vector<std::unique_ptr<ApiField>> fields;
+
+  std::vector<jpp_sentence_result> sentences;
+  std::vector<jpp_morpheme> morphemes;
+  std::vector<jpp_field_value> values;
+  std::vector<jpp_string> items;
+  // strings which exist neither in the model nor in the input
+  std::deque<std::string> ownedStrings;
+
+  Status initialize() {
+    JPP_RETURN_IF_ERROR(model->env.makeAnalyzer(&analyzer));
+    auto& omgr = analyzer.output();
+    walker = omgr.nodeWalker();
+    auto& dicFields = model->env.coreHolder()->dic().fields();
+    for (u32 i = 0; i < dicFields.totalFields(); ++i) {
+      auto& df = dicFields.at(i);
+      std::unique_ptr<ApiField> fld{new ApiField};
+      fld->type = df.columnType;
+      fld->index = df.idxInEntry;
+      switch (df.columnType) {
+        case core::spec::FieldType::Int:
+          break;
+        case core::spec::FieldType::String:
+          JPP_RETURN_IF_ERROR(omgr.stringField(df.name, &fld->strings));
+          break;
+        case core::spec::FieldType::StringList:
+          JPP_RETURN_IF_ERROR(
+              omgr.stringListField(df.name, &fld->stringLists));
+          break;
+        case core::spec::FieldType::StringKVList:
+          JPP_RETURN_IF_ERROR(omgr.kvListField(df.name, &fld->kvLists));
+          break;
+        default:
+          return JPPS_INVALID_STATE << "field " << df.name
+                                    << " has unsupported type";
+      }
+      fields.emplace_back(std::move(fld));
+    }
+    return Status::Ok();
+  }
+
+  // Strings of the unknown words point into the analyzer input,
+  // which is overwritten by the next sentence.
+  // Move them to the caller's sentence or make a copy.
+  StringPiece stableString(StringPiece str, StringPiece input,
+                           StringPiece callerInput) {
+    if (str.begin() >= input.begin() && str.end() <= input.end()) {
+      auto offset = str.begin() - input.begin();
+      return StringPiece{callerInput.begin() + offset, str.size()};
+    }
+    ownedStrings.emplace_back(str.begin(), str.end());
+    return StringPiece{ownedStrings.back()};
+  }
+
+  Status fillValue(const ApiField& fld, bool unknown, StringPiece input,
+                   StringPiece callerInput, jpp_field_value* result) {
+    result->string = jpp_string{nullptr, 0};
+    result->items_begin = static_cast<u32>(items.size());
+    result->items_count = 0;
+    if (!walker.valueOf(fld.index, &result->id)) {
+      return JPPS_INVALID_STATE << "failed to read a field value";
+    }
+    switch (fld.type) {
+      case core::spec::FieldType::Int:
+        break;
+      case core::spec::FieldType::String: {
+        auto str = fld.strings[walker];
+        if (unknown) {
+          str = stableString(str, input, callerInput);
+        }
+        result->string = toApi(str);
+        break;
+      }
+      case core::spec::FieldType::StringList: {
+        auto iter = fld.stringLists[walker];
+        StringPiece str;
+        while (iter.next(&str)) {
+          items.push_back(toApi(str));
+        }
+        break;
+      }
+      case core::spec::FieldType::StringKVList: {
+        auto iter = fld.kvLists[walker];
+        while (iter.next()) {
+          items.push_back(toApi(iter.key()));
+          if (iter.hasValue()) {
+            items.push_back(toApi(iter.value()));
+          } else {
+            items.push_back(jpp_string{nullptr, 0});
+          }
+        }
+        break;
+      }
+      default:
+        return JPPS_INVALID_STATE << "unsupported field type";
+    }
+    result->items_count =
+        static_cast<u32>(items.size() - result->items_begin);
+    return Status::Ok();
+  }
+
+  Status fillTop1(StringPiece callerInput) {
+    auto impl = analyzer.impl();
+    auto lattice = impl->lattice();
+    auto& omgr = analyzer.output();
+    auto input = impl->input().surface();
+    JPP_RETURN_IF_ERROR(top1.fillIn(lattice));
+
+    core::analysis::ConnectionPtr ptr;
+    while (top1.nextBoundary()) {
+      if (!top1.nextNode(&ptr)) {
+        return JPPS_INVALID_STATE << "failed to find a node at " << ptr;
+      }
+      if (!omgr.locate(ptr.latticeNodePtr(), &walker) || !walker.next()) {
+        return JPPS_INVALID_STATE << "failed to find a node at " << ptr;
+      }
+
+      auto bnd = lattice->boundary(ptr.boundary);
+      auto& ninfo = bnd->starts()->nodeInfo().at(ptr.right);
+      auto position = ptr.boundary - 2;  // we have 2 BOS
+      auto surface =
+          impl->input().surface(position, position + ninfo.numCodepoints());
+      bool unknown = walker.eptr().isSpecial();
+
+      jpp_morpheme morph;
+      morph.begin = static_cast<u32>(surface.begin() - input.begin());
+      morph.length = static_cast<u32>(surface.size());
+      morph.values_begin = static_cast<u32>(values.size());
+      morph.is_unknown = unknown ? 1 : 0;
+      morphemes.push_back(morph);
+
+      for (auto& fld : fields) {
+        values.emplace_back();
+        JPP_RETURN_IF_ERROR(
+            fillValue(*fld, unknown, input, callerInput, &values.back()));
+      }
+    }
+    return Status::Ok();
+  }
+
+  void resetResults() {
+    sentences.clear();
+    morphemes.clear();
+    values.clear();
+    items.clear();
+    ownedStrings.clear();
+  }
+
+  void analyzeOne(StringPiece sentence) {
+    jpp_sentence_result result;
+    result.morphemes_begin = static_cast<u32>(morphemes.size());
+    auto valuesSize = values.size();
+    auto itemsSize = items.size();
+
+    Status s = analyzer.analyze(sentence);
+    if (s) {
+      s = fillTop1(sentence);
+    }
+    if (!s) {
+      // do not leave partial results
+      morphemes.resize(result.morphemes_begin);
+      values.resize(valuesSize);
+      items.resize(itemsSize);
+    }
+    result.status = s ? JPP_STATUS_OK : reportError(s);
+    result.degraded = analyzer.impl()->degraded() ? 1 : 0;
+    result.morphemes_count =
+        static_cast<u32>(morphemes.size() - result.morphemes_begin);
+    sentences.push_back(result);
+  }
+
+  void exportResults(jpp_batch_result* result) const {
+    result->sentences = sentences.data();
+    result->num_sentences = sentences.size();
+    result->morphemes = morphemes.data();
+    result->num_morphemes = morphemes.size();
+    result->values = values.data();
+    result->num_values = values.size();
+    result->items = items.data();
+    result->num_items = items.size();
+    result->num_fields = fields.size();
+  }
+};
+
+extern "C" {
+
+uint32_t jpp_api_version(void) { return JPP_API_VERSION; }
+
+const char* jpp_last_error(void) { return lastError.c_str(); }
+
+jpp_status jpp_model_load(const char* filename, jpp_model** result) {
+  lastError.clear();
+  if (filename == nullptr || result == nullptr) {
+    return reportError(JPPS_INVALID_PARAMETER << "arguments must not be null");
+  }
+  try {
+    std::unique_ptr<jpp_model> model{new jpp_model};
+    auto& env = model->env;
+    Status s = env.loadModel(StringPiece::fromCString(filename));
+    if (!s) {
+      return reportError(s);
+    }
+    // defaults of the jumanpp binary
+    env.setBeamSize(5);
+    env.setGlobalBeam(6, 1, 5);
+    s = env.initFeatures(nullptr);
+    if (!s) {
+      return reportError(s);
+    }
+    if (!env.hasPerceptronModel()) {
+      return reportError(JPPS_INVALID_PARAMETER
+                         << "model " << filename << " was not trained");
+    }
+    *result = model.release();
+    return JPP_STATUS_OK;
+  } catch (std::exception& e) {
+    return reportError(e);
+  }
+}
+
+void jpp_model_destroy(jpp_model* model) { delete model; }
+
+void jpp_model_set_deadline(jpp_model* model, int64_t micros) {
+  model->env.setDeadline(micros);
+}
+
+jpp_status jpp_model_set_beam(jpp_model* model, uint32_t beam) {
+  lastError.clear();
+  if (beam == 0) {
+    return reportError(JPPS_INVALID_PARAMETER << "beam size must not be zero");
+  }
+  model->env.setBeamSize(beam);
+  return JPP_STATUS_OK;
+}
+
+jpp_status jpp_model_set_global_beam(jpp_model* model, int32_t global_beam,
+                                     int32_t right_check, int32_t right_beam) {
+  lastError.clear();
+  if (global_beam < 0 || right_check < 0 || right_beam < 0) {
+    return reportError(JPPS_INVALID_PARAMETER
+                       << "global beam sizes must not be negative");
+  }
+  if (right_check > 0 && right_beam == 0) {
+    return reportError(JPPS_INVALID_PARAMETER
+                       << "right beam size must not be zero when the right "
+                          "check is enabled");
+  }
+  model->env.setGlobalBeam(global_beam, right_check, right_beam);
+  return JPP_STATUS_OK;
+}
+
+size_t jpp_model_num_fields(const jpp_model* model) {
+  return model->env.coreHolder()->dic().fields().totalFields();
+}
+
+jpp_string jpp_model_field_name(const jpp_model* model, size_t field) {
+  auto& fields = model->env.coreHolder()->dic().fields();
+  if (field >= fields.totalFields()) {
+    return jpp_string{nullptr, 0};
+  }
+  return toApi(fields.at(static_cast<i32>(field)).name);
+}
+
+jpp_field_type jpp_model_field_type(const jpp_model* model, size_t field) {
+  auto& fields = model->env.coreHolder()->dic().fields();
+  if (field >= fields.totalFields()) {
+    return JPP_FIELD_INVALID;
+  }
+  switch (fields.at(static_cast<i32>(field)).columnType) {
+    case core::spec::FieldType::Int:
+      return JPP_FIELD_INT;
+    case core::spec::FieldType::StringList:
+      return JPP_FIELD_STRING_LIST;
+    case core::spec::FieldType::StringKVList:
+      return JPP_FIELD_KV_LIST;
+    default:
+      return JPP_FIELD_STRING;
+  }
+}
+
+jpp_status jpp_analyzer_create(const jpp_model* model, jpp_analyzer** result) {
+  lastError.clear();
+  if (model == nullptr || result == nullptr) {
+    return reportError(JPPS_INVALID_PARAMETER << "arguments must not be null");
+  }
+  try {
+    std::unique_ptr<jpp_analyzer> analyzer{new jpp_analyzer};
+    analyzer->model = model;
+    Status s = analyzer->initialize();
+    if (!s) {
+      return reportError(s);
+    }
+    *result = analyzer.release();
+    return JPP_STATUS_OK;
+  } catch (std::exception& e) {
+    return reportError(e);
+  }
+}
+
+void jpp_analyzer_destroy(jpp_analyzer* analyzer) { delete analyzer; }
+
+jpp_status jpp_analyze_batch(jpp_analyzer* analyzer,
+                             const char* const* sentences,
+                             const size_t* lengths, size_t num_sentences,
+                             jpp_batch_result* result) {
+  lastError.clear();
+  if (analyzer == nullptr || result == nullptr ||
+      (sentences == nullptr && num_sentences != 0)) {
+    return reportError(JPPS_INVALID_PARAMETER << "arguments must not be null");
+  }
+  try {
+    analyzer->resetResults();
+    for (size_t i = 0; i < num_sentences; ++i) {
+      auto data = sentences[i];
+      auto length = lengths == nullptr ? std::strlen(data) : lengths[i];
+      analyzer->analyzeOne(StringPiece{data, length});
+    }
+    analyzer->exportResults(result);
+    return JPP_STATUS_OK;
+  } catch (std::exception& e) {
+    analyzer->resetResults();
+    analyzer->exportResults(result);
+    return reportError(e);
+  }
+}
+
+}  // extern "C"
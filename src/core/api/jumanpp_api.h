@@ -0,0 +1,191 @@
+/*
+ * C API of Juman++ core.
+ * It is intended for embedding the analyzer into programs
+ * written in other languages (e.g. using cgo or Rust FFI),
+ * so this header must be valid C.
+ *
+ * Usage:
+ *   1. Load a model with jpp_model_load and configure it with
+ *      jpp_model_set_* functions. After that a model handle must not be
+ *      modified and can be shared between threads.
+ *   2. Create an analyzer for each thread with jpp_analyzer_create.
+ *   3. Analyze sentences with jpp_analyze_batch.
+ *      Results are stored in flat arrays owned by the analyzer.
+ *
+ * Strings in results point either into the loaded model
+ * (dictionary strings), or into the input sentences
+ * (surfaces of unknown words) or into the analyzer memory.
+ * Results are valid until the next call of jpp_analyze_batch
+ * for the same analyzer, while the input sentences are alive.
+ */
+
+#ifndef JUMANPP_API_H
+#define JUMANPP_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JPP_API_VERSION 2
+
+typedef struct jpp_model jpp_model;
+typedef struct jpp_analyzer jpp_analyzer;
+
+typedef enum jpp_status {
+  JPP_STATUS_OK = 0,
+  JPP_STATUS_INVALID_PARAMETER = 1,
+  JPP_STATUS_INVALID_STATE = 2,
+  JPP_STATUS_NOT_IMPLEMENTED = 3
+} jpp_status;
+
+typedef enum jpp_field_type {
+  /* Returned for field indices which are out of range */
+  JPP_FIELD_INVALID = -1,
+  JPP_FIELD_STRING = 0,
+  JPP_FIELD_INT = 1,
+  JPP_FIELD_STRING_LIST = 2,
+  JPP_FIELD_KV_LIST = 3
+} jpp_field_type;
+
+/* Not zero-terminated */
+typedef struct jpp_string {
+  const char* data;
+  size_t length;
+} jpp_string;
+
+typedef struct jpp_field_value {
+  /*
+   * Raw value of the field in the dictionary:
+   * string id for string fields (the same strings have the same ids),
+   * value for int fields and list id for list fields.
+   * Unknown words have negative string ids.
+   */
+  int32_t id;
+  /* Value of string fields, empty for other fields */
+  jpp_string string;
+  /*
+   * Elements of list fields are stored in jpp_batch_result.items.
+   * Key-value lists store keys and values interleaved,
+   * a key without a value has a value with NULL data.
+   * items_count is the number of jpp_string elements.
+   */
+  uint32_t items_begin;
+  uint32_t items_count;
+} jpp_field_value;
+
+typedef struct jpp_morpheme {
+  /* Byte offset of the morpheme in its sentence */
+  uint32_t begin;
+  /* Length of the morpheme in bytes */
+  uint32_t length;
+  /*
+   * Index of the first value of this morpheme in jpp_batch_result.values,
+   * there are jpp_batch_result.num_fields values for each morpheme.
+   */
+  uint32_t values_begin;
+  /* Non-zero if the morpheme was not in the dictionary */
+  uint32_t is_unknown;
+} jpp_morpheme;
+
+typedef struct jpp_sentence_result {
+  jpp_status status;
+  uint32_t morphemes_begin;
+  uint32_t morphemes_count;
+  /*
+   * Non-zero if analysis used narrower beams or skipped the RNN
+   * to fit into the deadline, see jpp_model_set_deadline
+   */
+  uint32_t degraded;
+} jpp_sentence_result;
+
+typedef struct jpp_batch_result {
+  const jpp_sentence_result* sentences;
+  size_t num_sentences;
+  const jpp_morpheme* morphemes;
+  size_t num_morphemes;
+  const jpp_field_value* values;
+  size_t num_values;
+  const jpp_string* items;
+  size_t num_items;
+  /* Same as jpp_model_num_fields */
+  size_t num_fields;
+} jpp_batch_result;
+
+uint32_t jpp_api_version(void);
+
+/*
+ * Message of the last error which has happened in this thread.
+ * Valid until the next API call in this thread.
+ */
+const char* jpp_last_error(void);
+
+/*
+ * Loads a trained model.
+ * Analysis uses the same beam settings as the jumanpp binary by default.
+ */
+jpp_status jpp_model_load(const char* filename, jpp_model** result);
+void jpp_model_destroy(jpp_model* model);
+
+/*
+ * Sets a time budget for analysis of a single sentence in microseconds,
+ * 0 (default) disables it.
+ * Analysis which is likely to exceed the budget uses narrower beams
+ * and does not use the RNN.
+ * Affects only analyzers which are created after this call.
+ */
+void jpp_model_set_deadline(jpp_model* model, int64_t micros);
+
+/*
+ * Sets the size of the local beam, 5 by default, it must not be zero.
+ * Affects only analyzers which are created after this call.
+ */
+jpp_status jpp_model_set_beam(jpp_model* model, uint32_t beam);
+
+/*
+ * Sets the global beam size, the number of checked right nodes
+ * and the right beam size, 6, 1 and 5 by default.
+ * Zero global_beam disables the global beam,
+ * zero right_check disables the right check and the right beam.
+ * Affects only analyzers which are created after this call.
+ */
+jpp_status jpp_model_set_global_beam(jpp_model* model, int32_t global_beam,
+                                     int32_t right_check, int32_t right_beam);
+
+/*
+ * Fields are indexed from 0 to jpp_model_num_fields() - 1.
+ * For other indices field name is an empty string with null data
+ * and field type is JPP_FIELD_INVALID.
+ */
+size_t jpp_model_num_fields(const jpp_model* model);
+jpp_string jpp_model_field_name(const jpp_model* model, size_t field);
+jpp_field_type jpp_model_field_type(const jpp_model* model, size_t field);
+
+/*
+ * Analyzer can be used only by a single thread at a time.
+ * It must be destroyed before the model.
+ */
+jpp_status jpp_analyzer_create(const jpp_model* model, jpp_analyzer** result);
+void jpp_analyzer_destroy(jpp_analyzer* analyzer);
+
+/*
+ * Analyzes sentences and returns the best analysis for each of them.
+ * Sentences are UTF-8 without newlines, they are not required to be
+ * zero-terminated.
+ * If lengths is NULL, sentences must be zero-terminated.
+ *
+ * A failure to analyze a single sentence is reported in its
+ * jpp_sentence_result, such sentences have no morphemes.
+ */
+jpp_status jpp_analyze_batch(jpp_analyzer* analyzer,
+                             const char* const* sentences,
+                             const size_t* lengths, size_t num_sentences,
+                             jpp_batch_result* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JUMANPP_API_H */
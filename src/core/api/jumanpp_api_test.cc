@@ -0,0 +1,187 @@
+#include "jumanpp_api.h"
+#include <cstring>
+#include "core/impl/perceptron_io.h"
+#include "testing/test_analyzer.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core;
+
+namespace {
+
+class ApiTestEnv {
+ public:
+  testing::TestEnv tenv;
+  TempFile modelFile;
+  std::vector<float> weights = std::vector<float>(1 << 8, 0.1f);
+  util::serialization::Saver saver;
+  jpp_model* model = nullptr;
+  jpp_analyzer* analyzer = nullptr;
+
+  ApiTestEnv() {
+    tenv.spec([](spec::dsl::ModelSpecBuilder& sb) {
+      auto& a = sb.field(1, "a").strings().trieIndex();
+      auto& b = sb.field(2, "b").strings();
+      sb.field(3, "c").kvLists();
+      sb.field(4, "d").stringLists();
+      sb.unigram({a, b});
+      sb.unk("alpha", 1).chunking(chars::CharacterClass::ALPH).outputTo({a});
+    });
+    REQUIRE_OK(tenv.origDicBuilder.importSpec(&tenv.originalSpec));
+    REQUIRE_OK(tenv.origDicBuilder.importCsv(
+        "test", "a,b,k:v,x y\nb,c,k,\nab,d,,z\n"));
+
+    model::ModelInfo info{};
+    info.parts.emplace_back();
+    REQUIRE_OK(tenv.origDicBuilder.fillModelPart(&info.parts.back()));
+
+    PerceptronInfo pi{8};
+    saver.save(pi);
+    model::ModelPart perc;
+    perc.kind = model::ModelPartKind::Perceprton;
+    perc.data.push_back(saver.result());
+    auto wptr = reinterpret_cast<const char*>(weights.data());
+    perc.data.push_back(
+        StringPiece{wptr, wptr + weights.size() * sizeof(float)});
+    info.parts.push_back(perc);
+
+    model::ModelSaver msaver;
+    REQUIRE_OK(msaver.open(modelFile.name()));
+    REQUIRE_OK(msaver.save(info));
+
+    REQUIRE(jpp_model_load(modelFile.name().c_str(), &model) ==
+            JPP_STATUS_OK);
+    REQUIRE(jpp_analyzer_create(model, &analyzer) == JPP_STATUS_OK);
+  }
+
+  ~ApiTestEnv() {
+    jpp_analyzer_destroy(analyzer);
+    jpp_model_destroy(model);
+  }
+
+  i32 fieldIdx(StringPiece name) const {
+    for (size_t i = 0; i < jpp_model_num_fields(model); ++i) {
+      auto fld = jpp_model_field_name(model, i);
+      if (StringPiece{fld.data, fld.length} == name) {
+        return static_cast<i32>(i);
+      }
+    }
+    return -1;
+  }
+};
+
+StringPiece sp(jpp_string s) { return StringPiece{s.data, s.length}; }
+
+}  // namespace
+
+TEST_CASE("c api describes model fields") {
+  ApiTestEnv env;
+  CHECK(jpp_api_version() == JPP_API_VERSION);
+  REQUIRE(jpp_model_num_fields(env.model) == 4);
+  CHECK(jpp_model_field_type(env.model, env.fieldIdx("a")) ==
+        JPP_FIELD_STRING);
+  CHECK(jpp_model_field_type(env.model, env.fieldIdx("c")) ==
+        JPP_FIELD_KV_LIST);
+  CHECK(jpp_model_field_type(env.model, env.fieldIdx("d")) ==
+        JPP_FIELD_STRING_LIST);
+  CHECK(jpp_model_field_name(env.model, 10).data == nullptr);
+  CHECK(jpp_model_field_type(env.model, 4) == JPP_FIELD_INVALID);
+}
+
+TEST_CASE("c api analyzes a batch of sentences") {
+  ApiTestEnv env;
+  std::string s0 = "abba";
+  std::string s1 = "zzab";
+  const char* sentences[] = {s0.c_str(), s1.c_str()};
+  jpp_batch_result result;
+  REQUIRE(jpp_analyze_batch(env.analyzer, sentences, nullptr, 2, &result) ==
+          JPP_STATUS_OK);
+  REQUIRE(result.num_sentences == 2);
+  REQUIRE(result.num_fields == 4);
+  CHECK(result.num_values == result.num_morphemes * 4);
+
+  auto fa = env.fieldIdx("a");
+  auto fc = env.fieldIdx("c");
+  auto fd = env.fieldIdx("d");
+  bool sawUnknown = false;
+  for (int i = 0; i < 2; ++i) {
+    auto& sent = result.sentences[i];
+    StringPiece input = i == 0 ? s0 : s1;
+    REQUIRE(sent.status == JPP_STATUS_OK);
+    REQUIRE(sent.morphemes_count > 0);
+    u32 position = 0;
+    for (u32 j = 0; j < sent.morphemes_count; ++j) {
+      auto& m = result.morphemes[sent.morphemes_begin + j];
+      CHECK(m.begin == position);
+      position += m.length;
+      auto values = result.values + m.values_begin;
+      auto surface = input.slice(m.begin, m.begin + m.length);
+      CHECK(sp(values[fa].string) == surface);
+      if (m.is_unknown) {
+        sawUnknown = true;
+        // unknown words point into the input sentence
+        CHECK(values[fa].string.data == input.char_begin() + m.begin);
+        CHECK(values[fa].id < 0);
+      }
+      if (surface == "a" && !m.is_unknown) {
+        auto& kv = values[fc];
+        REQUIRE(kv.items_count == 2);
+        CHECK(sp(result.items[kv.items_begin]) == "k");
+        CHECK(sp(result.items[kv.items_begin + 1]) == "v");
+        auto& lst = values[fd];
+        REQUIRE(lst.items_count == 2);
+        CHECK(sp(result.items[lst.items_begin]) == "x");
+        CHECK(sp(result.items[lst.items_begin + 1]) == "y");
+      }
+      if (surface == "b" && !m.is_unknown) {
+        auto& kv = values[fc];
+        REQUIRE(kv.items_count == 2);
+        CHECK(sp(result.items[kv.items_begin]) == "k");
+        CHECK(result.items[kv.items_begin + 1].data == nullptr);
+        CHECK(values[fd].items_count == 0);
+      }
+    }
+    CHECK(position == input.size());
+  }
+  CHECK(sawUnknown);
+}
+
+TEST_CASE("c api reports failures for single sentences") {
+  ApiTestEnv env;
+  std::string big(64 * 1024, 'a');
+  const char* sentences[] = {big.data(), "ab"};
+  size_t lengths[] = {big.size(), 2};
+  jpp_batch_result result;
+  REQUIRE(jpp_analyze_batch(env.analyzer, sentences, lengths, 2, &result) ==
+          JPP_STATUS_OK);
+  REQUIRE(result.num_sentences == 2);
+  CHECK(result.sentences[0].status != JPP_STATUS_OK);
+  CHECK(result.sentences[0].morphemes_count == 0);
+  CHECK(std::strlen(jpp_last_error()) > 0);
+  CHECK(result.sentences[1].status == JPP_STATUS_OK);
+  CHECK(result.sentences[1].morphemes_count > 0);
+}
+
+TEST_CASE("c api configures beams of new analyzers") {
+  ApiTestEnv env;
+  CHECK(jpp_model_set_beam(env.model, 0) == JPP_STATUS_INVALID_PARAMETER);
+  CHECK(jpp_model_set_global_beam(env.model, 3, 1, 0) ==
+        JPP_STATUS_INVALID_PARAMETER);
+  REQUIRE(jpp_model_set_beam(env.model, 2) == JPP_STATUS_OK);
+  REQUIRE(jpp_model_set_global_beam(env.model, 0, 0, 0) == JPP_STATUS_OK);
+  jpp_analyzer* analyzer = nullptr;
+  REQUIRE(jpp_analyzer_create(env.model, &analyzer) == JPP_STATUS_OK);
+  const char* sentences[] = {"abba"};
+  jpp_batch_result result;
+  CHECK(jpp_analyze_batch(analyzer, sentences, nullptr, 1, &result) ==
+        JPP_STATUS_OK);
+  CHECK(result.sentences[0].status == JPP_STATUS_OK);
+  jpp_analyzer_destroy(analyzer);
+}
+
+TEST_CASE("c api reports model loading errors") {
+  jpp_model* model = nullptr;
+  CHECK(jpp_model_load("/this/file/does/not/exist", &model) !=
+        JPP_STATUS_OK);
+  CHECK(model == nullptr);
+  CHECK(std::strlen(jpp_last_error()) > 0);
+}
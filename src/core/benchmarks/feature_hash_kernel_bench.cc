@@ -7,6 +7,7 @@
 #include <core/analysis/perceptron.h>
 #include <benchpress/benchpress.hpp>
 #include <random>
+#include "core/impl/feature_impl_ngram_partial_kernels.h"
 #include "util/common.hpp"
 #include "util/fast_hash.h"
 #include "util/sliceable_array.h"
@@ -572,4 +573,250 @@ BENCHMARK("punroll2-prefetch", [](benchpress::context* ctx) {
                           &inputs.result, &inputs.buffer1, &inputs.buffer2);
     }
   }
-});
\ No newline at end of file
+});
+// bigram/trigram kernel which hashes a single beam candidate at a time
+JPP_NO_INLINE void biTriRowKernel(
+    util::ArraySlice<u64> biState, util::ArraySlice<u64> triState,
+    util::ConstSliceable<u64> t1pats, util::ConstSliceable<u64> t2pats,
+    util::ArraySlice<u32> t1idxes, util::ArraySlice<u32> t1featuresBi,
+    util::ArraySlice<u32> t1FeaturesTri, util::ArraySlice<u32> t2FeaturesTri,
+    util::MutableArraySlice<u32> buf1, util::MutableArraySlice<u32> buf2,
+    const core::analysis::WeightBuffer& weights,
+    util::MutableArraySlice<float> scoreBuffer,
+    util::MutableArraySlice<float> result) {
+  u32 mask = static_cast<u32>(weights.size() - 1);
+  auto numBiFeat = t1featuresBi.size();
+  buf1 = util::MutableArraySlice<u32>{buf1.data(), numBiFeat};
+  buf2 = util::MutableArraySlice<u32>{buf2.data(), numBiFeat};
+
+  int biRow = 0;
+  for (; biRow < t1pats.numRows(); ++biRow) {
+    buf1.swap(buf2);
+    auto t1row = t1pats.row(biRow);
+    float r1 = 0;
+    float r2 = 0;
+    u32 feat = 0;
+    for (; (feat + 2) <= numBiFeat; feat += 2) {
+      auto f = feat;
+      auto t1v1 = t1row.at(t1featuresBi.at(f));
+      auto v1 = util::hashing::FastHash1{biState.at(f)}.mix(t1v1).masked(mask);
+      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
+      buf1.at(f) = v1;
+      r1 += weights.at(buf2.at(f));
+      f += 1;
+      auto t1v2 = t1row.at(t1featuresBi.at(f));
+      auto v2 = util::hashing::FastHash1{biState.at(f)}.mix(t1v2).masked(mask);
+      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v2);
+      buf1.at(f) = v2;
+      r2 += weights.at(buf2.at(f));
+    }
+    if (numBiFeat & 0x1) {
+      auto f = feat;
+      auto t1v1 = t1row.at(t1featuresBi.at(f));
+      auto v1 = util::hashing::FastHash1{biState.at(f)}.mix(t1v1).masked(mask);
+      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
+      buf1.at(f) = v1;
+      r1 += weights.at(buf2.at(f));
+    }
+    if (JPP_LIKELY(biRow > 0)) {
+      scoreBuffer.at(biRow - 1) = r1 + r2;
+    }
+  }
+
+  int triRow = 0;
+  auto numTriFeat = t2FeaturesTri.size();
+  util::MutableArraySlice<u32> tribuf1{buf1.data(), numTriFeat};
+  util::MutableArraySlice<u32> tribuf2{buf2.data(), numTriFeat};
+  for (; triRow < t2pats.numRows(); ++triRow) {
+    tribuf1.swap(tribuf2);
+    auto t2row = t2pats.row(triRow);
+    auto t1row = t1pats.row(t1idxes.at(triRow));
+    float r1 = 0;
+    float r2 = 0;
+    u32 feat = 0;
+    for (; (feat + 2) <= numTriFeat; feat += 2) {
+      auto f = feat;
+      auto t1v1 = t1row.at(t1FeaturesTri.at(f));
+      auto t2v1 = t2row.at(t2FeaturesTri.at(f));
+      auto v1 =
+          util::hashing::FastHash1{triState.at(f)}.mix(t1v1).mix(t2v1).masked(
+              mask);
+      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
+      tribuf1.at(f) = v1;
+      r1 += weights.at(tribuf2.at(f));
+      f += 1;
+      auto t1v2 = t1row.at(t1FeaturesTri.at(f));
+      auto t2v2 = t2row.at(t2FeaturesTri.at(f));
+      auto v2 =
+          util::hashing::FastHash1{triState.at(f)}.mix(t1v2).mix(t2v2).masked(
+              mask);
+      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v2);
+      tribuf1.at(f) = v2;
+      r2 += weights.at(tribuf2.at(f));
+    }
+    if (numTriFeat & 0x1) {
+      auto f = feat;
+      auto t1v1 = t1row.at(t1FeaturesTri.at(f));
+      auto t2v1 = t2row.at(t2FeaturesTri.at(f));
+      auto v1 =
+          util::hashing::FastHash1{triState.at(f)}.mix(t1v1).mix(t2v1).masked(
+              mask);
+      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
+      tribuf1.at(f) = v1;
+      r1 += weights.at(tribuf2.at(f));
+    }
+    if (JPP_LIKELY(triRow > 0)) {
+      result.at(triRow - 1) = scoreBuffer.at(t1idxes.at(triRow - 1)) + r1 + r2;
+    } else {
+      scoreBuffer.at(biRow - 1) =
+          core::analysis::impl::computeUnrolled4RawPerceptron(weights, buf1);
+    }
+  }
+  result.at(triRow - 1) =
+      scoreBuffer.at(t1idxes.at(triRow - 1)) +
+      core::analysis::impl::computeUnrolled4RawPerceptron(weights, tribuf1);
+}
+
+JPP_NO_INLINE void biTriBlockKernel(
+    util::ArraySlice<u64> biState, util::ArraySlice<u64> triState,
+    util::ConstSliceable<u64> t1pats, util::ConstSliceable<u64> t2pats,
+    util::ArraySlice<u32> t1idxes, util::ArraySlice<u32> t1featuresBi,
+    util::ArraySlice<u32> t1FeaturesTri, util::ArraySlice<u32> t2FeaturesTri,
+    util::MutableArraySlice<u32> buf1, util::MutableArraySlice<u32> buf2,
+    const core::analysis::WeightBuffer& weights,
+    util::MutableArraySlice<float> scoreBuffer,
+    util::MutableArraySlice<float> result) {
+  core::features::impl::applyBiTriFullKernel(
+      biState, triState, t1pats, t2pats, t1idxes, t1featuresBi, t1FeaturesTri,
+      t2FeaturesTri, buf1, buf2, weights, scoreBuffer, result);
+}
+
+// roughly the shape of the jumandic model
+constexpr u32 BiTriPatterns = 40;
+constexpr u32 BiTriBigrams = 24;
+constexpr u32 BiTriTrigrams = 12;
+constexpr u32 BiTriRightNodes = 64;
+constexpr u32 BiTriMaxBeam = 64;
+
+struct BiTriInput {
+  std::vector<u64> biStates;
+  std::vector<u64> triStates;
+  std::vector<u64> t1;
+  std::vector<u64> t2;
+  std::vector<u32> t1idxes;
+  std::vector<u32> t1BiFeatures;
+  std::vector<u32> t1TriFeatures;
+  std::vector<u32> t2TriFeatures;
+  std::vector<u32> buffer1;
+  std::vector<u32> buffer2;
+  std::vector<float> scores;
+  std::vector<float> result;
+
+  JPP_NO_INLINE BiTriInput() {
+    std::minstd_rand rng{2};
+    std::uniform_int_distribution<u64> values{};
+    std::uniform_int_distribution<u32> patterns{0, BiTriPatterns - 1};
+    for (u32 i = 0; i < BiTriRightNodes * BiTriBigrams; ++i) {
+      biStates.push_back(values(rng));
+    }
+    for (u32 i = 0; i < BiTriRightNodes * BiTriTrigrams; ++i) {
+      triStates.push_back(values(rng));
+    }
+    for (u32 i = 0; i < BiTriMaxBeam * BiTriPatterns; ++i) {
+      t1.push_back(values(rng));
+      t2.push_back(values(rng));
+    }
+    for (u32 i = 0; i < BiTriBigrams; ++i) {
+      t1BiFeatures.push_back(patterns(rng));
+    }
+    for (u32 i = 0; i < BiTriTrigrams; ++i) {
+      t1TriFeatures.push_back(patterns(rng));
+      t2TriFeatures.push_back(patterns(rng));
+    }
+    auto bufferSize = core::features::impl::BiTriRowBlock *
+                      std::max(BiTriBigrams, BiTriTrigrams);
+    buffer1.resize(bufferSize, 0);
+    buffer2.resize(bufferSize, 0);
+    scores.resize(BiTriMaxBeam);
+    result.resize(BiTriMaxBeam);
+  }
+
+  // global beam candidates have about a half of distinct t1 nodes
+  template <typename Kernel>
+  void run(Kernel kernel, u32 beam) {
+    u32 numT1 = std::max(beam / 2, 1u);
+    t1idxes.clear();
+    for (u32 i = 0; i < beam; ++i) {
+      t1idxes.push_back(i % numT1);
+    }
+    util::ConstSliceable<u64> t1pats{t1, BiTriPatterns, BiTriMaxBeam};
+    util::ConstSliceable<u64> t2pats{t2, BiTriPatterns, BiTriMaxBeam};
+    core::analysis::WeightBuffer weights{inputs.weights};
+    for (u32 node = 0; node < BiTriRightNodes; ++node) {
+      util::ArraySlice<u64> biState{biStates, node * BiTriBigrams,
+                                    BiTriBigrams};
+      util::ArraySlice<u64> triState{triStates, node * BiTriTrigrams,
+                                     BiTriTrigrams};
+      kernel(biState, triState, t1pats.rows(0, numT1), t2pats.rows(0, beam),
+             t1idxes, t1BiFeatures, t1TriFeatures, t2TriFeatures, &buffer1,
+             &buffer2, weights, &scores, &result);
+    }
+  }
+};
+
+template <typename Kernel>
+void runBiTri(benchpress::context* ctx, Kernel kernel, u32 beam) {
+  BiTriInput input;
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    input.run(kernel, beam);
+  }
+}
+
+BENCHMARK("bitri-rows-gbeam-1", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriRowKernel, 1);
+});
+
+BENCHMARK("bitri-block-gbeam-1", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriBlockKernel, 1);
+});
+
+BENCHMARK("bitri-rows-gbeam-4", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriRowKernel, 4);
+});
+
+BENCHMARK("bitri-block-gbeam-4", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriBlockKernel, 4);
+});
+
+BENCHMARK("bitri-rows-gbeam-8", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriRowKernel, 8);
+});
+
+BENCHMARK("bitri-block-gbeam-8", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriBlockKernel, 8);
+});
+
+BENCHMARK("bitri-rows-gbeam-16", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriRowKernel, 16);
+});
+
+BENCHMARK("bitri-block-gbeam-16", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriBlockKernel, 16);
+});
+
+BENCHMARK("bitri-rows-gbeam-32", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriRowKernel, 32);
+});
+
+BENCHMARK("bitri-block-gbeam-32", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriBlockKernel, 32);
+});
+
+BENCHMARK("bitri-rows-gbeam-64", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriRowKernel, 64);
+});
+
+BENCHMARK("bitri-block-gbeam-64", [](benchpress::context* ctx) {
+  runBiTri(ctx, biTriBlockKernel, 64);
+});
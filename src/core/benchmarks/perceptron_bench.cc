@@ -7,6 +7,7 @@
 #include <xmmintrin.h>
 #include <random>
 #include "benchpress/benchpress.hpp"
+#include "core/benchmarks/perceptron_kernel_bench.h"
 #include "util/seahash.h"
 #include "util/sliceable_array.h"
 
@@ -475,4 +476,7 @@ BENCHMARK("hor-fu-pf1-4m", [](context* ctx) {
   for (u64 iter = 0; iter < ctx->num_iterations(); ++iter) {
     out.computeMixedScoresPf1(iter, mask);
   }
-});
\ No newline at end of file
+});
+
+static bool kernelBenchmarks =
+    bench::registerPerceptronKernelBenchmarks<OutputData>(&inputs.weights);
@@ -0,0 +1,60 @@
+#ifndef JUMANPP_PERCEPTRON_KERNEL_BENCH_H
+#define JUMANPP_PERCEPTRON_KERNEL_BENCH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "benchpress/benchpress.hpp"
+#include "core/analysis/perceptron_kernels.h"
+
+namespace jumanpp {
+namespace bench {
+
+template <typename Data>
+void runPerceptronKernel(benchpress::context* ctx,
+                         core::analysis::PerceptronKernel kernel,
+                         const std::vector<float>& weights) {
+  auto rows = core::analysis::impl::perceptronRowsKernel(kernel);
+  if (rows == nullptr) {
+    std::cerr << core::analysis::impl::perceptronKernelName(kernel)
+              << " kernel is not supported by this CPU, skipping\n";
+    return;
+  }
+  auto mask = static_cast<u32>(weights.size() - 1);
+  Data out;
+  for (u64 iter = 0; iter < ctx->num_iterations(); ++iter) {
+    out.computeFeatures(iter);
+    rows(weights.data(), mask, out.features, nullptr,
+         out.outputScores.data());
+  }
+}
+
+/**
+ * Registers kernel-{scalar,avx2,avx512}-4m benchmarks of the perceptron
+ * kernels from core/analysis/perceptron_kernels.h.
+ *
+ * Each iteration fills Data::features with rows of hashed feature indices
+ * (Data::computeFeatures) and scores them into Data::outputScores.
+ * Weights must have 4M elements.
+ */
+template <typename Data>
+bool registerPerceptronKernelBenchmarks(const std::vector<float>* weights) {
+  using core::analysis::PerceptronKernel;
+  for (auto kernel : {PerceptronKernel::Scalar, PerceptronKernel::Avx2,
+                      PerceptronKernel::Avx512}) {
+    auto name = "kernel-" +
+                core::analysis::impl::perceptronKernelName(kernel).str() +
+                "-4m";
+    benchpress::auto_register{name,
+                              [weights, kernel](benchpress::context* ctx) {
+                                runPerceptronKernel<Data>(ctx, kernel,
+                                                          *weights);
+                              }};
+  }
+  return true;
+}
+
+}  // namespace bench
+}  // namespace jumanpp
+
+#endif  // JUMANPP_PERCEPTRON_KERNEL_BENCH_H
@@ -0,0 +1,363 @@
+#define BENCHPRESS_CONFIG_MAIN
+
+#include <random>
+#include <set>
+#include <vector>
+#include "benchpress/benchpress.hpp"
+#include "core/dic/codepoint_trie.h"
+#include "core/dic/darts.h"
+#include "core/dic/darts_trie.h"
+#include "util/characters.h"
+
+using context = benchpress::context;
+using namespace jumanpp;
+using namespace jumanpp::core::dic;
+
+u32 numKeys = 1000000;
+u32 numSentences = 2000;
+u32 keysInSentence = 40;
+
+// all codepoints are three bytes long in utf8
+void appendCodepoint(char32_t cp, std::string* result) {
+  result->push_back(static_cast<char>(0xe0 | (cp >> 12)));
+  result->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+  result->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+}
+
+struct InputData {
+  std::vector<std::string> keys;
+  DoubleArrayBuilder builder;
+  DoubleArray trie;
+  impl::DoubleArrayCore core;
+  CodepointTrieBuilder cpBuilder;
+  CodepointTrie cpTrie;
+  // codepoints point into these strings
+  std::vector<std::string> texts;
+  std::vector<std::vector<chars::InputCodepoint>> sentences;
+
+  InputData() {
+    std::minstd_rand rng{1};
+    // kanji and hiragana, frequent ones are more likely
+    std::geometric_distribution<u32> kanji{0.002};
+    std::uniform_int_distribution<u32> hiragana{0x3041, 0x3093};
+    std::uniform_int_distribution<u32> length{1, 5};
+    std::bernoulli_distribution isKanji{0.6};
+
+    std::set<std::string> unique;
+    while (unique.size() < numKeys) {
+      std::string key;
+      auto len = length(rng);
+      for (u32 i = 0; i < len; ++i) {
+        auto cp = isKanji(rng) ? 0x4e00 + kanji(rng) % 0x5000 : hiragana(rng);
+        appendCodepoint(cp, &key);
+      }
+      unique.insert(key);
+    }
+    keys.assign(unique.begin(), unique.end());
+
+    i32 value = 0;
+    for (auto& k : keys) {
+      builder.add(k, value);
+      cpBuilder.add(k, value);
+      ++value;
+    }
+    auto s = builder.build();
+    if (!s || !cpBuilder.build()) {
+      throw std::runtime_error{"failed to build the trie"};
+    }
+    s = trie.loadFromMemory(builder.result());
+    s = cpTrie.loadFromMemory(cpBuilder.result());
+    auto storage = const_cast<char*>(builder.result().char_begin());
+    core.set_array(storage, builder.result().size() / core.unit_size());
+
+    std::uniform_int_distribution<size_t> keyIdx{0, keys.size() - 1};
+    texts.resize(numSentences);
+    for (u32 i = 0; i < numSentences; ++i) {
+      auto& sentence = texts[i];
+      for (u32 j = 0; j < keysInSentence; ++j) {
+        sentence += keys[keyIdx(rng)];
+      }
+      sentences.emplace_back();
+      s = chars::preprocessRawData(sentence, &sentences.back());
+    }
+  }
+};
+
+// character tables are static objects too, so inputs must be lazy
+const InputData& inputs() {
+  static InputData data;
+  return data;
+}
+
+/**
+ * Same as DoubleArrayTraversal, but can prefetch the trie unit
+ * which the next step will need.
+ */
+class PrefetchingTraversal {
+  const impl::DoubleArrayUnit* units_;
+  u32 node_ = 0;
+  i32 value_;
+
+ public:
+  explicit PrefetchingTraversal(const impl::DoubleArrayUnit* units)
+      : units_{units} {}
+
+  i32 value() const { return value_; }
+
+  TraverseStatus step(const chars::InputCodepoint& cp) {
+    auto key = cp.bytes.begin();
+    auto len = cp.bytes.size();
+    i32 b = units_[node_].base;
+    u32 p;
+    for (size_t i = 0; i < len; ++i) {
+      p = b + static_cast<u8>(key[i]) + 1;
+      if (static_cast<u32>(b) != units_[p].check) {
+        return TraverseStatus::NoNode;
+      }
+      node_ = p;
+      b = units_[p].base;
+    }
+    i32 n = units_[b].base;
+    if (static_cast<u32>(b) == units_[b].check && n < 0) {
+      value_ = -n - 1;
+      return TraverseStatus::Ok;
+    }
+    return TraverseStatus::NoLeaf;
+  }
+
+  void prefetch(const chars::InputCodepoint& cp) const {
+    u32 p = units_[node_].base + static_cast<u8>(cp.bytes[0]) + 1;
+    util::prefetch<util::PREFETCH_HINT_T0>(units_ + p);
+  }
+};
+
+/**
+ * Traverses the trie from every start position of the input,
+ * like AllStartsTraversal, but interleaves the traversals.
+ *
+ * Every trie step is a dependent memory access, so a single traversal
+ * is bound by memory latency. Here up to NumLanes traversals from
+ * different start positions are advanced in lockstep and the trie units
+ * for their next steps are prefetched, so their cache misses overlap.
+ * A finished traversal is replaced by one from the next start position.
+ *
+ * Matches are reported in the same order as with AllStartsTraversal.
+ */
+template <i32 NumLanes>
+class InterleavedTraversal {
+  static_assert(NumLanes > 0, "there must be at least one lane");
+
+  struct Match {
+    i32 end;
+    i32 value;
+  };
+
+  struct Lane {
+    PrefetchingTraversal trav{nullptr};
+    i32 begin;
+    i32 position;
+  };
+
+  // matches of traversals which started after the oldest unfinished one
+  // are buffered, the index is begin % NumLanes
+  std::vector<Match> pending_[NumLanes];
+  bool finished_[NumLanes];
+
+ public:
+  template <typename Handler>
+  void traverse(const impl::DoubleArrayUnit* units,
+                util::ArraySlice<chars::InputCodepoint> points,
+                Handler& handler) {
+    i32 total = static_cast<i32>(points.size());
+    Lane lanes[NumLanes];
+    i32 active = 0;
+    i32 nextStart = 0;
+    // all traversals which started before this one are reported
+    i32 oldest = 0;
+
+    auto launch = [&]() {
+      auto& lane = lanes[active];
+      lane.trav = PrefetchingTraversal{units};
+      lane.begin = nextStart;
+      lane.position = nextStart;
+      lane.trav.prefetch(points[nextStart]);
+      finished_[nextStart % NumLanes] = false;
+      ++active;
+      ++nextStart;
+    };
+
+    while (nextStart < total && nextStart < NumLanes) {
+      launch();
+    }
+
+    while (active > 0) {
+      for (i32 i = 0; i < active;) {
+        auto& lane = lanes[i];
+        auto status = lane.trav.step(points[lane.position]);
+        lane.position += 1;
+        if (status == TraverseStatus::Ok) {
+          if (lane.begin == oldest) {
+            handler.match(lane.begin, lane.position, lane.trav.value());
+          } else {
+            pending_[lane.begin % NumLanes].push_back(
+                {lane.position, lane.trav.value()});
+          }
+        }
+
+        if (status != TraverseStatus::NoNode && lane.position != total) {
+          lane.trav.prefetch(points[lane.position]);
+          ++i;
+          continue;
+        }
+
+        finished_[lane.begin % NumLanes] = true;
+        active -= 1;
+        lane = lanes[active];
+        // report all finished traversals in the order of start positions
+        while (oldest < nextStart) {
+          auto slot = oldest % NumLanes;
+          auto& matches = pending_[slot];
+          for (auto& m : matches) {
+            handler.match(oldest, m.end, m.value);
+          }
+          matches.clear();
+          if (!finished_[slot]) {
+            break;
+          }
+          ++oldest;
+          if (nextStart < total) {
+            launch();
+          }
+        }
+      }
+    }
+  }
+};
+
+struct CountingHandler {
+  u64 matches = 0;
+
+  void match(i32 begin, i32 end, i32 value) { matches += value + end - begin; }
+};
+
+// Trie steps were not inlined before AllStartsTraversal
+__attribute__((noinline)) TraverseStatus stepOutOfLine(
+    const impl::DoubleArrayCore& core, StringPiece data, size_t* nodePos,
+    i32* value) {
+  size_t keyPos = 0;
+  auto status = core.traverse(data.begin(), *nodePos, keyPos, data.size());
+  switch (status) {
+    case -1:
+      return TraverseStatus::NoLeaf;
+    case -2:
+      return TraverseStatus::NoNode;
+    default:
+      *value = status;
+      return TraverseStatus::Ok;
+  }
+}
+
+__attribute__((noinline)) u64 lookupOutOfLine() {
+  CountingHandler handler;
+  auto& data = inputs();
+  for (auto& points : data.sentences) {
+    i32 total = static_cast<i32>(points.size());
+    for (i32 begin = 0; begin < total; ++begin) {
+      size_t nodePos = 0;
+      i32 value = 0;
+      for (i32 position = begin; position < total; ++position) {
+        auto status =
+            stepOutOfLine(data.core, points[position].bytes, &nodePos, &value);
+        if (status == TraverseStatus::Ok) {
+          handler.match(begin, position + 1, value);
+        } else if (status == TraverseStatus::NoNode) {
+          break;
+        }
+      }
+    }
+  }
+  return handler.matches;
+}
+
+__attribute__((noinline)) u64 lookupSequential() {
+  static AllStartsTraversal<> traversal;
+  CountingHandler handler;
+  auto& data = inputs();
+  for (auto& points : data.sentences) {
+    traversal.traverse(data.trie, points, handler);
+  }
+  return handler.matches;
+}
+
+template <i32 NumLanes>
+__attribute__((noinline)) u64 lookupLanes() {
+  static InterleavedTraversal<NumLanes> traversal;
+  CountingHandler handler;
+  auto& data = inputs();
+  auto units =
+      reinterpret_cast<const impl::DoubleArrayUnit*>(data.core.array());
+  for (auto& points : data.sentences) {
+    traversal.traverse(units, points, handler);
+  }
+  return handler.matches;
+}
+
+__attribute__((noinline)) u64 lookupCodepoints() {
+  static AllStartsTraversal<CodepointTrie> traversal;
+  CountingHandler handler;
+  auto& data = inputs();
+  for (auto& points : data.sentences) {
+    traversal.traverse(data.cpTrie, points, handler);
+  }
+  return handler.matches;
+}
+
+volatile u64 sink;
+
+BENCHMARK("out-of-line-step", [](context* ctx) {
+  inputs();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    sink = lookupOutOfLine();
+  }
+});
+
+BENCHMARK("sequential", [](context* ctx) {
+  inputs();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    sink = lookupSequential();
+  }
+});
+
+BENCHMARK("lanes-2", [](context* ctx) {
+  inputs();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    sink = lookupLanes<2>();
+  }
+});
+
+BENCHMARK("lanes-4", [](context* ctx) {
+  inputs();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    sink = lookupLanes<4>();
+  }
+});
+
+BENCHMARK("lanes-8", [](context* ctx) {
+  inputs();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    sink = lookupLanes<8>();
+  }
+});
+
+BENCHMARK("codepoint-trie", [](context* ctx) {
+  inputs();
+  ctx->reset_timer();
+  for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+    sink = lookupCodepoints();
+  }
+});
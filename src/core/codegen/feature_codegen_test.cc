@@ -241,4 +241,19 @@ TEST_CASE("partial ngram joint biTri produces the same values") {
     CAPTURE(i);
     CHECK(result1[i] == Approx(result2[i]));
   }
+
+  // several full blocks of t1 rows
+  u32 idxes2[] = {
+      9, 4, 5, 0, 8, 3, 7, 1, 6, 2,
+  };
+
+  fs.ngramPartialDynamic->applyBiTri(&fb1, 0, inp.t1, sl0, sl0, idxes2, &perc,
+                                     result1);
+  fs.ngramPartialStatic->applyBiTri(&fb2, 0, inp.t1, sl0, sl0, idxes2, &perc,
+                                    result2);
+
+  for (int i = 0; i < NumExamples; ++i) {
+    CAPTURE(i);
+    CHECK(result1[i] == Approx(result2[i]));
+  }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 //
 
 #include "partial_ngram_feature_codegen.h"
+#include <algorithm>
 #include "core_config.h"
 #include "pattern_feature_codegen.h"
 
@@ -204,8 +205,11 @@ void PartialNgramPrinter::outputApplyBiTriLoop(util::io::Printer& p) {
     p << "\nconst auto tristateBuf = buffers->t2Buf1(numTrigrams, "
          "buffers->currentElems);";
 
-    p << "\nauto buf1 = buffers->valBuf1(numBigrams);";
-    p << "\nauto buf2 = buffers->valBuf2(numBigrams);";
+    p << "\nconstexpr auto bufferSize = "
+      << JPP_TEXT(::jumanpp::core::features::impl::BiTriRowBlock) << " * "
+      << std::max(bigrams_.size(), trigrams_.size()) << ";";
+    p << "\nauto buf1 = buffers->valBuf1(bufferSize);";
+    p << "\nauto buf2 = buffers->valBuf2(bufferSize);";
     p << "\nstatic constexpr jumanpp::u32"
       << " t1BiFeatureIdxes[numBigrams] = {\n  ";
     for (auto& bi : bigrams_) {
@@ -521,8 +525,13 @@ void PartialNgramPrinter::outputClassBody(util::io::Printer& p) {
     p << "\nu32 maxNgrams = std::max({numUnigrams(), numBigrams(), "
          "numTrigrams()});";
     p << "\nfbuf->currentElems = ~0u;";
-    p << "\nfbuf->valueBuffer1 = alloc->allocateBuf<u32>(maxNgrams, 64);";
-    p << "\nfbuf->valueBuffer2 = alloc->allocateBuf<u32>(maxNgrams, 64);";
+    p << "\nu32 valueBufferSize = "
+      << JPP_TEXT(::jumanpp::core::features::impl::BiTriRowBlock)
+      << " * maxNgrams;";
+    p << "\nfbuf->valueBuffer1 = alloc->allocateBuf<u32>(valueBufferSize, "
+         "64);";
+    p << "\nfbuf->valueBuffer2 = alloc->allocateBuf<u32>(valueBufferSize, "
+         "64);";
     p << "\nfbuf->t1Buffer = alloc->allocateBuf<u64>(numBigrams() * "
          "stats.maxStarts, 64);";
     p << "\nfbuf->t2Buffer1 = alloc->allocateBuf<u64>(numTrigrams() * "
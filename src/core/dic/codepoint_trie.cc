@@ -0,0 +1,380 @@
+#include "codepoint_trie.h"
+#include <algorithm>
+#include <deque>
+#include "util/flatmap.h"
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+namespace {
+
+constexpr u32 CodepointTrieVersion = 1;
+constexpr u32 HeaderSize = 5;
+constexpr u32 NoParent = ~0u;
+constexpr u32 NoCell = ~0u;
+
+struct LabeledKey {
+  std::vector<u32> labels;
+  i32 value;
+
+  bool operator<(const LabeledKey& o) const { return labels < o.labels; }
+};
+
+struct PendingNode {
+  u32 node;
+  u32 begin;
+  u32 end;
+  u32 depth;
+};
+
+class UnitArrayBuilder {
+  enum class Cell : u8 { Free, Skipped, Used };
+  // free cells which can hold the first child of a node
+  // form a doubly linked list
+  // free cells which were not suitable for this many times
+  // are not considered as candidates for the first child anymore
+  static constexpr u8 MaxTrials = 8;
+
+  std::vector<impl::CodepointTrieUnit> units_;
+  std::vector<Cell> state_;
+  std::vector<u32> nextFree_;
+  std::vector<u32> prevFree_;
+  std::vector<u8> trials_;
+  u32 freeHead_ = NoCell;
+  u32 freeTail_ = NoCell;
+
+  void ensureSize(size_t size) {
+    auto oldSize = units_.size();
+    if (size <= oldSize) {
+      return;
+    }
+    auto newSize = std::max(size, oldSize * 2);
+    units_.resize(newSize, impl::CodepointTrieUnit{0, NoParent});
+    state_.resize(newSize, Cell::Free);
+    nextFree_.resize(newSize, NoCell);
+    prevFree_.resize(newSize, NoCell);
+    trials_.resize(newSize, 0);
+    for (auto i = static_cast<u32>(oldSize); i < newSize; ++i) {
+      prevFree_[i] = freeTail_;
+      if (freeTail_ == NoCell) {
+        freeHead_ = i;
+      } else {
+        nextFree_[freeTail_] = i;
+      }
+      freeTail_ = i;
+    }
+  }
+
+  void unlink(u32 idx, Cell newState) {
+    if (state_[idx] == Cell::Free) {
+      auto prev = prevFree_[idx];
+      auto next = nextFree_[idx];
+      if (prev == NoCell) {
+        freeHead_ = next;
+      } else {
+        nextFree_[prev] = next;
+      }
+      if (next == NoCell) {
+        freeTail_ = prev;
+      } else {
+        prevFree_[next] = prev;
+      }
+    }
+    state_[idx] = newState;
+  }
+
+ public:
+  UnitArrayBuilder() {
+    ensureSize(1024);
+    unlink(0, Cell::Used);
+  }
+
+  // finds a base where all labels (sorted) fit into unused units
+  u32 findBase(const std::vector<u32>& labels) {
+    auto first = labels.front();
+    auto last = labels.back();
+    u32 cell = freeHead_;
+    while (true) {
+      if (cell == NoCell) {
+        cell = static_cast<u32>(units_.size());
+        ensureSize(cell + 1);
+      }
+      auto next = nextFree_[cell];
+      if (cell < first) {
+        cell = next;
+        continue;
+      }
+      u32 base = cell - first;
+      ensureSize(size_t{base} + last + 1);
+      bool fits = true;
+      for (auto l : labels) {
+        if (state_[base + l] == Cell::Used) {
+          fits = false;
+          break;
+        }
+      }
+      if (fits) {
+        return base;
+      }
+      // ensureSize could have appended cells to an empty list
+      next = nextFree_[cell];
+      trials_[cell] += 1;
+      if (trials_[cell] >= MaxTrials) {
+        unlink(cell, Cell::Skipped);
+      }
+      cell = next;
+    }
+  }
+
+  void place(u32 parent, u32 base, const std::vector<u32>& labels) {
+    units_[parent].base = static_cast<i32>(base);
+    for (auto l : labels) {
+      auto idx = base + l;
+      unlink(idx, Cell::Used);
+      units_[idx].check = parent;
+    }
+  }
+
+  void setLeaf(u32 parent, u32 idx, i32 value) {
+    units_[parent].check |= impl::CodepointTrieUnit::HasLeaf;
+    units_[idx].base = -value - 1;
+  }
+
+  Status finish(std::vector<impl::CodepointTrieUnit>* result) {
+    size_t size = state_.size();
+    while (size > 1 && state_[size - 1] != Cell::Used) {
+      --size;
+    }
+    if (size >= impl::CodepointTrieUnit::HasLeaf) {
+      return JPPS_INVALID_PARAMETER << "codepoint trie is too large";
+    }
+    units_.resize(size);
+    units_[0].check = NoParent;
+    *result = std::move(units_);
+    return Status::Ok();
+  }
+};
+
+template <typename T>
+util::ArraySlice<T> sliceAt(const u32* data, size_t offset, size_t count) {
+  return util::ArraySlice<T>{reinterpret_cast<const T*>(data + offset), count};
+}
+
+}  // namespace
+
+constexpr u32 CodepointTrie::Magic;
+
+u32 CodepointTrie::supplementaryLabel(char32_t cp) const noexcept {
+  size_t lo = 0;
+  size_t hi = supplementary_.size() / 2;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    auto midCp = supplementary_[mid * 2];
+    if (midCp == cp) {
+      return supplementary_[mid * 2 + 1];
+    }
+    if (midCp < cp) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0;
+}
+
+Status CodepointTrie::loadFromMemory(StringPiece memory) {
+  if (memory.size() % sizeof(u32) != 0 ||
+      reinterpret_cast<uintptr_t>(memory.data()) % sizeof(u32) != 0) {
+    return JPPS_INVALID_PARAMETER
+           << "codepoint trie memory is not aligned, probably corrupted model";
+  }
+  auto data = reinterpret_cast<const u32*>(memory.data());
+  size_t size = memory.size() / sizeof(u32);
+  if (size < HeaderSize || data[0] != CodepointTrie::Magic) {
+    return JPPS_INVALID_PARAMETER << "codepoint trie has invalid header";
+  }
+  if (data[1] != CodepointTrieVersion) {
+    return JPPS_INVALID_PARAMETER << "codepoint trie version " << data[1]
+                                  << " is not supported";
+  }
+  size_t numPages = data[2];
+  size_t numSupplementary = data[3];
+  size_t numUnits = data[4];
+  size_t expected = HeaderSize + NumBmpPages + numPages * PageSize +
+                    numSupplementary * 2 + numUnits * 2;
+  if (size != expected || numPages == 0 || numUnits == 0) {
+    return JPPS_INVALID_PARAMETER << "codepoint trie size " << size
+                                  << " was different from expected "
+                                  << expected;
+  }
+
+  size_t offset = HeaderSize;
+  pageIndex_ = sliceAt<u32>(data, offset, NumBmpPages);
+  offset += NumBmpPages;
+  pages_ = sliceAt<u32>(data, offset, numPages * PageSize);
+  offset += numPages * PageSize;
+  supplementary_ = sliceAt<u32>(data, offset, numSupplementary * 2);
+  offset += numSupplementary * 2;
+  units_ = sliceAt<impl::CodepointTrieUnit>(data, offset, numUnits);
+
+  for (auto page : pageIndex_) {
+    if (page >= numPages) {
+      return JPPS_INVALID_PARAMETER << "codepoint trie has invalid page index";
+    }
+  }
+  return Status::Ok();
+}
+
+Status CodepointTrieBuilder::add(StringPiece key, i32 value) {
+  std::vector<chars::InputCodepoint> cps;
+  JPP_RETURN_IF_ERROR(chars::preprocessRawData(key, &cps));
+  if (cps.empty()) {
+    return JPPS_INVALID_PARAMETER << "codepoint trie keys can not be empty";
+  }
+  std::vector<char32_t> codepoints;
+  codepoints.reserve(cps.size());
+  for (auto& cp : cps) {
+    codepoints.push_back(cp.codepoint);
+  }
+  raw_.emplace_back(std::move(codepoints), value);
+  return Status::Ok();
+}
+
+Status CodepointTrieBuilder::build() {
+  // frequent codepoints get small labels, so transitions of
+  // frequent nodes are placed close to each other
+  util::FlatMap<char32_t, u32> frequency;
+  for (auto& k : raw_) {
+    for (auto cp : k.first) {
+      frequency[cp] += 1;
+    }
+  }
+  std::vector<std::pair<char32_t, u32>> byFrequency;
+  for (auto& f : frequency) {
+    byFrequency.emplace_back(f.first, f.second);
+  }
+  std::sort(byFrequency.begin(), byFrequency.end(),
+            [](const std::pair<char32_t, u32>& a,
+               const std::pair<char32_t, u32>& b) {
+              if (a.second != b.second) {
+                return a.second > b.second;
+              }
+              return a.first < b.first;
+            });
+  util::FlatMap<char32_t, u32> labels;
+  for (u32 i = 0; i < byFrequency.size(); ++i) {
+    // label 0 is reserved for leaves
+    labels[byFrequency[i].first] = i + 1;
+  }
+
+  std::vector<LabeledKey> keys;
+  keys.reserve(raw_.size());
+  for (auto& k : raw_) {
+    LabeledKey key;
+    key.value = k.second;
+    for (auto cp : k.first) {
+      key.labels.push_back(labels[cp]);
+    }
+    keys.push_back(std::move(key));
+  }
+  raw_.clear();
+  raw_.shrink_to_fit();
+  std::sort(keys.begin(), keys.end());
+
+  UnitArrayBuilder units;
+  std::deque<PendingNode> queue;
+  std::vector<u32> children;
+  queue.push_back({0, 0, static_cast<u32>(keys.size()), 0});
+  while (!queue.empty()) {
+    auto node = queue.front();
+    queue.pop_front();
+    children.clear();
+    bool hasLeaf = false;
+    i32 leafValue = 0;
+    for (u32 i = node.begin; i < node.end; ++i) {
+      auto& key = keys[i];
+      if (key.labels.size() == node.depth) {
+        if (hasLeaf) {
+          return JPPS_INVALID_PARAMETER << "codepoint trie keys must be unique";
+        }
+        hasLeaf = true;
+        leafValue = key.value;
+        children.push_back(0);
+      } else {
+        auto l = key.labels[node.depth];
+        if (children.empty() || children.back() != l) {
+          children.push_back(l);
+        }
+      }
+    }
+    if (children.empty()) {
+      // only for the root of an empty trie
+      continue;
+    }
+
+    auto base = units.findBase(children);
+    units.place(node.node, base, children);
+    if (hasLeaf) {
+      units.setLeaf(node.node, base, leafValue);
+    }
+
+    u32 begin = hasLeaf ? node.begin + 1 : node.begin;
+    while (begin < node.end) {
+      auto l = keys[begin].labels[node.depth];
+      u32 end = begin + 1;
+      while (end < node.end && keys[end].labels[node.depth] == l) {
+        ++end;
+      }
+      queue.push_back({base + l, begin, end, node.depth + 1});
+      begin = end;
+    }
+  }
+
+  std::vector<impl::CodepointTrieUnit> unitArray;
+  JPP_RETURN_IF_ERROR(units.finish(&unitArray));
+
+  constexpr u32 PageBits = CodepointTrie::PageBits;
+  constexpr u32 PageSize = CodepointTrie::PageSize;
+
+  std::vector<u32> pageIndex(CodepointTrie::NumBmpPages, 0);
+  // the first page is empty and shared by all pages without keys
+  std::vector<u32> pages(PageSize, 0);
+  std::vector<std::pair<char32_t, u32>> supplementary;
+  for (auto& l : labels) {
+    auto cp = l.first;
+    if (cp >= 0x10000) {
+      supplementary.emplace_back(cp, l.second);
+      continue;
+    }
+    auto& page = pageIndex[cp >> PageBits];
+    if (page == 0) {
+      page = static_cast<u32>(pages.size() / PageSize);
+      pages.resize(pages.size() + PageSize, 0);
+    }
+    pages[(page << PageBits) | (cp & (PageSize - 1))] = l.second;
+  }
+  std::sort(supplementary.begin(), supplementary.end());
+
+  result_.clear();
+  result_.push_back(CodepointTrie::Magic);
+  result_.push_back(CodepointTrieVersion);
+  result_.push_back(static_cast<u32>(pages.size() / PageSize));
+  result_.push_back(static_cast<u32>(supplementary.size()));
+  result_.push_back(static_cast<u32>(unitArray.size()));
+  result_.insert(result_.end(), pageIndex.begin(), pageIndex.end());
+  result_.insert(result_.end(), pages.begin(), pages.end());
+  for (auto& s : supplementary) {
+    result_.push_back(s.first);
+    result_.push_back(s.second);
+  }
+  for (auto& u : unitArray) {
+    result_.push_back(static_cast<u32>(u.base));
+    result_.push_back(u.check);
+  }
+  return Status::Ok();
+}
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
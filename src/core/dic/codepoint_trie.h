@@ -0,0 +1,143 @@
+#ifndef JUMANPP_CODEPOINT_TRIE_H
+#define JUMANPP_CODEPOINT_TRIE_H
+
+#include <vector>
+#include "core/dic/darts_trie.h"
+#include "util/array_slice.h"
+#include "util/characters.h"
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+namespace impl {
+// Same layout as DoubleArrayUnit, but check contains the parent node index.
+// The highest bit of check is set if the node has a leaf child,
+// so the leaf is read only for nodes which have one.
+struct CodepointTrieUnit {
+  static constexpr u32 HasLeaf = 1u << 31;
+
+  i32 base;
+  u32 check;
+};
+}  // namespace impl
+
+class CodepointTrieTraversal;
+
+/**
+ * Double array trie which uses a single transition per codepoint,
+ * unlike DoubleArray which uses a transition per UTF-8 byte.
+ *
+ * Codepoints of keys are mapped into dense labels,
+ * frequent codepoints get smaller labels.
+ * Nodes are placed in the breadth-first order, so nodes which are
+ * close to the root (and are used by almost all lookups) are packed
+ * into the beginning of the unit array.
+ *
+ * The trie is an optional chunk of a dictionary model part:
+ * it points to the memory of the model file and is not copied.
+ */
+class CodepointTrie {
+  // index of a page in pages_ for each 256 BMP codepoints, 0 is empty page
+  util::ArraySlice<u32> pageIndex_;
+  util::ArraySlice<u32> pages_;
+  // sorted (codepoint, label) pairs for codepoints outside of BMP
+  util::ArraySlice<u32> supplementary_;
+  util::ArraySlice<impl::CodepointTrieUnit> units_;
+
+  u32 supplementaryLabel(char32_t cp) const noexcept;
+
+ public:
+  static constexpr u32 PageBits = 8;
+  static constexpr u32 PageSize = 1u << PageBits;
+  static constexpr u32 NumBmpPages = 0x10000 >> PageBits;
+  static constexpr u32 Magic = 0x43505452;  // CPTR
+
+  Status loadFromMemory(StringPiece memory);
+
+  bool empty() const noexcept { return units_.size() == 0; }
+  size_t numUnits() const noexcept { return units_.size(); }
+
+  // label of a codepoint, 0 if no keys contain it
+  u32 label(char32_t cp) const noexcept {
+    if (JPP_LIKELY(cp < 0x10000)) {
+      auto page = pageIndex_[cp >> PageBits];
+      return pages_[(page << PageBits) | (cp & (PageSize - 1))];
+    }
+    return supplementaryLabel(cp);
+  }
+
+  inline CodepointTrieTraversal traversal() const noexcept;
+
+  friend class CodepointTrieTraversal;
+};
+
+class CodepointTrieTraversal {
+  const CodepointTrie* trie_;
+  u32 node_ = 0;
+  i32 value_;
+
+ public:
+  explicit CodepointTrieTraversal(const CodepointTrie* trie) noexcept
+      : trie_{trie} {}
+
+  i32 value() const noexcept { return value_; }
+
+  TraverseStatus step(char32_t cp) noexcept {
+    auto lbl = trie_->label(cp);
+    if (lbl == 0) {
+      return TraverseStatus::NoNode;
+    }
+    auto units = trie_->units_;
+    u32 next = static_cast<u32>(units[node_].base) + lbl;
+    if (next >= units.size()) {
+      return TraverseStatus::NoNode;
+    }
+    auto check = units[next].check;
+    if ((check & ~impl::CodepointTrieUnit::HasLeaf) != node_) {
+      return TraverseStatus::NoNode;
+    }
+    node_ = next;
+    if ((check & impl::CodepointTrieUnit::HasLeaf) == 0) {
+      return TraverseStatus::NoLeaf;
+    }
+    // leaf is a child with label 0
+    value_ = -units[units[next].base].base - 1;
+    return TraverseStatus::Ok;
+  }
+
+  TraverseStatus step(const chars::InputCodepoint& cp) noexcept {
+    return step(cp.codepoint);
+  }
+};
+
+CodepointTrieTraversal CodepointTrie::traversal() const noexcept {
+  return CodepointTrieTraversal{this};
+}
+
+/**
+ * Builds a CodepointTrie.
+ * Keys must be unique and must be valid UTF-8.
+ */
+class CodepointTrieBuilder {
+  std::vector<std::pair<std::vector<char32_t>, i32>> raw_;
+  std::vector<u32> result_;
+
+ public:
+  Status add(StringPiece key, i32 value);
+  Status build();
+
+  StringPiece result() const {
+    return StringPiece{reinterpret_cast<const char*>(result_.data()),
+                       result_.size() * sizeof(u32)};
+  }
+};
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_CODEPOINT_TRIE_H
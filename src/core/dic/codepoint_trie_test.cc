@@ -0,0 +1,150 @@
+#include "codepoint_trie.h"
+#include <random>
+#include <testing/standalone_test.h>
+
+namespace c = jumanpp::core::dic;
+namespace j = jumanpp;
+
+namespace {
+struct MatchRecorder {
+  std::vector<std::pair<j::i32, j::i32>> result;
+
+  void match(j::i32 begin, j::i32 end, j::i32 value) {
+    result.emplace_back(begin, end + 100 * value);
+  }
+};
+
+std::vector<j::chars::InputCodepoint> codepoints(j::StringPiece data) {
+  std::vector<j::chars::InputCodepoint> cps;
+  REQUIRE_OK(j::chars::preprocessRawData(data, &cps));
+  return cps;
+}
+}  // namespace
+
+TEST_CASE("codepoint trie builds and traverses") {
+  c::CodepointTrieBuilder bldr;
+  CHECK_OK(bldr.add("test", 1));
+  CHECK_OK(bldr.add("tiny", 2));
+  CHECK_OK(bldr.add("anchor", 3));
+  CHECK_OK(bldr.add("tanya", 4));
+  CHECK_OK(bldr.build());
+  c::CodepointTrie trie;
+  REQUIRE_OK(trie.loadFromMemory(bldr.result()));
+  CHECK_FALSE(trie.empty());
+  auto trav = trie.traversal();
+  CHECK(trav.step(U't') == c::TraverseStatus::NoLeaf);
+  CHECK(trav.step(U'e') == c::TraverseStatus::NoLeaf);
+  CHECK(trav.step(U's') == c::TraverseStatus::NoLeaf);
+  CHECK(trav.step(U't') == c::TraverseStatus::Ok);
+  CHECK(trav.value() == 1);
+  CHECK(trav.step(U'x') == c::TraverseStatus::NoNode);
+  auto trav2 = trie.traversal();
+  CHECK(trav2.step(U'a') == c::TraverseStatus::NoLeaf);
+  CHECK(trav2.step(U'a') == c::TraverseStatus::NoNode);
+}
+
+TEST_CASE("codepoint trie handles prefixes and non-BMP codepoints") {
+  c::CodepointTrieBuilder bldr;
+  CHECK_OK(bldr.add("𠮷", 1));
+  CHECK_OK(bldr.add("𠮷野家", 2));
+  CHECK_OK(bldr.add("吉野", 3));
+  CHECK_OK(bldr.build());
+  c::CodepointTrie trie;
+  REQUIRE_OK(trie.loadFromMemory(bldr.result()));
+
+  auto cps = codepoints("𠮷野家");
+  auto trav = trie.traversal();
+  CHECK(trav.step(cps[0]) == c::TraverseStatus::Ok);
+  CHECK(trav.value() == 1);
+  CHECK(trav.step(cps[1]) == c::TraverseStatus::NoLeaf);
+  CHECK(trav.step(cps[2]) == c::TraverseStatus::Ok);
+  CHECK(trav.value() == 2);
+  CHECK(trie.label(U'😀') == 0);
+  CHECK(trie.traversal().step(U'😀') == c::TraverseStatus::NoNode);
+}
+
+TEST_CASE("codepoint trie traverses all starts") {
+  c::CodepointTrieBuilder bldr;
+  CHECK_OK(bldr.add("t", 1));
+  CHECK_OK(bldr.add("te", 2));
+  CHECK_OK(bldr.add("test", 3));
+  CHECK_OK(bldr.add("st", 4));
+  CHECK_OK(bldr.add("ста", 5));
+  CHECK_OK(bldr.build());
+  c::CodepointTrie trie;
+  REQUIRE_OK(trie.loadFromMemory(bldr.result()));
+  auto cps = codepoints("testestaстаt");
+  std::vector<std::pair<j::i32, j::i32>> expected = {
+      {0, 101}, {0, 202}, {0, 304}, {2, 404}, {3, 104}, {3, 205},
+      {3, 307}, {5, 407}, {6, 107}, {8, 511}, {11, 112}};
+
+  MatchRecorder recorder;
+  c::AllStartsTraversal<c::CodepointTrie> trav;
+  trav.traverse(trie, cps, recorder);
+  CHECK(recorder.result == expected);
+}
+
+TEST_CASE("codepoint trie finds the same entries as the byte trie") {
+  std::minstd_rand rng{5};
+  std::uniform_int_distribution<char32_t> chars{0x3041, 0x3060};
+  std::uniform_int_distribution<int> length{1, 4};
+  std::vector<std::string> keys;
+  for (int i = 0; i < 2000; ++i) {
+    std::string key;
+    auto len = length(rng);
+    for (int k = 0; k < len; ++k) {
+      auto cp = chars(rng);
+      key.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+      key.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+      key.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+    keys.push_back(key);
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  c::DoubleArrayBuilder daBldr;
+  c::CodepointTrieBuilder cpBldr;
+  for (j::i32 i = 0; i < keys.size(); ++i) {
+    daBldr.add(keys[i], i);
+    CHECK_OK(cpBldr.add(keys[i], i));
+  }
+  REQUIRE_OK(daBldr.build());
+  REQUIRE_OK(cpBldr.build());
+  c::DoubleArray da;
+  REQUIRE_OK(da.loadFromMemory(daBldr.result()));
+  c::CodepointTrie cpt;
+  REQUIRE_OK(cpt.loadFromMemory(cpBldr.result()));
+
+  std::string sentence;
+  for (int i = 0; i < 200; ++i) {
+    sentence += keys[rng() % keys.size()];
+  }
+  sentence += "abc";
+  auto cps = codepoints(sentence);
+
+  MatchRecorder daResult;
+  c::AllStartsTraversal<> daTrav;
+  daTrav.traverse(da, cps, daResult);
+  MatchRecorder cpResult;
+  c::AllStartsTraversal<c::CodepointTrie> cpTrav;
+  cpTrav.traverse(cpt, cps, cpResult);
+  CHECK(daResult.result.size() > 200);
+  CHECK(cpResult.result == daResult.result);
+}
+
+TEST_CASE("codepoint trie rejects invalid input") {
+  c::CodepointTrieBuilder bldr;
+  CHECK_OK(bldr.add("test", 1));
+  CHECK_OK(bldr.add("test", 2));
+  CHECK_FALSE(bldr.build());
+
+  c::CodepointTrieBuilder empty;
+  CHECK_FALSE(empty.add("", 1));
+
+  c::CodepointTrie trie;
+  std::vector<j::u32> garbage(300, 0);
+  j::StringPiece sp{reinterpret_cast<const char*>(garbage.data()),
+                    garbage.size() * sizeof(j::u32)};
+  CHECK_FALSE(trie.loadFromMemory(sp));
+}
@@ -66,6 +66,9 @@ const void *DoubleArrayBuilder::underlyingStorage() const {
 // empty destructor is needed to hide darts interface completely
 DoubleArrayBuilder::~DoubleArrayBuilder() {}
 
+static_assert(sizeof(impl::DoubleArrayUnit) == 2 * sizeof(i32),
+              "DoubleArrayUnit must have the same layout as Darts units");
+
 Status DoubleArray::loadFromMemory(StringPiece memory) {
   underlying_.reset(new impl::DoubleArrayCore{});
   auto &arr = *underlying_;
@@ -73,6 +76,7 @@ Status DoubleArray::loadFromMemory(StringPiece memory) {
   // boo, this casts away const
   void *ptr = (void *)memory.begin();
   arr.set_array(ptr, memory.size() / arr.unit_size());
+  units_ = reinterpret_cast<const impl::DoubleArrayUnit *>(arr.array());
 
   return Status::Ok();
 }
@@ -88,6 +92,8 @@ StringPiece DoubleArray::contents() const {
 
 void DoubleArray::plunder(DoubleArrayBuilder *bldr) {
   underlying_ = std::move(bldr->array_);
+  units_ = reinterpret_cast<const impl::DoubleArrayUnit *>(
+      underlying_->array());
 }
 
 std::string DoubleArray::describe() const {
@@ -99,21 +105,6 @@ std::string DoubleArray::describe() const {
   return description;
 }
 
-TraverseStatus DoubleArrayTraversal::step(StringPiece data) {
-  key_pos_ = 0;
-  auto status = base_->traverse(data.begin(), node_pos_, key_pos_, data.size());
-
-  switch (status) {
-    case -1:
-      return TraverseStatus::NoLeaf;
-    case -2:
-      return TraverseStatus::NoNode;
-    default:
-      value_ = status;
-      return TraverseStatus::Ok;
-  }
-}
-
 }  // namespace dic
 }  // namespace core
 }  // namespace jumanpp
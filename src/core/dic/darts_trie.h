@@ -7,6 +7,8 @@
 
 #include <memory>
 #include <vector>
+#include "util/characters.h"
+#include "util/common.hpp"
 #include "util/status.hpp"
 #include "util/string_piece.h"
 #include "util/types.hpp"
@@ -34,6 +36,12 @@ namespace impl {
 using DoubleArrayCore =
     Darts::DoubleArrayImpl<char, unsigned char, i32, u32, CharStringLength>;
 
+// Memory layout of Darts::DoubleArrayImpl::unit_t
+struct DoubleArrayUnit {
+  i32 base;
+  u32 check;
+};
+
 struct PieceWithValue {
   StringPiece key;
   i32 value;
@@ -75,28 +83,58 @@ enum class TraverseStatus {
 };
 
 class DoubleArrayTraversal {
-  const impl::DoubleArrayCore *base_;
+  const impl::DoubleArrayUnit *units_;
   size_t node_pos_ = 0;
   size_t key_pos_ = 0;
   i32 value_;
 
  public:
-  DoubleArrayTraversal(const impl::DoubleArrayCore *base_) noexcept
-      : base_(base_) {}
+  DoubleArrayTraversal(const impl::DoubleArrayUnit *units_) noexcept
+      : units_(units_) {}
 
   DoubleArrayTraversal(const DoubleArrayTraversal &) noexcept = default;
 
   i32 value() const { return value_; }
-  TraverseStatus step(StringPiece data);
+
+  // Same as Darts::DoubleArrayImpl::traverse, but can be inlined
+  TraverseStatus step(StringPiece data) {
+    auto key = data.begin();
+    auto len = data.size();
+    i32 b = units_[node_pos_].base;
+    u32 p;
+
+    for (key_pos_ = 0; key_pos_ < len; ++key_pos_) {
+      p = b + static_cast<u8>(key[key_pos_]) + 1;
+      if (static_cast<u32>(b) == units_[p].check) {
+        node_pos_ = p;
+        b = units_[p].base;
+      } else {
+        return TraverseStatus::NoNode;
+      }
+    }
+
+    p = b;
+    i32 n = units_[p].base;
+    if (static_cast<u32>(b) == units_[p].check && n < 0) {
+      value_ = -n - 1;
+      return TraverseStatus::Ok;
+    }
+    return TraverseStatus::NoLeaf;
+  }
+
+  TraverseStatus step(const chars::InputCodepoint &cp) {
+    return step(cp.bytes);
+  }
 
   bool operator==(const DoubleArrayTraversal &o) const {
-    return base_ == o.base_ && node_pos_ == o.node_pos_ &&
+    return units_ == o.units_ && node_pos_ == o.node_pos_ &&
            key_pos_ == o.key_pos_ && value_ == o.value_;
   }
 };
 
 class DoubleArray {
   std::unique_ptr<impl::DoubleArrayCore> underlying_;
+  const impl::DoubleArrayUnit *units_ = nullptr;
 
  public:
   Status loadFromMemory(StringPiece memory);
@@ -106,13 +144,42 @@ class DoubleArray {
   ~DoubleArray();
 
   DoubleArrayTraversal traversal() const {
-    return DoubleArrayTraversal(underlying_.get());
+    return DoubleArrayTraversal(units_);
   }
 
   StringPiece contents() const;
   std::string describe() const;
+};
 
-  friend class DoubleArrayTraversal;
+/**
+ * Traverses the trie from every start position of the input.
+ *
+ * Matches are reported to the handler by start, then by end position.
+ * Handler must have a method match(i32 begin, i32 end, i32 value),
+ * value is the same as the value() of the trie traversal.
+ *
+ * Trie is DoubleArray or CodepointTrie.
+ */
+template <typename Trie = DoubleArray>
+class AllStartsTraversal {
+ public:
+  template <typename Handler>
+  void traverse(const Trie &trie,
+                util::ArraySlice<chars::InputCodepoint> points,
+                Handler &handler) {
+    i32 total = static_cast<i32>(points.size());
+    for (i32 begin = 0; begin < total; ++begin) {
+      auto trav = trie.traversal();
+      for (i32 position = begin; position < total; ++position) {
+        auto status = trav.step(points[position]);
+        if (status == TraverseStatus::Ok) {
+          handler.match(begin, position + 1, trav.value());
+        } else if (status == TraverseStatus::NoNode) {
+          break;
+        }
+      }
+    }
+  }
 };
 
 }  // namespace dic
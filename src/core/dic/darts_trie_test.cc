@@ -34,4 +34,35 @@ TEST_CASE("darts builds and traverses") {
   CHECK(trav.step("t") == c::TraverseStatus::Ok);
   CHECK(trav.value() == 1);
   CHECK(trav.step("x") == c::TraverseStatus::NoNode);
-}
\ No newline at end of file
+}
+namespace {
+struct MatchRecorder {
+  std::vector<std::pair<j::i32, j::i32>> result;
+
+  void match(j::i32 begin, j::i32 end, j::i32 value) {
+    result.emplace_back(begin, end + 100 * value);
+  }
+};
+}  // namespace
+
+TEST_CASE("darts traverses all starts") {
+  c::DoubleArrayBuilder bldr;
+  bldr.add("t", 1);
+  bldr.add("te", 2);
+  bldr.add("test", 3);
+  bldr.add("st", 4);
+  bldr.add("ста", 5);
+  CHECK_OK(bldr.build());
+  c::DoubleArray da;
+  CHECK_OK(da.loadFromMemory(bldr.result()));
+  std::vector<j::chars::InputCodepoint> cps;
+  REQUIRE_OK(j::chars::preprocessRawData("testestaстаt", &cps));
+
+  MatchRecorder recorder;
+  c::AllStartsTraversal<> trav;
+  trav.traverse(da, cps, recorder);
+  std::vector<std::pair<j::i32, j::i32>> expected = {
+      {0, 101}, {0, 202}, {0, 304}, {2, 404}, {3, 104}, {3, 205},
+      {3, 307}, {5, 407}, {6, 107}, {8, 511}, {11, 112}};
+  CHECK(recorder.result == expected);
+}
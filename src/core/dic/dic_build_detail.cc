@@ -3,6 +3,7 @@
 //
 
 #include "dic_build_detail.h"
+#include <thread>
 #include "dic_builder.h"
 
 namespace jumanpp {
@@ -20,6 +21,12 @@ void DictionaryBuilderStorage::fillResult(BuiltDictionary* dic_) {
   }
 
   dic_->trieContent = entries.trieBuilder.daBuilder.result();
+  if (entries.trieBuilder.hasCodepointTrie) {
+    dic_->codepointTrieContent = entries.trieBuilder.cpBuilder.result();
+  }
+  if (entries.buildFeatureTable) {
+    dic_->entryTableContent = entries.featureTable.result();
+  }
   dic_->entryPointers = entries.trieBuilder.entryPtrBuffer.contents();
   dic_->entryData = entries.entryDataBuffer.contents();
   auto& flds = dic_->fieldData;
@@ -66,27 +73,38 @@ void DictionaryBuilderStorage::fillResult(BuiltDictionary* dic_) {
 Status DictionaryBuilderStorage::computeStats(StringPiece name,
                                               util::CsvReader* csv,
                                               ProgressCallback* callback) {
+  return countValues(name, csv, &importers, &entries.surfaceCounter_, 0,
+                     callback);
+}
+
+Status DictionaryBuilderStorage::countValues(
+    StringPiece name, util::CsvReader* csv,
+    std::vector<ColumnImportContext>* columns, impl::StringStorage* surfaces,
+    i64 firstLine, ProgressCallback* callback) const {
   u64 numLine = 1;
   while (csv->nextLine()) {
     auto ncols = csv->numFields();
     if (maxUsedCol >= ncols) {
       return Status::InvalidParameter()
              << "when processing file: " << name << ", on line "
-             << csv->lineNumber() << " there were " << ncols
+             << firstLine + csv->lineNumber() << " there were " << ncols
              << " columns, however field " << maxFieldName
              << " is defined as column #" << maxUsedCol + 1;
     }
 
-    for (auto& imp : importers) {
+    for (auto& imp : *columns) {
       if (!imp.importFieldValue(*csv)) {
         return Status::InvalidState()
                << "when processing dictionary file " << name
                << " import failed when importing column number "
                << imp.descriptor->position << " named " << imp.descriptor->name
-               << " line #" << csv->lineNumber();
+               << " line #" << firstLine + csv->lineNumber();
       }
       if (imp.isTrieIndexed) {
-        entries.addSurface(csv->field(imp.descriptor->position - 1));
+        auto surface = csv->field(imp.descriptor->position - 1);
+        if (!surfaces->increaseFieldValueCount(surface)) {
+          return JPPS_INVALID_STATE << "failed to import surface " << surface;
+        }
       }
     }
     if (callback != nullptr && numLine % 4096 == 0) {
@@ -98,6 +116,123 @@ Status DictionaryBuilderStorage::computeStats(StringPiece name,
   return Status::Ok();
 }
 
+namespace {
+
+/**
+ * Splits csv data into at most numParts parts of similar size,
+ * each of them starts at the beginning of a csv line.
+ * Quoted fields can contain line breaks.
+ */
+void splitCsvLines(StringPiece data, u32 numParts,
+                   std::vector<StringPiece>* parts,
+                   std::vector<i64>* firstLines) {
+  auto begin = data.char_begin();
+  auto end = data.char_end();
+  auto partSize = static_cast<ptrdiff_t>(data.size() / numParts);
+  auto partStart = begin;
+  i64 numLines = 0;
+  i64 partLines = 0;
+  bool quoted = false;
+  for (auto position = begin; position < end; ++position) {
+    auto ch = *position;
+    if (ch == '"') {
+      quoted = !quoted;
+    } else if (ch == '\n' && !quoted) {
+      ++numLines;
+      auto next = position + 1;
+      // the same as CsvReader, \n\r is a single line break
+      if (next < end && *next == '\r') {
+        ++next;
+      }
+      if (next - partStart >= partSize && parts->size() + 1 < numParts) {
+        parts->emplace_back(partStart, next);
+        firstLines->push_back(partLines);
+        partStart = next;
+        partLines = numLines;
+      }
+    }
+  }
+  parts->emplace_back(partStart, end);
+  firstLines->push_back(partLines);
+}
+
+struct StatsPart {
+  StringPiece data;
+  i64 firstLine;
+  std::vector<impl::StringStorage> storage;
+  std::vector<ColumnImportContext> importers;
+  impl::StringStorage surfaces;
+  Status status = Status::Ok();
+  // csv reader did not reach the end of the part because of malformed csv
+  bool stopped = false;
+};
+
+}  // namespace
+
+Status DictionaryBuilderStorage::computeStatsParallel(
+    StringPiece name, StringPiece data, u32 numThreads,
+    ProgressCallback* callback) {
+  std::vector<StringPiece> datas;
+  std::vector<i64> firstLines;
+  splitCsvLines(data, numThreads, &datas, &firstLines);
+
+  std::vector<StatsPart> parts(datas.size());
+  for (size_t i = 0; i < parts.size(); ++i) {
+    auto& part = parts[i];
+    part.data = datas[i];
+    part.firstLine = firstLines[i];
+    part.storage.resize(storage.size());
+    part.importers.resize(importers.size());
+    for (i32 j = 0; j < importers.size(); ++j) {
+      JPP_RETURN_IF_ERROR(part.importers[j].initialize(
+          j, importers[j].descriptor, part.storage));
+    }
+  }
+
+  auto countPart = [&](StatsPart* part) {
+    util::CsvReader csv;
+    part->status = csv.initFromMemory(part->data);
+    if (part->status) {
+      part->status = countValues(name, &csv, &part->importers,
+                                 &part->surfaces, part->firstLine, nullptr);
+      part->stopped = csv.bytePosition() != csv.byteSize();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < parts.size(); ++i) {
+    threads.emplace_back(countPart, &parts[i]);
+  }
+  countPart(&parts[0]);
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // merge in the order of parts, so hashmaps have the same layout
+  // as after computeStats
+  for (auto& part : parts) {
+    JPP_RETURN_IF_ERROR(std::move(part.status));
+    for (size_t i = 0; i < storage.size(); ++i) {
+      if (!storage[i].mergeCounts(part.storage[i])) {
+        return JPPS_INVALID_STATE << "failed to merge values of storage #"
+                                  << i;
+      }
+    }
+    if (!entries.surfaceCounter_.mergeCounts(part.surfaces)) {
+      return JPPS_INVALID_STATE << "failed to merge surfaces";
+    }
+    // computeStats stops at the first malformed line too
+    if (part.stopped) {
+      break;
+    }
+    if (callback != nullptr) {
+      auto done = part.data.char_end() - data.char_begin();
+      callback->report(static_cast<u64>(done), data.size());
+    }
+  }
+  return Status::Ok();
+}
+
 Status DictionaryBuilderStorage::makeStorage(ProgressCallback* callback) {
   for (int i = 0; i < storage.size(); ++i) {
     JPP_RETURN_IF_ERROR(storage[i].makeStorage(&stringBuffers[i]));
@@ -144,6 +279,11 @@ Status DictionaryBuilderStorage::buildTrie(ProgressCallback* callback) {
   return Status::Ok();
 }
 
+Status DictionaryBuilderStorage::buildEntryTable() {
+  auto dataSize = entries.entryDataBuffer.contents().size();
+  return entries.featureTable.build(dataSize);
+}
+
 Status DictionaryBuilderStorage::initialize(const s::DictionarySpec& dicSpec) {
   indexColumn = dicSpec.indexColumn;
 
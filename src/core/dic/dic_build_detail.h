@@ -45,9 +45,17 @@ struct DictionaryBuilderStorage {
   Status initDicFeatures(const s::FeaturesSpec& dicSpec);
   Status computeStats(StringPiece name, util::CsvReader* csv,
                       ProgressCallback* callback);
+  // Same result as computeStats for the whole data
+  Status computeStatsParallel(StringPiece name, StringPiece data,
+                              u32 numThreads, ProgressCallback* callback);
+  Status countValues(StringPiece name, util::CsvReader* csv,
+                     std::vector<ColumnImportContext>* columns,
+                     impl::StringStorage* surfaces, i64 firstLine,
+                     ProgressCallback* callback) const;
   Status makeStorage(ProgressCallback* callback);
   i32 importActualData(util::CsvReader* csv, ProgressCallback* callback);
   Status buildTrie(ProgressCallback* callback);
+  Status buildEntryTable();
   void fillResult(BuiltDictionary* dic_);
   Status initGroupingFields(const s::AnalysisSpec& spec);
 };
@@ -4,6 +4,7 @@
 
 #include "dic_builder.h"
 #include <chrono>
+#include <cstring>
 #include "core/dic/dic_build_detail.h"
 #include "core/dic/progress.h"
 #include "core/spec/spec_ser.h"
@@ -28,7 +29,12 @@ Status DictionaryBuilder::importCsv(StringPiece name, StringPiece data) {
 
   // first csv pass -- compute stats
   newProgressStep("Compiling column contents");
-  JPP_RETURN_IF_ERROR(storage_->computeStats(name, &csv, progress_));
+  if (numThreads_ > 1) {
+    JPP_RETURN_IF_ERROR(
+        storage_->computeStatsParallel(name, data, numThreads_, progress_));
+  } else {
+    JPP_RETURN_IF_ERROR(storage_->computeStats(name, &csv, progress_));
+  }
 
   // build string storage and internal state for the third step
   newProgressStep("Compiling column storage");
@@ -38,6 +44,8 @@ Status DictionaryBuilder::importCsv(StringPiece name, StringPiece data) {
   JPP_RETURN_IF_ERROR(csv.initFromMemory(data));
 
   JPP_RETURN_IF_ERROR(storage_->initDicFeatures(spec_->features));
+  storage_->entries.buildFeatureTable = buildEntryTable_;
+  storage_->entries.trieBuilder.hasCodepointTrie = buildCodepointTrie_;
 
   // second csv pass -- compute entries
   newProgressStep("Compiling dictionary entries");
@@ -47,6 +55,11 @@ Status DictionaryBuilder::importCsv(StringPiece name, StringPiece data) {
   newProgressStep("Compiling trie index");
   JPP_RETURN_IF_ERROR(storage_->buildTrie(progress_));
 
+  if (buildEntryTable_) {
+    newProgressStep("Compiling entry feature table");
+    JPP_RETURN_IF_ERROR(storage_->buildEntryTable());
+  }
+
   // and create answer
 
   dic_.reset(new BuiltDictionary);
@@ -106,6 +119,14 @@ Status DictionaryBuilder::fillModelPart(model::ModelPart *part,
   for (auto &ib : storage_->builtInts) {
     part->data.push_back(ib);
   }
+  // Optional chunks go after all mandatory ones,
+  // so models without them can still be loaded
+  if (!dic_->codepointTrieContent.empty()) {
+    part->data.push_back(dic_->codepointTrieContent);
+  }
+  if (!dic_->entryTableContent.empty()) {
+    part->data.push_back(dic_->entryTableContent);
+  }
 
   return Status::Ok();
 }
@@ -122,7 +143,9 @@ inline Status fixupDictionary(const model::ModelPart &dicInfo,
   auto spec_ = &dic->spec;
   i32 expectedCount =
       spec_->dictionary.numStringStorage + spec_->dictionary.numIntStorage + 4;
-  if (expectedCount != dicInfo.data.size()) {
+  i32 actualCount = static_cast<i32>(dicInfo.data.size());
+  // at most two optional chunks
+  if (actualCount < expectedCount || actualCount > expectedCount + 2) {
     return JPPS_INVALID_PARAMETER
            << "model file did not have all dictionary chunks";
   }
@@ -159,6 +182,22 @@ inline Status fixupDictionary(const model::ModelPart &dicInfo,
     dic->intStorages.push_back(dicInfo.data[cnt]);
     ++cnt;
   }
+  // optional chunks are identified by their magic
+  for (; cnt < actualCount; ++cnt) {
+    auto chunk = dicInfo.data[cnt];
+    u32 magic = 0;
+    if (chunk.size() >= sizeof(u32)) {
+      std::memcpy(&magic, chunk.data(), sizeof(u32));
+    }
+    if (magic == CodepointTrie::Magic) {
+      dic->codepointTrieContent = chunk;
+    } else if (magic == EntryFeatureTable::Magic) {
+      dic->entryTableContent = chunk;
+    } else {
+      return JPPS_INVALID_PARAMETER << "unknown optional dictionary chunk #"
+                                    << cnt << ", probably corrupted model";
+    }
+  }
   if (dic->fieldData.size() != spec_->dictionary.fields.size()) {
     return JPPS_INVALID_PARAMETER << "number of columns in spec was not "
                                      "equal to loaded number of columns";
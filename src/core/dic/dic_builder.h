@@ -32,6 +32,10 @@ struct BuiltField {
 
 struct BuiltDictionary {
   StringPiece trieContent;
+  // Optional, see DictionaryBuilder::setBuildCodepointTrie
+  StringPiece codepointTrieContent;
+  // Optional, see DictionaryBuilder::setBuildEntryTable
+  StringPiece entryTableContent;
   StringPiece entryPointers;
   StringPiece entryData;
   std::vector<BuiltField> fieldData;
@@ -50,6 +54,9 @@ class DictionaryBuilder {
   std::unique_ptr<BuiltDictionary> dic_;
   std::unique_ptr<DictionaryBuilderStorage> storage_;
   ProgressCallback* progress_ = nullptr;
+  bool buildEntryTable_ = false;
+  bool buildCodepointTrie_ = false;
+  u32 numThreads_ = 1;
 
   void newProgressStep(StringPiece name);
 
@@ -63,6 +70,25 @@ class DictionaryBuilder {
   const BuiltDictionary& result() const { return *dic_; }
   const spec::AnalysisSpec& spec() const { return *spec_; }
   void setProgress(ProgressCallback* callback) { progress_ = callback; }
+  /**
+   * Also store feature fields of all entries in a fixed-width table
+   * (see EntryFeatureTable), so analysis does not need to decode them.
+   * Makes the model larger.
+   */
+  void setBuildEntryTable(bool value) { buildEntryTable_ = value; }
+  /**
+   * Also index entries with a trie which makes a step per codepoint
+   * (see CodepointTrie), dictionary lookups use it when it is present.
+   * Makes the model larger, models with it can not be loaded
+   * by versions which do not know the trie.
+   */
+  void setBuildCodepointTrie(bool value) { buildCodepointTrie_ = value; }
+  /**
+   * Count field values of dictionary parts in several threads.
+   * Other stages of the import are not parallel.
+   * The result does not depend on the number of threads.
+   */
+  void setNumThreads(u32 value) { numThreads_ = value; }
 };
 
 }  // namespace dic
@@ -5,9 +5,12 @@
 #ifndef JUMANPP_DIC_ENTRIES_H
 #define JUMANPP_DIC_ENTRIES_H
 
+#include <algorithm>
 #include <array>
 #include "core/core_types.h"
+#include "core/dic/codepoint_trie.h"
 #include "core/dic/darts_trie.h"
+#include "core/dic/entry_table.h"
 #include "core_config.h"
 #include "field_reader.h"
 #include "util/array_slice.h"
@@ -127,6 +130,17 @@ class DicEntryBuffer {
     return true;
   }
 
+  // an entry which is not stored in the dictionary, without aliases
+  void fillFromValues(util::ArraySlice<i32> features,
+                      util::ArraySlice<i32> data) {
+    JPP_DCHECK_EQ(features.size(), numFeatures_);
+    JPP_DCHECK_EQ(data.size(), numData_);
+    std::copy(features.begin(), features.end(), featureBuffer_.begin());
+    std::copy(data.begin(), data.end(), featureBuffer_.begin() + numFeatures_);
+    remainingData_.clear();
+    dataBuffer_[0] = 1;
+  }
+
   void overwriteFeaturesWith(util::ArraySlice<i32> newFeatures) {
     JPP_DCHECK_LT(newFeatures.size(), JPP_MAX_DIC_FIELDS);
     for (int i = 0; i < newFeatures.size(); ++i) {
@@ -189,6 +203,10 @@ class IndexedEntries {
 
 struct EntriesHolder {
   DoubleArray trie;
+  // can be empty for models which were built without it
+  CodepointTrie codepointTrie;
+  // can be empty as well
+  EntryFeatureTable entryTable;
   i32 numFeatures;
   i32 numData;
   impl::IntStorageReader entries;
@@ -200,15 +218,34 @@ struct EntriesHolder {
   }
 };
 
+/**
+ * Traverses the dictionary index one input codepoint at a time.
+ * Uses the codepoint trie if the dictionary has it.
+ */
 class IndexTraversal {
   DoubleArrayTraversal da_;
+  CodepointTrieTraversal cp_;
   const EntriesHolder* dic_;
+  bool useCodepoints_;
 
  public:
   explicit IndexTraversal(const EntriesHolder* dic_)
-      : da_(dic_->trie.traversal()), dic_(dic_) {}
-  TraverseStatus step(const StringPiece& sp) { return da_.step(sp); }
-  IndexedEntries entries() const { return dic_->entryTraversal(da_.value()); }
+      : da_(dic_->trie.traversal()),
+        cp_(dic_->codepointTrie.traversal()),
+        dic_(dic_),
+        useCodepoints_{!dic_->codepointTrie.empty()} {}
+
+  TraverseStatus step(const chars::InputCodepoint& cp) {
+    if (useCodepoints_) {
+      return cp_.step(cp.codepoint);
+    }
+    return da_.step(cp.bytes);
+  }
+
+  IndexedEntries entries() const {
+    auto value = useCodepoints_ ? cp_.value() : da_.value();
+    return dic_->entryTraversal(value);
+  }
 };
 
 class DictionaryEntries {
@@ -224,16 +261,51 @@ class DictionaryEntries {
   DoubleArrayTraversal doubleArrayTraversal() const {
     return data_->trie.traversal();
   }
+  const DoubleArray& trie() const { return data_->trie; }
+  // nullptr if the dictionary does not have the codepoint trie
+  const CodepointTrie* codepointTrie() const {
+    auto t = &data_->codepointTrie;
+    return t->empty() ? nullptr : t;
+  }
 
   IndexedEntries entryTraversal(const DoubleArrayTraversal& at) const {
     return data_->entryTraversal(at.value());
   }
 
+  IndexedEntries entryTraversal(i32 trieValue) const {
+    return data_->entryTraversal(trieValue);
+  }
+
   impl::IntListTraversal entryAtPtr(EntryPtr ptr) const {
     auto rdr = data_->entries.rawWithLimit(ptr.dicPtr(), data_->numFeatures);
     return rdr;
   }
 
+  /**
+   * Reads feature fields of a dictionary entry.
+   * Uses the entry table when the dictionary has one,
+   * decodes them from the entry data otherwise.
+   * Returns the number of read fields.
+   */
+  size_t fillFeatures(EntryPtr ptr, util::MutableArraySlice<i32> result) const {
+    auto row = data_->entryTable.featuresOf(ptr.dicPtr());
+    if (JPP_LIKELY(row != nullptr)) {
+      auto cnt = std::min<size_t>(result.size(), data_->numFeatures);
+      std::copy(row, row + cnt, result.begin());
+      return cnt;
+    }
+    return entryAtPtr(ptr).fill(result, result.size());
+  }
+
+  void prefetchFeatures(EntryPtr ptr) const {
+    auto row = data_->entryTable.featuresOf(ptr.dicPtr());
+    if (row != nullptr) {
+      util::prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(row);
+    } else {
+      data_->entries.prefetch(ptr.dicPtr());
+    }
+  }
+
   bool fillBuffer(EntryPtr eptr, DicEntryBuffer* buffer) const {
     buffer->setCounts(static_cast<u32>(numFeatures()),
                       static_cast<u32>(numData()));
@@ -16,6 +16,14 @@ Status fillEntriesHolder(const BuiltDictionary& dic, EntriesHolder* result) {
   result->numData = static_cast<i32>(dic.spec.features.numDicData);
   result->entries = impl::IntStorageReader{dic.entryData};
   result->entryPtrs = impl::IntStorageReader{dic.entryPointers};
+  if (!dic.codepointTrieContent.empty()) {
+    JPP_RETURN_IF_ERROR(
+        result->codepointTrie.loadFromMemory(dic.codepointTrieContent));
+  }
+  if (!dic.entryTableContent.empty()) {
+    JPP_RETURN_IF_ERROR(result->entryTable.loadFromMemory(
+        dic.entryTableContent, static_cast<u32>(result->numFeatures)));
+  }
   return result->trie.loadFromMemory(dic.trieContent);
 }
 
@@ -35,7 +35,10 @@ struct TesterStep {
       : cols_(cols_), trav(trav) {}
 
   TesterStep& step(StringPiece sp, TraverseStatus expected) {
-    auto actual = trav.step(sp);
+    std::vector<chars::InputCodepoint> cps;
+    REQUIRE_OK(chars::preprocessRawData(sp, &cps));
+    REQUIRE(cps.size() == 1);
+    auto actual = trav.step(cps[0]);
     REQUIRE(actual == expected);
     return *this;
   }
@@ -86,6 +89,12 @@ struct DataTester {
   TesterStep operator()() { return TesterStep{columns, entrs->traversal()}; }
 };
 
+std::vector<chars::InputCodepoint> codepoints(StringPiece data) {
+  std::vector<chars::InputCodepoint> cps;
+  REQUIRE_OK(chars::preprocessRawData(data, &cps));
+  return cps;
+}
+
 class TesterSpec {
  public:
   AnalysisSpec spec;
@@ -236,3 +245,119 @@ TEST_CASE("small dictionary where one of lines is corrupted is not imported") {
   CHECK_THAT(status.message().str(), Catch::Contains("there were 1 columns"));
   CHECK_THAT(status.message().str(), Catch::Contains("on line 2"));
 }
+
+TEST_CASE("codepoint trie is built only when requested") {
+  TesterSpec test;
+  StringPiece data{"a,b\nあい,d\nあ,f"};
+
+  DictionaryBuilder plain;
+  CHECK_OK(plain.importSpec(&test.spec));
+  CHECK_OK(plain.importCsv("data", data));
+  CHECK(plain.result().codepointTrieContent.empty());
+
+  DictionaryBuilder bldr;
+  bldr.setBuildCodepointTrie(true);
+  CHECK_OK(bldr.importSpec(&test.spec));
+  CHECK_OK(bldr.importCsv("data", data));
+  auto& dic = bldr.result();
+  REQUIRE_FALSE(dic.codepointTrieContent.empty());
+
+  DataTester tester{dic};
+  tester().step("a", TraverseStatus::Ok).fillEntries().strings({"a", "b"});
+  tester().step("あ", TraverseStatus::Ok).fillEntries().strings({"あ", "f"});
+  tester()
+      .step("あ", TraverseStatus::Ok)
+      .step("い", TraverseStatus::Ok)
+      .fillEntries()
+      .strings({"あい", "d"});
+}
+
+TEST_CASE("dictionary is the same when it is imported in several threads") {
+  TesterSpec test;
+  std::string data;
+  for (int i = 0; i < 300; ++i) {
+    data += "k" + std::to_string(i % 97) + "," + std::to_string(i % 13);
+    if (i % 50 == 7) {
+      data += "\"q\nu,o\"\"te\"";
+    }
+    data += "\n";
+  }
+
+  DictionaryBuilder serial;
+  serial.setBuildCodepointTrie(true);
+  CHECK_OK(serial.importSpec(&test.spec));
+  CHECK_OK(serial.importCsv("data", data));
+  auto& dic1 = serial.result();
+
+  for (u32 threads : {2, 3, 7}) {
+    CAPTURE(threads);
+    DictionaryBuilder parallel;
+    parallel.setNumThreads(threads);
+    parallel.setBuildCodepointTrie(true);
+    CHECK_OK(parallel.importSpec(&test.spec));
+    CHECK_OK(parallel.importCsv("data", data));
+    auto& dic2 = parallel.result();
+    CHECK(dic1.entryCount == dic2.entryCount);
+    CHECK(dic1.trieContent == dic2.trieContent);
+    CHECK(dic1.codepointTrieContent == dic2.codepointTrieContent);
+    CHECK(dic1.entryPointers == dic2.entryPointers);
+    CHECK(dic1.entryData == dic2.entryData);
+    CHECK(dic1.stringStorages == dic2.stringStorages);
+    CHECK(dic1.intStorages == dic2.intStorages);
+  }
+}
+
+TEST_CASE("dictionary imported in several threads reports corrupted lines") {
+  TesterSpec test;
+  std::string data;
+  for (int i = 0; i < 100; ++i) {
+    data += (i == 80) ? "x\n" : "a,b\n";
+  }
+  DictionaryBuilder bldr;
+  bldr.setNumThreads(4);
+  CHECK_OK(bldr.importSpec(&test.spec));
+  auto status = bldr.importCsv("data", data);
+  CHECK_FALSE(status);
+  CHECK_THAT(status.message().str(), Catch::Contains("on line 81"));
+}
+
+TEST_CASE("entry table has the same features as entry data") {
+  TesterSpec test;
+  StringPiece data{"a,b\na,d\nae,f\nx,b"};
+
+  DictionaryBuilder bldr;
+  bldr.setBuildEntryTable(true);
+  CHECK_OK(bldr.importSpec(&test.spec));
+  CHECK_OK(bldr.importCsv("data", data));
+  auto& dic = bldr.result();
+  REQUIRE_FALSE(dic.entryTableContent.empty());
+
+  EntriesHolder holder;
+  REQUIRE_OK(fillEntriesHolder(dic, &holder));
+  REQUIRE_FALSE(holder.entryTable.empty());
+  CHECK(holder.entryTable.numRows() == 4);
+  DictionaryEntries entries{&holder};
+
+  i32 numChecked = 0;
+  std::vector<StringPiece> keys = {"a", "ae", "x"};
+  for (auto key : keys) {
+    CAPTURE(key);
+    auto trav = entries.traversal();
+    for (auto& cp : codepoints(key)) {
+      trav.step(cp);
+    }
+    auto ptrs = trav.entries();
+    while (ptrs.readOnePtr()) {
+      auto ptr = ptrs.currentPtr();
+      REQUIRE(holder.entryTable.featuresOf(ptr.dicPtr()) != nullptr);
+      std::vector<i32> decoded(2), fromTable(2);
+      REQUIRE(entries.entryAtPtr(ptr).fill(decoded, 2) == 2);
+      REQUIRE(entries.fillFeatures(ptr, &fromTable) == 2);
+      CHECK(decoded == fromTable);
+      ++numChecked;
+    }
+  }
+  CHECK(numChecked == 4);
+  // there are no entries in the middle of other entries
+  CHECK(holder.entryTable.featuresOf(1) == nullptr);
+}
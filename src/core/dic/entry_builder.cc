@@ -21,9 +21,16 @@ Status DicTrieBuilder::buildTrie(const impl::StringStorage& strings,
       auto entriesPtr = static_cast<i32>(entryPtrBuffer.position());
       impl::writePtrsAsDeltas(entries, entryPtrBuffer);
       daBuilder.add(key, entriesPtr);
+      if (hasCodepointTrie && !cpBuilder.add(key, entriesPtr)) {
+        hasCodepointTrie = false;
+      }
     }
   }
-  return daBuilder.build(progress);
+  JPP_RETURN_IF_ERROR(daBuilder.build(progress));
+  if (hasCodepointTrie) {
+    JPP_RETURN_IF_ERROR(cpBuilder.build());
+  }
+  return Status::Ok();
 }
 
 i32 EntryTableBuilder::importOneLine(std::vector<ColumnImportContext>& columns,
@@ -68,6 +75,7 @@ Status EntryTableBuilder::createFeatures(const spec::FeaturesSpec& features,
   for (auto& f : features.dictionary) {
     JPP_RIE_MSG(createFeature(f), "for feature: " << f.name);
   }
+  featureTable.initialize(static_cast<u32>(features.numDicFeatures));
   return Status::Ok();
 }
 
@@ -157,6 +165,9 @@ void DicEntryData::addData(EntryTableBuilder* bldr,
 i32 DicEntryData::write(EntryTableBuilder* bldr) {
   auto& buf = bldr->entryDataBuffer;
   auto ptr = buf.position();
+  if (bldr->buildFeatureTable) {
+    bldr->featureTable.add(static_cast<i32>(ptr), features);
+  }
   for (auto f : features) {
     buf.writeVarint(static_cast<u32>(f));
   }
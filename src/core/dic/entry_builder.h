@@ -5,8 +5,10 @@
 #ifndef JUMANPP_ENTRY_BUILDER_H
 #define JUMANPP_ENTRY_BUILDER_H
 
+#include "core/dic/codepoint_trie.h"
 #include "core/dic/darts_trie.h"
 #include "core/dic/dic_feature_impl.h"
+#include "core/dic/entry_table.h"
 #include "core/dic/field_import.h"
 #include "core/dic/progress.h"
 #include "util/coded_io.h"
@@ -25,6 +27,10 @@ struct DicTrieBuilder {
   util::CodedBuffer entryPtrBuffer;
   util::FlatMap<i32, util::InlinedVector<i32, 4>> entriesWithField;
   DoubleArrayBuilder daBuilder;
+  CodepointTrieBuilder cpBuilder;
+  // see DictionaryBuilder::setBuildCodepointTrie,
+  // codepoint trie is not built if any key is not a valid UTF-8
+  bool hasCodepointTrie = false;
   ProgressCallback* callback = nullptr;
 
   void addEntry(i32 fieldValue, i32 entryPtr) {
@@ -70,6 +76,8 @@ struct EntryTableBuilder {
   DicTrieBuilder trieBuilder;
   impl::StringStorage surfaceCounter_;
   DicEntryBag entryBag;
+  EntryFeatureTableBuilder featureTable;
+  bool buildFeatureTable = false;
 
   std::vector<std::unique_ptr<DicFeatureBase>> features_;
   std::vector<ImportFieldDicFeatureImpl> content_;
@@ -101,10 +109,6 @@ struct EntryTableBuilder {
   i32 importOneLine(std::vector<ColumnImportContext>& columns,
                     const util::CsvReader& csv);
 
-  void addSurface(StringPiece surface) {
-    surfaceCounter_.increaseFieldValueCount(surface);
-  }
-
   Status createFeatures(const spec::FeaturesSpec& features,
                         const DicFeatureContext& ctx);
 
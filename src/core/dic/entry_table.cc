@@ -0,0 +1,136 @@
+#include "entry_table.h"
+#include <algorithm>
+#include <cstring>
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+namespace {
+
+constexpr u32 EntryTableVersion = 1;
+// magic, version, numFeatures, stride, numRows, numWords, 2 x padding
+constexpr u32 HeaderSize = 8;
+// rows are aligned to 16 bytes
+constexpr u32 RowAlignment = 4;
+
+u32 alignUp(u32 value, u32 alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+constexpr u32 EntryFeatureTable::Magic;
+
+Status EntryFeatureTable::loadFromMemory(StringPiece memory, u32 numFeatures) {
+  if (memory.size() % sizeof(u32) != 0 ||
+      reinterpret_cast<uintptr_t>(memory.data()) % sizeof(u64) != 0) {
+    return JPPS_INVALID_PARAMETER
+           << "entry table memory is not aligned, probably corrupted model";
+  }
+  auto data = reinterpret_cast<const u32*>(memory.data());
+  size_t size = memory.size() / sizeof(u32);
+  if (size < HeaderSize || data[0] != Magic) {
+    return JPPS_INVALID_PARAMETER << "entry table has invalid header";
+  }
+  if (data[1] != EntryTableVersion) {
+    return JPPS_INVALID_PARAMETER << "entry table version " << data[1]
+                                  << " is not supported";
+  }
+  if (data[2] != numFeatures) {
+    return JPPS_INVALID_PARAMETER << "entry table had " << data[2]
+                                  << " features, dictionary has "
+                                  << numFeatures;
+  }
+  u32 stride = data[3];
+  u32 numRows = data[4];
+  u32 numWords = data[5];
+  u32 rankSize = alignUp(numWords, 2);
+  u32 rowOffset = alignUp(HeaderSize + rankSize + numWords * 2, RowAlignment);
+  size_t expected = rowOffset + static_cast<size_t>(numRows) * stride;
+  if (stride != alignUp(numFeatures, RowAlignment) || size != expected) {
+    return JPPS_INVALID_PARAMETER << "entry table size " << size
+                                  << " was different from expected "
+                                  << expected;
+  }
+
+  ranks_ = util::ArraySlice<u32>{data + HeaderSize, numWords};
+  starts_ = util::ArraySlice<u64>{
+      reinterpret_cast<const u64*>(data + HeaderSize + rankSize), numWords};
+  if (numWords != 0) {
+    auto last = ranks_[numWords - 1] + util::popCount(starts_.back());
+    if (last != numRows) {
+      return JPPS_INVALID_PARAMETER << "entry table has " << last
+                                    << " entries and " << numRows << " rows";
+    }
+  }
+  rows_ = reinterpret_cast<const i32*>(data + rowOffset);
+  numFeatures_ = numFeatures;
+  stride_ = stride;
+  numRows_ = numRows;
+  return Status::Ok();
+}
+
+void EntryFeatureTableBuilder::add(i32 dicPtr,
+                                   util::ArraySlice<i32> features) {
+  ptrs_.push_back(static_cast<u32>(dicPtr));
+  auto stride = alignUp(numFeatures_, RowAlignment);
+  auto copied = std::min<size_t>(features.size(), numFeatures_);
+  features_.insert(features_.end(), features.begin(),
+                   features.begin() + copied);
+  features_.resize(features_.size() + stride - copied, 0);
+}
+
+Status EntryFeatureTableBuilder::build(size_t dataSize) {
+  if (!std::is_sorted(ptrs_.begin(), ptrs_.end()) ||
+      std::adjacent_find(ptrs_.begin(), ptrs_.end()) != ptrs_.end()) {
+    return JPPS_INVALID_STATE << "entry table pointers were not increasing";
+  }
+  if (!ptrs_.empty() && ptrs_.back() >= dataSize) {
+    return JPPS_INVALID_STATE << "entry table pointer " << ptrs_.back()
+                              << " is outside of entry data of size "
+                              << dataSize;
+  }
+
+  auto numWords = static_cast<u32>((dataSize + 63) / 64);
+  auto stride = alignUp(numFeatures_, RowAlignment);
+  auto numRows = static_cast<u32>(ptrs_.size());
+  u32 rankSize = alignUp(numWords, 2);
+  u32 rowOffset = alignUp(HeaderSize + rankSize + numWords * 2, RowAlignment);
+
+  result_.clear();
+  result_.resize(rowOffset, 0);
+  result_[0] = EntryFeatureTable::Magic;
+  result_[1] = EntryTableVersion;
+  result_[2] = numFeatures_;
+  result_[3] = stride;
+  result_[4] = numRows;
+  result_[5] = numWords;
+
+  auto ranks = &result_[HeaderSize];
+  auto starts = &result_[HeaderSize + rankSize];
+  for (auto ptr : ptrs_) {
+    auto word = ptr >> 6;
+    u64 bit = u64{1} << (ptr & 63);
+    // word is stored in native byte order, the same as it is read
+    u64 bits;
+    std::memcpy(&bits, starts + word * 2, sizeof(u64));
+    bits |= bit;
+    std::memcpy(starts + word * 2, &bits, sizeof(u64));
+  }
+  u32 rank = 0;
+  for (u32 word = 0; word < numWords; ++word) {
+    ranks[word] = rank;
+    u64 bits;
+    std::memcpy(&bits, starts + word * 2, sizeof(u64));
+    rank += util::popCount(bits);
+  }
+
+  auto rowData = reinterpret_cast<const u32*>(features_.data());
+  result_.insert(result_.end(), rowData, rowData + features_.size());
+  return Status::Ok();
+}
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,85 @@
+#ifndef JUMANPP_ENTRY_TABLE_H
+#define JUMANPP_ENTRY_TABLE_H
+
+#include <vector>
+#include "util/array_slice.h"
+#include "util/common.hpp"
+#include "util/status.hpp"
+#include "util/string_piece.h"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace dic {
+
+/**
+ * Feature fields of dictionary entries in a table with fixed-stride,
+ * 16-byte aligned rows, so reading them needs no varint decoding.
+ *
+ * Entry pointers are byte offsets into the varint-coded entry data.
+ * A bitmap of entry starts with precomputed ranks maps them to rows.
+ * Entries which are not in the table must be read from the entry data.
+ *
+ * The table is an optional chunk of a dictionary model part
+ * (see DictionaryBuilder::setBuildEntryTable), it points to the memory
+ * of the model file and is not copied.
+ */
+class EntryFeatureTable {
+  util::ArraySlice<u32> ranks_;
+  util::ArraySlice<u64> starts_;
+  const i32* rows_ = nullptr;
+  u32 numFeatures_ = 0;
+  u32 stride_ = 0;
+  u32 numRows_ = 0;
+
+ public:
+  static constexpr u32 Magic = 0x42544e45;  // ENTB
+
+  Status loadFromMemory(StringPiece memory, u32 numFeatures);
+
+  bool empty() const noexcept { return rows_ == nullptr; }
+  u32 numRows() const noexcept { return numRows_; }
+  u32 stride() const noexcept { return stride_; }
+
+  // nullptr if the entry is not in the table
+  const i32* featuresOf(i32 dicPtr) const noexcept {
+    auto word = static_cast<u32>(dicPtr) >> 6;
+    if (JPP_UNLIKELY(word >= starts_.size())) {
+      return nullptr;
+    }
+    u64 bits = starts_[word];
+    u64 bit = u64{1} << (dicPtr & 63);
+    if (JPP_UNLIKELY((bits & bit) == 0)) {
+      return nullptr;
+    }
+    auto row = ranks_[word] + util::popCount(bits & (bit - 1));
+    return rows_ + static_cast<size_t>(row) * stride_;
+  }
+};
+
+/**
+ * Entries must be added in the order of increasing pointers.
+ */
+class EntryFeatureTableBuilder {
+  std::vector<u32> ptrs_;
+  std::vector<i32> features_;
+  std::vector<u32> result_;
+  u32 numFeatures_ = 0;
+
+ public:
+  void initialize(u32 numFeatures) { numFeatures_ = numFeatures; }
+  void add(i32 dicPtr, util::ArraySlice<i32> features);
+  // dataSize is the size of the entry data in bytes
+  Status build(size_t dataSize);
+
+  StringPiece result() const {
+    return StringPiece{reinterpret_cast<const char*>(result_.data()),
+                       result_.size() * sizeof(u32)};
+  }
+};
+
+}  // namespace dic
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_ENTRY_TABLE_H
@@ -0,0 +1,59 @@
+#include "entry_table.h"
+#include <testing/standalone_test.h>
+
+namespace c = jumanpp::core::dic;
+namespace j = jumanpp;
+
+TEST_CASE("entry table finds rows by entry pointers") {
+  c::EntryFeatureTableBuilder bldr;
+  bldr.initialize(3);
+  std::vector<j::i32> f1 = {1, 2, 3};
+  std::vector<j::i32> f2 = {4, 5, 6};
+  std::vector<j::i32> f3 = {7, 8, 9};
+  bldr.add(0, f1);
+  bldr.add(5, f2);
+  bldr.add(130, f3);
+  REQUIRE_OK(bldr.build(140));
+
+  c::EntryFeatureTable table;
+  REQUIRE_OK(table.loadFromMemory(bldr.result(), 3));
+  CHECK(table.numRows() == 3);
+  CHECK(table.stride() == 4);
+
+  auto r1 = table.featuresOf(0);
+  REQUIRE(r1 != nullptr);
+  CHECK(r1[0] == 1);
+  CHECK(r1[2] == 3);
+  auto r2 = table.featuresOf(5);
+  REQUIRE(r2 != nullptr);
+  CHECK(r2[1] == 5);
+  auto r3 = table.featuresOf(130);
+  REQUIRE(r3 != nullptr);
+  CHECK(r3[0] == 7);
+  CHECK(r3[2] == 9);
+  CHECK(reinterpret_cast<std::uintptr_t>(r3) % 16 == 0);
+
+  CHECK(table.featuresOf(1) == nullptr);
+  CHECK(table.featuresOf(64) == nullptr);
+  CHECK(table.featuresOf(1000) == nullptr);
+  CHECK(table.featuresOf(-5) == nullptr);
+}
+
+TEST_CASE("entry table rejects invalid input") {
+  c::EntryFeatureTableBuilder bldr;
+  bldr.initialize(2);
+  std::vector<j::i32> f = {1, 2};
+  bldr.add(10, f);
+  bldr.add(3, f);
+  CHECK_FALSE(bldr.build(20));
+
+  c::EntryFeatureTableBuilder good;
+  good.initialize(2);
+  good.add(3, f);
+  REQUIRE_OK(good.build(20));
+  c::EntryFeatureTable table;
+  CHECK_FALSE(table.loadFromMemory(good.result(), 3));
+  auto data = good.result();
+  CHECK_FALSE(table.loadFromMemory(data.slice(0, data.size() - 4), 2));
+  CHECK(table.empty());
+}
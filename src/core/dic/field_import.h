@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <regex>
+#include <vector>
 #include "util/char_buffer.h"
 #include "util/coded_io.h"
 #include "util/csv_reader.h"
@@ -67,18 +68,35 @@ class StringStorage {
    */
   Mapping mapping_;
   util::CharBuffer<> contents_;
+  // keys in the order of their first occurrence
+  std::vector<StringPiece> keys_;
   i32 alignmentPower = 0;
   size_t alignment = 1;
 
  public:
-  bool increaseFieldValueCount(StringPiece sp) {
+  bool increaseFieldValueCount(StringPiece sp, i32 count = 1) {
     // the StringPiece could be transient if it was escaped
     // need to import it before doing anything, if there were none
     if (mapping_.count(sp) == 0) {
       JPP_RET_CHECK(contents_.import(&sp));
-      mapping_[sp] = 1;
+      mapping_[sp] = count;
+      keys_.push_back(sp);
     } else {
-      mapping_[sp] += 1;
+      mapping_[sp] += count;
+    }
+    return true;
+  }
+
+  /**
+   * Adds counts of the other storage.
+   * The layout of the hashmap (and the storage which is made from it)
+   * depends on the order of key insertions, so merging storages
+   * of consecutive parts of a dictionary in their order gives the same
+   * result as importing the whole dictionary into a single storage.
+   */
+  bool mergeCounts(const StringStorage& other) {
+    for (auto& key : other.keys_) {
+      JPP_RET_CHECK(increaseFieldValueCount(key, other.mapping_.at(key)));
     }
     return true;
   }
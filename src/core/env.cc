@@ -3,7 +3,9 @@
 //
 
 #include "env.h"
+#include <chrono>
 #include "core_version.h"
+#include "util/mmap.h"
 
 namespace jumanpp {
 namespace core {
@@ -112,6 +114,36 @@ void JumanppEnv::setAutoBeam(i32 base, i32 step, i32 max) {
   analyzerConfig_.autoBeamMax = max;
 }
 
+void JumanppEnv::setDeadline(i64 micros) {
+  analyzerConfig_.deadlineMicros = micros;
+}
+
+void JumanppEnv::setStatsCollector(
+    analysis::AnalysisStatsCollector *collector) {
+  analyzerConfig_.statsCollector = collector;
+}
+
+void JumanppEnv::setDicCacheSize(i32 size) {
+  analyzerConfig_.dicCacheSize = size;
+}
+
+Status JumanppEnv::setPerceptronKernel(analysis::PerceptronKernel kernel) {
+  return perceptron_.setKernel(kernel);
+}
+
+Status JumanppEnv::loadUserDictionary(StringPiece filename) {
+  if (!core_) {
+    return JPPS_INVALID_STATE
+           << "model must be loaded before user dictionaries";
+  }
+  util::FullyMappedFile file;
+  JPP_RETURN_IF_ERROR(file.open(filename));
+  JPP_RIE_MSG(userDic_.importCsv(dicBldr_.spec, dicHolder_, file.contents()),
+              "when loading user dictionary " << filename);
+  analyzerConfig_.userDictionary = &userDic_;
+  return Status::Ok();
+}
+
 void JumanppEnv::fillVersion(VersionInfo *result) const {
   result->binary = JPP_VERSION_STRING.str();
   using model::ModelPartKind;
@@ -132,5 +164,145 @@ void JumanppEnv::fillVersion(VersionInfo *result) const {
   }
 }
 
+void AnalyzerLease::release() {
+  if (pool_ != nullptr) {
+    pool_->giveBack(item_);
+    pool_ = nullptr;
+    item_ = nullptr;
+  }
+}
+
+Status AnalyzerPool::initialize(const JumanppEnv *env,
+                                const AnalyzerPoolConfig &conf,
+                                OutputFormatFactory formatFactory) {
+  if (conf.maxSize == 0) {
+    return JPPS_INVALID_PARAMETER << "analyzer pool size can not be zero";
+  }
+  if (conf.initialSize > conf.maxSize) {
+    return JPPS_INVALID_PARAMETER
+           << "initial analyzer pool size (" << conf.initialSize
+           << ") is larger than maximum (" << conf.maxSize << ")";
+  }
+
+  lock_t lock{mutex_};
+  if (all_.size() != idle_.size() || creating_ != 0) {
+    return JPPS_INVALID_STATE
+           << "can not reinitialize analyzer pool while it is in use";
+  }
+
+  env_ = env;
+  conf_ = conf;
+  formatFactory_ = std::move(formatFactory);
+  all_.clear();
+  idle_.clear();
+  stats_ = AnalyzerPoolStats{};
+
+  for (u32 i = 0; i < conf.initialSize; ++i) {
+    std::unique_ptr<PooledAnalyzer> item;
+    JPP_RETURN_IF_ERROR(create(&item));
+    idle_.push_back(item.get());
+    all_.emplace_back(std::move(item));
+  }
+  return Status::Ok();
+}
+
+Status AnalyzerPool::create(std::unique_ptr<PooledAnalyzer> *result) const {
+  std::unique_ptr<PooledAnalyzer> item{new PooledAnalyzer};
+  JPP_RETURN_IF_ERROR(env_->makeAnalyzer(&item->analyzer));
+  if (formatFactory_) {
+    JPP_RETURN_IF_ERROR(formatFactory_(&item->analyzer, &item->format));
+  }
+  *result = std::move(item);
+  return Status::Ok();
+}
+
+Status AnalyzerPool::tryAcquire(AnalyzerLease *result) {
+  *result = AnalyzerLease{};
+  lock_t lock{mutex_};
+  if (env_ == nullptr) {
+    return JPPS_INVALID_STATE << "analyzer pool was not initialized";
+  }
+
+  if (!idle_.empty()) {
+    auto item = idle_.back();
+    idle_.pop_back();
+    stats_.leases += 1;
+    *result = AnalyzerLease{this, item};
+    return Status::Ok();
+  }
+
+  if (all_.size() + creating_ >= conf_.maxSize) {
+    return Status::Ok();
+  }
+
+  // analyzer creation is slow, do not hold the lock while doing it
+  creating_ += 1;
+  lock.unlock();
+  std::unique_ptr<PooledAnalyzer> item;
+  Status s = create(&item);
+  lock.lock();
+  creating_ -= 1;
+  if (!s) {
+    // someone could be waiting for the slot which we have reserved
+    available_.notify_one();
+    return s;
+  }
+  auto ptr = item.get();
+  all_.emplace_back(std::move(item));
+  stats_.leases += 1;
+  *result = AnalyzerLease{this, ptr};
+  return Status::Ok();
+}
+
+Status AnalyzerPool::acquire(AnalyzerLease *result) {
+  JPP_RETURN_IF_ERROR(tryAcquire(result));
+  if (result->valid()) {
+    return Status::Ok();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  lock_t lock{mutex_};
+  stats_.queueDepth += 1;
+  available_.wait(lock, [this]() {
+    return !idle_.empty() || all_.size() + creating_ < conf_.maxSize;
+  });
+  stats_.queueDepth -= 1;
+
+  auto waited = std::chrono::steady_clock::now() - start;
+  auto waitNanos = static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+  stats_.waits += 1;
+  stats_.totalWaitNanos += waitNanos;
+  stats_.maxWaitNanos = std::max(stats_.maxWaitNanos, waitNanos);
+
+  if (!idle_.empty()) {
+    auto item = idle_.back();
+    idle_.pop_back();
+    stats_.leases += 1;
+    *result = AnalyzerLease{this, item};
+    return Status::Ok();
+  }
+
+  // a slot was freed because creation of an analyzer has failed
+  lock.unlock();
+  return acquire(result);
+}
+
+void AnalyzerPool::giveBack(PooledAnalyzer *item) {
+  {
+    lock_t lock{mutex_};
+    idle_.push_back(item);
+  }
+  available_.notify_one();
+}
+
+AnalyzerPoolStats AnalyzerPool::stats() const {
+  lock_t lock{mutex_};
+  auto result = stats_;
+  result.size = static_cast<u32>(all_.size());
+  result.idle = static_cast<u32>(idle_.size());
+  return result;
+}
+
 }  // namespace core
 }  // namespace jumanpp
\ No newline at end of file
@@ -5,9 +5,13 @@
 #ifndef JUMANPP_ENV_H
 #define JUMANPP_ENV_H
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include "core/analysis/analyzer.h"
 #include "core/analysis/perceptron.h"
 #include "core/analysis/rnn_scorer_gbeam.h"
+#include "core/analysis/user_dictionary.h"
 #include "core/impl/model_io.h"
 
 namespace jumanpp {
@@ -29,6 +33,7 @@ class JumanppEnv {
   std::unique_ptr<core::CoreHolder> core_;
 
   analysis::AnalyzerConfig analyzerConfig_{};
+  analysis::UserDictionary userDic_;
 
   analysis::HashedFeaturePerceptron perceptron_;
   analysis::RnnScorerGbeamFactory rnnHolder_;
@@ -63,6 +68,18 @@ class JumanppEnv {
 
   void setGlobalBeam(i32 globalBeam, i32 rightCheck, i32 rightBeam);
   void setAutoBeam(i32 base, i32 step, i32 max);
+  // see analysis::AnalyzerConfig::deadlineMicros
+  void setDeadline(i64 micros);
+  // see analysis::AnalyzerConfig::statsCollector
+  void setStatsCollector(analysis::AnalysisStatsCollector* collector);
+  // see analysis::AnalyzerConfig::dicCacheSize
+  void setDicCacheSize(i32 size);
+  // see analysis::HashedFeaturePerceptron::setKernel
+  Status setPerceptronKernel(analysis::PerceptronKernel kernel);
+  // Adds entries of a CSV file in the format of the model dictionary
+  // to the ones of previously loaded files, the model must be loaded.
+  // see analysis::AnalyzerConfig::userDictionary
+  Status loadUserDictionary(StringPiece filename);
 
   const analysis::FeatureScorer* featureScorer() const { return &perceptron_; }
 
@@ -78,6 +95,126 @@ class OutputFormat {
   virtual StringPiece result() const = 0;
 };
 
+using OutputFormatFactory = std::function<Status(
+    analysis::Analyzer* analyzer, std::unique_ptr<OutputFormat>* result)>;
+
+struct AnalyzerPoolConfig {
+  // analyzers which are created during initialization
+  u32 initialSize = 1;
+  // pool will not grow after reaching this number of analyzers
+  u32 maxSize = 1;
+};
+
+struct AnalyzerPoolStats {
+  u32 size = 0;        // created analyzers
+  u32 idle = 0;        // analyzers available for leasing right now
+  u32 queueDepth = 0;  // callers which are waiting for an analyzer
+  u64 leases = 0;
+  u64 waits = 0;  // leases which had to wait for an analyzer to be returned
+  u64 totalWaitNanos = 0;
+  u64 maxWaitNanos = 0;
+};
+
+class AnalyzerPool;
+
+struct PooledAnalyzer {
+  analysis::Analyzer analyzer;
+  std::unique_ptr<OutputFormat> format;
+};
+
+/**
+ * RAII handle for an analyzer from the pool.
+ * Returns the analyzer to the pool on destruction.
+ */
+class AnalyzerLease {
+  AnalyzerPool* pool_ = nullptr;
+  PooledAnalyzer* item_ = nullptr;
+
+  AnalyzerLease(AnalyzerPool* pool, PooledAnalyzer* item)
+      : pool_{pool}, item_{item} {}
+
+  friend class AnalyzerPool;
+
+ public:
+  AnalyzerLease() = default;
+  AnalyzerLease(const AnalyzerLease&) = delete;
+  AnalyzerLease(AnalyzerLease&& o) noexcept : pool_{o.pool_}, item_{o.item_} {
+    o.pool_ = nullptr;
+    o.item_ = nullptr;
+  }
+  AnalyzerLease& operator=(const AnalyzerLease&) = delete;
+  AnalyzerLease& operator=(AnalyzerLease&& o) noexcept {
+    release();
+    std::swap(pool_, o.pool_);
+    std::swap(item_, o.item_);
+    return *this;
+  }
+  ~AnalyzerLease() { release(); }
+
+  void release();
+  bool valid() const { return item_ != nullptr; }
+  analysis::Analyzer* analyzer() const { return &item_->analyzer; }
+  // Is nullptr if the pool was not configured with an output format
+  OutputFormat* format() const { return item_->format.get(); }
+};
+
+/**
+ * Thread-safe pool of analyzers (and their output formats) which share a
+ * single loaded model.
+ *
+ * Analyzers (with all their scorer instances) are expensive to create,
+ * so they are created once and then reused.
+ * Pool grows on demand until it reaches the maximum size,
+ * after that callers wait until an analyzer is returned.
+ */
+class AnalyzerPool {
+  const JumanppEnv* env_ = nullptr;
+  AnalyzerPoolConfig conf_;
+  OutputFormatFactory formatFactory_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable available_;
+  std::vector<std::unique_ptr<PooledAnalyzer>> all_;
+  std::vector<PooledAnalyzer*> idle_;
+  u32 creating_ = 0;
+  AnalyzerPoolStats stats_;
+
+  using lock_t = std::unique_lock<std::mutex>;
+
+  Status create(std::unique_ptr<PooledAnalyzer>* result) const;
+  void giveBack(PooledAnalyzer* item);
+
+  friend class AnalyzerLease;
+
+ public:
+  AnalyzerPool() = default;
+  AnalyzerPool(const AnalyzerPool&) = delete;
+
+  /**
+   * Environment must outlive the pool and must not be modified
+   * while the pool is used.
+   */
+  Status initialize(const JumanppEnv* env, const AnalyzerPoolConfig& conf,
+                    OutputFormatFactory formatFactory = nullptr);
+
+  /**
+   * Leases an analyzer.
+   * Creates a new one if all analyzers are in use and the pool can grow,
+   * otherwise blocks until an analyzer is returned to the pool.
+   */
+  Status acquire(AnalyzerLease* result);
+
+  /**
+   * Leases an analyzer only if it is possible without waiting.
+   * The lease is left empty if there are no idle analyzers and the pool
+   * can not grow anymore.
+   */
+  Status tryAcquire(AnalyzerLease* result);
+
+  AnalyzerPoolStats stats() const;
+  u32 maxSize() const { return conf_.maxSize; }
+};
+
 }  // namespace core
 }  // namespace jumanpp
 
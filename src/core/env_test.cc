@@ -0,0 +1,160 @@
+#include "core/env.h"
+#include <thread>
+#include "core/impl/perceptron_io.h"
+#include "testing/test_analyzer.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core;
+
+namespace {
+
+class PoolTestEnv {
+ public:
+  testing::TestEnv tenv;
+  TempFile modelFile;
+  JumanppEnv env;
+  std::vector<float> weights = std::vector<float>(1 << 8, 0.1f);
+  util::serialization::Saver saver;
+
+  PoolTestEnv() {
+    tenv.spec([](spec::dsl::ModelSpecBuilder& sb) {
+      auto& a = sb.field(1, "a").strings().trieIndex();
+      auto& b = sb.field(2, "b").strings();
+      sb.unigram({a, b});
+    });
+    REQUIRE_OK(tenv.origDicBuilder.importSpec(&tenv.originalSpec));
+    REQUIRE_OK(tenv.origDicBuilder.importCsv("test", "a,b\nb,c\nab,d\n"));
+
+    model::ModelInfo info{};
+    info.parts.emplace_back();
+    REQUIRE_OK(tenv.origDicBuilder.fillModelPart(&info.parts.back()));
+
+    PerceptronInfo pi{8};
+    saver.save(pi);
+    model::ModelPart perc;
+    perc.kind = model::ModelPartKind::Perceprton;
+    perc.data.push_back(saver.result());
+    auto wptr = reinterpret_cast<const char*>(weights.data());
+    perc.data.push_back(
+        StringPiece{wptr, wptr + weights.size() * sizeof(float)});
+    info.parts.push_back(perc);
+
+    model::ModelSaver msaver;
+    REQUIRE_OK(msaver.open(modelFile.name()));
+    REQUIRE_OK(msaver.save(info));
+
+    REQUIRE_OK(env.loadModel(modelFile.name()));
+    REQUIRE_OK(env.initFeatures(nullptr));
+  }
+};
+
+class CountingFormat : public OutputFormat {
+  std::string result_;
+
+ public:
+  Status format(const analysis::Analyzer& analyzer,
+                StringPiece comment) override {
+    result_ = comment.str();
+    return Status::Ok();
+  }
+  StringPiece result() const override { return result_; }
+};
+
+}  // namespace
+
+TEST_CASE("analyzer pool creates analyzers lazily up to the bound") {
+  PoolTestEnv env;
+  AnalyzerPool pool;
+  REQUIRE_OK(pool.initialize(&env.env, AnalyzerPoolConfig{1, 2}));
+  CHECK(pool.stats().size == 1);
+  CHECK(pool.stats().idle == 1);
+
+  AnalyzerLease l1;
+  REQUIRE_OK(pool.acquire(&l1));
+  REQUIRE(l1.valid());
+  CHECK(l1.format() == nullptr);
+  REQUIRE_OK(l1.analyzer()->analyze("ab"));
+
+  AnalyzerLease l2;
+  REQUIRE_OK(pool.tryAcquire(&l2));
+  REQUIRE(l2.valid());
+  CHECK(l1.analyzer() != l2.analyzer());
+  CHECK(pool.stats().size == 2);
+  CHECK(pool.stats().idle == 0);
+
+  AnalyzerLease l3;
+  REQUIRE_OK(pool.tryAcquire(&l3));
+  CHECK_FALSE(l3.valid());
+
+  l1.release();
+  CHECK(pool.stats().idle == 1);
+  REQUIRE_OK(pool.tryAcquire(&l3));
+  CHECK(l3.valid());
+  CHECK(pool.stats().leases == 3);
+}
+
+TEST_CASE("analyzer pool blocks until an analyzer is returned") {
+  PoolTestEnv env;
+  AnalyzerPool pool;
+  REQUIRE_OK(pool.initialize(&env.env, AnalyzerPoolConfig{1, 1}));
+
+  AnalyzerLease held;
+  REQUIRE_OK(pool.acquire(&held));
+  auto heldPtr = held.analyzer();
+
+  // catch assertions are not thread-safe, check results on the main thread
+  Status acquired = Status::Ok();
+  Status analyzed = Status::Ok();
+  analysis::Analyzer* otherPtr = nullptr;
+  std::thread waiter{[&]() {
+    AnalyzerLease other;
+    acquired = pool.acquire(&other);
+    if (acquired) {
+      otherPtr = other.analyzer();
+      analyzed = other.analyzer()->analyze("ba");
+    }
+  }};
+
+  while (pool.stats().queueDepth == 0) {
+    std::this_thread::yield();
+  }
+  held.release();
+  waiter.join();
+  CHECK_OK(acquired);
+  CHECK_OK(analyzed);
+  CHECK(otherPtr == heldPtr);
+
+  auto stats = pool.stats();
+  CHECK(stats.size == 1);
+  CHECK(stats.idle == 1);
+  CHECK(stats.queueDepth == 0);
+  CHECK(stats.leases == 2);
+  CHECK(stats.waits == 1);
+}
+
+TEST_CASE("analyzer pool creates output formats for analyzers") {
+  PoolTestEnv env;
+  AnalyzerPool pool;
+  u32 created = 0;
+  auto factory = [&created](analysis::Analyzer* an,
+                            std::unique_ptr<OutputFormat>* result) {
+    created += 1;
+    result->reset(new CountingFormat);
+    return Status::Ok();
+  };
+  REQUIRE_OK(pool.initialize(&env.env, AnalyzerPoolConfig{2, 2}, factory));
+  CHECK(created == 2);
+  AnalyzerLease lease;
+  REQUIRE_OK(pool.acquire(&lease));
+  REQUIRE(lease.format() != nullptr);
+  REQUIRE_OK(lease.analyzer()->analyze("ab"));
+  REQUIRE_OK(lease.format()->format(*lease.analyzer(), "test"));
+  CHECK(lease.format()->result() == "test");
+}
+
+TEST_CASE("analyzer pool rejects invalid sizes") {
+  PoolTestEnv env;
+  AnalyzerPool pool;
+  CHECK_FALSE(pool.initialize(&env.env, AnalyzerPoolConfig{0, 0}));
+  CHECK_FALSE(pool.initialize(&env.env, AnalyzerPoolConfig{3, 2}));
+}
@@ -3,6 +3,7 @@
 //
 
 #include "feature_impl_ngram_partial.h"
+#include "feature_impl_ngram_partial_kernels.h"
 
 namespace jumanpp {
 namespace core {
@@ -113,8 +114,10 @@ void PartialNgramDynamicFeatureApply::allocateBuffers(
     util::memory::PoolAlloc* alloc) const {
   u32 maxNgrams = std::max({numUnigrams(), numBigrams(), numTrigrams()});
   buffer->currentElems = ~0u;
-  buffer->valueBuffer1 = alloc->allocateBuf<u32>(maxNgrams, 64);
-  buffer->valueBuffer2 = alloc->allocateBuf<u32>(maxNgrams, 64);
+  // the bigram/trigram kernel keeps hashes for a block of rows
+  u32 valueBufferSize = BiTriRowBlock * maxNgrams;
+  buffer->valueBuffer1 = alloc->allocateBuf<u32>(valueBufferSize, 64);
+  buffer->valueBuffer2 = alloc->allocateBuf<u32>(valueBufferSize, 64);
   buffer->t1Buffer =
       alloc->allocateBuf<u64>(numBigrams() * stats.maxStarts, 64);
   buffer->t2Buffer1 =
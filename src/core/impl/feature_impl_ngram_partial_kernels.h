@@ -5,6 +5,7 @@
 #ifndef JUMANPP_FEATURE_NGRAM_PARTIAL_KERNELS_H
 #define JUMANPP_FEATURE_NGRAM_PARTIAL_KERNELS_H
 
+#include <algorithm>
 #include "core/analysis/perceptron.h"
 #include "util/common.hpp"
 #include "util/fast_hash.h"
@@ -16,6 +17,238 @@ namespace core {
 namespace features {
 namespace impl {
 
+// Beam candidates are processed in blocks of this many rows:
+// a feature is hashed for all rows of a block at once in SIMD lanes
+// and weight prefetches are issued for the whole block.
+// Without AVX2 the hashing is scalar and larger blocks only add overhead,
+// so rows are processed one at a time.
+#ifdef JPP_AVX2
+constexpr u32 BiTriRowBlock = 4;
+#else
+constexpr u32 BiTriRowBlock = 1;
+#endif
+
+namespace detail {
+
+// Feature values of a block of rows.
+// When there are less rows than a block,
+// the last row is repeated and the results for it are ignored.
+struct BiTriBlockRows {
+  const u64* rows[BiTriRowBlock];
+  // number of rows which are not repeated
+  u32 valid;
+
+  JPP_ALWAYS_INLINE BiTriBlockRows(util::ConstSliceable<u64> data,
+                                   u32 start) noexcept {
+    auto last = static_cast<u32>(data.numRows() - 1);
+    valid = std::min(BiTriRowBlock, last + 1 - start);
+    for (u32 i = 0; i < BiTriRowBlock; ++i) {
+      rows[i] = data.row(std::min(start + i, last)).data();
+    }
+  }
+
+  JPP_ALWAYS_INLINE BiTriBlockRows(util::ConstSliceable<u64> data,
+                                   util::ArraySlice<u32> idxes,
+                                   u32 start) noexcept {
+    auto last = static_cast<u32>(idxes.size() - 1);
+    valid = std::min(BiTriRowBlock, last + 1 - start);
+    for (u32 i = 0; i < BiTriRowBlock; ++i) {
+      rows[i] = data.row(idxes.at(std::min(start + i, last))).data();
+    }
+  }
+
+#ifdef JPP_AVX2
+  static_assert(BiTriRowBlock == 4, "FastHash4 hashes 4 rows");
+
+  // values are put into lanes directly: storing them to memory
+  // and loading as a vector stalls on store forwarding
+  JPP_ALWAYS_INLINE __m256i lanes(u32 feature) const noexcept {
+    return _mm256_setr_epi64x(rows[0][feature], rows[1][feature],
+                              rows[2][feature], rows[3][feature]);
+  }
+#endif
+};
+
+// Hash values are identical to
+// FastHash1{state}.mix(t1[feature]).masked(mask) for each row
+inline JPP_ALWAYS_INLINE void hashBlock(u64 state, const BiTriBlockRows& t1,
+                                        u32 feature, u32 mask,
+                                        u32* result) noexcept {
+#ifdef JPP_AVX2
+  util::hashing::FastHash4{_mm256_set1_epi64x(state)}
+      .mixImpl(t1.lanes(feature))
+      .maskedStore(mask, result);
+#else
+  for (u32 i = 0; i < BiTriRowBlock; ++i) {
+    result[i] =
+        util::hashing::FastHash1{state}.mix(t1.rows[i][feature]).masked(mask);
+  }
+#endif
+}
+
+inline JPP_ALWAYS_INLINE void hashBlock(u64 state, const BiTriBlockRows& t1,
+                                        u32 feature1, const BiTriBlockRows& t2,
+                                        u32 feature2, u32 mask,
+                                        u32* result) noexcept {
+#ifdef JPP_AVX2
+  util::hashing::FastHash4{_mm256_set1_epi64x(state)}
+      .mixImpl(t1.lanes(feature1))
+      .mixImpl(t2.lanes(feature2))
+      .maskedStore(mask, result);
+#else
+  for (u32 i = 0; i < BiTriRowBlock; ++i) {
+    result[i] = util::hashing::FastHash1{state}
+                    .mix(t1.rows[i][feature1])
+                    .mix(t2.rows[i][feature2])
+                    .masked(mask);
+  }
+#endif
+}
+
+// repeated rows are not prefetched
+inline JPP_ALWAYS_INLINE void prefetchBlock(
+    const analysis::WeightBuffer& weights, const u32* idxes,
+    u32 valid) noexcept {
+  for (u32 i = 0; i < BiTriRowBlock; ++i) {
+    if (i < valid) {
+      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(idxes[i]);
+    }
+  }
+}
+
+// Hashes of a single row in a block
+struct BiTriBlockColumn {
+  const u32* data;
+  size_t size_;
+
+  JPP_ALWAYS_INLINE u32 at(size_t feature) const noexcept {
+    return data[feature * BiTriRowBlock];
+  }
+
+  JPP_ALWAYS_INLINE size_t size() const noexcept { return size_; }
+};
+
+// Even and odd features are summed separately, like in the row kernels
+struct BiTriBlockSums {
+  float even[BiTriRowBlock] = {0};
+  float odd[BiTriRowBlock] = {0};
+
+  static JPP_ALWAYS_INLINE void add(float* sums,
+                                    const analysis::WeightBuffer& weights,
+                                    const u32* idxes) noexcept {
+    for (u32 i = 0; i < BiTriRowBlock; ++i) {
+      sums[i] += weights.at(idxes[i]);
+    }
+  }
+
+  // base + even + odd, in this order
+  JPP_ALWAYS_INLINE float total(u32 row, float base) const noexcept {
+    return base + even[row] + odd[row];
+  }
+};
+
+// Sums weights of the last block which can be incomplete and adds them
+// to base scores. The last row is summed in the same order
+// as the row-at-a-time kernel did it, so all scores are bit-identical
+// to the ones of that kernel.
+inline JPP_ALWAYS_INLINE void sumLastBlock(
+    u32 numFeatures, const analysis::WeightBuffer& weights, const u32* hashes,
+    u32 numRows, const float* base, float* result) noexcept {
+  for (u32 i = 0; i + 1 < numRows; ++i) {
+    BiTriBlockColumn row{hashes + i, numFeatures};
+    float even = 0;
+    float odd = 0;
+    u32 f = 0;
+    for (; f + 2 <= numFeatures; f += 2) {
+      even += weights.at(row.at(f));
+      odd += weights.at(row.at(f + 1));
+    }
+    if (f < numFeatures) {
+      even += weights.at(row.at(f));
+    }
+    result[i] = base[i] + even + odd;
+  }
+  BiTriBlockColumn last{hashes + numRows - 1, numFeatures};
+  result[numRows - 1] =
+      base[numRows - 1] +
+      analysis::impl::computeUnrolled4RawPerceptron(weights, last);
+}
+
+// Hashes features of a block into current (feature-major layout)
+// using hashFeature(feature, result) and, when Sum is true,
+// sums weights of the previous block while the new ones are being fetched.
+template <bool Sum, typename HashFeature>
+inline JPP_ALWAYS_INLINE void processBlock(
+    u32 numFeatures, u32 valid, HashFeature hashFeature,
+    const analysis::WeightBuffer& weights, u32* current, const u32* previous,
+    BiTriBlockSums* sums) noexcept {
+  u32 f = 0;
+  for (; f + 2 <= numFeatures; f += 2) {
+    auto out1 = current + f * BiTriRowBlock;
+    auto out2 = out1 + BiTriRowBlock;
+    hashFeature(f, out1);
+    hashFeature(f + 1, out2);
+    prefetchBlock(weights, out1, valid);
+    prefetchBlock(weights, out2, valid);
+    if (Sum) {
+      BiTriBlockSums::add(sums->even, weights, previous + f * BiTriRowBlock);
+      BiTriBlockSums::add(sums->odd, weights,
+                          previous + (f + 1) * BiTriRowBlock);
+    }
+  }
+  if (f < numFeatures) {
+    auto out = current + f * BiTriRowBlock;
+    hashFeature(f, out);
+    prefetchBlock(weights, out, valid);
+    if (Sum) {
+      BiTriBlockSums::add(sums->even, weights, previous + f * BiTriRowBlock);
+    }
+  }
+}
+
+template <bool Sum>
+inline JPP_ALWAYS_INLINE void biBlock(const BiTriBlockRows& t1,
+                                      util::ArraySlice<u64> state,
+                                      util::ArraySlice<u32> t1features,
+                                      u32 mask,
+                                      const analysis::WeightBuffer& weights,
+                                      u32* current, const u32* previous,
+                                      BiTriBlockSums* sums) noexcept {
+  auto hashFeature = [&](u32 f, u32* out) {
+    hashBlock(state.at(f), t1, t1features.at(f), mask, out);
+  };
+  processBlock<Sum>(static_cast<u32>(t1features.size()), t1.valid,
+                    hashFeature, weights, current, previous, sums);
+}
+
+template <bool Sum>
+inline JPP_ALWAYS_INLINE void triBlock(const BiTriBlockRows& t1,
+                                       const BiTriBlockRows& t2,
+                                       util::ArraySlice<u64> state,
+                                       util::ArraySlice<u32> t1features,
+                                       util::ArraySlice<u32> t2features,
+                                       u32 mask,
+                                       const analysis::WeightBuffer& weights,
+                                       u32* current, const u32* previous,
+                                       BiTriBlockSums* sums) noexcept {
+  auto hashFeature = [&](u32 f, u32* out) {
+    hashBlock(state.at(f), t1, t1features.at(f), t2, t2features.at(f), mask,
+              out);
+  };
+  processBlock<Sum>(static_cast<u32>(t1features.size()), t2.valid,
+                    hashFeature, weights, current, previous, sums);
+}
+
+}  // namespace detail
+
+/**
+ * Computes bigram and trigram scores for all global beam candidates
+ * of a single right node (t0).
+ * Bigram scores are computed for each t1 row and are stored in scoreBuffer,
+ * trigram scores are computed for each t2 row and are added to them.
+ *
+ * Buffers must hold BiTriRowBlock values for each bigram and trigram.
+ */
 inline void applyBiTriFullKernel(
     util::ArraySlice<u64> biState, util::ArraySlice<u64> triState,
     util::ConstSliceable<u64> t1pats, util::ConstSliceable<u64> t2pats,
@@ -25,95 +258,70 @@ inline void applyBiTriFullKernel(
     const analysis::WeightBuffer& weights,
     util::MutableArraySlice<float> scoreBuffer,
     util::MutableArraySlice<float> result) {
+  constexpr u32 Block = BiTriRowBlock;
+  auto numBiRows = static_cast<u32>(t1pats.numRows());
+  auto numTriRows = static_cast<u32>(t2pats.numRows());
+  if (numTriRows == 0) {
+    return;
+  }
+  JPP_DCHECK_EQ(t1idxes.size(), numTriRows);
+  JPP_DCHECK_GE(buf1.size(), t1featuresBi.size() * Block);
+  JPP_DCHECK_GE(buf1.size(), t2FeaturesTri.size() * Block);
+  JPP_DCHECK_EQ(buf1.size(), buf2.size());
   u32 mask = static_cast<u32>(weights.size() - 1);
-  auto numBiFeat = t1featuresBi.size();
-
-  int biRow = 0;
-  for (; biRow < t1pats.numRows(); ++biRow) {
-    buf1.swap(buf2);
-    auto t1row = t1pats.row(biRow);
-    float r1 = 0;
-    float r2 = 0;
-    u32 feat = 0;
-    for (; (feat + 2) <= numBiFeat; feat += 2) {
-      auto f = feat;
-      auto t1v1 = t1row.at(t1featuresBi.at(f));
-      auto v1 = util::hashing::FastHash1{biState.at(f)}.mix(t1v1).masked(mask);
-      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
-      buf1.at(f) = v1;
-      r1 += weights.at(buf2.at(f));
-      f += 1;
-      auto t1v2 = t1row.at(t1featuresBi.at(f));
-      auto v2 = util::hashing::FastHash1{biState.at(f)}.mix(t1v2).masked(mask);
-      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v2);
-      buf1.at(f) = v2;
-      r2 += weights.at(buf2.at(f));
-    }
-    if (numBiFeat & 0x1) {
-      auto f = feat;
-      auto t1v1 = t1row.at(t1featuresBi.at(f));
-      auto v1 = util::hashing::FastHash1{biState.at(f)}.mix(t1v1).masked(mask);
-      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
-      buf1.at(f) = v1;
-      r1 += weights.at(buf2.at(f));
-    }
-    if (JPP_LIKELY(biRow > 0)) {
-      scoreBuffer.at(biRow - 1) = r1 + r2;
+  auto hashes1 = buf1.data();
+  auto hashes2 = buf2.data();
+
+  detail::biBlock<false>(detail::BiTriBlockRows{t1pats, 0}, biState,
+                         t1featuresBi, mask, weights, hashes2, nullptr,
+                         nullptr);
+  u32 biStart = Block;
+  for (; biStart < numBiRows; biStart += Block) {
+    detail::BiTriBlockSums sums;
+    detail::biBlock<true>(detail::BiTriBlockRows{t1pats, biStart}, biState,
+                          t1featuresBi, mask, weights, hashes1, hashes2,
+                          &sums);
+    for (u32 i = 0; i < Block; ++i) {
+      scoreBuffer.at(biStart - Block + i) = sums.total(i, 0);
     }
+    std::swap(hashes1, hashes2);
   }
 
-  int triRow = 0;
-  auto numTriFeat = t2FeaturesTri.size();
-  util::MutableArraySlice<u32> tribuf1{buf1.data(), numTriFeat};
-  util::MutableArraySlice<u32> tribuf2{buf2.data(), numTriFeat};
-  for (; triRow < t2pats.numRows(); ++triRow) {
-    tribuf1.swap(tribuf2);
-    auto t2row = t2pats.row(triRow);
-    auto t1row = t1pats.row(t1idxes.at(triRow));
-    float r1 = 0;
-    float r2 = 0;
-    u32 feat = 0;
-    for (; (feat + 2) <= numTriFeat; feat += 2) {
-      auto f = feat;
-      auto t1v1 = t1row.at(t1FeaturesTri.at(f));
-      auto t2v1 = t2row.at(t2FeaturesTri.at(f));
-      auto v1 =
-          util::hashing::FastHash1{triState.at(f)}.mix(t1v1).mix(t2v1).masked(
-              mask);
-      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
-      tribuf1.at(f) = v1;
-      r1 += weights.at(tribuf2.at(f));
-      f += 1;
-      auto t1v2 = t1row.at(t1FeaturesTri.at(f));
-      auto t2v2 = t2row.at(t2FeaturesTri.at(f));
-      auto v2 =
-          util::hashing::FastHash1{triState.at(f)}.mix(t1v2).mix(t2v2).masked(
-              mask);
-      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v2);
-      tribuf1.at(f) = v2;
-      r2 += weights.at(tribuf2.at(f));
-    }
-    if (numTriFeat & 0x1) {
-      auto f = feat;
-      auto t1v1 = t1row.at(t1FeaturesTri.at(f));
-      auto t2v1 = t2row.at(t2FeaturesTri.at(f));
-      auto v1 =
-          util::hashing::FastHash1{triState.at(f)}.mix(t1v1).mix(t2v1).masked(
-              mask);
-      weights.prefetch<util::PrefetchHint::PREFETCH_HINT_T0>(v1);
-      tribuf1.at(f) = v1;
-      r1 += weights.at(tribuf2.at(f));
-    }
-    if (JPP_LIKELY(triRow > 0)) {
-      result.at(triRow - 1) = scoreBuffer.at(t1idxes.at(triRow - 1)) + r1 + r2;
-    } else {
-      scoreBuffer.at(biRow - 1) =
-          analysis::impl::computeUnrolled4RawPerceptron(weights, buf1);
+  // hashes of the last bigram block are in hashes2,
+  // their weights are summed after hashing the first trigram block
+  detail::triBlock<false>(detail::BiTriBlockRows{t1pats, t1idxes, 0},
+                          detail::BiTriBlockRows{t2pats, 0}, triState,
+                          t1FeaturesTri, t2FeaturesTri, mask, weights, hashes1,
+                          nullptr, nullptr);
+  const float zeros[Block] = {0};
+  auto lastBiStart = biStart - Block;
+  detail::sumLastBlock(static_cast<u32>(t1featuresBi.size()), weights,
+                       hashes2, numBiRows - lastBiStart, zeros,
+                       &scoreBuffer.at(lastBiStart));
+
+  u32 triStart = Block;
+  for (; triStart < numTriRows; triStart += Block) {
+    detail::BiTriBlockSums sums;
+    detail::triBlock<true>(detail::BiTriBlockRows{t1pats, t1idxes, triStart},
+                           detail::BiTriBlockRows{t2pats, triStart}, triState,
+                           t1FeaturesTri, t2FeaturesTri, mask, weights,
+                           hashes2, hashes1, &sums);
+    for (u32 i = 0; i < Block; ++i) {
+      auto row = triStart - Block + i;
+      result.at(row) = sums.total(i, scoreBuffer.at(t1idxes.at(row)));
     }
+    std::swap(hashes1, hashes2);
+  }
+
+  float biScores[Block];
+  auto lastTriStart = triStart - Block;
+  auto lastTriRows = numTriRows - lastTriStart;
+  for (u32 i = 0; i < lastTriRows; ++i) {
+    biScores[i] = scoreBuffer.at(t1idxes.at(lastTriStart + i));
   }
-  result.at(triRow - 1) =
-      scoreBuffer.at(t1idxes.at(triRow - 1)) +
-      analysis::impl::computeUnrolled4RawPerceptron(weights, tribuf1);
+  detail::sumLastBlock(static_cast<u32>(t2FeaturesTri.size()), weights,
+                       hashes1, lastTriRows, biScores,
+                       &result.at(lastTriStart));
 }
 
 }  // namespace impl
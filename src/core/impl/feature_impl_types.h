@@ -136,7 +136,7 @@ class PrimitiveFeatureContext {
 
     auto numf = features.size();
     if (JPP_LIKELY(eptr.isDic())) {
-      return entries_.entryAtPtr(eptr).fill(features, numf) == numf;
+      return entries_.fillFeatures(eptr, features) == numf;
     } else {
       auto node = extraCtx_->node(eptr);
       if (node == nullptr) {
@@ -149,14 +149,14 @@ class PrimitiveFeatureContext {
 
   inline void prefetchDicItem(EntryPtr eptr) {
     if (JPP_LIKELY(eptr.isDic())) {
-      entries_.entryData().prefetch(eptr.dicPtr());
+      entries_.prefetchFeatures(eptr);
     }
   }
 
   i32 lengthOf(NodeInfo nodeInfo, i32 fieldNum, i32 fieldPtr,
                LengthFieldSource field, bool useBytes) {
     if (fieldPtr < 0) {
-      return extraCtx_->lengthOf(nodeInfo.entryPtr());
+      return extraCtx_->lengthOf(nodeInfo.entryPtr(), fieldPtr);
     }
     auto fld = fields_.at(fieldNum);
     switch (field) {
@@ -4,7 +4,9 @@
 
 #include "model_io.h"
 #include <core/analysis/perceptron.h>
+#include <core/dic/codepoint_trie.h>
 #include <core/dic/darts_trie.h>
+#include <core/dic/entry_table.h>
 #include <util/printer.h>
 #include <cmath>
 #include <cstring>
@@ -230,6 +232,25 @@ inline void printDicInfo(i::Printer& p, const ModelPart& mp,
       }
     }
   }
+
+  // optional chunks are saved in this order
+  size_t optIdx = 4 + dic.stringStorages.size() + dic.intStorages.size();
+  if (!dic.codepointTrieContent.empty() && optIdx < mpr.data.size()) {
+    partInfo("Codepoint Trie", mpr.data[optIdx]);
+    dic::CodepointTrie cpt;
+    if (cpt.loadFromMemory(dic.codepointTrieContent)) {
+      p << "\n  units: " << cpt.numUnits();
+    }
+    ++optIdx;
+  }
+  if (!dic.entryTableContent.empty() && optIdx < mpr.data.size()) {
+    partInfo("Entry Feature Table", mpr.data[optIdx]);
+    dic::EntryFeatureTable eft;
+    auto numFeatures = static_cast<u32>(dic.spec.features.numDicFeatures);
+    if (eft.loadFromMemory(dic.entryTableContent, numFeatures)) {
+      p << "\n  rows: " << eft.numRows() << ", stride: " << eft.stride();
+    }
+  }
 }
 
 inline void printPerceptronInfo(util::io::Printer& p, const ModelPart& part,
@@ -257,6 +278,22 @@ inline void printPerceptronInfo(util::io::Printer& p, const ModelPart& part,
   float avg = static_cast<float>(sum / w.size());
   float zeroPerc = static_cast<float>(zero) / w.size() * 100;
   p << "\n  size=" << w.size();
+  switch (w.encoding()) {
+    case util::WeightEncoding::Linear8:
+      p << "\n  encoding=linear 8 bit";
+      break;
+    case util::WeightEncoding::Linear16:
+      p << "\n  encoding=linear 16 bit";
+      break;
+    case util::WeightEncoding::SparseFloat32:
+      p << "\n  encoding=sparse float, " << w.byteSize() << " bytes";
+      break;
+    default:
+      p << "\n  encoding=float";
+  }
+  if (w.hasHotWeights()) {
+    p << "\n  hot weights=" << part.data[2].size() / sizeof(u32);
+  }
   p << "\n  zero=" << zero << " (" << zeroPerc << "%)";
   p << "\n  min=" << min << " max=" << max << " avg=" << avg;
 }
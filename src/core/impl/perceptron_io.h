@@ -19,6 +19,31 @@ void Serialize(Arch& arch, PerceptronInfo& obj) {
   arch& obj.modelSizeExponent;
 }
 
+/**
+ * Perceptron model parts with float weights have two chunks:
+ * serialized PerceptronInfo and weights.
+ * Quantized parts have two more: serialized PerceptronQuantization
+ * and util::LinearQuantParams of every block, and weight codes
+ * are stored instead of floats.
+ * Sparse parts (SparseFloat32 encoding) have the same four chunks,
+ * block exponent is not used. Weights chunk contains a zero and floats
+ * of stored weights and the last one analysis::SparseWeightWord of every
+ * 64 weights.
+ * Float parts with a hot table have three chunks: the third one is
+ * a u32 array of hot slots, its size is a power of 2 and the slot
+ * at position p must have p as its lower bits (see HotWeight).
+ */
+struct PerceptronQuantization {
+  u32 encoding;
+  u32 blockExponent;
+};
+
+template <typename Arch>
+void Serialize(Arch& arch, PerceptronQuantization& obj) {
+  arch& obj.encoding;
+  arch& obj.blockExponent;
+}
+
 }  // namespace core
 }  // namespace jumanpp
 
@@ -3,6 +3,7 @@
 //
 
 #include "stream_reader.h"
+#include <cstring>
 #include <iostream>
 
 namespace jumanpp {
@@ -36,6 +37,54 @@ Status PlainStreamReader::readExample(std::istream *stream) {
   return Status::Ok();
 }
 
+namespace {
+
+// memchr is vectorized in all sane libc implementations
+inline StringPiece nextLine(StringPiece* data) {
+  auto begin = data->begin();
+  auto end = data->end();
+  auto eol = static_cast<const char *>(std::memchr(begin, '\n', data->size()));
+  if (eol == nullptr) {
+    *data = StringPiece{end, end};
+    return StringPiece{begin, end};
+  }
+  *data = StringPiece{eol + 1, end};
+  return StringPiece{begin, eol};
+}
+
+}  // namespace
+
+Status MappedStreamReader::readExample(StringPiece *data) {
+  useFallback_ = false;
+  comment_ = EMPTY_SP;
+  while (true) {
+    input_ = nextLine(data);
+    if (input_.size() > 2 && input_[0] == '#' && input_[1] == ' ') {
+      comment_ = input_;
+      input_ = EMPTY_SP;
+      if (data->empty()) {
+        break;
+      }
+    } else {
+      break;
+    }
+  }
+
+  if (comment_.size() > maxCommentLength_) {
+    return Status::InvalidParameter()
+           << "Comment size was: " << comment_.size()
+           << " which is more than max: " << maxCommentLength_;
+  }
+
+  if (input_.size() > maxInputLength_) {
+    return Status::InvalidParameter()
+           << "Input size was: " << input_.size()
+           << " which is more than max: " << maxInputLength_;
+  }
+
+  return Status::Ok();
+}
+
 }  // namespace input
 }  // namespace core
 }  // namespace jumanpp
\ No newline at end of file
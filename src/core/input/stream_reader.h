@@ -44,6 +44,68 @@ class PlainStreamReader : public StreamReader {
     }
     return StringPiece{comment_}.from(2);
   }
+
+  StringPiece input() const { return input_; }
+};
+
+/**
+ * Reader for raw examples which are already in memory,
+ * e.g. in a memory-mapped file.
+ *
+ * Example (with optional "# " comment lines before it) is
+ * split from memory without copying and is passed to analyzer as is,
+ * so the memory must be alive until the example is analyzed.
+ *
+ * Examples from streams (stdin, pipes) are read with
+ * the usual copying reader instead.
+ */
+class MappedStreamReader : public StreamReader {
+  PlainStreamReader fallback_;
+  bool useFallback_ = false;
+  StringPiece input_;
+  StringPiece comment_;
+  u64 maxInputLength_ = 4096;
+  u64 maxCommentLength_ = 4096;
+
+ public:
+  void setMaxSizes(u64 inputLength, u64 commentLength) {
+    maxInputLength_ = inputLength;
+    maxCommentLength_ = commentLength;
+    fallback_.setMaxSizes(inputLength, commentLength);
+  }
+
+  /**
+   * Reads a single example from the beginning of data and
+   * moves data to the start of the next example.
+   */
+  Status readExample(StringPiece* data);
+  virtual Status readExample(std::istream* stream) override {
+    useFallback_ = true;
+    return fallback_.readExample(stream);
+  }
+  virtual Status analyzeWith(analysis::Analyzer* an) override {
+    if (useFallback_) {
+      return fallback_.analyzeWith(an);
+    }
+    JPP_RETURN_IF_ERROR(an->analyze(input_));
+    return Status::Ok();
+  }
+  virtual StringPiece comment() override {
+    if (useFallback_) {
+      return fallback_.comment();
+    }
+    if (comment_.size() < 2) {
+      return EMPTY_SP;
+    }
+    return comment_.from(2);
+  }
+
+  StringPiece input() const {
+    if (useFallback_) {
+      return fallback_.input();
+    }
+    return input_;
+  }
 };
 
 }  // namespace input
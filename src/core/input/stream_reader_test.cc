@@ -0,0 +1,45 @@
+#include "stream_reader.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::core::input;
+
+TEST_CASE("mapped reader splits lines without copying") {
+  StringPiece data{"test\n# comment\nline2\n\nend"};
+  StringPiece rest = data;
+  MappedStreamReader rdr;
+  REQUIRE_OK(rdr.readExample(&rest));
+  CHECK(rdr.input() == "test");
+  CHECK(rdr.input().begin() == data.begin());
+  CHECK(rdr.comment() == "");
+  REQUIRE_OK(rdr.readExample(&rest));
+  CHECK(rdr.input() == "line2");
+  CHECK(rdr.comment() == "comment");
+  REQUIRE_OK(rdr.readExample(&rest));
+  CHECK(rdr.input() == "");
+  CHECK(rdr.comment() == "");
+  REQUIRE_OK(rdr.readExample(&rest));
+  CHECK(rdr.input() == "end");
+  CHECK(rest.empty());
+}
+
+TEST_CASE("mapped reader uses only the last comment") {
+  StringPiece rest{"# c1\n# c2\ndata\n# c3\n"};
+  MappedStreamReader rdr;
+  REQUIRE_OK(rdr.readExample(&rest));
+  CHECK(rdr.input() == "data");
+  CHECK(rdr.comment() == "c2");
+  REQUIRE_OK(rdr.readExample(&rest));
+  CHECK(rdr.input() == "");
+  CHECK(rdr.comment() == "c3");
+  CHECK(rest.empty());
+}
+
+TEST_CASE("mapped reader checks input length") {
+  StringPiece rest{"# long comment\nlong input\nshort\n"};
+  MappedStreamReader rdr;
+  rdr.setMaxSizes(5, 100);
+  CHECK_FALSE(rdr.readExample(&rest));
+  REQUIRE_OK(rdr.readExample(&rest));
+  CHECK(rdr.input() == "short");
+}
@@ -53,9 +53,12 @@ class PrimFeatureTestEnv {
  public:
   template <typename Fn>
   PrimFeatureTestEnv(StringPiece csvData, Fn fn, i32 beamSize = 1,
-                     i32 globalBeam = 0) {
+                     i32 globalBeam = 0, i64 deadlineMicros = 0,
+                     AnalysisStatsCollector* stats = nullptr) {
     tenv.beamSize = beamSize;
     tenv.aconf.globalBeamSize = globalBeam;
+    tenv.aconf.deadlineMicros = deadlineMicros;
+    tenv.aconf.statsCollector = stats;
     tenv.spec([fn](dsl::ModelSpecBuilder& specBldr) {
       auto& a = specBldr.field(1, "a").strings().trieIndex();
       auto& b = specBldr.field(2, "b").strings();
@@ -90,6 +93,7 @@ class PrimFeatureTestEnv {
   }
 
   AnalysisPath& top() { return top1; }
+  bool degraded() const { return tenv.analyzer->degraded(); }
 
   void analyze(StringPiece str) {
     CAPTURE(str);
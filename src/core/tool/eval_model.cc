@@ -0,0 +1,134 @@
+#include "eval_model.h"
+#include <cmath>
+#include <fstream>
+#include <ostream>
+#include "core/analysis/lattice_types.h"
+#include "util/mmap.h"
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+size_t matchingNodes(const TopPath& a, const TopPath& b) {
+  size_t matches = 0;
+  size_t i = 0, j = 0;
+  while (i < a.nodes.size() && j < b.nodes.size()) {
+    auto& n1 = a.nodes[i];
+    auto& n2 = b.nodes[j];
+    if (n1 == n2) {
+      ++matches;
+      ++i;
+      ++j;
+    } else if (n1.boundary < n2.boundary ||
+               (n1.boundary == n2.boundary && n1.position < n2.position)) {
+      ++i;
+    } else {
+      ++j;
+    }
+  }
+  return matches;
+}
+
+Status EvalModel::initialize(StringPiece filename, u32 beamSize) {
+  JPP_RETURN_IF_ERROR(env.loadModel(filename));
+  env.setBeamSize(beamSize);
+  JPP_RETURN_IF_ERROR(env.initFeatures(nullptr));
+  return env.makeAnalyzer(&analyzer);
+}
+
+Status EvalModel::analyze(StringPiece input, TopPath* top) {
+  auto start = std::chrono::steady_clock::now();
+  JPP_RETURN_IF_ERROR(analyzer.analyze(input));
+  time += std::chrono::steady_clock::now() - start;
+  JPP_RETURN_IF_ERROR(result.reset(analyzer));
+  JPP_RETURN_IF_ERROR(result.fillTop1(&path));
+  top->nodes.clear();
+  top->score = 0;
+  while (path.nextBoundary()) {
+    auto beam = path.nextBeamPtr();
+    if (beam == nullptr) {
+      return JPPS_INVALID_STATE << "no nodes in chunk";
+    }
+    top->nodes.push_back(beam->ptr.latticeNodePtr());
+    top->score = beam->totalScore;
+  }
+  return Status::Ok();
+}
+
+Status compareAnalysis(StringPiece referenceModel, StringPiece model,
+                       StringPiece modelName, StringPiece input, u32 beam,
+                       std::ostream& report) {
+  util::FullyMappedFile inputFile;
+  JPP_RETURN_IF_ERROR(inputFile.open(input, util::MMapType::ReadOnly));
+
+  EvalModel original;
+  JPP_RIE_MSG(original.initialize(referenceModel, beam),
+              "model=" << referenceModel);
+  EvalModel changed;
+  JPP_RIE_MSG(changed.initialize(model, beam), "model=" << model);
+
+  TopPath top1;
+  TopPath top2;
+  size_t sentences = 0;
+  size_t equalPaths = 0;
+  size_t originalNodes = 0;
+  size_t changedNodes = 0;
+  size_t matches = 0;
+  double scoreDiff = 0;
+
+  JPP_RETURN_IF_ERROR(forEachLine(
+      inputFile.contents(), [&](StringPiece line, size_t lineNumber) -> Status {
+        JPP_RIE_MSG(original.analyze(line, &top1), "line #" << lineNumber);
+        JPP_RIE_MSG(changed.analyze(line, &top2), "line #" << lineNumber);
+        sentences += 1;
+        auto match = matchingNodes(top1, top2);
+        if (match == top1.nodes.size() && match == top2.nodes.size()) {
+          equalPaths += 1;
+        }
+        originalNodes += top1.nodes.size();
+        changedNodes += top2.nodes.size();
+        matches += match;
+        scoreDiff += std::abs(top1.score - top2.score);
+        return Status::Ok();
+      }));
+
+  if (sentences == 0) {
+    return JPPS_INVALID_PARAMETER << "evaluation input " << input
+                                  << " did not have any sentences";
+  }
+
+  using millis = std::chrono::duration<double, std::milli>;
+  auto originalMs = std::chrono::duration_cast<millis>(original.time).count();
+  auto changedMs = std::chrono::duration_cast<millis>(changed.time).count();
+
+  report << "\nAnalysis of " << sentences << " sentences, beam " << beam
+         << ", original model results are the reference:";
+  report << "\n  equal top-1 paths: " << equalPaths << " ("
+         << 100.0 * equalPaths / sentences << "%)";
+  report << "\n  node F1: "
+         << 200.0 * matches / (originalNodes + changedNodes) << "%";
+  report << "\n  mean top-1 score difference: " << scoreDiff / sentences;
+  report << "\n  analysis time: original " << originalMs << " ms, "
+         << modelName << " " << changedMs << " ms";
+  return Status::Ok();
+}
+
+size_t residentMemoryBytes() {
+#if defined(__linux__)
+  std::ifstream statm{"/proc/self/statm"};
+  size_t total = 0;
+  size_t resident = 0;
+  if (statm >> total >> resident) {
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return 0;
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,74 @@
+#ifndef JUMANPP_EVAL_MODEL_H
+#define JUMANPP_EVAL_MODEL_H
+
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+#include "core/analysis/analysis_result.h"
+#include "core/env.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+struct TopPath {
+  std::vector<analysis::LatticeNodePtr> nodes;
+  float score = 0;
+};
+
+// number of nodes which are present in both paths
+size_t matchingNodes(const TopPath& a, const TopPath& b);
+
+/**
+ * A model which is used by tools to analyze raw sentences
+ * and compare top-1 paths, keeps the total analysis time.
+ */
+struct EvalModel {
+  JumanppEnv env;
+  analysis::Analyzer analyzer;
+  analysis::AnalysisResult result;
+  analysis::AnalysisPath path;
+  std::chrono::steady_clock::duration time{};
+
+  Status initialize(StringPiece filename, u32 beamSize);
+  Status analyze(StringPiece input, TopPath* top);
+};
+
+/**
+ * Analyzes raw text (a sentence per line) with two models and reports
+ * how much results of the second one, which is called modelName,
+ * differ from the ones of the reference model.
+ */
+Status compareAnalysis(StringPiece referenceModel, StringPiece model,
+                       StringPiece modelName, StringPiece input, u32 beam,
+                       std::ostream& report);
+
+// 0 if it is not known on the platform
+size_t residentMemoryBytes();
+
+// Calls the callback with every non-empty line and its 1-based number
+template <typename Fn>
+Status forEachLine(StringPiece data, Fn&& fn) {
+  size_t start = 0;
+  size_t lineNumber = 0;
+  while (start < data.size()) {
+    size_t end = start;
+    while (end < data.size() && data[end] != '\n') {
+      ++end;
+    }
+    StringPiece line = data.slice(start, end);
+    start = end + 1;
+    lineNumber += 1;
+    if (line.size() == 0) {
+      continue;
+    }
+    JPP_RETURN_IF_ERROR(fn(line, lineNumber));
+  }
+  return Status::Ok();
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_EVAL_MODEL_H
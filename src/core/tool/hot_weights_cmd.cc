@@ -0,0 +1,266 @@
+#include "hot_weights_cmd.h"
+#include <ostream>
+#include "core/analysis/analyzer_impl.h"
+#include "core/analysis/score_processor.h"
+#include "core/impl/feature_computer.h"
+#include "core/impl/model_io.h"
+#include "core/tool/eval_model.h"
+#include "util/mmap.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+namespace {
+
+/**
+ * Counts how many times each weight of the wrapped scorer is read
+ * by compute and add calls.
+ *
+ * The analyzer reads weights directly from the weight buffer,
+ * so LatticeAccessReplay passes the features which the analysis
+ * has scored through this scorer.
+ */
+class CountingScorer : public analysis::FeatureScorer {
+  const analysis::FeatureScorer* scorer_;
+  u32 mask_;
+  mutable std::vector<u32> counts_;
+
+  void count(util::ConstSliceable<u32> features) const {
+    for (size_t row = 0; row < features.numRows(); ++row) {
+      for (auto feature : features.row(row)) {
+        counts_[feature & mask_] += 1;
+      }
+    }
+  }
+
+ public:
+  explicit CountingScorer(const analysis::FeatureScorer* scorer)
+      : scorer_{scorer},
+        mask_{static_cast<u32>(scorer->weights().size() - 1)},
+        counts_(scorer->weights().size(), 0) {}
+
+  Status load(const model::ModelInfo& model) override {
+    return JPPS_NOT_IMPLEMENTED << "counting scorer wraps a loaded scorer";
+  }
+
+  void compute(util::MutableArraySlice<float> result,
+               util::ConstSliceable<u32> features) const override {
+    count(features);
+    scorer_->compute(result, features);
+  }
+
+  void add(util::ArraySlice<float> source,
+           util::MutableArraySlice<float> result,
+           util::ConstSliceable<u32> features) const override {
+    count(features);
+    scorer_->add(source, result, features);
+  }
+
+  const analysis::WeightBuffer& weights() const override {
+    return scorer_->weights();
+  }
+
+  const std::vector<u32>& counts() const { return counts_; }
+};
+
+/**
+ * Passes features of all ngrams which were scored during the analysis
+ * to the scorer: unigrams once for each node, bigrams once for each
+ * pair of connected nodes and trigrams for each left node beam entry,
+ * the same as AnalyzerImpl::computeScoresFull does.
+ * Feature patterns of all nodes must be stored in the lattice.
+ */
+class LatticeAccessReplay {
+  const analysis::AnalyzerImpl* analyzer_;
+  features::NgramFeaturesComputer features_;
+  std::vector<u32> buffer_;
+  float score_;
+
+  void score(const analysis::FeatureScorer& scorer,
+             const features::NgramFeatureRef& ref,
+             features::NgramSubset subset) {
+    auto values = features_.subset(buffer_, subset);
+    util::ConstSliceable<u32> rows{values, values.size(), 1};
+    scorer.compute(util::MutableArraySlice<float>{&score_, 1}, rows);
+  }
+
+ public:
+  explicit LatticeAccessReplay(const analysis::AnalyzerImpl* analyzer)
+      : analyzer_{analyzer},
+        features_{analyzer->lattice(), analyzer->core().features()},
+        buffer_(analyzer->core().spec().features.ngram.size()) {}
+
+  void replay(const analysis::FeatureScorer& scorer) {
+    auto lattice = analyzer_->lattice();
+    auto bndCount = lattice->createdBoundaryCount();
+    for (u32 boundary = 2; boundary < bndCount; ++boundary) {
+      auto bnd = lattice->boundary(boundary);
+      auto left = bnd->ends()->nodePtrs();
+      for (u16 t0 = 0; t0 < bnd->localNodeCount(); ++t0) {
+        analysis::LatticeNodePtr t0ptr{static_cast<u16>(boundary), t0};
+        for (size_t t1idx = 0; t1idx < left.size(); ++t1idx) {
+          auto& t1ptr = left[t1idx];
+          auto beam = lattice->boundary(t1ptr.boundary)
+                          ->starts()
+                          ->beamData()
+                          .row(t1ptr.position);
+          for (size_t beamIdx = 0; beamIdx < beam.size(); ++beamIdx) {
+            auto& elem = beam[beamIdx];
+            if (analysis::EntryBeam::isFake(elem)) {
+              break;
+            }
+            features::NgramFeatureRef ref{elem.ptr.previous->latticeNodePtr(),
+                                          t1ptr, t0ptr};
+            features_.calculateNgramFeatures(ref, &buffer_);
+            if (t1idx == 0 && beamIdx == 0) {
+              score(scorer, ref, features::NgramSubset::Unigrams);
+            }
+            if (beamIdx == 0) {
+              score(scorer, ref, features::NgramSubset::Bigrams);
+            }
+            score(scorer, ref, features::NgramSubset::Trigrams);
+          }
+        }
+      }
+    }
+  }
+};
+
+Status countAccesses(const HotWeightsArgs& args, StringPiece sample,
+                     std::vector<u32>* counts, size_t* sentences) {
+  JumanppEnv env;
+  JPP_RIE_MSG(env.loadModel(args.modelInput), "model=" << args.modelInput);
+  JPP_RETURN_IF_ERROR(env.initFeatures(nullptr));
+
+  analysis::HashedFeaturePerceptron perceptron;
+  JPP_RETURN_IF_ERROR(perceptron.load(env.modelInfoCopy()));
+  CountingScorer counting{&perceptron};
+
+  // only the linear model is used, it is the one which reads the weights;
+  // the global beam is disabled, so the analysis scores exactly the ngrams
+  // which LatticeAccessReplay replays
+  analysis::ScorerDef scorers;
+  scorers.feature = &counting;
+  scorers.scoreWeights.push_back(1);
+  ScoringConfig scoring{static_cast<i32>(args.beam), 1};
+  analysis::AnalyzerConfig config;
+  config.storeAllPatterns = true;
+  analysis::Analyzer analyzer;
+  JPP_RETURN_IF_ERROR(
+      analyzer.initialize(env.coreHolder(), config, scoring, &scorers));
+  LatticeAccessReplay replay{analyzer.impl()};
+
+  *sentences = 0;
+  JPP_RETURN_IF_ERROR(
+      forEachLine(sample, [&](StringPiece line, size_t lineNumber) -> Status {
+        *sentences += 1;
+        JPP_RIE_MSG(analyzer.analyze(line), "line #" << lineNumber);
+        replay.replay(counting);
+        return Status::Ok();
+      }));
+  *counts = counting.counts();
+  return Status::Ok();
+}
+
+Status checkAnalysis(const HotWeightsArgs& args, StringPiece sample,
+                     std::ostream& report) {
+  EvalModel original;
+  JPP_RIE_MSG(original.initialize(args.modelInput, args.beam),
+              "model=" << args.modelInput);
+  EvalModel hot;
+  JPP_RIE_MSG(hot.initialize(args.modelOutput, args.beam),
+              "model=" << args.modelOutput);
+
+  TopPath top1;
+  TopPath top2;
+  JPP_RETURN_IF_ERROR(
+      forEachLine(sample, [&](StringPiece line, size_t lineNumber) -> Status {
+        JPP_RIE_MSG(original.analyze(line, &top1), "line #" << lineNumber);
+        JPP_RIE_MSG(hot.analyze(line, &top2), "line #" << lineNumber);
+        auto match = matchingNodes(top1, top2);
+        if (match != top1.nodes.size() || match != top2.nodes.size() ||
+            top1.score != top2.score) {
+          return JPPS_INVALID_STATE
+                 << "analysis result of line #" << lineNumber
+                 << " has changed with hot weights";
+        }
+        return Status::Ok();
+      }));
+
+  using millis = std::chrono::duration<double, std::milli>;
+  auto originalMs = std::chrono::duration_cast<millis>(original.time).count();
+  auto hotMs = std::chrono::duration_cast<millis>(hot.time).count();
+  report << "\nAnalysis results on the sample are the same, analysis time: "
+         << "original " << originalMs << " ms, with hot weights " << hotMs
+         << " ms";
+  return Status::Ok();
+}
+
+}  // namespace
+
+Status hotWeightsModel(const HotWeightsArgs& args, std::ostream& report) {
+  model::FilesystemModel modelFile;
+  JPP_RETURN_IF_ERROR(modelFile.open(args.modelInput));
+  model::ModelInfo info;
+  JPP_RETURN_IF_ERROR(modelFile.load(&info));
+
+  auto part = info.firstPartOf(model::ModelPartKind::Perceprton);
+  if (part == nullptr) {
+    return JPPS_INVALID_PARAMETER << "model " << args.modelInput
+                                  << " was not trained";
+  }
+
+  analysis::HashedFeaturePerceptron perceptron;
+  JPP_RETURN_IF_ERROR(perceptron.load(info));
+  auto& weights = perceptron.weights();
+  if (weights.floats() == nullptr) {
+    return JPPS_INVALID_PARAMETER << "model " << args.modelInput
+                                  << " is quantized, pruned or already has "
+                                     "hot weights";
+  }
+  util::ArraySlice<float> floats{weights.floats(), weights.size()};
+
+  util::FullyMappedFile sample;
+  JPP_RETURN_IF_ERROR(sample.open(args.sampleInput, util::MMapType::ReadOnly));
+
+  std::vector<u32> counts;
+  size_t sentences = 0;
+  JPP_RETURN_IF_ERROR(
+      countAccesses(args, sample.contents(), &counts, &sentences));
+  if (sentences == 0) {
+    return JPPS_INVALID_PARAMETER << "sample input " << args.sampleInput
+                                  << " did not have any sentences";
+  }
+
+  analysis::HotWeightSelector selector;
+  JPP_RETURN_IF_ERROR(selector.select(floats, counts, args.hotExponent));
+  selector.fillModelPart(part);
+  if (!args.comment.empty()) {
+    part->comment = args.comment;
+  }
+
+  model::ModelSaver saver;
+  JPP_RETURN_IF_ERROR(saver.open(args.modelOutput));
+  JPP_RETURN_IF_ERROR(saver.save(info));
+
+  auto total = selector.totalAccesses();
+  report << "\nWeight accesses on " << sentences << " sentences: " << total
+         << ", to " << selector.usedSlots() << " different weights";
+  report << "\nServed by the hot table: " << selector.hotAccesses() << " ("
+         << (total == 0 ? 0.0 : 100.0 * selector.hotAccesses() / total)
+         << "%)";
+  report << "\nWeights size: " << weights.byteSize() << " -> "
+         << selector.weights().byteSize() << " bytes, hot table "
+         << (size_t{1} << args.hotExponent) * sizeof(analysis::HotWeight)
+         << " bytes";
+
+  JPP_RETURN_IF_ERROR(checkAnalysis(args, sample.contents(), report));
+  report << "\n";
+
+  return Status::Ok();
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
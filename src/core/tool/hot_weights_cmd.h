@@ -0,0 +1,37 @@
+#ifndef JUMANPP_HOT_WEIGHTS_CMD_H
+#define JUMANPP_HOT_WEIGHTS_CMD_H
+
+#include <iosfwd>
+#include <string>
+#include "util/status.hpp"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+struct HotWeightsArgs {
+  std::string modelInput;
+  std::string modelOutput;
+  std::string comment;
+  // raw text, a sentence per line, weight accesses are counted on it
+  std::string sampleInput;
+  // the hot table has 2^hotExponent weights, 8 bytes each
+  u32 hotExponent = 18;
+  u32 beam = 5;
+};
+
+/**
+ * Writes a copy of a trained model with a hot weight table.
+ * Slots for the table are selected by analyzing a sample corpus
+ * and counting how many times each weight is used.
+ * Analysis results of the copy are checked to be the same as the
+ * ones of the original model on the sample.
+ */
+Status hotWeightsModel(const HotWeightsArgs& args, std::ostream& report);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_HOT_WEIGHTS_CMD_H
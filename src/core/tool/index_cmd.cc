@@ -26,6 +26,10 @@ void IndexTool::setProgressCallback(ProgressCallback* callback) {
   impl_->builder.setProgress(callback);
 }
 
+void IndexTool::setNumThreads(u32 numThreads) {
+  impl_->builder.setNumThreads(numThreads);
+}
+
 Status IndexTool::indexDictionary(StringPiece specFile, StringPiece dicFile) {
   JPP_RETURN_IF_ERROR(spec::parseFromFile(specFile, &impl_->rawSpec));
   JPP_RETURN_IF_ERROR(impl_->builder.importSpec(&impl_->rawSpec));
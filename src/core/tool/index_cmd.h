@@ -9,6 +9,7 @@
 
 #include "util/status.hpp"
 #include "util/string_piece.h"
+#include "util/types.hpp"
 
 namespace jumanpp {
 namespace core {
@@ -27,6 +28,8 @@ class IndexTool {
   ~IndexTool();
 
   void setProgressCallback(ProgressCallback* callback);
+  // see dic::DictionaryBuilder::setNumThreads
+  void setNumThreads(u32 numThreads);
   Status indexDictionary(StringPiece specFile, StringPiece dicFile);
   Status saveModel(StringPiece outputFile, StringPiece dicComment);
 };
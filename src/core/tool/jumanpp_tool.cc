@@ -16,7 +16,10 @@
 #include <chrono>
 #include "core/dic/progress.h"
 #include "core/tool/codegen_cmd.h"
+#include "core/tool/hot_weights_cmd.h"
 #include "core/tool/index_cmd.h"
+#include "core/tool/prune_cmd.h"
+#include "core/tool/quantize_cmd.h"
 #include "core/tool/train_cmd.h"
 #include "core/training/training_env.h"
 #include "rnn/rnn_arg_parse.h"
@@ -39,7 +42,15 @@ void copyValue(T1& out, args::Base& flag, const T1& val) {
   }
 }
 
-enum class ToolMode { Index, Train, EmbedRnn, StaticFeatures };
+enum class ToolMode {
+  Index,
+  Train,
+  EmbedRnn,
+  StaticFeatures,
+  Quantize,
+  HotWeights,
+  Prune
+};
 
 namespace t = ::jumanpp::core::training;
 
@@ -47,8 +58,12 @@ struct JumanppToolArgs {
   std::string specFile;
   std::string dictFile;
   std::string comment;
+  u32 indexThreads = 1;
 
   t::TrainingArguments trainArgs;
+  core::tool::QuantizeArgs quantizeArgs;
+  core::tool::HotWeightsArgs hotWeightsArgs;
+  core::tool::PruneArgs pruneArgs;
 
   ToolMode mode;
 
@@ -72,6 +87,16 @@ struct JumanppToolArgs {
                            "Embed a RNN into a trained model"};
     args::Command staticFeatures{commandGroup, "static-features",
                                  "Generate a C++ code for feature processing"};
+    args::Command quantize{
+        commandGroup, "quantize",
+        "Quantize linear model weights of a trained model to 8 or 16 bits"};
+    args::Command hotWeights{
+        commandGroup, "hot-weights",
+        "Copy the most used linear model weights of a trained model "
+        "into a small table which stays in cache"};
+    args::Command prune{commandGroup, "prune",
+                        "Drop small linear model weights of a trained model "
+                        "and store the rest in a sparse table"};
 
     args::HelpFlag help{globalParams,
                         "Help",
@@ -80,6 +105,12 @@ struct JumanppToolArgs {
 
     args::ValueFlag<std::string> dictFile{
         index, "FILE", "A raw dictionary file to index", {"dict-file"}};
+    args::ValueFlag<u32> indexThreads{
+        index,
+        "THREADS",
+        "# of threads for indexing, 1 default",
+        {"index-threads"},
+        1};
 
     args::ValueFlag<std::string> specFile{
         globalParams, "FILE", "Analysis Spec file", {"spec"}};
@@ -198,6 +229,62 @@ struct JumanppToolArgs {
         {"rnn-model"}};
     RnnArgs rnnArgs{embedRnn};
 
+    args::ValueFlag<std::string> quantizeInput{
+        quantize, "FILENAME", "Filename of trained model", {"model-input"}};
+    args::ValueFlag<u32> quantizeBits{
+        quantize, "BITS", "Bits per weight, 8 or 16 (8)", {"bits"}, 8};
+    args::ValueFlag<u32> quantizeBlock{
+        quantize,
+        "EXPONENT",
+        "Use separate quantization parameters for blocks of 2^EXPONENT "
+        "weights, 0 (default) is a single block for the whole table",
+        {"block-exponent"},
+        0};
+    args::ValueFlag<std::string> quantizeEval{
+        quantize,
+        "FILENAME",
+        "Raw text, a sentence per line. Analysis results of quantized model "
+        "on it are compared to the ones of the original model",
+        {"eval-input"}};
+    args::ValueFlag<u32> quantizeEvalBeam{
+        quantize, "BEAM", "Beam size for comparison, 5 default", {"beam"}, 5};
+
+    args::ValueFlag<std::string> hotInput{
+        hotWeights, "FILENAME", "Filename of trained model", {"model-input"}};
+    args::ValueFlag<std::string> hotSample{
+        hotWeights,
+        "FILENAME",
+        "Raw text, a sentence per line. Weights which are used the most "
+        "when analyzing it are put into the hot table",
+        {"sample-input"}};
+    args::ValueFlag<u32> hotExponent{
+        hotWeights,
+        "EXPONENT",
+        "Hot table will have 2^EXPONENT weights, 8 bytes each, 18 default",
+        {"hot-exponent"},
+        18};
+    args::ValueFlag<u32> hotBeam{
+        hotWeights, "BEAM", "Beam size for analysis, 5 default", {"beam"}, 5};
+
+    args::ValueFlag<std::string> pruneInput{
+        prune, "FILENAME", "Filename of trained model", {"model-input"}};
+    args::ValueFlag<float> pruneThreshold{
+        prune,
+        "VALUE",
+        "Drop weights with absolute values not greater than VALUE, "
+        "0 (default) drops only zeros",
+        {"threshold"},
+        0.0f};
+    args::ValueFlag<std::string> pruneEval{
+        prune,
+        "FILENAME",
+        "Raw text, a sentence per line. Analysis results, memory usage and "
+        "speed of the pruned model on it are compared to the ones of the "
+        "original model",
+        {"eval-input"}};
+    args::ValueFlag<u32> pruneEvalBeam{
+        prune, "BEAM", "Beam size for comparison, 5 default", {"beam"}, 5};
+
     args::ValueFlag<std::string> cgClassName{
         staticFeatures,
         "NAME",
@@ -230,9 +317,13 @@ struct JumanppToolArgs {
     copyValue(result->mode, train, ToolMode::Train);
     copyValue(result->mode, embedRnn, ToolMode::EmbedRnn);
     copyValue(result->mode, staticFeatures, ToolMode::StaticFeatures);
+    copyValue(result->mode, quantize, ToolMode::Quantize);
+    copyValue(result->mode, hotWeights, ToolMode::HotWeights);
+    copyValue(result->mode, prune, ToolMode::Prune);
 
     copyValue(result->specFile, specFile);
     copyValue(result->dictFile, dictFile);
+    copyValue(result->indexThreads, indexThreads);
     copyValue(result->comment, comment);
     copyValue(result->comment, cgClassName);
 
@@ -269,6 +360,31 @@ struct JumanppToolArgs {
     trg->globalBeam.fullFirstIter = firstIterFull.Get();
     trg->comment = result->comment;
 
+    auto qargs = &result->quantizeArgs;
+    qargs->modelInput = quantizeInput.Get();
+    qargs->modelOutput = modelOutput.Get();
+    qargs->comment = result->comment;
+    qargs->bits = quantizeBits.Get();
+    qargs->blockExponent = quantizeBlock.Get();
+    qargs->evalInput = quantizeEval.Get();
+    qargs->evalBeam = quantizeEvalBeam.Get();
+
+    auto hargs = &result->hotWeightsArgs;
+    hargs->modelInput = hotInput.Get();
+    hargs->modelOutput = modelOutput.Get();
+    hargs->comment = result->comment;
+    hargs->sampleInput = hotSample.Get();
+    hargs->hotExponent = hotExponent.Get();
+    hargs->beam = hotBeam.Get();
+
+    auto pargs = &result->pruneArgs;
+    pargs->modelInput = pruneInput.Get();
+    pargs->modelOutput = modelOutput.Get();
+    pargs->comment = result->comment;
+    pargs->threshold = pruneThreshold.Get();
+    pargs->evalInput = pruneEval.Get();
+    pargs->evalBeam = pruneEvalBeam.Get();
+
     return Status::Ok();
   }
 };
@@ -318,6 +434,7 @@ void invokeTool(const JumanppToolArgs& args) {
       core::tool::IndexTool tool;
       StdoutProgressReporter progress;
       tool.setProgressCallback(&progress);
+      tool.setNumThreads(args.indexThreads);
 
       std::cout << "Indexing a dictionary!";
       std::cout << "\nSpec: " << args.specFile;
@@ -337,6 +454,15 @@ void invokeTool(const JumanppToolArgs& args) {
       dieOnError(core::tool::generateStaticFeatures(
           args.specFile, args.trainArgs.outputFilename, args.comment));
       return;
+    case ToolMode::Quantize:
+      dieOnError(core::tool::quantizeModel(args.quantizeArgs, std::cout));
+      return;
+    case ToolMode::HotWeights:
+      dieOnError(core::tool::hotWeightsModel(args.hotWeightsArgs, std::cout));
+      return;
+    case ToolMode::Prune:
+      dieOnError(core::tool::pruneModel(args.pruneArgs, std::cout));
+      return;
     default:
       std::cerr << "The tool is not implemented\n";
       exit(5);
@@ -0,0 +1,220 @@
+#include "prune_cmd.h"
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include "core/impl/model_io.h"
+#include "core/tool/eval_model.h"
+#include "util/mmap.h"
+
+#ifdef __unix__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+namespace {
+
+struct ModelFootprint {
+  // growth of the resident memory after loading the model
+  // and analyzing the input, 0 if it is not known
+  size_t residentBytes = 0;
+  double sentencesPerSecond = 0;
+};
+
+Status measureFootprint(StringPiece model, StringPiece input, u32 beam,
+                        ModelFootprint* result) {
+  auto residentBefore = residentMemoryBytes();
+  EvalModel eval;
+  JPP_RIE_MSG(eval.initialize(model, beam), "model=" << model);
+  TopPath top;
+  size_t sentences = 0;
+  JPP_RETURN_IF_ERROR(
+      forEachLine(input, [&](StringPiece line, size_t lineNumber) -> Status {
+        JPP_RIE_MSG(eval.analyze(line, &top), "line #" << lineNumber);
+        sentences += 1;
+        return Status::Ok();
+      }));
+  auto residentAfter = residentMemoryBytes();
+  if (residentAfter > residentBefore) {
+    result->residentBytes = residentAfter - residentBefore;
+  }
+  using seconds = std::chrono::duration<double>;
+  auto time = std::chrono::duration_cast<seconds>(eval.time).count();
+  if (time > 0) {
+    result->sentencesPerSecond = sentences / time;
+  }
+  return Status::Ok();
+}
+
+#ifdef __unix__
+/**
+ * Measures the footprint in a child process, so models which were
+ * loaded before do not affect it. The child writes the footprint
+ * followed by the error message, if any, to a pipe.
+ */
+Status measureFootprintAlone(StringPiece model, StringPiece input, u32 beam,
+                             ModelFootprint* result) {
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    return JPPS_INVALID_STATE << "failed to create a pipe: "
+                              << std::strerror(errno);
+  }
+  auto pid = ::fork();
+  if (pid < 0) {
+    auto error = errno;
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return JPPS_INVALID_STATE << "failed to fork: " << std::strerror(error);
+  }
+
+  if (pid == 0) {
+    ::close(fds[0]);
+    std::string message;
+    ModelFootprint fp;
+    auto s = measureFootprint(model, input, beam, &fp);
+    if (!s) {
+      message = s.message().str();
+      if (message.empty()) {
+        message = "unknown error";
+      }
+    }
+    std::string data{reinterpret_cast<const char*>(&fp), sizeof(fp)};
+    data += message;
+    size_t written = 0;
+    while (written < data.size()) {
+      auto n = ::write(fds[1], data.data() + written, data.size() - written);
+      if (n <= 0 && errno != EINTR) {
+        break;
+      }
+      written += n > 0 ? n : 0;
+    }
+    ::_exit(0);
+  }
+
+  ::close(fds[1]);
+  std::string data;
+  char buffer[4096];
+  while (true) {
+    auto n = ::read(fds[0], buffer, sizeof(buffer));
+    if (n > 0) {
+      data.append(buffer, n);
+    } else if (n == 0 || errno != EINTR) {
+      break;
+    }
+  }
+  ::close(fds[0]);
+  int status = 0;
+  while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+
+  if (data.size() < sizeof(ModelFootprint)) {
+    return JPPS_INVALID_STATE << "measuring model " << model
+                              << " in a child process failed";
+  }
+  if (data.size() > sizeof(ModelFootprint)) {
+    return JPPS_INVALID_STATE << data.substr(sizeof(ModelFootprint));
+  }
+  std::memcpy(result, data.data(), sizeof(ModelFootprint));
+  return Status::Ok();
+}
+#endif
+
+void reportFootprint(StringPiece name, const ModelFootprint& fp,
+                     std::ostream& report) {
+  report << "\n  " << name << ": resident memory ";
+  if (fp.residentBytes == 0) {
+    report << "unknown";
+  } else {
+    report << "+" << fp.residentBytes / 1024 << " KB";
+  }
+  report << ", " << fp.sentencesPerSecond << " sentences/s";
+}
+
+size_t fileSize(StringPiece filename) {
+  util::MappedFile file;
+  if (!file.open(filename, util::MMapType::ReadOnly)) {
+    return 0;
+  }
+  return file.size();
+}
+
+}  // namespace
+
+Status pruneModel(const PruneArgs& args, std::ostream& report) {
+  model::FilesystemModel modelFile;
+  JPP_RETURN_IF_ERROR(modelFile.open(args.modelInput));
+  model::ModelInfo info;
+  JPP_RETURN_IF_ERROR(modelFile.load(&info));
+
+  auto part = info.firstPartOf(model::ModelPartKind::Perceprton);
+  if (part == nullptr) {
+    return JPPS_INVALID_PARAMETER << "model " << args.modelInput
+                                  << " was not trained";
+  }
+
+  analysis::HashedFeaturePerceptron perceptron;
+  JPP_RETURN_IF_ERROR(perceptron.load(info));
+  auto& weights = perceptron.weights();
+  if (weights.floats() == nullptr) {
+    return JPPS_INVALID_PARAMETER << "model " << args.modelInput
+                                  << " is quantized, pruned or has hot "
+                                     "weights";
+  }
+
+  analysis::PerceptronPruner pruner;
+  JPP_RETURN_IF_ERROR(pruner.prune(
+      util::ArraySlice<float>{weights.floats(), weights.size()},
+      args.threshold));
+  pruner.fillModelPart(part);
+  if (!args.comment.empty()) {
+    part->comment = args.comment;
+  }
+
+  model::ModelSaver saver;
+  JPP_RETURN_IF_ERROR(saver.open(args.modelOutput));
+  JPP_RETURN_IF_ERROR(saver.save(info));
+
+  report << "\nStored weights: " << pruner.numStored() << " of "
+         << weights.size() << " ("
+         << 100.0 * pruner.numStored() / weights.size() << "%)";
+  report << "\nWeights size: " << weights.byteSize() << " -> "
+         << pruner.weights().byteSize() << " bytes";
+  report << "\nModel size: " << fileSize(args.modelInput) << " -> "
+         << fileSize(args.modelOutput) << " bytes";
+
+  if (!args.evalInput.empty()) {
+    JPP_RETURN_IF_ERROR(compareAnalysis(args.modelInput, args.modelOutput,
+                                        "pruned", args.evalInput,
+                                        args.evalBeam, report));
+
+    util::FullyMappedFile input;
+    JPP_RETURN_IF_ERROR(input.open(args.evalInput, util::MMapType::ReadOnly));
+    ModelFootprint original;
+    ModelFootprint pruned;
+#ifdef __unix__
+    JPP_RETURN_IF_ERROR(measureFootprintAlone(
+        args.modelInput, input.contents(), args.evalBeam, &original));
+    JPP_RETURN_IF_ERROR(measureFootprintAlone(
+        args.modelOutput, input.contents(), args.evalBeam, &pruned));
+    report << "\nEach model loaded alone:";
+#else
+    JPP_RETURN_IF_ERROR(measureFootprint(args.modelInput, input.contents(),
+                                         args.evalBeam, &original));
+    JPP_RETURN_IF_ERROR(measureFootprint(args.modelOutput, input.contents(),
+                                         args.evalBeam, &pruned));
+    report << "\nModels loaded one after another:";
+#endif
+    reportFootprint("original", original, report);
+    reportFootprint("pruned", pruned, report);
+  }
+  report << "\n";
+
+  return Status::Ok();
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
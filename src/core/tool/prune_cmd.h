@@ -0,0 +1,39 @@
+#ifndef JUMANPP_PRUNE_CMD_H
+#define JUMANPP_PRUNE_CMD_H
+
+#include <iosfwd>
+#include <string>
+#include "util/status.hpp"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+struct PruneArgs {
+  std::string modelInput;
+  std::string modelOutput;
+  std::string comment;
+  // weights with absolute values not greater than it are dropped,
+  // so zero weights are always dropped
+  float threshold = 0;
+  // raw text, a sentence per line; when it is not empty,
+  // analysis results, memory usage and speed of the original
+  // and pruned models are compared
+  std::string evalInput;
+  u32 evalBeam = 5;
+};
+
+/**
+ * Writes a copy of a trained model which stores only linear model
+ * weights with absolute values greater than a threshold in a sparse table
+ * and reports how it changes the model size and, optionally,
+ * analysis results, memory usage and speed.
+ */
+Status pruneModel(const PruneArgs& args, std::ostream& report);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_PRUNE_CMD_H
@@ -0,0 +1,105 @@
+#include "quantize_cmd.h"
+#include <cmath>
+#include <ostream>
+#include "core/impl/model_io.h"
+#include "core/tool/eval_model.h"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+namespace {
+
+void reportWeightError(const analysis::WeightBuffer& original,
+                       const analysis::WeightBuffer& quantized,
+                       std::ostream& report) {
+  double sum = 0;
+  float max = 0;
+  size_t zeros = 0;
+  size_t zerosKept = 0;
+  for (size_t i = 0; i < original.size(); ++i) {
+    float value = original.at(i);
+    float diff = std::abs(value - quantized.at(i));
+    sum += diff;
+    max = std::max(max, diff);
+    if (value == 0) {
+      zeros += 1;
+      zerosKept += quantized.at(i) == 0;
+    }
+  }
+  report << "\nWeight error: mean " << sum / original.size() << ", max "
+         << max;
+  report << "\nZero weights: " << zeros << ", kept zero: " << zerosKept;
+  report << "\nWeights size: " << original.byteSize() << " -> "
+         << quantized.byteSize() << " bytes";
+}
+
+}  // namespace
+
+Status quantizeModel(const QuantizeArgs& args, std::ostream& report) {
+  util::WeightEncoding encoding;
+  switch (args.bits) {
+    case 8:
+      encoding = util::WeightEncoding::Linear8;
+      break;
+    case 16:
+      encoding = util::WeightEncoding::Linear16;
+      break;
+    default:
+      return JPPS_INVALID_PARAMETER << "weights can be quantized to 8 or 16 "
+                                       "bits, was "
+                                    << args.bits;
+  }
+
+  model::FilesystemModel modelFile;
+  JPP_RETURN_IF_ERROR(modelFile.open(args.modelInput));
+  model::ModelInfo info;
+  JPP_RETURN_IF_ERROR(modelFile.load(&info));
+
+  auto part = info.firstPartOf(model::ModelPartKind::Perceprton);
+  if (part == nullptr) {
+    return JPPS_INVALID_PARAMETER << "model " << args.modelInput
+                                  << " was not trained";
+  }
+
+  analysis::HashedFeaturePerceptron perceptron;
+  JPP_RETURN_IF_ERROR(perceptron.load(info));
+  auto& weights = perceptron.weights();
+  if (weights.encoding() != util::WeightEncoding::Float32) {
+    return JPPS_INVALID_PARAMETER << "model " << args.modelInput
+                                  << " is already quantized or pruned";
+  }
+  if (weights.hasHotWeights()) {
+    return JPPS_INVALID_PARAMETER << "model " << args.modelInput
+                                  << " has hot weights, quantize the model "
+                                     "without them";
+  }
+
+  analysis::PerceptronQuantizer quantizer;
+  JPP_RETURN_IF_ERROR(quantizer.quantize(
+      util::ArraySlice<float>{weights.floats(), weights.size()}, encoding,
+      args.blockExponent));
+  quantizer.fillModelPart(part);
+  if (!args.comment.empty()) {
+    part->comment = args.comment;
+  }
+
+  model::ModelSaver saver;
+  JPP_RETURN_IF_ERROR(saver.open(args.modelOutput));
+  JPP_RETURN_IF_ERROR(saver.save(info));
+
+  reportWeightError(weights, quantizer.weights(), report);
+
+  if (!args.evalInput.empty()) {
+    JPP_RETURN_IF_ERROR(compareAnalysis(args.modelInput, args.modelOutput,
+                                        "quantized", args.evalInput,
+                                        args.evalBeam, report));
+  }
+  report << "\n";
+
+  return Status::Ok();
+}
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
@@ -0,0 +1,39 @@
+#ifndef JUMANPP_QUANTIZE_CMD_H
+#define JUMANPP_QUANTIZE_CMD_H
+
+#include <iosfwd>
+#include <string>
+#include "util/status.hpp"
+#include "util/types.hpp"
+
+namespace jumanpp {
+namespace core {
+namespace tool {
+
+struct QuantizeArgs {
+  std::string modelInput;
+  std::string modelOutput;
+  std::string comment;
+  // 8 or 16
+  u32 bits = 8;
+  // weights of a block share quantization parameters,
+  // 0 means a single block for the whole table
+  u32 blockExponent = 0;
+  // raw text, a sentence per line; when it is not empty,
+  // analysis results of the original and quantized models are compared
+  std::string evalInput;
+  u32 evalBeam = 5;
+};
+
+/**
+ * Writes a copy of a trained model with quantized perceptron weights
+ * and reports the weight error and, optionally, how much analysis
+ * results of the quantized model differ from the original ones.
+ */
+Status quantizeModel(const QuantizeArgs& args, std::ostream& report);
+
+}  // namespace tool
+}  // namespace core
+}  // namespace jumanpp
+
+#endif  // JUMANPP_QUANTIZE_CMD_H
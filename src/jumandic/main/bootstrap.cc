@@ -18,6 +18,9 @@ struct BootstrapArgs {
   std::string rawDicPath;
   std::string rawDicVersion;
   std::string outputPath;
+  bool entryTable = false;
+  bool codepointTrie = false;
+  u32 numThreads = 1;
 };
 
 Status importDictionary(const BootstrapArgs& bargs) {
@@ -48,6 +51,9 @@ Status importDictionary(const BootstrapArgs& bargs) {
   core::dic::DictionaryBuilder builder;
   JPP_RETURN_IF_ERROR(builder.importSpec(&spec));
   builder.setProgress(&progress);
+  builder.setBuildEntryTable(bargs.entryTable);
+  builder.setBuildCodepointTrie(bargs.codepointTrie);
+  builder.setNumThreads(bargs.numThreads);
   JPP_RETURN_IF_ERROR(builder.importCsv(bargs.rawDicPath, file.contents()));
   std::cout << "\nimport done\n";
 
@@ -80,6 +86,22 @@ Status parseArgs(BootstrapArgs* bargs, int argc, const char* argv[]) {
       "Embed this version into built dictionary",
       {"dic-version"},
       ""};
+  args::Flag entryTable{
+      parser,
+      "ENTRY_TABLE",
+      "Store entry features in a fixed-width table for faster analysis",
+      {"entry-table"}};
+  args::Flag codepointTrie{
+      parser,
+      "CODEPOINT_TRIE",
+      "Also index entries with a codepoint trie for faster lookups",
+      {"codepoint-trie"}};
+  args::ValueFlag<u32> numThreads{
+      parser,
+      "THREADS",
+      "Use this number of threads for indexing, 1 default",
+      {"threads"},
+      1};
   args::HelpFlag help{parser, "HELP", "Print help", {"help", 'h'}};
 
   try {
@@ -96,6 +118,9 @@ Status parseArgs(BootstrapArgs* bargs, int argc, const char* argv[]) {
   bargs->outputPath = output.Get();
   bargs->rawDicPath = input.Get();
   bargs->rawDicVersion = dicVersion.Get();
+  bargs->entryTable = entryTable.Get();
+  bargs->codepointTrie = codepointTrie.Get();
+  bargs->numThreads = numThreads.Get();
 
   return Status::Ok();
 }
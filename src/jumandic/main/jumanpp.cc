@@ -3,100 +3,387 @@
 //
 
 #include "jumanpp.h"
+#include <atomic>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include "core/input/pex_stream_reader.h"
 #include "jumandic/shared/jumanpp_args.h"
+#include "jumandic/shared/jumanpp_io.h"
+#include "jumandic/shared/jumanpp_server.h"
+#include "util/bounded_queue.h"
 #include "util/logging.hpp"
 
 using namespace jumanpp;
 
-struct InputOutput {
-  std::unique_ptr<core::input::StreamReader> streamReader_;
-  std::unique_ptr<std::ifstream> fileInput_;
-  int currentInFile_ = 0;
-  const std::vector<std::string>* inFiles_;
-  StringPiece currentInputFilename_;
-  std::istream* input_;
-
-  std::unique_ptr<std::ofstream> fileOutput_;
-  std::ostream* output_;
-
-  Status moveToNextFile() {
-    auto& fn = (*inFiles_)[currentInFile_];
-    fileInput_.reset(new std::ifstream{fn});
-    if (fileInput_->bad()) {
-      return JPPS_INVALID_PARAMETER << "failed to open output file: " << fn;
-    }
-    input_ = fileInput_.get();
-    currentInputFilename_ = fn;
-    currentInFile_ += 1;
-    return Status::Ok();
+/**
+ * A single example which is being processed by the multithreaded
+ * analysis pipeline.
+ * Tasks are allocated once and then recycled between
+ * the reader, the workers and the writer.
+ */
+struct AnalysisTask {
+  u64 sequence = 0;
+  std::unique_ptr<core::input::StreamReader> reader;
+  Status status = Status::Ok();
+  bool formatted = false;
+  std::string output;
+};
+
+void logDegraded(u64 numDegraded) {
+  if (numDegraded > 0) {
+    LOG_INFO() << numDegraded
+               << " sentences were analyzed with degraded quality "
+                  "to meet the deadline";
   }
+}
 
-  Status nextInput() {
-    if (*input_) {
-      JPP_RETURN_IF_ERROR(streamReader_->readExample(input_));
-      return Status::Ok();
-    }
+/**
+ * Reader (caller thread) -> N analysis workers -> writer.
+ *
+ * Each worker holds a lease of an analyzer with its output format
+ * from a pool which shares the model of JumanppExec.
+ * Writer puts results back to the input order,
+ * so the output is the same as of the single-threaded mode.
+ */
+class ParallelAnalysis {
+  jumandic::JumanppExec* exec_;
+  jumandic::InputOutput* io_;
+  u32 numThreads_;
+  u32 numTasks_;
+  std::vector<std::unique_ptr<AnalysisTask>> tasks_;
+  util::bounded_queue<AnalysisTask*> free_;
+  util::bounded_queue<AnalysisTask*> work_;
+  util::bounded_queue<AnalysisTask*> done_;
+  std::thread writer_;
 
-    if (input_->fail()) {
-      return JPPS_INVALID_STATE << "failed when reading from file: "
-                                << currentInputFilename_;
+  // Reader asks the writer to flush the output after all examples
+  // before this sequence number are written, when input becomes idle.
+  // Marker task only wakes the writer up.
+  std::atomic<u64> flushUpTo_{0};
+  AnalysisTask flushMarker_;
+  Status writeStatus_ = Status::Ok();
+
+  template <typename T>
+  static void push(util::bounded_queue<T>* queue, T item) {
+    while (!queue->offer(std::move(item))) {
+      std::this_thread::yield();
     }
+  }
 
-    return JPPS_NOT_IMPLEMENTED << "should not reach here, it is a bug";
+  core::AnalyzerPool pool_;
+  std::vector<core::AnalyzerLease> leases_;
+  std::vector<jumandic::RawExampleAnalyzer> rawAnalyzers_;
+  std::vector<std::thread> workers_;
+
+  void runWorker(u32 index) {
+    auto& lease = leases_[index];
+    auto analyzer = lease.analyzer();
+    auto format = lease.format();
+    auto& raw = rawAnalyzers_[index];
+    bool rawInput = io_->inputType_ == jumandic::InputType::Raw;
+    while (true) {
+      auto task = work_.waitFor();
+      if (task == nullptr) {
+        return;
+      }
+      try {
+        task->output.clear();
+        task->formatted = false;
+        if (rawInput) {
+          auto rdr =
+              static_cast<core::input::MappedStreamReader*>(task->reader.get());
+          // failed examples are output as empty results
+          task->formatted = true;
+          auto append = [task](StringPiece result) {
+            task->output.append(result.char_begin(), result.size());
+            return Status::Ok();
+          };
+          // appending to a string can not fail
+          raw.analyze(rdr->input(), rdr->comment(), append, &task->status);
+        } else {
+          task->status = task->reader->analyzeWith(analyzer);
+          if (task->status) {
+            task->status = format->format(*analyzer, task->reader->comment());
+            task->formatted = true;
+          }
+          if (task->status) {
+            task->output = format->result().str();
+          }
+        }
+      } catch (std::exception& e) {
+        task->formatted = false;
+        task->status = JPPS_INVALID_STATE
+                       << "caught an exception while analyzing: " << e.what();
+      }
+      push(&done_, task);
+    }
   }
 
-  Status initialize(const jumandic::JumanppConf& conf,
-                    const core::CoreHolder& cholder) {
-    inFiles_ = &conf.inputFiles.value();
-    if (!inFiles_->empty()) {
-      JPP_RETURN_IF_ERROR(moveToNextFile());
+  void writeResult(AnalysisTask* task) {
+    if (!writeStatus_) {
+      return;
+    }
+    auto& output = io_->output_;
+    if (!task->status) {
+      std::cerr << task->status;
+    }
+    if (task->formatted) {
+      writeStatus_ = output.write(task->output);
     } else {
-      input_ = &std::cin;
-      currentInputFilename_ = "<stdin>";
+      writeStatus_ = output.write(exec_->emptyResult());
     }
+  }
 
-    if (conf.outputFile == "-") {
-      output_ = &std::cout;
-    } else {
-      fileOutput_.reset(new std::ofstream{conf.outputFile});
-      output_ = fileOutput_.get();
+  void runWriter() {
+    // tasks in flight always have sequence numbers from
+    // [nextSeq, nextSeq + numTasks_), so a ring is enough for reordering
+    std::vector<AnalysisTask*> pending(numTasks_, nullptr);
+    u64 nextSeq = 0;
+    u64 flushedUpTo = 0;
+    while (true) {
+      auto task = done_.waitFor();
+      if (task == nullptr) {
+        if (writeStatus_) {
+          writeStatus_ = io_->output_.flush();
+        }
+        return;
+      }
+      if (task != &flushMarker_) {
+        pending[task->sequence % numTasks_] = task;
+      }
+      auto idx = nextSeq % numTasks_;
+      while (pending[idx] != nullptr) {
+        auto ready = pending[idx];
+        pending[idx] = nullptr;
+        writeResult(ready);
+        push(&free_, ready);
+        nextSeq += 1;
+        idx = nextSeq % numTasks_;
+      }
+      auto flushRequest = flushUpTo_.load(std::memory_order_acquire);
+      if (flushRequest > flushedUpTo && nextSeq >= flushRequest) {
+        if (writeStatus_) {
+          writeStatus_ = io_->output_.flush();
+        }
+        flushedUpTo = flushRequest;
+      }
     }
+  }
 
-    auto inType = conf.inputType.value();
-    if (inType == jumandic::InputType::Raw) {
-      auto rdr = new core::input::PlainStreamReader{};
-      streamReader_.reset(rdr);
-      rdr->setMaxSizes(65535, 1024);
-    } else {
-      auto rdr = new core::input::PexStreamReader{};
-      streamReader_.reset(rdr);
-      JPP_RETURN_IF_ERROR(rdr->initialize(cholder, '&'));
+ public:
+  ParallelAnalysis(jumandic::JumanppExec* exec, jumandic::InputOutput* io,
+                   u32 threads)
+      : exec_{exec},
+        io_{io},
+        numThreads_{threads},
+        numTasks_{threads * 4} {}
+
+  Status initialize() {
+    free_.initialize(numTasks_);
+    work_.initialize(numTasks_ + numThreads_);
+    done_.initialize(numTasks_ + 1);
+
+    for (u32 i = 0; i < numTasks_; ++i) {
+      std::unique_ptr<AnalysisTask> task{new AnalysisTask};
+      JPP_RETURN_IF_ERROR(io_->makeReader(&task->reader));
+      push(&free_, task.get());
+      tasks_.emplace_back(std::move(task));
+    }
+
+    auto exec = exec_;
+    auto formats = [exec](core::analysis::Analyzer* analyzer,
+                          std::unique_ptr<core::OutputFormat>* result) {
+      return exec->makeFormat(analyzer, result);
+    };
+    core::AnalyzerPoolConfig poolConf{numThreads_, numThreads_};
+    JPP_RETURN_IF_ERROR(
+        pool_.initialize(&exec_->environment(), poolConf, formats));
+    leases_.resize(numThreads_);
+    rawAnalyzers_.resize(numThreads_);
+    for (u32 i = 0; i < numThreads_; ++i) {
+      auto& lease = leases_[i];
+      JPP_RETURN_IF_ERROR(pool_.acquire(&lease));
+      JPP_RETURN_IF_ERROR(rawAnalyzers_[i].initialize(exec_, lease.analyzer(),
+                                                      lease.format()));
     }
 
     return Status::Ok();
   }
 
-  bool hasNext() {
-    if (input_->good()) {
-      auto ch = input_->peek();
-      if (ch == std::char_traits<char>::eof()) {
-        return false;
+  int run() {
+    try {
+      for (u32 i = 0; i < numThreads_; ++i) {
+        workers_.emplace_back([this](u32 idx) { runWorker(idx); }, i);
       }
+      writer_ = std::thread{[this]() { runWriter(); }};
+    } catch (std::system_error& e) {
+      std::cerr << "failed to start analysis threads: " << e.what() << "\n";
+      return 1;
     }
-    while (input_->eof() && currentInFile_ < inFiles_->size()) {
-      auto s = moveToNextFile();
+
+    int result = 0;
+    u64 sequence = 0;
+    while (true) {
+      if (sequence > flushUpTo_.load(std::memory_order_relaxed) &&
+          io_->inputIdle()) {
+        flushUpTo_.store(sequence, std::memory_order_release);
+        push(&done_, &flushMarker_);
+      }
+      if (!io_->hasNext()) {
+        break;
+      }
+      auto task = free_.waitFor();
+      auto s = io_->nextInput(task->reader.get());
       if (!s) {
-        LOG_ERROR() << s.message();
+        std::cerr << "failed to read an example: " << s;
+        result = 1;
+        push(&free_, task);
+        continue;
       }
+      result = 0;
+      task->sequence = sequence;
+      sequence += 1;
+      push(&work_, task);
     }
-    auto isOk = !input_->eof();
-    return isOk;
+
+    for (u32 i = 0; i < numThreads_; ++i) {
+      push(&work_, static_cast<AnalysisTask*>(nullptr));
+    }
+    for (auto& t : workers_) {
+      t.join();
+    }
+    push(&done_, static_cast<AnalysisTask*>(nullptr));
+    writer_.join();
+
+    if (!writeStatus_) {
+      std::cerr << "failed to write the output: " << writeStatus_;
+      return 1;
+    }
+
+    u64 numDegraded = 0;
+    for (auto& raw : rawAnalyzers_) {
+      numDegraded += raw.numDegraded();
+    }
+    logDegraded(numDegraded);
+    exec_->printStats(std::cerr);
+
+    return result;
   }
 };
 
+void logCacheStats(const jumandic::JumanppExec& exec) {
+  auto cache = exec.resultCache();
+  if (cache == nullptr) {
+    return;
+  }
+  auto stats = cache->stats();
+  LOG_INFO() << "result cache: " << stats.hits << " hits, " << stats.misses
+             << " misses";
+}
+
+/**
+ * Thin client mode: the model is not loaded, input is sent
+ * to a running server (see --serve) and its responses are written
+ * to the output.
+ * Sentences are batched until the input becomes idle
+ * or a batch becomes large enough.
+ */
+int runClient(const jumandic::JumanppConf& conf) {
+  if (conf.inputType.value() != jumandic::InputType::Raw) {
+    std::cerr << "client mode supports only raw input\n";
+    return 1;
+  }
+
+  jumandic::InputOutput io;
+  Status s = io.initialize(conf, nullptr);
+  if (!s) {
+    std::cerr << "Failed to initialize I/O: " << s;
+    return 1;
+  }
+
+  jumandic::ServerConnection conn;
+  s = conn.connect(conf.connectSocket.value());
+  if (!s) {
+    std::cerr << "Failed to connect to the server: " << s;
+    return 1;
+  }
+
+  constexpr size_t MaxBatchSize = 64 * 1024;
+  auto reader =
+      static_cast<core::input::MappedStreamReader*>(io.streamReader_.get());
+  std::string batch;
+  int result = 0;
+
+  auto sendBatch = [&]() -> Status {
+    StringPiece response;
+    u32 latency = 0;
+    JPP_RETURN_IF_ERROR(conn.request(batch, &response, &latency));
+    LOG_DEBUG() << "server has processed " << batch.size() << " bytes in "
+                << latency << "us";
+    batch.clear();
+    return io.output_.write(response);
+  };
+
+  while (true) {
+    // checking for the next example can block on interactive input,
+    // so the batch must be sent and its results written before that
+    bool idle = io.inputIdle();
+    if (!batch.empty() && (idle || batch.size() >= MaxBatchSize)) {
+      s = sendBatch();
+      if (!s) {
+        std::cerr << "request to the server has failed: " << s;
+        return 1;
+      }
+    }
+    if (idle) {
+      s = io.output_.flush();
+      if (!s) {
+        std::cerr << "failed to write the output: " << s;
+        return 1;
+      }
+    }
+
+    if (!io.hasNext()) {
+      break;
+    }
+
+    s = io.nextInput();
+    if (!s) {
+      std::cerr << "failed to read an example: " << s;
+      result = 1;
+      continue;
+    }
+
+    result = 0;
+    auto comment = reader->comment();
+    if (!comment.empty()) {
+      batch.append("# ");
+      batch.append(comment.begin(), comment.end());
+      batch.push_back('\n');
+    }
+    auto input = reader->input();
+    batch.append(input.begin(), input.end());
+    batch.push_back('\n');
+  }
+
+  if (!batch.empty()) {
+    s = sendBatch();
+    if (!s) {
+      std::cerr << "request to the server has failed: " << s;
+      return 1;
+    }
+  }
+
+  s = io.output_.flush();
+  if (!s) {
+    std::cerr << "failed to write the output: " << s;
+    return 1;
+  }
+  return result;
+}
+
 int main(int argc, const char** argv) {
   std::unique_ptr<std::ifstream> filePtr;
 
@@ -107,6 +394,10 @@ int main(int argc, const char** argv) {
     return 1;
   }
 
+  if (!conf.connectSocket.isDefault()) {
+    return runClient(conf);
+  }
+
   LOG_DEBUG() << "trying to create jumanppexec with model: "
               << conf.modelFile.value()
               << " and rnnmodel=" << conf.rnnModelFile.value();
@@ -143,17 +434,78 @@ int main(int argc, const char** argv) {
     return 0;
   }
 
-  InputOutput io;
+  if (!conf.serveSocket.isDefault()) {
+    u32 poolSize = std::thread::hardware_concurrency();
+    if (!conf.numThreads.isDefault()) {
+      poolSize = static_cast<u32>(std::max(conf.numThreads.value(), 1));
+    }
+    jumandic::JumanppServer server;
+    auto maxConnections =
+        static_cast<u32>(std::max(conf.maxConnections.value(), 1));
+    s = server.initialize(&exec, conf.serveSocket.value(),
+                          std::max<u32>(poolSize, 1), maxConnections);
+    if (s) {
+      s = server.stopOnSignals();
+    }
+    if (!s) {
+      std::cerr << "Failed to start the server: " << s;
+      return 1;
+    }
+    s = server.serve();
+    if (!s) {
+      std::cerr << "server has stopped: " << s;
+      return 1;
+    }
+    return 0;
+  }
+
+  jumandic::InputOutput io;
 
-  s = io.initialize(conf, exec.core());
+  s = io.initialize(conf, &exec.core());
   if (!s) {
     std::cerr << "Failed to initialize I/O: " << s;
     return 1;
   }
 
+  if (conf.numThreads > 1) {
+    ParallelAnalysis parallel{&exec, &io,
+                              static_cast<u32>(conf.numThreads.value())};
+    s = parallel.initialize();
+    if (!s) {
+      std::cerr << "Failed to initialize analysis threads: " << s;
+      return 1;
+    }
+    int result = parallel.run();
+    logCacheStats(exec);
+    return result;
+  }
+
+  bool rawInput = conf.inputType.value() == jumandic::InputType::Raw;
+  jumandic::RawExampleAnalyzer rawAnalyzer;
+  s = rawAnalyzer.initialize(&exec, exec.analyzerPtr(), exec.format());
+  if (!s) {
+    std::cerr << "Failed to initialize the analyzer: " << s;
+    return 1;
+  }
+  auto writeOutput = [&io](StringPiece result) {
+    return io.output_.write(result);
+  };
+
   int result = 0;
 
-  while (io.hasNext()) {
+  while (true) {
+    if (io.inputIdle()) {
+      s = io.output_.flush();
+      if (!s) {
+        std::cerr << "failed to write the output: " << s;
+        return 1;
+      }
+    }
+
+    if (!io.hasNext()) {
+      break;
+    }
+
     s = io.nextInput();
     if (!s) {
       std::cerr << "failed to read an example: " << s;
@@ -163,10 +515,30 @@ int main(int argc, const char** argv) {
 
     result = 0;
 
+    if (rawInput) {
+      auto rdr =
+          static_cast<core::input::MappedStreamReader*>(io.streamReader_.get());
+      Status exampleStatus = Status::Ok();
+      s = rawAnalyzer.analyze(rdr->input(), rdr->comment(), writeOutput,
+                              &exampleStatus);
+      if (!exampleStatus) {
+        std::cerr << exampleStatus;
+      }
+      if (!s) {
+        std::cerr << "failed to write the output: " << s;
+        return 1;
+      }
+      continue;
+    }
+
     s = io.streamReader_->analyzeWith(exec.analyzerPtr());
     if (!s) {
       std::cerr << s;
-      *io.output_ << exec.emptyResult();
+      s = io.output_.write(exec.emptyResult());
+      if (!s) {
+        std::cerr << "failed to write the output: " << s;
+        return 1;
+      }
       continue;
     }
 
@@ -174,9 +546,22 @@ int main(int argc, const char** argv) {
     if (!s) {
       std::cerr << s;
     } else {
-      *io.output_ << exec.format()->result();
+      s = io.output_.write(exec.format()->result());
+      if (!s) {
+        std::cerr << "failed to write the output: " << s;
+        return 1;
+      }
     }
   }
 
+  s = io.output_.flush();
+  if (!s) {
+    std::cerr << "failed to write the output: " << s;
+    return 1;
+  }
+
+  logDegraded(rawAnalyzer.numDegraded());
+  exec.printStats(std::cerr);
+  logCacheStats(exec);
   return result;
 }
\ No newline at end of file
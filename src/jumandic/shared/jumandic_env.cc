@@ -12,13 +12,17 @@
 #include "jumandic/shared/lattice_format.h"
 #include "jumandic/shared/morph_format.h"
 #include "jumandic/shared/subset_format.h"
+#include "util/murmur_hash.h"
 
 #if defined(JPP_USE_PROTOBUF)
 #include "core/proto/lattice_dump_output.h"
 #endif
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
 namespace jumanpp {
 namespace jumandic {
@@ -29,6 +33,31 @@ Status JumanppExec::init() {
   if (conf.autoStep.defined()) {
     env.setAutoBeam(conf.beamSize, conf.autoStep, conf.globalBeam);
   }
+  env.setDeadline(conf.deadlineMicros);
+  env.setDicCacheSize(conf.dicCacheSize);
+  auto& kernelName = conf.perceptronKernel.value();
+  if (!kernelName.empty()) {
+    core::analysis::PerceptronKernel kernel;
+    if (!core::analysis::impl::perceptronKernelByName(kernelName, &kernel)) {
+      return JPPS_INVALID_PARAMETER << "unknown perceptron kernel: "
+                                    << kernelName
+                                    << ", use scalar, avx2 or avx512";
+    }
+    JPP_RETURN_IF_ERROR(env.setPerceptronKernel(kernel));
+  }
+  for (auto& file : conf.userDictionaries.value()) {
+    JPP_RETURN_IF_ERROR(env.loadUserDictionary(file));
+  }
+
+  auto& statsFormat = conf.statsFormat.value();
+  if (!statsFormat.empty()) {
+    if (statsFormat != "text" && statsFormat != "json") {
+      return JPPS_INVALID_PARAMETER << "unknown statistics format: "
+                                    << statsFormat << ", use text or json";
+    }
+    stats_.reset(new core::analysis::AnalysisStatsCollector);
+    env.setStatsCollector(stats_.get());
+  }
 
   bool newRnn = !conf.rnnModelFile.value().empty();
 
@@ -46,45 +75,64 @@ Status JumanppExec::init() {
   JPP_RETURN_IF_ERROR(env.initFeatures(&features));
   JPP_RETURN_IF_ERROR(env.makeAnalyzer(&analyzer_));
   JPP_RETURN_IF_ERROR(initOutput());
+
+  if (conf.cacheSize > 0) {
+    // cached results depend on the model and on all analysis
+    // and output settings, so the whole configuration is a part of the key
+    std::stringstream ss;
+    ss << conf;
+    auto confString = ss.str();
+    StringPiece sp{confString};
+    auto confHash = util::hashing::murmurhash3_memory(sp.ubegin(), sp.uend(),
+                                                      0x3e5a7c1d2f9b8e61ULL);
+    auto size = static_cast<size_t>(conf.cacheSize.value());
+    cache_.reset(new ResultCache{size, confHash});
+  }
   return Status::Ok();
 }
 
 Status JumanppExec::initOutput() {
+  return makeFormat(&analyzer_, &format_);
+}
+
+Status JumanppExec::makeFormat(
+    core::analysis::Analyzer *analyzer,
+    std::unique_ptr<core::OutputFormat> *result) const {
   switch (conf.outputType.value()) {
     case jumandic::OutputType::Juman: {
       auto jfmt = new jumandic::output::JumanFormat;
-      format_.reset(jfmt);
-      JPP_RETURN_IF_ERROR(jfmt->initialize(analyzer_.output()));
+      result->reset(jfmt);
+      JPP_RETURN_IF_ERROR(jfmt->initialize(analyzer->output()));
       break;
     }
     case jumandic::OutputType::Morph: {
       auto mfmt = new jumandic::output::MorphFormat(false);
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case jumandic::OutputType::FullMorph: {
       auto mfmt = new jumandic::output::MorphFormat(true);
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::DicSubset: {
       auto mfmt = new jumandic::output::SubsetFormat{};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::Lattice: {
       auto mfmt = new jumandic::output::LatticeFormat{conf.beamOutput};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output()));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output()));
       break;
     }
     case OutputType::Segmentation: {
       auto mfmt = new core::output::SegmentedFormat{};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_.output(),
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer->output(),
                                            *env.coreHolder(),
                                            conf.segmentSeparator.value()));
       break;
@@ -95,17 +143,17 @@ Status JumanppExec::initOutput() {
 #ifdef JPP_ENABLE_DEV_TOOLS
     case OutputType::GlobalBeamPos: {
       auto mfmt = new core::output::GlobalBeamPositionFormat{conf.globalBeam};
-      format_.reset(mfmt);
-      JPP_RETURN_IF_ERROR(mfmt->initialize(analyzer_));
+      result->reset(mfmt);
+      JPP_RETURN_IF_ERROR(mfmt->initialize(*analyzer));
       break;
     }
 #if defined(JPP_USE_PROTOBUF)
     case OutputType::FullLatticeDump: {
       auto mfmt = new core::output::LatticeDumpOutput{true, true};
-      format_.reset(mfmt);
+      result->reset(mfmt);
       JPP_RETURN_IF_ERROR(
-          mfmt->initialize(analyzer_.impl(), &env.featureScorer()->weights()));
-      analyzer_.impl()->setStoreAllPatterns(true);
+          mfmt->initialize(analyzer->impl(), &env.featureScorer()->weights()));
+      analyzer->impl()->setStoreAllPatterns(true);
       break;
     }
 #endif
@@ -173,6 +221,18 @@ void JumanppExec::printFullVersion() const {
   std::cout << "\n";
 }
 
+void JumanppExec::printStats(std::ostream& os) const {
+  if (!stats_) {
+    return;
+  }
+  auto stats = stats_->aggregate();
+  if (conf.statsFormat.value() == "json") {
+    stats.printJson(os);
+  } else {
+    stats.printText(os);
+  }
+}
+
 StringPiece JumanppExec::emptyResult() const {
   switch (conf.outputType.value()) {
     case OutputType::Juman:
@@ -190,6 +250,153 @@ Status JumanppExec::initAnalyzer(core::analysis::Analyzer *result) {
   return env.makeAnalyzer(result);
 }
 
+namespace {
+
+bool removeSuffix(std::string *str, StringPiece suffix) {
+  if (str->size() < suffix.size() ||
+      StringPiece{*str}.from(str->size() - suffix.size()) != suffix) {
+    return false;
+  }
+  str->resize(str->size() - suffix.size());
+  return true;
+}
+
+StringPiece nextField(StringPiece *line, char separator) {
+  auto end = std::find(line->char_begin(), line->char_end(), separator);
+  StringPiece result{line->char_begin(), end};
+  if (end == line->char_end()) {
+    *line = StringPiece{end, end};
+  } else {
+    *line = StringPiece{end + 1, line->char_end()};
+  }
+  return result;
+}
+
+i32 parseNumber(StringPiece field) {
+  return static_cast<i32>(std::strtol(field.str().c_str(), nullptr, 10));
+}
+
+}  // namespace
+
+void ChunkedResult::initialize(OutputType type, StringPiece separator) {
+  type_ = type;
+  separator.assignTo(separator_);
+}
+
+bool ChunkedResult::usesBestPath() const {
+  switch (type_) {
+    case OutputType::Juman:
+    case OutputType::Morph:
+    case OutputType::FullMorph:
+    case OutputType::Segmentation:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ChunkedResult::commentAtEnd() const {
+  return type_ == OutputType::Morph || type_ == OutputType::FullMorph;
+}
+
+void ChunkedResult::reset() {
+  result_.clear();
+  numIds_ = 0;
+  numCodepoints_ = 0;
+  lastIds_.clear();
+}
+
+void ChunkedResult::append(StringPiece chunk) {
+  switch (type_) {
+    case OutputType::Juman:
+      removeSuffix(&result_, "EOS\n");
+      break;
+    case OutputType::Morph:
+    case OutputType::FullMorph:
+      removeSuffix(&result_, "\n");
+      break;
+    case OutputType::Segmentation:
+      if (removeSuffix(&result_, "\n")) {
+        result_ += separator_;
+      }
+      break;
+    case OutputType::Lattice:
+      appendLattice(chunk);
+      return;
+    default:
+      break;
+  }
+  result_.append(chunk.char_begin(), chunk.char_end());
+}
+
+// node lines are: - id prev1;prev2 start end other fields...
+void ChunkedResult::appendLattice(StringPiece chunk) {
+  bool first = !removeSuffix(&result_, "EOS\n");
+  auto idOffset = numIds_;
+  auto positionOffset = numCodepoints_;
+  auto previousIds = std::move(lastIds_);
+  lastIds_.clear();
+  i32 lastEnd = -1;
+  i32 lastEndId = -1;
+
+  StringPiece rest = chunk;
+  while (rest.size() > 0) {
+    auto line = nextField(&rest, '\n');
+    if (line.take(2) != "-\t") {
+      if (first || line == "EOS") {
+        result_.append(line.char_begin(), line.char_end());
+        result_ += '\n';
+      }
+      continue;
+    }
+
+    nextField(&line, '\t');
+    auto id = parseNumber(nextField(&line, '\t')) + idOffset;
+    auto prevs = nextField(&line, '\t');
+    auto start = parseNumber(nextField(&line, '\t')) + positionOffset;
+    auto end = parseNumber(nextField(&line, '\t')) + positionOffset;
+
+    result_ += "-\t";
+    result_ += std::to_string(id);
+    result_ += '\t';
+    while (prevs.size() > 0) {
+      auto prev = parseNumber(nextField(&prevs, ';'));
+      if (prev != 0) {
+        result_ += std::to_string(prev + idOffset);
+      } else if (!previousIds.empty()) {
+        result_ += previousIds;
+      } else {
+        result_ += '0';
+      }
+      if (prevs.size() > 0) {
+        result_ += ';';
+      }
+    }
+    result_ += '\t';
+    result_ += std::to_string(start);
+    result_ += '\t';
+    result_ += std::to_string(end);
+    result_ += '\t';
+    result_.append(line.char_begin(), line.char_end());
+    result_ += '\n';
+
+    numIds_ = std::max(numIds_, id);
+    numCodepoints_ = std::max(numCodepoints_, end + 1);
+    if (end > lastEnd) {
+      lastEnd = end;
+      lastIds_.clear();
+    }
+    // lines of the same node are adjacent
+    if (end == lastEnd && id != lastEndId) {
+      if (!lastIds_.empty()) {
+        lastIds_ += ';';
+      }
+      lastIds_ += std::to_string(id);
+      lastEndId = id;
+    }
+  }
+}
+
 const core::features::StaticFeatureFactory *jumandicStaticFeatures() {
   static jumanpp_generated::JumandicStatic factory;
   return &factory;
@@ -5,6 +5,8 @@
 #ifndef JUMANPP_JUMANDIC_ENV_H
 #define JUMANPP_JUMANDIC_ENV_H
 
+#include "core/analysis/analyzer_impl.h"
+#include "core/analysis/long_input.h"
 #include "core/analysis/perceptron.h"
 #include "core/analysis/rnn_scorer.h"
 #include "core/analysis/score_api.h"
@@ -12,11 +14,45 @@
 #include "core/impl/model_io.h"
 #include "jumandic/shared/juman_format.h"
 #include "jumandic/shared/jumanpp_args.h"
+#include "jumandic/shared/result_cache.h"
 #include "rnn/mikolov_rnn.h"
 
 namespace jumanpp {
 namespace jumandic {
 
+/**
+ * Joins formatted results of the chunks of a long example
+ * into a single result with a single end of sentence.
+ * Lattice node ids and positions of a chunk continue the ones
+ * of the previous chunks, and nodes at the start of a chunk
+ * are connected to the nodes at the end of the previous one.
+ */
+class ChunkedResult {
+  OutputType type_ = OutputType::Juman;
+  std::string separator_;
+  std::string result_;
+  // lattice output
+  i32 numIds_ = 0;
+  i32 numCodepoints_ = 0;
+  std::string lastIds_;
+
+  void appendLattice(StringPiece chunk);
+
+ public:
+  void initialize(OutputType type, StringPiece separator);
+  /**
+   * True if the output uses only the best path, so a chunk
+   * can be a cut of the analysis with the overlap
+   * (see core::analysis::LongInputConfig::stitchPaths).
+   */
+  bool usesBestPath() const;
+  // morph outputs print the comment at the end of the line
+  bool commentAtEnd() const;
+  void reset();
+  void append(StringPiece chunk);
+  StringPiece result() const { return result_; }
+};
+
 class JumanppExec {
  protected:
   jumandic::JumanppConf conf;
@@ -27,6 +63,9 @@ class JumanppExec {
   // rnn
   core::analysis::RnnScorerGbeamFactory rnnFactory;
 
+  std::unique_ptr<ResultCache> cache_;
+  std::unique_ptr<core::analysis::AnalysisStatsCollector> stats_;
+
   u64 numAnalyzed_ = 0;
 
   Status writeGraphviz();
@@ -68,11 +107,116 @@ class JumanppExec {
   void printModelInfo() const;
 
   void printFullVersion() const;
+  // Prints aggregated statistics of all analyzers if --stats was specified
+  void printStats(std::ostream& os) const;
   StringPiece emptyResult() const;
   core::analysis::Analyzer* analyzerPtr() { return &analyzer_; }
   core::OutputFormat* format() { return format_.get(); }
   const core::CoreHolder& core() const { return *env.coreHolder(); }
+  const core::JumanppEnv& environment() const { return env; }
+  // nullptr if the cache is disabled
+  ResultCache* resultCache() const { return cache_.get(); }
   Status initAnalyzer(core::analysis::Analyzer* result);
+  void initChunkedResult(ChunkedResult* result) const {
+    result->initialize(conf.outputType.value(), conf.segmentSeparator.value());
+  }
+  /**
+   * Create an output format, configured for the current output type,
+   * which will take data from the passed analyzer.
+   */
+  Status makeFormat(core::analysis::Analyzer* analyzer,
+                    std::unique_ptr<core::OutputFormat>* result) const;
+};
+
+/**
+ * Analyzes raw examples of any length and formats them.
+ * Examples which are too long for the analyzer are split into chunks
+ * (see core::analysis::LongInputAnalyzer), results of the chunks are joined
+ * into a single result of the example (see ChunkedResult).
+ * Examples which failed to be analyzed or formatted are output
+ * as empty results.
+ *
+ * Results of short examples without comments are taken from
+ * the result cache of JumanppExec if it is enabled.
+ * Results which were degraded to meet the deadline are not cached.
+ */
+class RawExampleAnalyzer {
+  const JumanppExec* exec_ = nullptr;
+  core::analysis::Analyzer* analyzer_ = nullptr;
+  core::OutputFormat* format_ = nullptr;
+  ResultCache* cache_ = nullptr;
+  core::analysis::LongInputAnalyzer longInput_;
+  ChunkedResult chunks_;
+  u64 numDegraded_ = 0;
+
+ public:
+  Status initialize(const JumanppExec* exec,
+                    core::analysis::Analyzer* analyzer,
+                    core::OutputFormat* format) {
+    exec_ = exec;
+    analyzer_ = analyzer;
+    format_ = format;
+    cache_ = exec->resultCache();
+    exec->initChunkedResult(&chunks_);
+    core::analysis::LongInputConfig config;
+    config.stitchPaths = chunks_.usesBestPath();
+    return longInput_.initialize(analyzer, config);
+  }
+
+  /**
+   * Output is called once with the formatted result of the example,
+   * its errors are returned immediately.
+   * Errors of analysis or formatting are returned via exampleStatus.
+   */
+  template <typename Fn>
+  Status analyze(StringPiece input, StringPiece comment, Fn output,
+                 Status* exampleStatus) {
+    *exampleStatus = Status::Ok();
+    bool cacheable = cache_ != nullptr && comment.empty() &&
+                     input.size() <= longInput_.maxInputBytes();
+    if (cacheable) {
+      auto cached = cache_->find(input);
+      if (cached != nullptr) {
+        return output(cached->output);
+      }
+    }
+
+    longInput_.reset(input);
+    chunks_.reset();
+    while (longInput_.hasNext()) {
+      Status s = longInput_.analyzeNext();
+      bool last = !longInput_.hasNext();
+      if (s) {
+        bool withComment =
+            chunks_.commentAtEnd() ? last : longInput_.isFirst();
+        core::analysis::StageTimer timer{analyzer_->impl()->stats(),
+                                         core::analysis::AnalysisStage::Output};
+        s = format_->format(*analyzer_, withComment ? comment : EMPTY_SP);
+      }
+      if (!s) {
+        *exampleStatus = std::move(s);
+        return output(exec_->emptyResult());
+      }
+      bool degraded = analyzer_->impl()->degraded();
+      if (degraded) {
+        numDegraded_ += 1;
+      }
+      if (longInput_.isFirst() && last) {
+        if (cacheable && !degraded) {
+          cache_->insert(input, format_->result());
+        }
+        return output(format_->result());
+      }
+      chunks_.append(format_->result());
+    }
+    return output(chunks_.result());
+  }
+
+  /**
+   * Number of chunks which were analyzed in degraded mode
+   * because of the deadline
+   */
+  u64 numDegraded() const { return numDegraded_; }
 };
 
 const core::features::StaticFeatureFactory* jumandicStaticFeatures();
@@ -64,6 +64,56 @@ struct JppArgsParser {
       general, "printVersion", "Just print version and exit", {'v', "version"}};
   args::Flag printDicInfo{
       general, "printModelInfo", "Print model info and exit", {"model-info"}};
+  args::ValueFlag<i32> numThreads{
+      general,
+      "N",
+      "Number of analysis threads (1 default), output keeps input order",
+      {"threads"}};
+  args::ValueFlag<i32> outputBuffer{
+      general,
+      "BYTES",
+      "Output is written in chunks of this size (65536 default), "
+      "0 writes every sentence immediately",
+      {"output-buffer"}};
+  args::ValueFlag<i32> cacheSize{
+      general,
+      "N",
+      "Cache analysis results of up to N repeated sentences "
+      "(0 default, disables the cache)",
+      {"cache-size"}};
+  args::ValueFlag<i32> dicCacheSize{
+      general,
+      "N",
+      "Cache up to N dictionary lookups of short substrings in each analyzer "
+      "(0 default, disables the cache)",
+      {"dic-cache-size"}};
+  args::ValueFlagList<std::string> userDictionaries{
+      general,
+      "FILENAME",
+      "Add entries of a CSV file in the format of the model dictionary "
+      "to the dictionary, can be used several times",
+      {"user-dic"}};
+  args::ValueFlag<std::string> statsFormat{
+      general,
+      "FORMAT",
+      "Print analysis timings and counters to stderr at exit, "
+      "FORMAT is text or json",
+      {"stats"}};
+  args::ValueFlag<std::string> serveSocket{
+      general,
+      "SOCKET",
+      "Keep the model loaded and serve analysis requests on this unix socket",
+      {"serve"}};
+  args::ValueFlag<i32> maxConnections{
+      general,
+      "N",
+      "Serve at most N connections at once (64 default), with --serve",
+      {"max-connections"}};
+  args::ValueFlag<std::string> connectSocket{
+      general,
+      "SOCKET",
+      "Send input for analysis to a server (see --serve) on this unix socket",
+      {"connect"}};
   args::Flag partialInput{general,
                           "partianInput",
                           "Input is partially-annotated",
@@ -115,6 +165,19 @@ struct JppArgsParser {
       "BASE:STEP:MAX",
       "Automatic beam size (from length). Sets local and global left beams.",
       {"auto-nbest"}};
+  args::ValueFlag<i32> deadline{
+      analysisParams,
+      "MICROS",
+      "Time budget for a single sentence (0 default, no budget). "
+      "Beams are narrowed and RNN is skipped if it is likely to be exceeded",
+      {"deadline-us"}};
+  args::ValueFlag<std::string> perceptronKernel{
+      analysisParams,
+      "KERNEL",
+      "Feature scoring kernel: scalar, avx2 or avx512. "
+      "The fastest one supported by the CPU is used by default, "
+      "scalar gives scores which do not depend on the machine",
+      {"perceptron-kernel"}};
 #ifdef JPP_ENABLE_DEV_TOOLS
   args::Group devParams{parser, "Dev options"};
   args::Flag globalBeamPos{devParams,
@@ -209,6 +272,15 @@ struct JppArgsParser {
     result->rnnModelFile.set(rnnModelFile);
     result->graphvizDir.set(graphvis);
     result->segmentSeparator.set(segmentSeparator);
+    result->numThreads.set(numThreads);
+    result->outputBuffer.set(outputBuffer);
+    result->cacheSize.set(cacheSize);
+    result->dicCacheSize.set(dicCacheSize);
+    result->userDictionaries.set(userDictionaries);
+    result->statsFormat.set(statsFormat);
+    result->serveSocket.set(serveSocket);
+    result->maxConnections.set(maxConnections);
+    result->connectSocket.set(connectSocket);
 
     result->beamSize.set(beamSize);
     if (result->beamSize < result->beamOutput) {
@@ -218,6 +290,8 @@ struct JppArgsParser {
     result->globalBeam.set(globalBeamSize);
     result->rightCheck.set(rightCheckBeam);
     result->rightBeam.set(rightBeamSize);
+    result->deadlineMicros.set(deadline);
+    result->perceptronKernel.set(perceptronKernel);
 
     if (autoBeam) {
       std::regex autoBeamRegex(R"(^(\d+):(\d+):(\d+)$)");
@@ -331,7 +405,19 @@ std::ostream& operator<<(std::ostream& os, const JumanppConf& conf) {
      << "\nglobalBeam: " << conf.globalBeam << "\nrightBeam: " << conf.rightBeam
      << "\nrightCheck: " << conf.rightCheck
      << "\nsegmentSeparator: " << conf.segmentSeparator
-     << "\nautoStep: " << conf.autoStep << "\nlogLevel: " << conf.logLevel;
+     << "\nautoStep: " << conf.autoStep
+     << "\ndeadlineMicros: " << conf.deadlineMicros
+     << "\nperceptronKernel: " << conf.perceptronKernel
+     << "\nnumThreads: " << conf.numThreads
+     << "\noutputBuffer: " << conf.outputBuffer
+     << "\ncacheSize: " << conf.cacheSize
+     << "\ndicCacheSize: " << conf.dicCacheSize
+     << "\nuserDictionaries: " << VOut(conf.userDictionaries.value())
+     << "\nstatsFormat: " << conf.statsFormat
+     << "\nserveSocket: " << conf.serveSocket
+     << "\nmaxConnections: " << conf.maxConnections
+     << "\nconnectSocket: " << conf.connectSocket
+     << "\nlogLevel: " << conf.logLevel;
   return os;
 }
 }  // namespace jumandic
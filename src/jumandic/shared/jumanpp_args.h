@@ -51,6 +51,17 @@ struct JumanppConf {
   util::Cfg<i32> rightCheck = 1;
   util::Cfg<i32> logLevel = 0;
   util::Cfg<i32> autoStep = 0;
+  util::Cfg<i32> deadlineMicros = 0;
+  util::Cfg<std::string> perceptronKernel;
+  util::Cfg<i32> numThreads = 1;
+  util::Cfg<i32> outputBuffer = 64 * 1024;
+  util::Cfg<i32> cacheSize = 0;
+  util::Cfg<i32> dicCacheSize = 0;
+  util::Cfg<std::vector<std::string>> userDictionaries{};
+  util::Cfg<std::string> statsFormat;
+  util::Cfg<std::string> serveSocket;
+  util::Cfg<i32> maxConnections = 64;
+  util::Cfg<std::string> connectSocket;
   util::Cfg<std::string> segmentSeparator{" "};
 
   void mergeWith(const JumanppConf& o) {
@@ -70,6 +81,17 @@ struct JumanppConf {
     rightCheck.mergeWith(o.rightCheck);
     logLevel.mergeWith(o.logLevel);
     autoStep.mergeWith(o.autoStep);
+    deadlineMicros.mergeWith(o.deadlineMicros);
+    perceptronKernel.mergeWith(o.perceptronKernel);
+    numThreads.mergeWith(o.numThreads);
+    outputBuffer.mergeWith(o.outputBuffer);
+    cacheSize.mergeWith(o.cacheSize);
+    dicCacheSize.mergeWith(o.dicCacheSize);
+    userDictionaries.mergeWith(o.userDictionaries);
+    statsFormat.mergeWith(o.statsFormat);
+    serveSocket.mergeWith(o.serveSocket);
+    maxConnections.mergeWith(o.maxConnections);
+    connectSocket.mergeWith(o.connectSocket);
     segmentSeparator.mergeWith(o.segmentSeparator);
   }
 
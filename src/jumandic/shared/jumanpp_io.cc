@@ -0,0 +1,163 @@
+#include "jumanpp_io.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include "core/analysis/long_input.h"
+#include "core/input/pex_stream_reader.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace jumandic {
+
+Status InputOutput::moveToNextFile() {
+  auto& fn = (*inFiles_)[currentInFile_];
+  currentInputFilename_ = fn;
+  currentInFile_ += 1;
+  input_ = nullptr;
+
+  if (inputType_ == InputType::Raw) {
+    std::unique_ptr<util::FullyMappedFile> file{new util::FullyMappedFile};
+    // can not map pipes and empty files, read them as streams
+    if (file->open(fn)) {
+      mappedData_ = file->contents();
+      mappedFiles_.emplace_back(std::move(file));
+      mapped_ = true;
+      return Status::Ok();
+    }
+  }
+
+  mapped_ = false;
+  fileInput_.reset(new std::ifstream{fn});
+  if (fileInput_->bad() || !fileInput_->is_open()) {
+    fileInput_.reset();
+    return JPPS_INVALID_PARAMETER << "failed to open input file: " << fn;
+  }
+  input_ = fileInput_.get();
+  return Status::Ok();
+}
+
+Status InputOutput::nextInput(core::input::StreamReader* reader) {
+  if (mapped_) {
+    // raw input always uses mapped readers
+    auto rdr = static_cast<core::input::MappedStreamReader*>(reader);
+    return rdr->readExample(&mappedData_);
+  }
+
+  if (input_ == nullptr) {
+    if (!openError_) {
+      return std::move(openError_);
+    }
+    return JPPS_INVALID_STATE << "no input file is open";
+  }
+
+  if (*input_) {
+    JPP_RETURN_IF_ERROR(reader->readExample(input_));
+    return Status::Ok();
+  }
+
+  if (input_->fail()) {
+    return JPPS_INVALID_STATE << "failed when reading from file: "
+                              << currentInputFilename_;
+  }
+
+  return JPPS_NOT_IMPLEMENTED << "should not reach here, it is a bug";
+}
+
+Status InputOutput::initialize(const JumanppConf& conf,
+                               const core::CoreHolder* cholder) {
+  inputType_ = conf.inputType.value();
+  inFiles_ = &conf.inputFiles.value();
+  if (!inFiles_->empty()) {
+    JPP_RETURN_IF_ERROR(moveToNextFile());
+  } else {
+    input_ = &std::cin;
+    currentInputFilename_ = "<stdin>";
+  }
+
+  if (conf.outputFile == "-") {
+    output_.attach(fileno(stdout));
+  } else {
+    JPP_RETURN_IF_ERROR(output_.open(conf.outputFile.value()));
+  }
+  auto bufferSize = std::max<i32>(conf.outputBuffer.value(), 0);
+  output_.setFlushSize(static_cast<size_t>(bufferSize));
+
+  if (inputType_ == InputType::Raw) {
+    auto rdr = new core::input::MappedStreamReader{};
+    streamReader_.reset(rdr);
+    rdr->setMaxSizes(core::analysis::MaxLongInputBytes, 1024);
+  } else {
+    auto rdr = new core::input::PexStreamReader{};
+    streamReader_.reset(rdr);
+    JPP_RETURN_IF_ERROR(rdr->initialize(*cholder, '&'));
+  }
+
+  return Status::Ok();
+}
+
+Status InputOutput::makeReader(
+    std::unique_ptr<core::input::StreamReader>* result) const {
+  if (inputType_ == InputType::Raw) {
+    auto rdr = new core::input::MappedStreamReader{};
+    result->reset(rdr);
+    rdr->setMaxSizes(core::analysis::MaxLongInputBytes, 1024);
+  } else {
+    auto rdr = new core::input::PexStreamReader{};
+    result->reset(rdr);
+    auto main =
+        static_cast<const core::input::PexStreamReader*>(streamReader_.get());
+    JPP_RETURN_IF_ERROR(rdr->initialize(*main));
+  }
+  return Status::Ok();
+}
+
+bool InputOutput::inputIdle() {
+  if (mapped_ || input_ != &std::cin) {
+    return false;
+  }
+  if (std::cin.rdbuf()->in_avail() > 0) {
+    return false;
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  pollfd pfd{STDIN_FILENO, POLLIN, 0};
+  return ::poll(&pfd, 1, 0) <= 0;
+#else
+  return true;
+#endif
+}
+
+bool InputOutput::hasNext() {
+  while (true) {
+    if (mapped_) {
+      if (!mappedData_.empty()) {
+        return true;
+      }
+    } else if (input_ == nullptr) {
+      if (!openError_) {
+        // nextInput will report the error
+        return true;
+      }
+    } else if (input_->good()) {
+      auto ch = input_->peek();
+      if (ch != std::char_traits<char>::eof()) {
+        return true;
+      }
+    } else if (!input_->eof()) {
+      // nextInput will report the error
+      return true;
+    }
+
+    if (currentInFile_ >= inFiles_->size()) {
+      return false;
+    }
+
+    openError_ = moveToNextFile();
+  }
+}
+
+}  // namespace jumandic
+}  // namespace jumanpp
@@ -0,0 +1,74 @@
+#ifndef JUMANPP_JUMANPP_IO_H
+#define JUMANPP_JUMANPP_IO_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/core.h"
+#include "core/input/stream_reader.h"
+#include "jumandic/shared/jumanpp_args.h"
+#include "util/chunked_writer.h"
+#include "util/mmap.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+/**
+ * Input and output of the jumanpp binary.
+ *
+ * Input comes from the list of input files or stdin if the list is empty.
+ * Raw input files are memory-mapped when possible.
+ * A file which can not be opened is reported as an error by nextInput,
+ * reading continues from the next file afterwards.
+ */
+struct InputOutput {
+  std::unique_ptr<core::input::StreamReader> streamReader_;
+  std::unique_ptr<std::ifstream> fileInput_;
+  int currentInFile_ = 0;
+  const std::vector<std::string>* inFiles_;
+  StringPiece currentInputFilename_;
+  // is nullptr for mapped files and files which failed to open
+  std::istream* input_ = nullptr;
+  // failure to open the current file, reported by nextInput
+  Status openError_ = Status::Ok();
+
+  // Raw input files are memory-mapped and examples are not copied.
+  // Examples can be still in flight when we move to the next file,
+  // so mappings are kept until the end.
+  std::vector<std::unique_ptr<util::FullyMappedFile>> mappedFiles_;
+  StringPiece mappedData_;
+  bool mapped_ = false;
+
+  util::io::ChunkedWriter output_;
+  InputType inputType_;
+
+  Status moveToNextFile();
+
+  Status nextInput() { return nextInput(streamReader_.get()); }
+  Status nextInput(core::input::StreamReader* reader);
+
+  // cholder can be null only for the raw input
+  Status initialize(const JumanppConf& conf, const core::CoreHolder* cholder);
+
+  /**
+   * Creates an additional reader with the same configuration
+   * as the main one. Used for the multithreaded analysis,
+   * when each example in flight holds its own reader.
+   */
+  Status makeReader(std::unique_ptr<core::input::StreamReader>* result) const;
+
+  /**
+   * Check if reading the next example can block,
+   * so the buffered output must be written out
+   * for interactive users (e.g. a tty or a subprocess pipe).
+   */
+  bool inputIdle();
+
+  bool hasNext();
+};
+
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_JUMANPP_IO_H
@@ -0,0 +1,62 @@
+#include "jumanpp_io.h"
+#include <fstream>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::jumandic;
+
+namespace {
+void writeFile(const std::string& name, StringPiece data) {
+  std::ofstream out{name};
+  out.write(data.char_begin(), data.size());
+}
+
+StringPiece lastInput(const InputOutput& io) {
+  auto rdr =
+      static_cast<core::input::MappedStreamReader*>(io.streamReader_.get());
+  return rdr->input();
+}
+}  // namespace
+
+TEST_CASE("jumanpp input reports a missing file after a mapped one") {
+  TempFile data;
+  TempFile missing;
+  TempFile output;
+  writeFile(data.name(), "a\nb\n");
+  JumanppConf conf;
+  conf.inputFiles = std::vector<std::string>{data.name(), missing.name()};
+  conf.outputFile = output.name();
+  InputOutput io;
+  REQUIRE_OK(io.initialize(conf, nullptr));
+  REQUIRE(io.hasNext());
+  REQUIRE_OK(io.nextInput());
+  CHECK(lastInput(io) == "a");
+  REQUIRE(io.hasNext());
+  REQUIRE_OK(io.nextInput());
+  CHECK(lastInput(io) == "b");
+  REQUIRE(io.hasNext());
+  CHECK_FALSE(io.nextInput());
+  CHECK_FALSE(io.hasNext());
+}
+
+TEST_CASE("jumanpp input continues after a missing file") {
+  TempFile empty;
+  TempFile missing;
+  TempFile data;
+  TempFile output;
+  // empty files can not be mapped and are read as streams
+  writeFile(empty.name(), "");
+  writeFile(data.name(), "c\n");
+  JumanppConf conf;
+  conf.inputFiles =
+      std::vector<std::string>{empty.name(), missing.name(), data.name()};
+  conf.outputFile = output.name();
+  InputOutput io;
+  REQUIRE_OK(io.initialize(conf, nullptr));
+  REQUIRE(io.hasNext());
+  CHECK_FALSE(io.nextInput());
+  REQUIRE(io.hasNext());
+  REQUIRE_OK(io.nextInput());
+  CHECK(lastInput(io) == "c");
+  CHECK_FALSE(io.hasNext());
+}
@@ -0,0 +1,647 @@
+#include "jumanpp_server.h"
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "core/input/stream_reader.h"
+#include "util/logging.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define JPP_HAS_UNIX_SOCKETS
+#endif
+
+namespace jumanpp {
+namespace jumandic {
+
+constexpr u32 ServerFraming::MaxPayloadSize;
+constexpr u32 ServerFraming::MaxResponseSize;
+constexpr u32 ServerFraming::ErrorFlag;
+constexpr size_t ServerFraming::RequestHeaderSize;
+constexpr size_t ServerFraming::ResponseHeaderSize;
+
+#if defined(JPP_HAS_UNIX_SOCKETS)
+
+namespace {
+
+void encodeU32(u32 value, char* out) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>((value >> (i * 8)) & 0xff);
+  }
+}
+
+u32 decodeU32(const char* data) {
+  u32 result = 0;
+  for (int i = 0; i < 4; ++i) {
+    result |= static_cast<u32>(static_cast<u8>(data[i])) << (i * 8);
+  }
+  return result;
+}
+
+Status sendAll(int fd, const char* data, size_t size) {
+#if defined(MSG_NOSIGNAL)
+  constexpr int flags = MSG_NOSIGNAL;
+#else
+  constexpr int flags = 0;
+#endif
+  while (size > 0) {
+    auto sent = ::send(fd, data, size, flags);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return JPPS_INVALID_STATE << "failed to send data: " << strerror(errno);
+    }
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return Status::Ok();
+}
+
+// returns false on clean EOF before the first byte
+Status recvAll(int fd, char* data, size_t size, bool* eof) {
+  size_t total = 0;
+  *eof = false;
+  while (total < size) {
+    auto read = ::recv(fd, data + total, size - total, 0);
+    if (read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return JPPS_INVALID_STATE << "failed to receive data: "
+                                << strerror(errno);
+    }
+    if (read == 0) {
+      if (total == 0) {
+        *eof = true;
+        return Status::Ok();
+      }
+      return JPPS_INVALID_STATE << "connection was closed in the middle of "
+                                   "a message";
+    }
+    total += static_cast<size_t>(read);
+  }
+  return Status::Ok();
+}
+
+Status makeAddress(StringPiece path, sockaddr_un* addr) {
+  memset(addr, 0, sizeof(sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr->sun_path)) {
+    return JPPS_INVALID_PARAMETER << "socket path is too long: " << path;
+  }
+  std::copy(path.begin(), path.end(), addr->sun_path);
+  return Status::Ok();
+}
+
+// write end of the pipe of the server which is stopped by signals
+int stopSignalFd = -1;
+
+void writeStopSignal(int) {
+  auto savedErrno = errno;
+  char byte = 0;
+  // the pipe is non-blocking, a full pipe already stops the server
+  auto written = ::write(stopSignalFd, &byte, 1);
+  static_cast<void>(written);
+  errno = savedErrno;
+}
+
+}  // namespace
+
+JumanppServer::~JumanppServer() {
+  stopWorkers();
+  if (listenFd_ >= 0) {
+    ::close(listenFd_);
+    ::unlink(path_.c_str());
+  }
+  if (signalFd_ >= 0) {
+    ::signal(SIGINT, SIG_DFL);
+    ::signal(SIGTERM, SIG_DFL);
+    ::close(stopSignalFd);
+    ::close(signalFd_);
+    stopSignalFd = -1;
+  }
+}
+
+Status JumanppServer::initialize(JumanppExec* exec, StringPiece socketPath,
+                                 u32 poolSize, u32 maxConnections) {
+  if (maxConnections == 0) {
+    return JPPS_INVALID_PARAMETER << "server must accept at least one "
+                                     "connection";
+  }
+  exec_ = exec;
+  path_ = socketPath.str();
+  poolSize_ = poolSize;
+  maxConnections_ = maxConnections;
+
+  auto formats = [exec](core::analysis::Analyzer* analyzer,
+                        std::unique_ptr<core::OutputFormat>* result) {
+    return exec->makeFormat(analyzer, result);
+  };
+  core::AnalyzerPoolConfig poolConf{1, poolSize};
+  JPP_RETURN_IF_ERROR(
+      pool_.initialize(&exec->environment(), poolConf, formats));
+
+  sockaddr_un addr;
+  JPP_RETURN_IF_ERROR(makeAddress(socketPath, &addr));
+
+  // a killed server leaves its socket behind, it is removed
+  // only if nobody accepts connections on it
+  struct stat st;
+  if (::stat(path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+      return JPPS_INVALID_STATE << "failed to create a socket: "
+                                << strerror(errno);
+    }
+    auto connected =
+        ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    auto err = errno;
+    ::close(probe);
+    if (connected == 0) {
+      return JPPS_INVALID_PARAMETER << "failed to bind socket to "
+                                    << socketPath << ": "
+                                    << strerror(EADDRINUSE);
+    }
+    if (err == ECONNREFUSED) {
+      ::unlink(path_.c_str());
+    }
+  }
+
+  listenFd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd_ < 0) {
+    return JPPS_INVALID_STATE << "failed to create a socket: "
+                              << strerror(errno);
+  }
+
+  if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+      0) {
+    auto err = errno;
+    ::close(listenFd_);
+    listenFd_ = -1;
+    return JPPS_INVALID_PARAMETER << "failed to bind socket to " << socketPath
+                                  << ": " << strerror(err);
+  }
+
+  if (::listen(listenFd_, 128) != 0) {
+    return JPPS_INVALID_STATE << "failed to listen on socket " << socketPath
+                              << ": " << strerror(errno);
+  }
+
+  return Status::Ok();
+}
+
+Status JumanppServer::stopOnSignals() {
+  if (stopSignalFd >= 0) {
+    return JPPS_INVALID_STATE << "signals already stop another server";
+  }
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    return JPPS_INVALID_STATE << "failed to create a pipe: "
+                              << strerror(errno);
+  }
+  ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  // signal handler must never block
+  ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+  signalFd_ = fds[0];
+  stopSignalFd = fds[1];
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = writeStopSignal;
+  sigemptyset(&action.sa_mask);
+  if (::sigaction(SIGINT, &action, nullptr) != 0 ||
+      ::sigaction(SIGTERM, &action, nullptr) != 0) {
+    return JPPS_INVALID_STATE << "failed to install signal handlers: "
+                              << strerror(errno);
+  }
+  return Status::Ok();
+}
+
+Status JumanppServer::serve() {
+  LOG_INFO() << "serving analysis requests on " << path_;
+
+  // analyzers are held by analysis threads until serve() returns
+  std::vector<core::AnalyzerLease> leases(poolSize_);
+  std::vector<std::unique_ptr<RawExampleAnalyzer>> analyzers;
+  for (auto& lease : leases) {
+    JPP_RETURN_IF_ERROR(pool_.acquire(&lease));
+    analyzers.emplace_back(new RawExampleAnalyzer);
+    JPP_RETURN_IF_ERROR(analyzers.back()->initialize(exec_, lease.analyzer(),
+                                                     lease.format()));
+  }
+  analysisDone_ = false;
+  analysisThreads_.reserve(poolSize_);
+  for (auto& raw : analyzers) {
+    auto ptr = raw.get();
+    analysisThreads_.emplace_back([this, ptr]() { runAnalysis(ptr); });
+  }
+
+  accepted_.initialize(maxConnections_);
+  workers_.reserve(maxConnections_);
+  for (u32 i = 0; i < maxConnections_; ++i) {
+    workers_.emplace_back([this]() { runWorker(); });
+  }
+
+  Status result = Status::Ok();
+  while (!stopping_) {
+    if (signalFd_ >= 0) {
+      pollfd fds[2] = {{listenFd_, POLLIN, 0}, {signalFd_, POLLIN, 0}};
+      if (::poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        result = JPPS_INVALID_STATE << "failed to wait for a connection: "
+                                    << strerror(errno);
+        break;
+      }
+      if (fds[1].revents != 0) {
+        LOG_INFO() << "stopping the server on a signal";
+        break;
+      }
+    }
+    int fd = ::accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (stopping_) {
+        break;
+      }
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      result = JPPS_INVALID_STATE << "failed to accept a connection: "
+                                  << strerror(errno);
+      break;
+    }
+    if (!accepted_.offer(std::move(fd))) {
+      LOG_WARN() << "too many connections, closing a new one";
+      ::close(fd);
+    }
+  }
+
+  stop();
+  stopWorkers();
+  return result;
+}
+
+void JumanppServer::stop() {
+  stopping_ = true;
+  if (listenFd_ >= 0) {
+    // wakes up accept in serve()
+    ::shutdown(listenFd_, SHUT_RDWR);
+  }
+  std::lock_guard<std::mutex> lock{activeMutex_};
+  for (int fd : active_) {
+    ::shutdown(fd, SHUT_RDWR);
+  }
+}
+
+void JumanppServer::stopWorkers() {
+  if (!workers_.empty()) {
+    int fd;
+    while (accepted_.recieve(&fd)) {
+      ::close(fd);
+    }
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      int marker = -1;
+      while (!accepted_.offer(std::move(marker))) {
+        std::this_thread::yield();
+      }
+    }
+    for (auto& w : workers_) {
+      w.join();
+    }
+    workers_.clear();
+  }
+
+  // workers wait for their sentences, so the queue is empty now
+  {
+    std::lock_guard<std::mutex> lock{tasksMutex_};
+    analysisDone_ = true;
+  }
+  tasksReady_.notify_all();
+  for (auto& t : analysisThreads_) {
+    t.join();
+  }
+  analysisThreads_.clear();
+}
+
+void JumanppServer::runAnalysis(RawExampleAnalyzer* raw) {
+  while (true) {
+    ServerTask* task;
+    {
+      std::unique_lock<std::mutex> lock{tasksMutex_};
+      tasksReady_.wait(lock,
+                       [this]() { return !tasks_.empty() || analysisDone_; });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = tasks_.front();
+      tasks_.pop_front();
+    }
+
+    task->output.clear();
+    auto output = [task](StringPiece result) -> Status {
+      task->output.append(result.char_begin(), result.size());
+      return Status::Ok();
+    };
+    Status exampleStatus = Status::Ok();
+    task->status =
+        raw->analyze(task->input, task->comment, output, &exampleStatus);
+    if (!exampleStatus) {
+      LOG_WARN() << "failed to analyze [" << task->input
+                 << "]: " << exampleStatus.message();
+    }
+
+    auto batch = task->batch;
+    // the batch is destroyed as soon as its last sentence is done
+    std::lock_guard<std::mutex> lock{batch->mutex};
+    batch->remaining -= 1;
+    if (batch->remaining == 0) {
+      batch->done.notify_one();
+    }
+  }
+}
+
+void JumanppServer::runWorker() {
+  while (true) {
+    int fd = accepted_.waitFor();
+    if (fd < 0) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock{activeMutex_};
+      active_.push_back(fd);
+    }
+    // stop() either sees the connection in active_ or we see stopping_ here
+    if (!stopping_) {
+      handleConnection(fd);
+    }
+    {
+      std::lock_guard<std::mutex> lock{activeMutex_};
+      active_.erase(std::find(active_.begin(), active_.end(), fd));
+    }
+    // closed only after being removed, so stop() never sees a reused fd
+    ::close(fd);
+  }
+}
+
+void JumanppServer::handleConnection(int fd) {
+  auto connId = connections_.fetch_add(1);
+  LOG_DEBUG() << "connection #" << connId << " opened";
+
+  ServerStats stats;
+  std::string request;
+  std::vector<ServerTask> tasks;
+  std::string response;
+  char header[ServerFraming::RequestHeaderSize];
+
+  while (true) {
+    bool eof = false;
+    Status s = recvAll(fd, header, sizeof(header), &eof);
+    if (!s) {
+      LOG_WARN() << "connection #" << connId << ": " << s.message();
+      break;
+    }
+    if (eof) {
+      break;
+    }
+
+    auto size = decodeU32(header);
+    if (size > ServerFraming::MaxPayloadSize) {
+      LOG_WARN() << "connection #" << connId << ": request of " << size
+                 << " bytes is too large";
+      break;
+    }
+    request.resize(size);
+    s = recvAll(fd, &request[0], size, &eof);
+    if (!s || eof) {
+      LOG_WARN() << "connection #" << connId
+                 << ": failed to read a request: " << s.message();
+      break;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    response.resize(ServerFraming::ResponseHeaderSize);
+    s = processRequest(request, &tasks, &response, &stats);
+    u32 errorFlag = 0;
+    if (!s) {
+      LOG_WARN() << "connection #" << connId
+                 << ": failed to process a request: " << s.message();
+      response.resize(ServerFraming::ResponseHeaderSize);
+      auto message = s.message();
+      response.append(message.char_begin(), message.size());
+      errorFlag = ServerFraming::ErrorFlag;
+    }
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    auto latencyMicros = static_cast<u64>(latency.count());
+    stats.requests += 1;
+    stats.totalLatencyMicros += latencyMicros;
+    stats.maxLatencyMicros = std::max(stats.maxLatencyMicros, latencyMicros);
+    LOG_DEBUG() << "connection #" << connId << ": request of " << size
+                << " bytes took " << latencyMicros << "us";
+
+    // processRequest keeps the payload under MaxResponseSize
+    auto payloadSize = response.size() - ServerFraming::ResponseHeaderSize;
+    encodeU32(static_cast<u32>(payloadSize) | errorFlag, &response[0]);
+    encodeU32(static_cast<u32>(std::min<u64>(latencyMicros, ~u32{0})),
+              &response[4]);
+    s = sendAll(fd, response.data(), response.size());
+    if (!s) {
+      LOG_WARN() << "connection #" << connId << ": " << s.message();
+      break;
+    }
+  }
+
+  auto avgLatency =
+      stats.requests == 0 ? 0 : stats.totalLatencyMicros / stats.requests;
+  LOG_INFO() << "connection #" << connId << " closed: " << stats.requests
+             << " requests, " << stats.sentences
+             << " sentences, average latency " << avgLatency
+             << "us, max latency " << stats.maxLatencyMicros << "us";
+}
+
+Status JumanppServer::processRequest(StringPiece request,
+                                     std::vector<ServerTask>* tasks,
+                                     std::string* response,
+                                     ServerStats* stats) {
+  core::input::MappedStreamReader reader;
+  reader.setMaxSizes(core::analysis::MaxLongInputBytes, 1024);
+  // tasks are reused by requests of a connection
+  size_t numTasks = 0;
+  StringPiece rest = request;
+  while (!rest.empty()) {
+    Status s = reader.readExample(&rest);
+    if (!s) {
+      LOG_WARN() << "failed to read an example: " << s.message();
+      continue;
+    }
+    if (numTasks == tasks->size()) {
+      tasks->emplace_back();
+    }
+    auto& task = (*tasks)[numTasks];
+    task.input = reader.input();
+    task.comment = reader.comment();
+    numTasks += 1;
+  }
+  stats->sentences += numTasks;
+
+  if (numTasks > 0) {
+    ServerBatch batch;
+    batch.remaining = numTasks;
+    {
+      std::lock_guard<std::mutex> lock{tasksMutex_};
+      for (size_t i = 0; i < numTasks; ++i) {
+        auto& task = (*tasks)[i];
+        task.batch = &batch;
+        tasks_.push_back(&task);
+      }
+    }
+    tasksReady_.notify_all();
+    std::unique_lock<std::mutex> lock{batch.mutex};
+    batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+  }
+
+  for (size_t i = 0; i < numTasks; ++i) {
+    auto& task = (*tasks)[i];
+    if (!task.status) {
+      return std::move(task.status);
+    }
+    auto payloadSize = response->size() - ServerFraming::ResponseHeaderSize;
+    if (payloadSize + task.output.size() > ServerFraming::MaxResponseSize) {
+      return JPPS_INVALID_PARAMETER << "response is larger than "
+                                    << ServerFraming::MaxResponseSize
+                                    << " bytes, split the request";
+    }
+    response->append(task.output);
+  }
+  return Status::Ok();
+}
+
+ServerConnection::~ServerConnection() { close(); }
+
+Status ServerConnection::connect(StringPiece socketPath) {
+  close();
+  sockaddr_un addr;
+  JPP_RETURN_IF_ERROR(makeAddress(socketPath, &addr));
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd_ < 0) {
+    return JPPS_INVALID_STATE << "failed to create a socket: "
+                              << strerror(errno);
+  }
+  if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    auto err = errno;
+    close();
+    return JPPS_INVALID_PARAMETER << "failed to connect to " << socketPath
+                                  << ": " << strerror(err);
+  }
+  return Status::Ok();
+}
+
+Status ServerConnection::request(StringPiece payload, StringPiece* response,
+                                 u32* latencyMicros) {
+  if (payload.size() > ServerFraming::MaxPayloadSize) {
+    return JPPS_INVALID_PARAMETER << "request of " << payload.size()
+                                  << " bytes is too large";
+  }
+  char header[ServerFraming::ResponseHeaderSize];
+  encodeU32(static_cast<u32>(payload.size()), header);
+  JPP_RETURN_IF_ERROR(
+      sendAll(fd_, header, ServerFraming::RequestHeaderSize));
+  JPP_RETURN_IF_ERROR(sendAll(fd_, payload.begin(), payload.size()));
+
+  bool eof = false;
+  JPP_RETURN_IF_ERROR(
+      recvAll(fd_, header, ServerFraming::ResponseHeaderSize, &eof));
+  if (eof) {
+    return JPPS_INVALID_STATE << "server has closed the connection";
+  }
+  auto size = decodeU32(header);
+  bool failed = (size & ServerFraming::ErrorFlag) != 0;
+  size &= ~ServerFraming::ErrorFlag;
+  *latencyMicros = decodeU32(header + 4);
+  buffer_.resize(size);
+  if (size > 0) {
+    JPP_RETURN_IF_ERROR(recvAll(fd_, &buffer_[0], size, &eof));
+    if (eof) {
+      return JPPS_INVALID_STATE << "server has closed the connection";
+    }
+  }
+  if (failed) {
+    return JPPS_INVALID_STATE << "server has failed to process the request: "
+                              << buffer_;
+  }
+  *response = StringPiece{buffer_};
+  return Status::Ok();
+}
+
+void ServerConnection::close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+#else  // JPP_HAS_UNIX_SOCKETS
+
+JumanppServer::~JumanppServer() = default;
+
+Status JumanppServer::initialize(JumanppExec* exec, StringPiece socketPath,
+                                 u32 poolSize, u32 maxConnections) {
+  return JPPS_NOT_IMPLEMENTED
+         << "server mode is supported only on platforms with unix sockets";
+}
+
+Status JumanppServer::stopOnSignals() {
+  return JPPS_NOT_IMPLEMENTED
+         << "server mode is supported only on platforms with unix sockets";
+}
+
+Status JumanppServer::serve() {
+  return JPPS_NOT_IMPLEMENTED
+         << "server mode is supported only on platforms with unix sockets";
+}
+
+void JumanppServer::stop() {}
+
+void JumanppServer::stopWorkers() {}
+
+void JumanppServer::runWorker() {}
+
+void JumanppServer::runAnalysis(RawExampleAnalyzer* raw) {}
+
+void JumanppServer::handleConnection(int fd) {}
+
+Status JumanppServer::processRequest(StringPiece request,
+                                     std::vector<ServerTask>* tasks,
+                                     std::string* response,
+                                     ServerStats* stats) {
+  return JPPS_NOT_IMPLEMENTED;
+}
+
+ServerConnection::~ServerConnection() = default;
+
+Status ServerConnection::connect(StringPiece socketPath) {
+  return JPPS_NOT_IMPLEMENTED
+         << "client mode is supported only on platforms with unix sockets";
+}
+
+Status ServerConnection::request(StringPiece payload, StringPiece* response,
+                                 u32* latencyMicros) {
+  return JPPS_NOT_IMPLEMENTED;
+}
+
+void ServerConnection::close() {}
+
+#endif  // JPP_HAS_UNIX_SOCKETS
+
+}  // namespace jumandic
+}  // namespace jumanpp
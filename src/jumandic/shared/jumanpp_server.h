@@ -0,0 +1,153 @@
+#ifndef JUMANPP_JUMANPP_SERVER_H
+#define JUMANPP_JUMANPP_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/env.h"
+#include "jumandic/shared/jumandic_env.h"
+#include "util/bounded_queue.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+/**
+ * Framing of the local server protocol.
+ *
+ * Request: u32 payload length + payload.
+ * Payload is raw input: one or more sentences, each on its own line,
+ * optionally preceded by "# " comment lines.
+ *
+ * Response: u32 payload length + u32 analysis latency in microseconds
+ * + payload (formatted analysis results for all sentences of the request).
+ * If the ErrorFlag bit of the length is set, the request has failed
+ * and the payload is an error message instead.
+ * Responses larger than MaxResponseSize are replaced by an error.
+ *
+ * All integers are little-endian.
+ */
+struct ServerFraming {
+  static constexpr u32 MaxPayloadSize = 256 * 1024 * 1024;
+  static constexpr u32 MaxResponseSize = 1024 * 1024 * 1024;
+  static constexpr u32 ErrorFlag = 0x80000000u;
+  static constexpr size_t RequestHeaderSize = 4;
+  static constexpr size_t ResponseHeaderSize = 8;
+};
+
+struct ServerStats {
+  u64 requests = 0;
+  u64 sentences = 0;
+  u64 totalLatencyMicros = 0;
+  u64 maxLatencyMicros = 0;
+};
+
+/**
+ * Sentences of a single request, the connection worker waits
+ * until all of them are analyzed
+ */
+struct ServerBatch {
+  std::mutex mutex;
+  std::condition_variable done;
+  size_t remaining = 0;
+};
+
+/**
+ * A sentence of a request which is analyzed by one of the analysis threads
+ */
+struct ServerTask {
+  StringPiece input;
+  StringPiece comment;
+  std::string output;
+  // failure to produce the output, fails the whole request
+  Status status = Status::Ok();
+  ServerBatch* batch = nullptr;
+};
+
+/**
+ * Keeps the model loaded and serves analysis requests
+ * over a Unix domain socket.
+ *
+ * Connections are handled by a fixed set of maxConnections workers.
+ * Accepted connections wait in a queue of the same size for a free worker,
+ * connections which do not fit there are closed right away.
+ *
+ * Workers split requests into sentences and put them into a single queue,
+ * which is served by poolSize analysis threads, each of them holding
+ * an analyzer for the lifetime of the server.
+ * Sentences of concurrent requests are batched in the queue,
+ * so all analyzers are busy even if only some connections are active.
+ */
+class JumanppServer {
+  JumanppExec* exec_ = nullptr;
+  core::AnalyzerPool pool_;
+  std::string path_;
+  int listenFd_ = -1;
+  // read end of the pipe which is written to on SIGINT and SIGTERM
+  int signalFd_ = -1;
+  u32 poolSize_ = 0;
+  u32 maxConnections_ = 0;
+  std::atomic<u64> connections_{0};
+  std::atomic<bool> stopping_{false};
+  // accepted connections, -1 stops a worker
+  util::bounded_queue<int> accepted_;
+  std::vector<std::thread> workers_;
+  std::mutex activeMutex_;
+  std::vector<int> active_;
+
+  std::mutex tasksMutex_;
+  std::condition_variable tasksReady_;
+  std::deque<ServerTask*> tasks_;
+  bool analysisDone_ = false;
+  std::vector<std::thread> analysisThreads_;
+
+  void runWorker();
+  void runAnalysis(RawExampleAnalyzer* raw);
+  void stopWorkers();
+  void handleConnection(int fd);
+  Status processRequest(StringPiece request, std::vector<ServerTask>* tasks,
+                        std::string* response, ServerStats* stats);
+
+ public:
+  ~JumanppServer();
+  Status initialize(JumanppExec* exec, StringPiece socketPath, u32 poolSize,
+                    u32 maxConnections);
+  /**
+   * Makes serve() return on SIGINT and SIGTERM.
+   * Signal handlers are process-wide, so only one server can use it.
+   */
+  Status stopOnSignals();
+  // Serves requests until stop() is called, joins all workers on return
+  Status serve();
+  // Makes serve() return, can be called from any thread
+  void stop();
+};
+
+/**
+ * Connection to the local server, used by the thin client mode
+ */
+class ServerConnection {
+  int fd_ = -1;
+  std::string buffer_;
+
+ public:
+  ~ServerConnection();
+  Status connect(StringPiece socketPath);
+  /**
+   * Sends the request and waits for the response.
+   * Response points to the connection buffer and is valid until the next
+   * request.
+   */
+  Status request(StringPiece payload, StringPiece* response,
+                 u32* latencyMicros);
+  void close();
+};
+
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_JUMANPP_SERVER_H
@@ -0,0 +1,45 @@
+#include "result_cache.h"
+#include "util/murmur_hash.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+ResultCache::ResultCache(size_t capacity, u64 configHash)
+    : cache_{capacity}, seed_{configHash} {}
+
+u64 ResultCache::keyOf(StringPiece input) const {
+  return util::hashing::murmurhash3_memory(input.ubegin(), input.uend(),
+                                           seed_);
+}
+
+std::shared_ptr<const CachedResult> ResultCache::find(StringPiece input) {
+  auto key = keyOf(input);
+  std::shared_ptr<const CachedResult> result;
+  bool found;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    found = cache_.tryFind(key, &result);
+  }
+  if (found && result->input == input) {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return result;
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void ResultCache::insert(StringPiece input, StringPiece output) {
+  auto key = keyOf(input);
+  std::shared_ptr<const CachedResult> value{
+      new CachedResult{input.str(), output.str()}};
+  std::lock_guard<std::mutex> lock{mutex_};
+  cache_.insert(key, value);
+}
+
+ResultCacheStats ResultCache::stats() const {
+  return ResultCacheStats{hits_.load(std::memory_order_relaxed),
+                          misses_.load(std::memory_order_relaxed)};
+}
+
+}  // namespace jumandic
+}  // namespace jumanpp
@@ -0,0 +1,58 @@
+#ifndef JUMANPP_RESULT_CACHE_H
+#define JUMANPP_RESULT_CACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "util/lru_cache.h"
+#include "util/string_piece.h"
+
+namespace jumanpp {
+namespace jumandic {
+
+struct CachedResult {
+  std::string input;
+  std::string output;
+};
+
+struct ResultCacheStats {
+  u64 hits;
+  u64 misses;
+};
+
+/**
+ * Size-bounded cache of formatted analysis results for raw sentences.
+ *
+ * Keys are hashes of the input seeded with a hash of the
+ * configuration, so results of different models or output formats
+ * never mix. Inputs are stored as well and compared on lookup,
+ * so hash collisions can not produce a wrong result.
+ *
+ * Can be used from several threads.
+ */
+class ResultCache {
+  std::mutex mutex_;
+  util::LruCache<u64, std::shared_ptr<const CachedResult>> cache_;
+  u64 seed_;
+  std::atomic<u64> hits_{0};
+  std::atomic<u64> misses_{0};
+
+  u64 keyOf(StringPiece input) const;
+
+ public:
+  ResultCache(size_t capacity, u64 configHash);
+
+  /**
+   * Returns nullptr if there is no result for this input.
+   * Returned result stays valid even if it is evicted from the cache.
+   */
+  std::shared_ptr<const CachedResult> find(StringPiece input);
+  void insert(StringPiece input, StringPiece output);
+  ResultCacheStats stats() const;
+};
+
+}  // namespace jumandic
+}  // namespace jumanpp
+
+#endif  // JUMANPP_RESULT_CACHE_H
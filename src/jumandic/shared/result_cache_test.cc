@@ -0,0 +1,32 @@
+#include "result_cache.h"
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+using namespace jumanpp::jumandic;
+
+TEST_CASE("result cache returns inserted results") {
+  ResultCache cache{16, 42};
+  CHECK(cache.find("test") == nullptr);
+  cache.insert("test", "result");
+  auto r = cache.find("test");
+  REQUIRE(r != nullptr);
+  CHECK(r->input == "test");
+  CHECK(r->output == "result");
+  CHECK(cache.find("test2") == nullptr);
+  auto stats = cache.stats();
+  CHECK(stats.hits == 1);
+  CHECK(stats.misses == 2);
+}
+
+TEST_CASE("result cache results outlive eviction") {
+  ResultCache cache{2, 0};
+  cache.insert("a", "1");
+  auto r = cache.find("a");
+  REQUIRE(r != nullptr);
+  for (int i = 0; i < 10; ++i) {
+    auto s = std::to_string(i);
+    cache.insert(s, s);
+  }
+  CHECK(cache.find("a") == nullptr);
+  CHECK(r->output == "1");
+}
@@ -5,6 +5,42 @@
 #include "jumandic/shared/jumandic_test_env.h"
 #include "jumandic/shared/lattice_format.h"
 
+namespace {
+namespace an = jumanpp::core::analysis;
+
+// writes the same score for all nodes
+class ConstantScorer : public an::ScoreComputer {
+ public:
+  Status scoreLattice(an::Lattice* l, const an::ExtraNodesContext* xtra,
+                      u32 scorerIdx) override {
+    for (u32 i = 0; i < l->createdBoundaryCount(); ++i) {
+      auto bnd = l->boundary(i);
+      for (u32 right = 0; right < bnd->localNodeCount(); ++right) {
+        auto scores = bnd->scores()->nodeScores(right);
+        for (u32 beam = 0; beam < scores.beam(); ++beam) {
+          for (u32 left = 0; left < scores.left(); ++left) {
+            scores.beamLeft(beam, left).at(scorerIdx) = 1000;
+          }
+        }
+      }
+    }
+    return Status::Ok();
+  }
+};
+
+class ConstantScorerFactory : public an::ScorerFactory {
+ public:
+  Status load(const core::model::ModelInfo& model) override {
+    return Status::Ok();
+  }
+
+  Status makeInstance(std::unique_ptr<an::ScoreComputer>* result) override {
+    result->reset(new ConstantScorer);
+    return Status::Ok();
+  }
+};
+}  // namespace
+
 TEST_CASE("lattice output works") {
   JumandicTrainingTestEnv env{"jumandic/bug-28-lattice.mdic"};
   env.trainArgs.batchSize = 100;
@@ -32,3 +68,37 @@ TEST_CASE("lattice output works with gbeam", "[gbeam]") {
   REQUIRE(fmt.format(*ana, ""));
   CHECK_THAT(fmt.result().str(), Catch::Contains("1;2;3"));
 }
+
+TEST_CASE("lattice output has zero scores of scorers skipped by the deadline",
+          "[gbeam]") {
+  JumandicTrainingTestEnv env{"jumandic/bug-28-lattice.mdic"};
+  env.globalBeam(3, 1, 3);
+  env.trainArgs.batchSize = 100;
+  env.trainArgs.trainingConfig.featureNumberExponent = 15;
+  env.trainNepochsFrom("jumandic/bug-28-lattice.in", 3);
+  ConstantScorerFactory lm;
+  an::ScorerDef scorers = *env.trainEnv.value().scorerDef();
+  scorers.others.push_back(&lm);
+  scorers.scoreWeights.push_back(1.0f);
+  an::AnalyzerConfig cfg;
+  cfg.globalBeamSize = 3;
+  cfg.rightGbeamCheck = 1;
+  cfg.rightGbeamSize = 3;
+  an::Analyzer ana;
+  REQUIRE_OK(ana.initialize(env.jppEnv.coreHolder(), cfg,
+                            core::ScoringConfig{5, 2}, &scorers));
+  jumanpp::jumandic::output::LatticeFormat fmt{3};
+  REQUIRE(fmt.initialize(ana.output()));
+  CHECK_OK(ana.analyze("見ぬふりをする"));
+  REQUIRE(fmt.format(ana, ""));
+  CHECK_THAT(fmt.result().str(), Catch::Contains("言語モデルスコア:1000|"));
+
+  // scores of the first analysis stay in the reused memory
+  ana.impl()->setDeadline(1);
+  CHECK_OK(ana.analyze("見ぬふりをする"));
+  CHECK(ana.impl()->degraded());
+  REQUIRE(fmt.format(ana, ""));
+  auto result = fmt.result().str();
+  CHECK_THAT(result, Catch::Contains("言語モデルスコア:0|"));
+  CHECK_THAT(result, !Catch::Contains("言語モデルスコア:1000|"));
+}
@@ -23,6 +23,7 @@ using namespace jumanpp::core::analysis;
 
 class TestAnalyzer : public core::analysis::AnalyzerImpl {
   friend class TestEnv;
+  bool compactorReady_ = false;
 
  public:
   TestAnalyzer(const CoreHolder* core, const ScoringConfig& sconf,
@@ -30,6 +31,7 @@ class TestAnalyzer : public core::analysis::AnalyzerImpl {
       : AnalyzerImpl(core, sconf, cfg) {}
 
   LatticeBuilder& latticeBuilder() { return latticeBldr_; }
+  const DictionaryNodeCreator& dicNodes() const { return dicNodes_; }
 
   Status fullAnalyze(StringPiece input, const ScorerDef* sconf) {
     JPP_RETURN_IF_ERROR(this->resetForInput(input));
@@ -42,6 +44,27 @@ class TestAnalyzer : public core::analysis::AnalyzerImpl {
 
   ScoreProcessor& sproc() { return *sproc_; }
   AnalysisInput& input() { return input_; }
+
+  /**
+   * Merges seeds which are not distinguishable by the scoring model
+   * into alias nodes (see LatticeCompactor).
+   * Call between prepareNodeSeeds and buildLattice.
+   * Analyzers do not do it because OutputManager can not locate
+   * alias nodes yet.
+   *
+   * \return number of merged seeds
+   */
+  u64 compactNodeSeeds() {
+    if (!compactorReady_) {
+      REQUIRE_OK(compactor_.initialize(&xtra_, core_->spec()));
+      compactorReady_ = true;
+    }
+    auto deleted = compactor_.totalDeleted();
+    for (i32 bnd = 0; bnd < input_.numCodepoints(); ++bnd) {
+      latticeBldr_.compactBoundary(bnd, &compactor_);
+    }
+    return compactor_.totalDeleted() - deleted;
+  }
 };
 
 class TestEnv {
@@ -4,6 +4,18 @@
 
 #include "characters.h"
 #include <util/flatset.h>
+#include <cstring>
+#include <map>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define JPP_CHARS_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 namespace jumanpp {
 namespace chars {
@@ -256,25 +268,367 @@ CharacterClass getCodeType(char32_t input) noexcept {
   }
 }
 
-Status preprocessRawData(StringPiece utf8data,
-                         std::vector<InputCodepoint> *result) {
-  auto itr = utf8data.ubegin();
-  StringPiece::byte_ptr end = utf8data.uend();
+namespace {
+
+/**
+ * Character classes of the Basic Multilingual Plane.
+ * The plane is split into pages of 256 codepoints,
+ * pages with the same content are stored only once.
+ */
+class BmpClassTable {
+  static constexpr u32 PageBits = 8;
+  static constexpr u32 PageSize = 1 << PageBits;
+  static constexpr u32 NumPages = 0x10000 >> PageBits;
+
+  u16 pageIndex_[NumPages];
+  std::vector<i32> pages_;
+
+ public:
+  BmpClassTable() {
+    std::map<std::vector<i32>, u16> uniquePages;
+    std::vector<i32> page(PageSize);
+    for (u32 pg = 0; pg < NumPages; ++pg) {
+      for (u32 i = 0; i < PageSize; ++i) {
+        auto cp = static_cast<char32_t>((pg << PageBits) | i);
+        page[i] = static_cast<i32>(getCodeType(cp));
+      }
+      auto it = uniquePages.find(page);
+      if (it == uniquePages.end()) {
+        auto idx = static_cast<u16>(uniquePages.size());
+        it = uniquePages.emplace(page, idx).first;
+        pages_.insert(pages_.end(), page.begin(), page.end());
+      }
+      pageIndex_[pg] = it->second;
+    }
+  }
+
+  JPP_ALWAYS_INLINE CharacterClass lookup(char32_t code) const noexcept {
+    u32 page = pageIndex_[code >> PageBits];
+    auto value = pages_[(page << PageBits) | (code & (PageSize - 1))];
+    return static_cast<CharacterClass>(value);
+  }
+};
+
+const BmpClassTable& bmpClasses() {
+  static const BmpClassTable table;
+  return table;
+}
+
+inline JPP_ALWAYS_INLINE void emitCodepoint(
+    const u8* begin, const u8* end, char32_t cp, CharacterClass cls,
+    const u8* base, std::vector<InputCodepoint>* result,
+    CodepointArrays* arrays) {
+  result->emplace_back(InputCodepoint{cp, cls, StringPiece{begin, end}});
+  if (arrays != nullptr) {
+    arrays->codepoints.push_back(cp);
+    arrays->classes.push_back(static_cast<i32>(cls));
+    arrays->offsets.push_back(static_cast<u32>(begin - base));
+  }
+}
+
+using DecodeFn = const u8 *(*)(const u8 *itr, const u8 *end, const u8 *base,
+                               std::vector<InputCodepoint> *result,
+                               CodepointArrays *arrays);
+
+inline JPP_ALWAYS_INLINE void emitAscii(const u8 *itr, u32 count,
+                                        const u8 *base,
+                                        std::vector<InputCodepoint> *result,
+                                        CodepointArrays *arrays) {
+  auto &table = bmpClasses();
+  for (u32 i = 0; i < count; ++i) {
+    char32_t cp = itr[i];
+    emitCodepoint(itr + i, itr + i + 1, cp, table.lookup(cp), base, result,
+                  arrays);
+  }
+}
+
+inline JPP_ALWAYS_INLINE void emitThreeByte(
+    const u8 *itr, const u32 *codepoints, u32 count, const u8 *base,
+    std::vector<InputCodepoint> *result, CodepointArrays *arrays) {
+  auto &table = bmpClasses();
+  for (u32 i = 0; i < count; ++i) {
+    auto begin = itr + i * 3;
+    char32_t cp = codepoints[i];
+    emitCodepoint(begin, begin + 3, cp, table.lookup(cp), base, result,
+                  arrays);
+  }
+}
+
+/**
+ * Decodes a single codepoint.
+ * Returns false if the input does not start with a valid UTF-8 sequence.
+ */
+inline JPP_ALWAYS_INLINE bool decodeOne(const u8 *&itr, const u8 *end,
+                                        const u8 *base,
+                                        std::vector<InputCodepoint> *result,
+                                        CodepointArrays *arrays) {
+  auto begin = itr;
+  auto ret = getCodepoint(itr, end);
+  if (ret.utf8Length == 0) {
+    return false;
+  }
+  itr += ret.utf8Length;
+  auto unicode = ret.codepoint;
+  CharacterClass cc = unicode < 0x10000 ? bmpClasses().lookup(unicode)
+                                        : getCodeType(unicode);
+  emitCodepoint(begin, itr, unicode, cc, base, result, arrays);
+  return true;
+}
+
+// Decoders return the position of an invalid sequence or the end of input
+
+const u8 *decodeScalar(const u8 *itr, const u8 *end, const u8 *base,
+                       std::vector<InputCodepoint> *result,
+                       CodepointArrays *arrays) {
   while (itr < end) {
-    auto begin = itr;
-    auto ret = getCodepoint(itr, end);
+    if (!decodeOne(itr, end, base, result, arrays)) {
+      return itr;
+    }
+  }
+  return end;
+}
+
+#ifdef JPP_CHARS_X86_KERNELS
+
+/*
+ * Vector decoders handle two kinds of blocks, everything else
+ * (and the tail of the input) is decoded one codepoint at a time.
+ *
+ * ASCII: all bytes of a block have the high bit unset.
+ *
+ * 3-byte sequences (most of Japanese text): bytes are shuffled so that
+ * each 32-bit lane holds one sequence as 00 b0 b1 b2 (big end first).
+ * A lane is valid when (lane & 0xf0c0c0) == 0xe08080, which is exactly
+ * the check of getCodepoint, and decodes to
+ * (b0 & 0x0f) << 12 | (b1 & 0x3f) << 6 | (b2 & 0x3f).
+ * A prefix of valid lanes is emitted.
+ */
+
+__attribute__((target("ssse3"))) inline __m128i decodeLanesSsse3(
+    __m128i lanes) {
+  auto b2 = _mm_and_si128(lanes, _mm_set1_epi32(0x3f));
+  auto b1 = _mm_and_si128(_mm_srli_epi32(lanes, 2), _mm_set1_epi32(0xfc0));
+  auto b0 = _mm_and_si128(_mm_srli_epi32(lanes, 4), _mm_set1_epi32(0xf000));
+  return _mm_or_si128(_mm_or_si128(b0, b1), b2);
+}
+
+__attribute__((target("ssse3"))) const u8 *decodeSsse3(
+    const u8 *itr, const u8 *end, const u8 *base,
+    std::vector<InputCodepoint> *result, CodepointArrays *arrays) {
+  const auto shuffle =
+      _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  const auto mask = _mm_set1_epi32(0xf0c0c0);
+  const auto pattern = _mm_set1_epi32(0xe08080);
+  alignas(16) u32 codepoints[4];
+  while (end - itr >= 16) {
+    auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(itr));
+    u32 nonAscii = static_cast<u32>(_mm_movemask_epi8(bytes));
+    if (nonAscii == 0) {
+      emitAscii(itr, 16, base, result, arrays);
+      itr += 16;
+      continue;
+    }
+    if ((nonAscii & 1) == 0) {
+      u32 count = static_cast<u32>(__builtin_ctz(nonAscii));
+      emitAscii(itr, count, base, result, arrays);
+      itr += count;
+      continue;
+    }
+    auto lanes = _mm_shuffle_epi8(bytes, shuffle);
+    auto valid = _mm_cmpeq_epi32(_mm_and_si128(lanes, mask), pattern);
+    u32 invalid = ~static_cast<u32>(_mm_movemask_epi8(valid));
+    u32 count = static_cast<u32>(__builtin_ctz(invalid)) / 4;
+    if (count == 0) {
+      if (!decodeOne(itr, end, base, result, arrays)) {
+        return itr;
+      }
+      continue;
+    }
+    _mm_store_si128(reinterpret_cast<__m128i *>(codepoints),
+                    decodeLanesSsse3(lanes));
+    emitThreeByte(itr, codepoints, count, base, result, arrays);
+    itr += count * 3;
+  }
+  return decodeScalar(itr, end, base, result, arrays);
+}
 
-    if (ret.utf8Length == 0) {
-      return JPPS_INVALID_PARAMETER << "Invalid UTF8 sequence: " << utf8data;
+__attribute__((target("avx2"))) const u8 *decodeAvx2(
+    const u8 *itr, const u8 *end, const u8 *base,
+    std::vector<InputCodepoint> *result, CodepointArrays *arrays) {
+  // each 128-bit half holds four sequences, the upper one starts at 12
+  const auto shuffle = _mm256_setr_epi8(
+      2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1, 0, -1, 5, 4,
+      3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  const auto mask = _mm256_set1_epi32(0xf0c0c0);
+  const auto pattern = _mm256_set1_epi32(0xe08080);
+  alignas(32) u32 codepoints[8];
+  while (end - itr >= 32) {
+    auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(itr));
+    u32 nonAscii = static_cast<u32>(_mm256_movemask_epi8(bytes));
+    if (nonAscii == 0) {
+      emitAscii(itr, 32, base, result, arrays);
+      itr += 32;
+      continue;
+    }
+    if ((nonAscii & 1) == 0) {
+      u32 count = static_cast<u32>(__builtin_ctz(nonAscii));
+      emitAscii(itr, count, base, result, arrays);
+      itr += count;
+      continue;
+    }
+    auto low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(itr));
+    auto high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(itr + 12));
+    auto halves = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+    auto lanes = _mm256_shuffle_epi8(halves, shuffle);
+    auto valid = _mm256_cmpeq_epi32(_mm256_and_si256(lanes, mask), pattern);
+    u32 invalid = ~static_cast<u32>(_mm256_movemask_epi8(valid));
+    u32 count = invalid == 0 ? 8 : static_cast<u32>(__builtin_ctz(invalid)) / 4;
+    if (count == 0) {
+      if (!decodeOne(itr, end, base, result, arrays)) {
+        return itr;
+      }
+      continue;
     }
-    itr += ret.utf8Length;
-    auto unicode = ret.codepoint;
-    CharacterClass cc = getCodeType(unicode);
-    result->emplace_back(InputCodepoint{unicode, cc, StringPiece(begin, itr)});
+    auto b2 = _mm256_and_si256(lanes, _mm256_set1_epi32(0x3f));
+    auto b1 = _mm256_and_si256(_mm256_srli_epi32(lanes, 2),
+                               _mm256_set1_epi32(0xfc0));
+    auto b0 = _mm256_and_si256(_mm256_srli_epi32(lanes, 4),
+                               _mm256_set1_epi32(0xf000));
+    auto decoded = _mm256_or_si256(_mm256_or_si256(b0, b1), b2);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(codepoints), decoded);
+    emitThreeByte(itr, codepoints, count, base, result, arrays);
+    itr += count * 3;
+  }
+  return decodeSsse3(itr, end, base, result, arrays);
+}
+
+#endif  // JPP_CHARS_X86_KERNELS
+
+DecodeFn decoderFor(Utf8Decoder decoder) {
+  if (!utf8DecoderSupported(decoder)) {
+    return nullptr;
+  }
+  switch (decoder) {
+#ifdef JPP_CHARS_X86_KERNELS
+    case Utf8Decoder::Ssse3:
+      return &decodeSsse3;
+    case Utf8Decoder::Avx2:
+      return &decodeAvx2;
+#endif
+    default:
+      return &decodeScalar;
+  }
+}
+
+Status decodeWith(DecodeFn decode, StringPiece utf8data,
+                  std::vector<InputCodepoint> *result,
+                  CodepointArrays *arrays) {
+  auto base = utf8data.ubegin();
+  auto end = utf8data.uend();
+  if (decode(base, end, base, result, arrays) != end) {
+    return JPPS_INVALID_PARAMETER << "Invalid UTF8 sequence: " << utf8data;
+  }
+  if (arrays != nullptr) {
+    arrays->offsets.push_back(static_cast<u32>(end - base));
   }
   return Status::Ok();
 }
 
+}  // namespace
+
+bool utf8DecoderSupported(Utf8Decoder decoder) {
+  switch (decoder) {
+    case Utf8Decoder::Scalar:
+      return true;
+#ifdef JPP_CHARS_X86_KERNELS
+    case Utf8Decoder::Ssse3: {
+      static const bool supported = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+      }();
+      return supported;
+    }
+    case Utf8Decoder::Avx2: {
+      static const bool supported = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+      }();
+      return supported;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+Utf8Decoder bestUtf8Decoder() {
+  if (utf8DecoderSupported(Utf8Decoder::Avx2)) {
+    return Utf8Decoder::Avx2;
+  }
+  if (utf8DecoderSupported(Utf8Decoder::Ssse3)) {
+    return Utf8Decoder::Ssse3;
+  }
+  return Utf8Decoder::Scalar;
+}
+
+CharacterClass classifyCodepoint(char32_t code) noexcept {
+  if (code < 0x10000) {
+    return bmpClasses().lookup(code);
+  }
+  return getCodeType(code);
+}
+
+Status preprocessRawData(StringPiece utf8data,
+                         std::vector<InputCodepoint> *result) {
+  return preprocessRawData(utf8data, result, nullptr);
+}
+
+Status preprocessRawData(StringPiece utf8data,
+                         std::vector<InputCodepoint> *result,
+                         CodepointArrays *arrays) {
+  static const DecodeFn decode = decoderFor(bestUtf8Decoder());
+  return decodeWith(decode, utf8data, result, arrays);
+}
+
+Status preprocessRawData(StringPiece utf8data,
+                         std::vector<InputCodepoint> *result,
+                         CodepointArrays *arrays, Utf8Decoder decoder) {
+  auto decode = decoderFor(decoder);
+  if (decode == nullptr) {
+    return JPPS_INVALID_PARAMETER << "UTF8 decoder #"
+                                  << static_cast<int>(decoder)
+                                  << " is not supported by the CPU";
+  }
+  return decodeWith(decode, utf8data, result, arrays);
+}
+
+void computeClassRuns(util::ArraySlice<i32> classes,
+                      std::vector<CharClassRun> *result) {
+  auto size = static_cast<u32>(classes.size());
+  auto data = classes.data();
+  u32 start = 0;
+  while (start < size) {
+    auto cls = data[start];
+    u32 end = start + 1;
+#ifdef __SSE2__
+    auto vcls = _mm_set1_epi32(cls);
+    for (; end + 4 <= size; end += 4) {
+      auto block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + end));
+      auto same = _mm_cmpeq_epi32(block, vcls);
+      if (_mm_movemask_ps(_mm_castsi128_ps(same)) != 0xf) {
+        break;
+      }
+    }
+#endif
+    while (end < size && data[end] == cls) {
+      ++end;
+    }
+    result->push_back({start, end, static_cast<CharacterClass>(cls)});
+    start = end;
+  }
+}
+
 i32 numCodepoints(StringPiece utf8) {
   auto itr = utf8.ubegin();
   auto end = utf8.uend();
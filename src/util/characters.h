@@ -5,6 +5,7 @@
 #ifndef JUMANPP_CHARACTERS_HPP
 #define JUMANPP_CHARACTERS_HPP
 
+#include "util/array_slice.h"
 #include "util/status.hpp"
 #include "util/string_piece.h"
 #include "util/types.hpp"
@@ -130,6 +131,12 @@ inline bool IsCompatibleCharClass(CharacterClass realCharClass,
 
 CharacterClass getCodeType(char32_t code) noexcept;
 
+/**
+ * Same result as getCodeType, but uses a lookup table
+ * for the Basic Multilingual Plane.
+ */
+CharacterClass classifyCodepoint(char32_t code) noexcept;
+
 struct InputCodepoint {
   /**
    * Unicode codepoint for character
@@ -158,9 +165,72 @@ struct InputCodepoint {
         bytes(sp) {}
 };
 
+/**
+ * Structure-of-arrays form of preprocessed input.
+ * Arrays are much more compact than InputCodepoint objects
+ * and can be scanned with vector instructions.
+ */
+struct CodepointArrays {
+  std::vector<char32_t> codepoints;
+  // CharacterClass values
+  std::vector<i32> classes;
+  // Byte offsets of codepoints, the last element is the total length
+  std::vector<u32> offsets;
+
+  void clear() {
+    codepoints.clear();
+    classes.clear();
+    offsets.clear();
+  }
+};
+
 Status preprocessRawData(StringPiece utf8data,
                          std::vector<InputCodepoint>* result);
 
+/**
+ * Also fills the structure-of-arrays form if arrays is not nullptr.
+ * Both outputs are appended to.
+ * Classes of BMP codepoints are taken from a precomputed page table
+ * instead of being computed by getCodeType.
+ */
+Status preprocessRawData(StringPiece utf8data,
+                         std::vector<InputCodepoint>* result,
+                         CodepointArrays* arrays);
+
+/**
+ * Implementations of UTF-8 decoding and classification.
+ * Vector ones decode blocks of ASCII and 3-byte sequences at once.
+ * They are selected at runtime, the best supported one is used by default.
+ */
+enum class Utf8Decoder { Scalar, Ssse3, Avx2 };
+
+bool utf8DecoderSupported(Utf8Decoder decoder);
+Utf8Decoder bestUtf8Decoder();
+
+/**
+ * Uses the specified decoder, fails if the CPU does not support it.
+ */
+Status preprocessRawData(StringPiece utf8data,
+                         std::vector<InputCodepoint>* result,
+                         CodepointArrays* arrays, Utf8Decoder decoder);
+
+/**
+ * Maximal run of codepoints which have the same character class,
+ * end is exclusive
+ */
+struct CharClassRun {
+  u32 start;
+  u32 end;
+  CharacterClass charClass;
+};
+
+/**
+ * Splits the input into maximal runs of the same character class.
+ * Runs are appended to the result in the order of positions.
+ */
+void computeClassRuns(util::ArraySlice<i32> classes,
+                      std::vector<CharClassRun>* result);
+
 i32 numCodepoints(StringPiece utf8);
 
 }  // namespace chars
@@ -157,4 +157,122 @@ TEST_CASE("preprocessRawData collectly treats impossible utf8 byte sequences",
   CHECK_FALSE(checkByteSequence({0xff}));
   // 0xfe 0xfe 0xff 0xff
   CHECK_FALSE(checkByteSequence({0xfe, 0xfe, 0xff, 0xff}));
-}
\ No newline at end of file
+}
+TEST_CASE("classifyCodepoint is the same as getCodeType", "[characters]") {
+  for (char32_t cp = 0; cp < 0x110000; ++cp) {
+    if (classifyCodepoint(cp) != getCodeType(cp)) {
+      CAPTURE(static_cast<u32>(cp));
+      CHECK(classifyCodepoint(cp) == getCodeType(cp));
+    }
+  }
+}
+
+TEST_CASE("preprocessRawData fills codepoint arrays", "[characters]") {
+  StringPiece input =
+      "some long ascii text (more than 16 chars)で、"
+      "ひらがなとカタカナと漢字😀のmixed text in one string";
+  std::vector<InputCodepoint> result;
+  CodepointArrays arrays;
+  REQUIRE_OK(preprocessRawData(input, &result, &arrays));
+  REQUIRE(result.size() == numCodepoints(input));
+  REQUIRE(arrays.codepoints.size() == result.size());
+  REQUIRE(arrays.classes.size() == result.size());
+  REQUIRE(arrays.offsets.size() == result.size() + 1);
+  CHECK(arrays.offsets.back() == input.size());
+  auto itr = input.ubegin();
+  for (size_t i = 0; i < result.size(); ++i) {
+    CAPTURE(i);
+    auto info = getCodepoint(itr, input.uend());
+    REQUIRE(info.utf8Length > 0);
+    auto& cp = result[i];
+    CHECK(cp.codepoint == info.codepoint);
+    CHECK(cp.charClass == getCodeType(info.codepoint));
+    CHECK(cp.bytes.ubegin() == itr);
+    CHECK(cp.bytes.size() == info.utf8Length);
+    CHECK(arrays.codepoints[i] == cp.codepoint);
+    CHECK(arrays.classes[i] == static_cast<i32>(cp.charClass));
+    CHECK(arrays.offsets[i] == itr - input.ubegin());
+    itr += info.utf8Length;
+  }
+}
+
+TEST_CASE("preprocessRawData detects errors after ascii blocks",
+          "[characters]") {
+  CHECK_FALSE(checkByteSequence({'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i',
+                                 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 0xff}));
+  CHECK_FALSE(checkByteSequence({'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i',
+                                 'j', 'k', 'l', 'm', 'n', 'o', 'p', 0xe3}));
+}
+
+TEST_CASE("utf8 decoders produce the same output as the scalar one",
+          "[characters]") {
+  std::string input =
+      "ascii text which is longer than a vector block, "
+      "ひらがなとカタカナと漢字が続く長めの日本語のテキスト、"
+      "ｈａｌｆ ｱｲｳ, ü, 😀🍣 and ＡＢＣ。";
+  // errors inside and after blocks of both kinds
+  std::vector<std::string> inputs{input, input + "\xe3\x81",
+                                  "\xe3\x81\x82\xe3\x81\x82\xe3\x41\x82" +
+                                      input,
+                                  input.substr(0, 40) + "\xff" + input};
+  for (auto& in : inputs) {
+    std::vector<InputCodepoint> expected;
+    CodepointArrays expectedArrays;
+    auto expectedStatus = preprocessRawData(in, &expected, &expectedArrays,
+                                            Utf8Decoder::Scalar);
+    CHECK(static_cast<bool>(expectedStatus) == (&in == &inputs.front()));
+    for (auto decoder : {Utf8Decoder::Ssse3, Utf8Decoder::Avx2}) {
+      if (!utf8DecoderSupported(decoder)) {
+        continue;
+      }
+      CAPTURE(static_cast<int>(decoder));
+      std::vector<InputCodepoint> result;
+      CodepointArrays arrays;
+      auto status = preprocessRawData(in, &result, &arrays, decoder);
+      CHECK(static_cast<bool>(status) == static_cast<bool>(expectedStatus));
+      if (!expectedStatus) {
+        continue;
+      }
+      REQUIRE(result.size() == expected.size());
+      for (size_t i = 0; i < result.size(); ++i) {
+        CAPTURE(i);
+        CHECK(result[i].codepoint == expected[i].codepoint);
+        CHECK(result[i].charClass == expected[i].charClass);
+        CHECK(result[i].bytes.ubegin() == expected[i].bytes.ubegin());
+        CHECK(result[i].bytes.size() == expected[i].bytes.size());
+      }
+      CHECK(arrays.codepoints == expectedArrays.codepoints);
+      CHECK(arrays.classes == expectedArrays.classes);
+      CHECK(arrays.offsets == expectedArrays.offsets);
+    }
+  }
+}
+
+TEST_CASE("computeClassRuns splits input by character classes",
+          "[characters]") {
+  std::vector<InputCodepoint> result;
+  CodepointArrays arrays;
+  REQUIRE_OK(
+      preprocessRawData("abcdefghijklmnopqrstuvwxyzカあいabcdeカ", &result,
+                        &arrays));
+  std::vector<CharClassRun> runs;
+  computeClassRuns(arrays.classes, &runs);
+  REQUIRE(runs.size() == 5);
+  CHECK(runs[0].start == 0);
+  CHECK(runs[0].end == 26);
+  CHECK(runs[0].charClass == CharacterClass::ALPH);
+  CHECK(runs[1].start == 26);
+  CHECK(runs[1].end == 27);
+  CHECK(runs[1].charClass == CharacterClass::KATAKANA);
+  CHECK(runs[2].end == 29);
+  CHECK(runs[2].charClass == CharacterClass::HIRAGANA);
+  CHECK(runs[3].end == 34);
+  CHECK(runs[3].charClass == CharacterClass::ALPH);
+  CHECK(runs[4].start == 34);
+  CHECK(runs[4].end == 35);
+  CHECK(runs[4].charClass == CharacterClass::KATAKANA);
+
+  runs.clear();
+  computeClassRuns(util::ArraySlice<i32>{}, &runs);
+  CHECK(runs.empty());
+}
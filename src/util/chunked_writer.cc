@@ -0,0 +1,145 @@
+#include "chunked_writer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#if defined(_WIN32_WINNT)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace jumanpp {
+namespace util {
+namespace io {
+
+ChunkedWriter::~ChunkedWriter() { close(); }
+
+Status ChunkedWriter::open(StringPiece filename) {
+  JPP_RETURN_IF_ERROR(close());
+  auto name = filename.str();
+#if defined(_WIN32_WINNT)
+  int fd = ::_open(name.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                   _S_IREAD | _S_IWRITE);
+#else
+  int fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+  if (fd < 0) {
+    return JPPS_INVALID_PARAMETER << "failed to open output file: " << filename
+                                  << " error: " << strerror(errno);
+  }
+  fd_ = fd;
+  ownsFd_ = true;
+  return Status::Ok();
+}
+
+void ChunkedWriter::attach(int fd) {
+  close();
+  fd_ = fd;
+  ownsFd_ = false;
+}
+
+void ChunkedWriter::setFlushSize(size_t size) {
+  flushSize_ = size;
+  buffer_.reserve(size);
+}
+
+Status ChunkedWriter::write(StringPiece data) {
+  if (buffer_.size() + data.size() <= flushSize_) {
+    buffer_.append(data.begin(), data.end());
+    return Status::Ok();
+  }
+  JPP_RETURN_IF_ERROR(writeAll(buffer_, data));
+  buffer_.clear();
+  return Status::Ok();
+}
+
+Status ChunkedWriter::flush() {
+  if (buffer_.empty()) {
+    return Status::Ok();
+  }
+  JPP_RETURN_IF_ERROR(writeAll(buffer_, EMPTY_SP));
+  buffer_.clear();
+  return Status::Ok();
+}
+
+Status ChunkedWriter::close() {
+  if (fd_ < 0) {
+    return Status::Ok();
+  }
+  Status s = flush();
+  if (ownsFd_) {
+#if defined(_WIN32_WINNT)
+    ::_close(fd_);
+#else
+    ::close(fd_);
+#endif
+  }
+  fd_ = -1;
+  ownsFd_ = false;
+  return s;
+}
+
+#if defined(_WIN32_WINNT)
+
+Status ChunkedWriter::writeAll(StringPiece first, StringPiece second) {
+  for (auto part : {first, second}) {
+    while (!part.empty()) {
+      auto chunk = static_cast<unsigned int>(
+          std::min<size_t>(part.size(), 1024 * 1024 * 1024));
+      int written = ::_write(fd_, part.begin(), chunk);
+      if (written < 0) {
+        return JPPS_INVALID_STATE << "failed to write output, error: "
+                                  << strerror(errno);
+      }
+      part = part.from(written);
+    }
+  }
+  return Status::Ok();
+}
+
+#else
+
+Status ChunkedWriter::writeAll(StringPiece first, StringPiece second) {
+  iovec parts[2];
+  parts[0].iov_base = const_cast<char*>(first.begin());
+  parts[0].iov_len = first.size();
+  parts[1].iov_base = const_cast<char*>(second.begin());
+  parts[1].iov_len = second.size();
+  iovec* current = parts;
+  int remaining = 2;
+
+  while (remaining > 0) {
+    if (current->iov_len == 0) {
+      ++current;
+      --remaining;
+      continue;
+    }
+    auto written = ::writev(fd_, current, remaining);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return JPPS_INVALID_STATE << "failed to write output, error: "
+                                << strerror(errno);
+    }
+    auto left = static_cast<size_t>(written);
+    while (remaining > 0 && left >= current->iov_len) {
+      left -= current->iov_len;
+      ++current;
+      --remaining;
+    }
+    if (remaining > 0) {
+      current->iov_base = static_cast<char*>(current->iov_base) + left;
+      current->iov_len -= left;
+    }
+  }
+  return Status::Ok();
+}
+
+#endif
+
+}  // namespace io
+}  // namespace util
+}  // namespace jumanpp
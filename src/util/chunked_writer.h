@@ -0,0 +1,62 @@
+#ifndef JUMANPP_CHUNKED_WRITER_H
+#define JUMANPP_CHUNKED_WRITER_H
+
+#include <string>
+#include "util/status.hpp"
+#include "util/string_piece.h"
+
+namespace jumanpp {
+namespace util {
+namespace io {
+
+/**
+ * Gathers small writes (e.g. formatted analysis results)
+ * into large chunks and writes them to a raw file descriptor.
+ *
+ * Data is copied to the internal buffer until the buffer would
+ * grow over the flush size, then the buffer and the new data
+ * are written together with a single vectored write.
+ */
+class ChunkedWriter {
+  int fd_ = -1;
+  bool ownsFd_ = false;
+  size_t flushSize_ = 64 * 1024;
+  std::string buffer_;
+
+  Status writeAll(StringPiece first, StringPiece second);
+
+ public:
+  ChunkedWriter() = default;
+  ChunkedWriter(const ChunkedWriter&) = delete;
+  ChunkedWriter& operator=(const ChunkedWriter&) = delete;
+  ~ChunkedWriter();
+
+  /**
+   * Creates (or truncates) the file and writes to it
+   */
+  Status open(StringPiece filename);
+
+  /**
+   * Writes to an already opened file descriptor, e.g. stdout.
+   * It will not be closed by the writer.
+   */
+  void attach(int fd);
+
+  /**
+   * Zero means that everything is written immediately
+   */
+  void setFlushSize(size_t size);
+
+  Status write(StringPiece data);
+  Status flush();
+  Status close();
+
+  size_t buffered() const { return buffer_.size(); }
+  size_t flushSize() const { return flushSize_; }
+};
+
+}  // namespace io
+}  // namespace util
+}  // namespace jumanpp
+
+#endif  // JUMANPP_CHUNKED_WRITER_H
@@ -0,0 +1,62 @@
+#include "chunked_writer.h"
+#include <fstream>
+#include <sstream>
+#include "testing/standalone_test.h"
+
+using namespace jumanpp;
+
+namespace {
+std::string readFile(const std::string& name) {
+  std::ifstream in{name};
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+}  // namespace
+
+TEST_CASE("chunked writer buffers small writes") {
+  TempFile tmp;
+  util::io::ChunkedWriter wr;
+  REQUIRE_OK(wr.open(tmp.name()));
+  wr.setFlushSize(10);
+  REQUIRE_OK(wr.write("abc"));
+  REQUIRE_OK(wr.write("def"));
+  CHECK(wr.buffered() == 6);
+  CHECK(readFile(tmp.name()) == "");
+  REQUIRE_OK(wr.write("0123456789"));
+  CHECK(wr.buffered() == 0);
+  CHECK(readFile(tmp.name()) == "abcdef0123456789");
+  REQUIRE_OK(wr.write("xyz"));
+  REQUIRE_OK(wr.flush());
+  CHECK(readFile(tmp.name()) == "abcdef0123456789xyz");
+  REQUIRE_OK(wr.write("end"));
+  REQUIRE_OK(wr.close());
+  CHECK(readFile(tmp.name()) == "abcdef0123456789xyzend");
+}
+
+TEST_CASE("chunked writer with zero flush size writes immediately") {
+  TempFile tmp;
+  util::io::ChunkedWriter wr;
+  REQUIRE_OK(wr.open(tmp.name()));
+  wr.setFlushSize(0);
+  REQUIRE_OK(wr.write("abc"));
+  CHECK(wr.buffered() == 0);
+  CHECK(readFile(tmp.name()) == "abc");
+}
+
+TEST_CASE("chunked writer handles large writes") {
+  TempFile tmp;
+  std::string data;
+  for (int i = 0; i < 100000; ++i) {
+    data += std::to_string(i);
+  }
+  {
+    util::io::ChunkedWriter wr;
+    REQUIRE_OK(wr.open(tmp.name()));
+    wr.setFlushSize(1000);
+    StringPiece sp{data};
+    REQUIRE_OK(wr.write(sp.slice(0, 500)));
+    REQUIRE_OK(wr.write(sp.from(500)));
+  }
+  CHECK(readFile(tmp.name()) == data);
+}
@@ -5,6 +5,8 @@
 #ifndef JUMANPP_COMMON_HPP
 #define JUMANPP_COMMON_HPP
 
+#include <cstdint>
+
 #ifdef _MSC_VER
 #define JPP_ALWAYS_INLINE __forceinline
 #define JPP_NO_INLINE __declspec(noinline)
@@ -63,6 +65,20 @@ inline JPP_ALWAYS_INLINE void prefetch(const void* x) {
 #endif
 }
 
+// Number of set bits.
+// Without the popcnt instruction (e.g. no -msse4.2) GCC compiles
+// __builtin_popcountll into a library call, this version is inlined.
+inline JPP_ALWAYS_INLINE unsigned popCount(std::uint64_t x) {
+#if defined(__POPCNT__)
+  return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<unsigned>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
 #define JPP_RET_CHECK(x)                  \
   {                                       \
     if (JPP_UNLIKELY(!(x))) return false; \
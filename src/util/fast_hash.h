@@ -244,6 +244,15 @@ class FastHash4 {
     _mm256_storeu_si256(reinterpret_cast<__m256i*>(result), s);
   }
 
+  // stores masked lower halves of the lanes, keeping the lane order
+  JPP_ALWAYS_INLINE void maskedStore(u32 mask, u32* result) const noexcept {
+    auto v = _mm256_permutevar8x32_epi32(
+        state_, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    v = _mm256_and_si256(v, _mm256_set1_epi32(mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(result),
+                     _mm256_castsi256_si128(v));
+  }
+
   JPP_ALWAYS_INLINE void store(u64* result) const noexcept {
     _mm256_storeu_si256(reinterpret_cast<__m256i*>(result), state_);
   }
@@ -84,4 +84,17 @@ TEST_CASE("avx fasthash compact-merge works") {
   CHECK(vresult[5] == (r7 & mask));
   CHECK(vresult[7] == (r8 & mask));
 }
+
+TEST_CASE("avx fasthash masked store keeps lane order") {
+  u64 state = 0xdeadbeef;
+  u64 data[] = {50, 80, 105, 241};
+  u32 vresult[4];
+  auto mask = (1u << 20u) - 1;
+  h::FastHash4{_mm256_set1_epi64x(state)}.mixMem(data).maskedStore(mask,
+                                                                     vresult);
+  for (int i = 0; i < 4; ++i) {
+    CAPTURE(i);
+    CHECK(vresult[i] == h::FastHash1{state}.mix(data[i]).masked(mask));
+  }
+}
 #endif
\ No newline at end of file
@@ -5,33 +5,79 @@
 #ifndef JUMANPP_QUANTIZED_WEIGHTS_H
 #define JUMANPP_QUANTIZED_WEIGHTS_H
 
+#include <algorithm>
+#include <cmath>
+#include "util/array_slice.h"
 #include "util/common.hpp"
+#include "util/types.hpp"
 
 namespace jumanpp {
 namespace util {
 
-class Float8BitLinearQ {
-  const unsigned char* memory_;
-  size_t size_;
-  float min_;
-  float step_;
-
- public:
-  Float8BitLinearQ(const char* memory, size_t size, float min, float step)
-      : memory_(reinterpret_cast<const unsigned char*>(memory)),
-        size_(size),
-        min_(min),
-        step_(step) {}
-  size_t size() const { return size_; }
-  float at(size_t idx) const {
-    JPP_DCHECK_IN(idx, 0, size_);
-    unsigned char data = memory_[idx];
-    return min_ + step_ * data;
+// SparseFloat32 stores only floats of nonzero weights
+enum class WeightEncoding : u32 {
+  Float32 = 0,
+  Linear8 = 1,
+  Linear16 = 2,
+  SparseFloat32 = 3
+};
+
+// log2 of the code size in bytes
+inline u32 weightCodeShift(WeightEncoding encoding) {
+  switch (encoding) {
+    case WeightEncoding::Linear8:
+      return 0;
+    case WeightEncoding::Linear16:
+      return 1;
+    default:
+      return 2;
   }
-  template <util::PrefetchHint kind>
-  void prefetch(size_t idx) const {}
+}
+
+// value = min + step * code
+struct LinearQuantParams {
+  float min;
+  float step;
 };
 
+/**
+ * Computes parameters of linear quantization with the given number
+ * of levels which covers all values.
+ * When values have different signs, the grid contains zero,
+ * so zero weights stay exactly zero.
+ */
+inline LinearQuantParams computeLinearQuantization(ArraySlice<float> values,
+                                                   u32 levels) {
+  JPP_DCHECK_GT(levels, 1);
+  if (values.size() == 0) {
+    return {0, 0};
+  }
+  auto minmax = std::minmax_element(values.begin(), values.end());
+  float min = *minmax.first;
+  float max = *minmax.second;
+  if (min == max) {
+    return {min, 0};
+  }
+  float step = (max - min) / (levels - 1);
+  if (min < 0 && max > 0) {
+    // zero point is rounded, so the values can be shifted by half a step
+    // and the grid is made one step wider to keep them inside
+    step = (max - min) / (levels - 2);
+    float zero = std::ceil(-min / step);
+    min = -zero * step;
+  }
+  return {min, step};
+}
+
+inline u32 quantizeLinear(float value, LinearQuantParams params, u32 levels) {
+  if (params.step == 0) {
+    return 0;
+  }
+  float code = std::round((value - params.min) / params.step);
+  code = std::max(0.0f, std::min(code, static_cast<float>(levels - 1)));
+  return static_cast<u32>(code);
+}
+
 }  // namespace util
 }  // namespace jumanpp
 